@@ -0,0 +1,72 @@
+-- Automation 4 test file
+-- Check that parallel_map gives the same result as a serial run
+
+script_name = "Test parallel_map"
+script_description = "Generate per-syllable lines for the selected lines both serially and with parallel_map, and compare the results"
+script_author = "Aegisub"
+script_version = "1"
+
+include("karaskel.lua")
+
+-- Must only depend on its arguments, as it's run in separate Lua states
+function syllable_lines(line, shared)
+	local style = shared.styles[line.style]
+	karaskel.preproc_line(shared.meta, shared.styles, line)
+	local result = {}
+	for i = 1, line.kara.n do
+		local syl = line.kara[i]
+		local nl = table.copy(line)
+		nl.kara = nil
+		nl.styleref = nil
+		nl.start_time = line.start_time + syl.start_time
+		nl.end_time = line.start_time + syl.end_time
+		nl.text = string.format("{\\an5\\pos(%d,%d)\\fscx%d}%s",
+			line.left + syl.center, line.middle, style.scale_x, syl.text_stripped)
+		result[#result + 1] = nl
+	end
+	return result
+end
+
+local function same(a, b)
+	if type(a) ~= "table" or type(b) ~= "table" then
+		return a == b
+	end
+	for k, v in pairs(a) do
+		if not same(v, b[k]) then return false end
+	end
+	for k in pairs(b) do
+		if a[k] == nil then return false end
+	end
+	return true
+end
+
+function test_parallel_map(subtitles, selected_lines, active_line)
+	local meta, styles = karaskel.collect_head(subtitles, false)
+	local shared = { meta = meta, styles = styles }
+
+	local lines = {}
+	for i, ri in ipairs(selected_lines) do
+		lines[i] = subtitles[ri]
+	end
+
+	local serial = {}
+	for i, line in ipairs(lines) do
+		serial[i] = syllable_lines(table.copy(line), shared)
+	end
+
+	local parallel = aegisub.parallel_map("syllable_lines", lines, shared)
+
+	if #serial ~= #parallel then
+		aegisub.debug.out("Result count differs: %d serial, %d parallel\n", #serial, #parallel)
+		return
+	end
+	for i = 1, #serial do
+		if not same(serial[i], parallel[i]) then
+			aegisub.debug.out("Results for selected line %d differ\n", i)
+			return
+		end
+	end
+	aegisub.debug.out("%d results match\n", #serial)
+end
+
+aegisub.register_macro("Test parallel_map", "Compare parallel_map to a serial run on the selected lines", test_parallel_map)
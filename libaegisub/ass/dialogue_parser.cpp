@@ -99,86 +99,76 @@ public:
 class WordSplitter {
 	std::string const& text;
 	std::vector<DialogueToken> &tokens;
+	/// The split tokens, built separately as inserting into the middle of
+	/// tokens is quadratic for lines with large drawings
+	std::vector<DialogueToken> out;
 	size_t pos = 0;
 
-	void SwitchTo(size_t &i, int type, size_t len) {
-		auto old = tokens[i];
-		tokens[i].type = type;
-		tokens[i].length = len;
-
-		if (old.length != (size_t)len) {
-			tokens.insert(tokens.begin() + i + 1, DialogueToken{old.type, old.length - len});
-			++i;
-		}
-	}
-
-	void SplitText(size_t &i) {
+	void SplitText(DialogueToken tok) {
 		using namespace boost::locale::boundary;
-		ssegment_index map(word, text.begin() + pos, text.begin() + pos + tokens[i].length);
+		size_t starti = out.size();
+		ssegment_index map(word, text.begin() + pos, text.begin() + pos + tok.length);
 		for (auto const& segment : map) {
 			auto len = static_cast<size_t>(distance(begin(segment), end(segment)));
-			if (segment.rule() & word_letters)
-				SwitchTo(i, dt::WORD, len);
-			else
-				SwitchTo(i, dt::TEXT, len);
+			out.push_back(DialogueToken{segment.rule() & word_letters ? dt::WORD : dt::TEXT, len});
 		}
+		if (out.size() == starti)
+			out.push_back(tok);
 	}
 
-	void SplitDrawing(size_t &i) {
-		size_t starti = i;
+	void SplitDrawing(DialogueToken tok) {
+		size_t starti = out.size();
 
 		// First, split into words
-		size_t dpos = pos;
-		size_t tlen = 0;
-		bool tokentype = text[pos] == ' ' || text[pos] == '\t';
-		while (tlen < tokens[i].length) {
-			bool newtype = text[dpos] == ' ' || text[dpos] == '\t';
-			if (newtype != tokentype) {
-				tokentype = newtype;
-				SwitchTo(i, tokentype ? dt::DRAWING_FULL : dt::WHITESPACE, tlen);
-				tokens[i].type = tokentype ? dt::WHITESPACE : dt::DRAWING_FULL;
-				tlen = 0;
+		auto is_space = [](char c) { return c == ' ' || c == '\t'; };
+		size_t run_start = pos;
+		for (size_t dpos = pos + 1; dpos < pos + tok.length; ++dpos) {
+			if (is_space(text[dpos]) != is_space(text[run_start])) {
+				out.push_back(DialogueToken{is_space(text[run_start]) ? dt::WHITESPACE : dt::DRAWING_FULL, dpos - run_start});
+				run_start = dpos;
 			}
-			++tlen;
-			++dpos;
 		}
+		// A drawing which is entirely whitespace stays a single DRAWING_FULL
+		// token and so is labeled as an error below
+		int last_type = out.size() == starti || !is_space(text[run_start]) ? dt::DRAWING_FULL : dt::WHITESPACE;
+		out.push_back(DialogueToken{last_type, pos + tok.length - run_start});
 
 		// Then, label all the tokens
-		dpos = pos;
+		size_t dpos = pos;
 		int num_coord = 0;
 		char lastcmd = ' ';
 
-		for (size_t j = starti; j <= i; j++) {
+		for (size_t j = starti; j < out.size(); j++) {
 			char c = text[dpos];
-			if (tokens[j].type == dt::WHITESPACE) {
+			if (out[j].type == dt::WHITESPACE) {
 			} else if (c == 'm' || c == 'n' || c == 'l' || c == 's' || c == 'b' || c == 'p' || c == 'c') {
-				tokens[j].type = dt::DRAWING_CMD;
+				out[j].type = dt::DRAWING_CMD;
 
-				if (tokens[j].length != 1)
-					tokens[j].type = dt::ERROR;
+				if (out[j].length != 1)
+					out[j].type = dt::ERROR;
 				if (num_coord % 2 != 0)
-					tokens[j].type = dt::ERROR;
+					out[j].type = dt::ERROR;
 
 				lastcmd = c;
 				num_coord = 0;
 			} else {
 				bool valid = true;
-				for (size_t k = 0; k < tokens[j].length; k++) {
+				for (size_t k = 0; k < out[j].length; k++) {
 					char c = text[dpos + k];
 					if (!((c >= '0' && c <= '9') || c == '.' || c == '+' || c == '-' || c == 'e' || c == 'E')) {
 						valid = false;
 					}
 				}
 				if (!valid)
-					tokens[j].type = dt::ERROR;
+					out[j].type = dt::ERROR;
 				else if (lastcmd == 'b' && num_coord % 6 >= 4)
-					tokens[j].type = num_coord % 2 == 0 ? dt::DRAWING_ENDPOINT_X : dt::DRAWING_ENDPOINT_Y;
+					out[j].type = num_coord % 2 == 0 ? dt::DRAWING_ENDPOINT_X : dt::DRAWING_ENDPOINT_Y;
 				else
-					tokens[j].type = num_coord % 2 == 0 ? dt::DRAWING_X : dt::DRAWING_Y;
+					out[j].type = num_coord % 2 == 0 ? dt::DRAWING_X : dt::DRAWING_Y;
 				++num_coord;
 			}
 
-			dpos += tokens[j].length;
+			dpos += out[j].length;
 		}
 	}
 
@@ -191,15 +181,17 @@ public:
 	void SplitWords() {
 		if (tokens.empty()) return;
 
-		for (size_t i = 0; i < tokens.size(); ++i) {
-			size_t len = tokens[i].length;
-			if (tokens[i].type == dt::TEXT)
-				SplitText(i);
-			else if (tokens[i].type == dt::DRAWING_FULL) {
-				SplitDrawing(i);
-			}
-			pos += len;
+		out.reserve(tokens.size());
+		for (auto tok : tokens) {
+			if (tok.type == dt::TEXT)
+				SplitText(tok);
+			else if (tok.type == dt::DRAWING_FULL)
+				SplitDrawing(tok);
+			else
+				out.push_back(tok);
+			pos += tok.length;
 		}
+		tokens = std::move(out);
 	}
 };
 }
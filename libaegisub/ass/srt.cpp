@@ -0,0 +1,640 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file srt.cpp
+/// @brief Parsing and formatting of SubRip and WebVTT subtitles
+/// @ingroup libaegisub
+
+#include "libaegisub/ass/srt.h"
+
+#include "libaegisub/color.h"
+#include "libaegisub/format.h"
+
+#include <algorithm>
+#include <boost/algorithm/string/replace.hpp>
+#include <climits>
+#include <cstring>
+
+namespace {
+using namespace agi::ass;
+
+bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+bool is_alpha(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+char to_lower(char c) {
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+/// A line of the file with the surrounding whitespace removed
+struct Line {
+	const char *begin = nullptr;
+	const char *end = nullptr;
+
+	size_t size() const { return end - begin; }
+	bool empty() const { return begin == end; }
+
+	bool starts_with(const char *prefix) const {
+		size_t len = strlen(prefix);
+		return size() >= len && !memcmp(begin, prefix, len);
+	}
+
+	/// Does the line start with the given word followed by whitespace or
+	/// the end of the line?
+	bool starts_with_word(const char *word) const {
+		size_t len = strlen(word);
+		return starts_with(word) && (size() == len || is_space(begin[len]));
+	}
+
+	bool contains(const char *needle) const {
+		return std::search(begin, end, needle, needle + strlen(needle)) != end;
+	}
+
+	bool all_digits() const {
+		return std::all_of(begin, end, is_digit);
+	}
+};
+
+/// Splits a buffer into lines the same way line_iterator does, including an
+/// empty final line if the buffer ends with a line break
+class LineReader {
+	const char *pos;
+	const char *end;
+	bool done = false;
+
+public:
+	int line_num = 0;
+
+	LineReader(const char *begin, const char *end) : pos(begin), end(end) {
+		if (end - pos >= 3 && !memcmp(pos, "\xef\xbb\xbf", 3))
+			pos += 3;
+	}
+
+	bool Next(Line& line) {
+		if (done) return false;
+
+		auto eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+		if (!eol) {
+			eol = end;
+			done = true;
+		}
+
+		line.begin = pos;
+		line.end = eol;
+		pos = eol + 1;
+		++line_num;
+
+		while (line.begin < line.end && is_space(*line.begin)) ++line.begin;
+		while (line.end > line.begin && is_space(line.end[-1])) --line.end;
+		return true;
+	}
+};
+
+/// Consume between min_digits and max_digits digits
+bool number(const char *&p, const char *end, size_t min_digits, size_t max_digits, int64_t& value) {
+	value = 0;
+	size_t count = 0;
+	for (; p < end && is_digit(*p) && count < max_digits; ++p, ++count)
+		value = value * 10 + (*p - '0');
+	return count >= min_digits;
+}
+
+bool expect(const char *&p, const char *end, char c) {
+	if (p >= end || *p != c) return false;
+	++p;
+	return true;
+}
+
+/// Consume the fractional seconds part of a timestamp. Digits past the
+/// third are ignored, as agi::Time does.
+bool fraction(const char *&p, const char *end, int64_t& ms) {
+	const char *start = p;
+	int weight = 100;
+	for (; p < end && is_digit(*p); ++p) {
+		ms += (*p - '0') * weight;
+		weight /= 10;
+	}
+	return p > start;
+}
+
+int clamp_time(int64_t ms) {
+	return static_cast<int>(std::min<int64_t>(ms, INT_MAX));
+}
+
+/// h:mm:ss,fff with one or two digits for each of hours, minutes and seconds
+bool subrip_time(const char *&p, const char *end, int& time) {
+	int64_t h, m, s;
+	if (!number(p, end, 1, 2, h) || !expect(p, end, ':')) return false;
+	if (!number(p, end, 1, 2, m) || !expect(p, end, ':')) return false;
+	if (!number(p, end, 1, 2, s) || !expect(p, end, ',')) return false;
+	int64_t ms = ((h * 60 + m) * 60 + s) * 1000;
+	if (!fraction(p, end, ms)) return false;
+	time = clamp_time(ms);
+	return true;
+}
+
+/// "start --> end", followed by anything
+bool subrip_timing(Line const& line, int& start, int& end) {
+	const char *p = line.begin;
+	if (!subrip_time(p, line.end, start)) return false;
+	if (line.end - p < 5 || memcmp(p, " --> ", 5)) return false;
+	p += 5;
+	return subrip_time(p, line.end, end);
+}
+
+/// [hh:]mm:ss.fff
+bool webvtt_time(const char *&p, const char *end, int& time) {
+	int64_t a, b, c = 0;
+	if (!number(p, end, 1, 9, a) || !expect(p, end, ':')) return false;
+	if (!number(p, end, 1, 2, b)) return false;
+	bool has_hours = expect(p, end, ':');
+	if (has_hours && !number(p, end, 1, 2, c)) return false;
+	if (!expect(p, end, '.') && !expect(p, end, ',')) return false;
+
+	int64_t ms = has_hours ? ((a * 60 + b) * 60 + c) * 1000 : (a * 60 + b) * 1000;
+	if (!fraction(p, end, ms)) return false;
+	time = clamp_time(ms);
+	return true;
+}
+
+/// "start --> end", optionally followed by cue settings
+bool webvtt_timing(Line const& line, int& start, int& end) {
+	const char *p = line.begin;
+	if (!webvtt_time(p, line.end, start)) return false;
+	while (p < line.end && is_space(*p)) ++p;
+	if (line.end - p < 3 || memcmp(p, "-->", 3)) return false;
+	p += 3;
+	while (p < line.end && is_space(*p)) ++p;
+	return webvtt_time(p, line.end, end);
+}
+
+// See parsing algorithm at <http://devel.aegisub.org/wiki/SubtitleFormats/SRT>
+enum class ParseState {
+	INITIAL,
+	TIMESTAMP,
+	FIRST_LINE_OF_BODY,
+	REST_OF_BODY,
+	LAST_WAS_BLANK
+};
+
+std::vector<SrtCue> parse_subrip(LineReader& lines) {
+	std::vector<SrtCue> cues;
+	ParseState state = ParseState::INITIAL;
+	int linebreak_debt = 0;
+	int start = 0, end = 0;
+
+	Line line;
+	while (lines.Next(line)) {
+		bool found_timestamps = false;
+		switch (state) {
+			case ParseState::INITIAL:
+				// ignore leading blank lines
+				if (line.empty()) break;
+				if (line.all_digits()) {
+					// found the line number, throw it away and hope for timestamps
+					state = ParseState::TIMESTAMP;
+					break;
+				}
+				if (subrip_timing(line, start, end)) {
+					found_timestamps = true;
+					break;
+				}
+
+				throw SrtParseError(agi::format("Parsing SRT: Expected subtitle index at line %d", lines.line_num));
+
+			case ParseState::TIMESTAMP:
+				if (!subrip_timing(line, start, end))
+					throw SrtParseError(agi::format("Parsing SRT: Expected timestamp pair at line %d", lines.line_num));
+
+				found_timestamps = true;
+				break;
+
+			case ParseState::FIRST_LINE_OF_BODY:
+				if (line.empty()) {
+					// that's not very interesting... blank subtitle?
+					state = ParseState::LAST_WAS_BLANK;
+					// no previous line that needs a line break after
+					linebreak_debt = 0;
+					break;
+				}
+				cues.back().text.append(line.begin, line.end);
+				state = ParseState::REST_OF_BODY;
+				break;
+
+			case ParseState::REST_OF_BODY:
+				if (line.empty()) {
+					// Might be either the gap between two subtitles or just a
+					// blank line in the middle of a subtitle, so defer adding
+					// the line break until we check what's on the next line
+					state = ParseState::LAST_WAS_BLANK;
+					linebreak_debt = 1;
+					break;
+				}
+				cues.back().text.append("\\N");
+				cues.back().text.append(line.begin, line.end);
+				break;
+
+			case ParseState::LAST_WAS_BLANK:
+				++linebreak_debt;
+				if (line.empty()) break;
+				if (line.all_digits()) {
+					// Hopefully it's the start of a new subtitle, and the
+					// previous blank line(s) were the gap between subtitles
+					state = ParseState::TIMESTAMP;
+					break;
+				}
+				if (subrip_timing(line, start, end)) {
+					found_timestamps = true;
+					break;
+				}
+
+				// assume it's a continuation of the subtitle text
+				// resolve our line break debt and append the line text
+				while (linebreak_debt-- > 0)
+					cues.back().text.append("\\N");
+				cues.back().text.append(line.begin, line.end);
+				state = ParseState::REST_OF_BODY;
+				break;
+		}
+
+		if (found_timestamps) {
+			cues.emplace_back();
+			cues.back().start = start;
+			cues.back().end = end;
+			state = ParseState::FIRST_LINE_OF_BODY;
+		}
+	}
+
+	if (state == ParseState::TIMESTAMP || state == ParseState::FIRST_LINE_OF_BODY)
+		throw SrtParseError("Parsing SRT: Incomplete file");
+
+	return cues;
+}
+
+std::vector<SrtCue> parse_webvtt(LineReader& lines) {
+	Line line;
+	if (!lines.Next(line) || !line.starts_with_word("WEBVTT"))
+		throw SrtParseError("Parsing WebVTT: File does not start with WEBVTT");
+
+	// Skip the rest of the header
+	while (lines.Next(line) && !line.empty()) { }
+
+	std::vector<SrtCue> cues;
+	std::vector<Line> block;
+	auto finish_block = [&] {
+		if (block.empty()) return;
+		auto const& first = block.front();
+		// Comments, style sheets and regions aren't supported
+		if (first.starts_with_word("NOTE") || first.starts_with_word("STYLE") || first.starts_with_word("REGION"))
+			return block.clear();
+
+		// Cues may have an identifier before the timing line
+		size_t timing = first.contains("-->") ? 0 : 1;
+		SrtCue cue;
+		if (timing >= block.size() || !webvtt_timing(block[timing], cue.start, cue.end))
+			return block.clear();
+
+		for (size_t i = timing + 1; i < block.size(); ++i) {
+			if (i > timing + 1)
+				cue.text.append("\\N");
+			cue.text.append(block[i].begin, block[i].end);
+		}
+		cues.push_back(std::move(cue));
+		block.clear();
+	};
+
+	while (lines.Next(line)) {
+		if (line.empty())
+			finish_block();
+		else
+			block.push_back(line);
+	}
+	finish_block();
+
+	return cues;
+}
+
+struct ToggleTag {
+	char tag;
+	int level = 0;
+
+	ToggleTag(char tag) : tag(tag) { }
+
+	void Open(std::string& out) {
+		if (level == 0) {
+			out += "{\\";
+			out += tag;
+			out += "1}";
+		}
+		++level;
+	}
+
+	void Close(std::string& out) {
+		if (level == 1) {
+			out += "{\\";
+			out += tag;
+			out += '}';
+		}
+		if (level > 0)
+			--level;
+	}
+
+	void Toggle(std::string& out, bool close) {
+		if (close)
+			Close(out);
+		else
+			Open(out);
+	}
+};
+
+struct FontAttribs {
+	std::string face;
+	std::string size;
+	std::string color;
+};
+
+/// Case-insensitively match an attribute name followed by '='
+bool attrib_name(std::string const& attrs, size_t& pos, const char *name) {
+	size_t len = strlen(name);
+	if (attrs.size() - pos < len + 1) return false;
+	for (size_t i = 0; i < len; ++i) {
+		if (to_lower(attrs[pos + i]) != name[i]) return false;
+	}
+	if (attrs[pos + len] != '=') return false;
+	pos += len + 1;
+	return true;
+}
+
+/// Read the face, size and color attributes of a font tag. Like the regular
+/// expression this replaces, stops at the first thing which isn't one of
+/// those attributes.
+void parse_font_attribs(std::string const& attrs, FontAttribs& out) {
+	size_t pos = 0;
+	while (pos < attrs.size()) {
+		size_t start = pos;
+		while (pos < attrs.size() && is_space(attrs[pos])) ++pos;
+		if (pos == start) return;
+
+		std::string *target;
+		const char *format;
+		bool is_color = false;
+		if (attrib_name(attrs, pos, "face")) {
+			target = &out.face;
+			format = "{\\fn%s}";
+		}
+		else if (attrib_name(attrs, pos, "size")) {
+			target = &out.size;
+			format = "{\\fs%s}";
+		}
+		else if (attrib_name(attrs, pos, "color")) {
+			target = &out.color;
+			format = "{\\c%s}";
+			is_color = true;
+		}
+		else
+			return;
+
+		std::string value;
+		char quote = pos < attrs.size() ? attrs[pos] : 0;
+		size_t close = std::string::npos;
+		if (quote == '\'' || quote == '"')
+			close = attrs.find(quote, pos + 1);
+		if (close != std::string::npos) {
+			value = attrs.substr(pos + 1, close - pos - 1);
+			pos = close + 1;
+		}
+		else {
+			start = pos;
+			while (pos < attrs.size() && !is_space(attrs[pos])) ++pos;
+			if (pos == start) return;
+			value = attrs.substr(start, pos - start);
+		}
+
+		if (is_color)
+			value = agi::Color(value).GetAssOverrideFormatted();
+		*target = agi::format(format, value);
+	}
+}
+
+std::string subrip_to_ass(std::string const& srt) {
+	ToggleTag bold('b');
+	ToggleTag italic('i');
+	ToggleTag underline('u');
+	ToggleTag strikeout('s');
+	std::vector<FontAttribs> font_stack;
+
+	std::string ass;
+	ass.reserve(srt.size());
+
+	size_t pos = 0;
+	size_t gt = 0;
+	while (pos < srt.size()) {
+		size_t lt = srt.find('<', pos);
+		if (lt == std::string::npos) break;
+		if (gt <= lt) {
+			gt = srt.find('>', lt);
+			// no more tags can be closed, so the rest is all text
+			if (gt == std::string::npos) break;
+		}
+
+		size_t name_begin = lt + 1;
+		bool close = srt[name_begin] == '/';
+		if (close) ++name_begin;
+		size_t name_end = name_begin;
+		while (name_end < gt && is_alpha(srt[name_end])) ++name_end;
+
+		std::string name;
+		name.reserve(name_end - name_begin);
+		for (size_t i = name_begin; i < name_end; ++i)
+			name += to_lower(srt[i]);
+
+		char next = srt[name_end];
+		bool known = name == "b" || name == "i" || name == "u" || name == "s" || name == "font";
+		if (!known || (next != '>' && next != '/' && !is_space(next))) {
+			// not a tag we understand, so it's just text
+			ass.append(srt, pos, lt + 1 - pos);
+			pos = lt + 1;
+			continue;
+		}
+
+		// the text before the tag goes through unchanged
+		ass.append(srt, pos, lt - pos);
+		pos = gt + 1;
+
+		switch (name[0]) {
+			case 'b': bold.Toggle(ass, close);      break;
+			case 'i': italic.Toggle(ass, close);    break;
+			case 'u': underline.Toggle(ass, close); break;
+			case 's': strikeout.Toggle(ass, close); break;
+			case 'f':
+				if (!close) {
+					// start out with any previous attributes on the stack
+					FontAttribs old_attribs;
+					if (!font_stack.empty())
+						old_attribs = font_stack.back();
+					FontAttribs new_attribs = old_attribs;
+					parse_font_attribs(srt.substr(name_end, gt - name_end), new_attribs);
+
+					// the attributes changed from old are then written out
+					if (new_attribs.face != old_attribs.face)
+						ass.append(new_attribs.face);
+					if (new_attribs.size != old_attribs.size)
+						ass.append(new_attribs.size);
+					if (new_attribs.color != old_attribs.color)
+						ass.append(new_attribs.color);
+
+					font_stack.push_back(std::move(new_attribs));
+				}
+				else if (!font_stack.empty()) {
+					FontAttribs cur_attribs = std::move(font_stack.back());
+					font_stack.pop_back();
+					FontAttribs old_attribs;
+					if (!font_stack.empty())
+						old_attribs = font_stack.back();
+
+					// restore the attributes to the previous settings
+					if (cur_attribs.face != old_attribs.face)
+						ass.append(old_attribs.face.empty() ? "{\\fn}" : old_attribs.face);
+					if (cur_attribs.size != old_attribs.size)
+						ass.append(old_attribs.size.empty() ? "{\\fs}" : old_attribs.size);
+					if (cur_attribs.color != old_attribs.color)
+						ass.append(old_attribs.color.empty() ? "{\\c}" : old_attribs.color);
+				}
+				break;
+		}
+	}
+
+	if (pos < srt.size())
+		ass.append(srt, pos, std::string::npos);
+
+	// make it a little prettier, join tag groups
+	boost::replace_all(ass, "}{", "");
+
+	return ass;
+}
+
+struct Entity {
+	const char *name;
+	const char *replacement;
+};
+
+const Entity entities[] = {
+	{"amp;", "&"},
+	{"lt;", "<"},
+	{"gt;", ">"},
+	{"nbsp;", "\\h"},
+	{"lrm;", "\xe2\x80\x8e"},
+	{"rlm;", "\xe2\x80\x8f"},
+};
+
+std::string webvtt_to_ass(std::string const& vtt) {
+	ToggleTag bold('b');
+	ToggleTag italic('i');
+	ToggleTag underline('u');
+
+	std::string ass;
+	ass.reserve(vtt.size());
+
+	for (size_t i = 0; i < vtt.size(); ) {
+		if (vtt[i] == '<') {
+			size_t gt = vtt.find('>', i);
+			// an unterminated tag runs to the end of the cue
+			if (gt == std::string::npos) break;
+
+			size_t name_begin = i + 1;
+			bool close = vtt[name_begin] == '/';
+			if (close) ++name_begin;
+			size_t name_end = name_begin;
+			while (name_end < gt && vtt[name_end] != '.' && !is_space(vtt[name_end])) ++name_end;
+
+			// Classes, voices, ruby text and timestamps have no equivalent
+			// and are dropped
+			if (name_end - name_begin == 1) {
+				switch (vtt[name_begin]) {
+					case 'b': bold.Toggle(ass, close);      break;
+					case 'i': italic.Toggle(ass, close);    break;
+					case 'u': underline.Toggle(ass, close); break;
+				}
+			}
+			i = gt + 1;
+			continue;
+		}
+
+		if (vtt[i] == '&') {
+			auto entity = std::find_if(std::begin(entities), std::end(entities), [&](Entity const& e) {
+				return !vtt.compare(i + 1, strlen(e.name), e.name);
+			});
+			if (entity != std::end(entities)) {
+				ass += entity->replacement;
+				i += 1 + strlen(entity->name);
+				continue;
+			}
+		}
+
+		ass += vtt[i++];
+	}
+
+	boost::replace_all(ass, "}{", "");
+	return ass;
+}
+}
+
+namespace agi { namespace ass {
+std::vector<SrtCue> ParseSrt(const char *begin, const char *end, SrtDialect dialect) {
+	LineReader lines(begin, end);
+	if (dialect == SrtDialect::WebVtt)
+		return parse_webvtt(lines);
+	return parse_subrip(lines);
+}
+
+std::string SrtToAss(std::string const& text, SrtDialect dialect) {
+	if (dialect == SrtDialect::WebVtt)
+		return webvtt_to_ass(text);
+	return subrip_to_ass(text);
+}
+
+std::string SrtTime(int ms, SrtDialect dialect) {
+	ms = std::max(ms, 0);
+	int h = ms / 3600000;
+	int m = ms / 60000 % 60;
+	int s = ms / 1000 % 60;
+	return agi::format(dialect == SrtDialect::WebVtt ? "%02d:%02d:%02d.%03d" : "%02d:%02d:%02d,%03d",
+		h, m, s, ms % 1000);
+}
+
+std::string EscapeWebVtt(std::string const& text) {
+	std::string ret;
+	ret.reserve(text.size());
+	for (char c : text) {
+		switch (c) {
+			case '&': ret += "&amp;"; break;
+			case '<': ret += "&lt;";  break;
+			case '>': ret += "&gt;";  break;
+			default:  ret += c;
+		}
+	}
+	return ret;
+}
+} }
@@ -0,0 +1,121 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file transform.cpp
+/// @brief Per-line arithmetic of the resolution and framerate transforms
+/// @ingroup libaegisub
+
+#include "libaegisub/ass/transform.h"
+
+#include "libaegisub/split.h"
+#include "libaegisub/util.h"
+
+#include <cctype>
+#include <cmath>
+
+namespace {
+/// Truncate a time to centisecond precision
+int trunc_cs(int time) {
+	return (time / 10) * 10;
+}
+}
+
+namespace agi { namespace ass {
+std::string TransformDrawing(std::string const& drawing, int shift_x, int shift_y, double scale_x, double scale_y) {
+	bool is_x = true;
+	std::string final;
+	final.reserve(drawing.size());
+
+	for (auto const& cur : agi::Split(drawing, ' ')) {
+		double val;
+		if (agi::util::try_parse(agi::str(cur), &val)) {
+			if (is_x)
+				val = (val + shift_x) * scale_x;
+			else
+				val = (val + shift_y) * scale_y;
+			val = round(val * 8) / 8.0; // round to eighth-pixels
+			final += agi::util::float_to_string(val);
+			final += ' ';
+			is_x = !is_x;
+		}
+		else if (cur.size() == 1) {
+			char c = tolower(cur[0]);
+			if (c == 'm' || c == 'n' || c == 'l' || c == 'b' || c == 's' || c == 'p' || c == 'c') {
+				is_x = true;
+				final += c;
+				final += ' ';
+			}
+		}
+	}
+
+	if (final.size())
+		final.pop_back();
+	return final;
+}
+
+FramerateTransform::FramerateTransform(vfr::Framerate from, vfr::Framerate to)
+: from(std::move(from))
+, to(std::move(to))
+{
+}
+
+int FramerateTransform::ConvertTime(int time) const {
+	int frame = from.FrameAtTime(time);
+	int frameStart = from.TimeAtFrame(frame);
+	int frameEnd = from.TimeAtFrame(frame + 1);
+	int frameDur = frameEnd - frameStart;
+	double dist = double(time - frameStart) / frameDur;
+
+	int newStart = to.TimeAtFrame(frame);
+	int newEnd = to.TimeAtFrame(frame + 1);
+	int newDur = newEnd - newStart;
+
+	return newStart + newDur * dist;
+}
+
+FramerateTransform::Line::Line(FramerateTransform const& transform, int start, int end)
+: transform(transform)
+, start(start)
+, end(end)
+, new_start(trunc_cs(transform.ConvertTime(start)))
+, new_end(trunc_cs(transform.ConvertTime(end) + 9))
+{
+}
+
+int FramerateTransform::Line::RelativeToStart(int value) {
+	int ret = transform.ConvertTime(trunc_cs(start) + value) - new_start;
+
+	// An end time of 0 is actually the end time of the line, so ensure
+	// nonzero is never converted to 0
+	// Needed here rather than the end case because start/end here mean
+	// which end of the line the time is relative to, not whether it's
+	// the start or end time (compare \move and \fad)
+	if (ret == 0 && value != 0) ret = 1;
+	return ret;
+}
+
+int FramerateTransform::Line::RelativeToEnd(int value) {
+	return new_end - transform.ConvertTime(trunc_cs(end) - value);
+}
+
+int FramerateTransform::Line::Karaoke(int value) {
+	int k_start = start / 10 + old_k + value;
+	int ret = (transform.ConvertTime(k_start * 10) - new_start) / 10 - new_k;
+	old_k += value;
+	new_k += ret;
+	return ret;
+}
+} }
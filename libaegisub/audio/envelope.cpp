@@ -0,0 +1,178 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/envelope.h"
+
+#include "libaegisub/audio/provider.h"
+#include "libaegisub/exception.h"
+#include "libaegisub/make_unique.h"
+#include "libaegisub/trace.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+/// Levels are stored as half-decibels above this
+const double floor_db = -96.;
+
+/// Speech starts when the level rises this far above the noise floor...
+const int onset_threshold = 12 * agi::EnergyEnvelope::steps_per_db;
+/// ...and continues until it drops below this
+const int offset_threshold = 6 * agi::EnergyEnvelope::steps_per_db;
+/// Number of quiet windows required to end a segment, so that the short
+/// gaps between words don't split a line's speech into pieces
+const size_t hangover_windows = 15;
+/// Segments shorter than this many windows are clicks and the like
+const size_t min_speech_windows = 5;
+
+/// Number of windows to read from the provider at a time
+const size_t windows_per_block = 100;
+
+uint8_t level_for(double sum_squares, int64_t count) {
+	if (count <= 0 || sum_squares <= 0) return 0;
+	double rms = std::sqrt(sum_squares / count) / 32768.;
+	double db = 20. * std::log10(rms);
+	double level = (db - floor_db) * agi::EnergyEnvelope::steps_per_db;
+	return static_cast<uint8_t>(std::max(0., std::min(255., std::round(level))));
+}
+
+int nearest(std::vector<int> const& times, int ms, int max_distance) {
+	auto it = std::lower_bound(begin(times), end(times), ms);
+	int best = -1;
+	int best_distance = max_distance + 1;
+	if (it != end(times) && *it - ms < best_distance) {
+		best = *it;
+		best_distance = *it - ms;
+	}
+	if (it != begin(times) && ms - *std::prev(it) < best_distance)
+		best = *std::prev(it);
+	return best;
+}
+}
+
+namespace agi {
+EnergyEnvelope::EnergyEnvelope(std::vector<uint8_t> levels)
+: levels(std::move(levels))
+{
+	Segment();
+}
+
+void EnergyEnvelope::Segment() {
+	if (levels.empty()) return;
+
+	// Use a low percentile of the levels as the noise floor, as even very
+	// talky content has a fair amount of silence between lines
+	std::array<size_t, 256> histogram{};
+	for (auto level : levels)
+		++histogram[level];
+	int noise_floor = 0;
+	for (size_t seen = 0; noise_floor < 255; ++noise_floor) {
+		seen += histogram[noise_floor];
+		if (seen * 10 >= levels.size()) break;
+	}
+
+	const int on = noise_floor + onset_threshold;
+	const int off = noise_floor + offset_threshold;
+
+	auto add_segment = [&](size_t start, size_t end) {
+		if (end - start < min_speech_windows) return;
+		onsets.push_back(static_cast<int>(start) * window_ms);
+		offsets.push_back(static_cast<int>(end) * window_ms);
+	};
+
+	bool in_speech = false;
+	size_t start = 0;
+	size_t last_loud = 0;
+	for (size_t i = 0; i < levels.size(); ++i) {
+		if (!in_speech) {
+			if (levels[i] < on) continue;
+
+			// Walk back to where the level first rose above the offset
+			// threshold to include the attack of the syllable
+			start = i;
+			size_t limit = onsets.empty() ? 0 : offsets.back() / window_ms;
+			while (start > limit && levels[start - 1] >= off)
+				--start;
+			in_speech = true;
+			last_loud = i;
+		}
+		else if (levels[i] >= off)
+			last_loud = i;
+		else if (i - last_loud > hangover_windows) {
+			add_segment(start, last_loud + 1);
+			in_speech = false;
+		}
+	}
+	if (in_speech)
+		add_segment(start, last_loud + 1);
+}
+
+std::unique_ptr<EnergyEnvelope> EnergyEnvelope::Compute(AudioProvider const& provider, std::function<bool ()> const& cancelled) {
+	AGI_TRACE_SCOPE("audio", "EnergyEnvelope::Compute");
+
+	const int64_t sample_rate = provider.GetSampleRate();
+	const int64_t num_samples = provider.GetNumSamples();
+	auto window_start = [&](size_t window) {
+		return static_cast<int64_t>(window) * sample_rate * window_ms / 1000;
+	};
+
+	size_t window_count = 0;
+	while (window_start(window_count) < num_samples)
+		++window_count;
+
+	std::vector<uint8_t> levels;
+	levels.reserve(window_count);
+	std::vector<int16_t> buffer;
+
+	for (size_t block = 0; block < window_count; block += windows_per_block) {
+		size_t block_end = std::min(window_count, block + windows_per_block);
+		int64_t first = window_start(block);
+		int64_t last = std::min(num_samples, window_start(block_end));
+
+		// Wait for the cache to catch up if it's still decoding
+		while (provider.GetDecodedSamples() < last) {
+			if (cancelled()) throw UserCancelException("Energy envelope computation cancelled");
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		if (cancelled()) throw UserCancelException("Energy envelope computation cancelled");
+
+		buffer.resize(static_cast<size_t>(last - first));
+		provider.GetInt16MonoAudioUncached(buffer.data(), first, last - first);
+
+		for (size_t window = block; window < block_end; ++window) {
+			int64_t begin = window_start(window) - first;
+			int64_t end = std::min(last, window_start(window + 1)) - first;
+			double sum = 0;
+			for (int64_t i = begin; i < end; ++i)
+				sum += double(buffer[i]) * buffer[i];
+			levels.push_back(level_for(sum, end - begin));
+		}
+	}
+
+	return agi::make_unique<EnergyEnvelope>(std::move(levels));
+}
+
+int EnergyEnvelope::NearestOnset(int ms, int max_distance) const {
+	return nearest(onsets, ms, max_distance);
+}
+
+int EnergyEnvelope::NearestOffset(int ms, int max_distance) const {
+	return nearest(offsets, ms, max_distance);
+}
+}
@@ -19,6 +19,7 @@
 #include "libaegisub/fs.h"
 #include "libaegisub/io.h"
 #include "libaegisub/log.h"
+#include "libaegisub/trace.h"
 #include "libaegisub/util.h"
 
 namespace {
@@ -74,12 +75,22 @@ public:
 
 namespace agi {
 void AudioProvider::FillBufferInt16Mono(int16_t* buf, int64_t start, int64_t count) const {
+	FillInt16Mono(buf, start, count, false);
+}
+
+void AudioProvider::FillInt16Mono(int16_t* buf, int64_t start, int64_t count, bool uncached) const {
+	auto fill = [&](void *dst) {
+		if (uncached)
+			FillBufferUncached(dst, start, count);
+		else
+			FillBuffer(dst, start, count);
+	};
 	if (!float_samples && bytes_per_sample == 2 && channels == 1) {
-		FillBuffer(buf, start, count);
+		fill(buf);
 		return;
 	}
 	void* buff = malloc(bytes_per_sample * count * channels);
-	FillBuffer(buff, start, count);
+	fill(buff);
 	if (channels == 1) {
 		if (float_samples) {
 			if (bytes_per_sample == sizeof(float))
@@ -178,6 +189,8 @@ void AudioProvider::ZeroFill(void *buf, int64_t count) const {
 }
 
 void AudioProvider::GetAudio(void *buf, int64_t start, int64_t count) const {
+	AGI_TRACE_SCOPE("audio", "GetAudio");
+
 	if (start < 0) {
 		ZeroFill(buf, std::min(-start, count));
 		buf = static_cast<char *>(buf) + -start * bytes_per_sample * channels;
@@ -211,6 +224,16 @@ void AudioProvider::GetAudio(void *buf, int64_t start, int64_t count) const {
 }
 
 void AudioProvider::GetInt16MonoAudio(int16_t* buf, int64_t start, int64_t count) const {
+	AGI_TRACE_SCOPE("audio", "GetInt16MonoAudio");
+	GetInt16Mono(buf, start, count, false);
+}
+
+void AudioProvider::GetInt16MonoAudioUncached(int16_t* buf, int64_t start, int64_t count) const {
+	AGI_TRACE_SCOPE("audio", "GetInt16MonoAudioUncached");
+	GetInt16Mono(buf, start, count, true);
+}
+
+void AudioProvider::GetInt16Mono(int16_t* buf, int64_t start, int64_t count, bool uncached) const {
 	if (start < 0) {
 		memset(buf, 0, sizeof(int16_t) * std::min(-start, count));
 		buf -= start;
@@ -227,7 +250,10 @@ void AudioProvider::GetInt16MonoAudio(int16_t* buf, int64_t start, int64_t count
 	if (count <= 0) return;
 
 	try {
-		FillBufferInt16Mono(buf, start, count);
+		if (uncached)
+			FillInt16Mono(buf, start, count, true);
+		else
+			FillBufferInt16Mono(buf, start, count);
 	}
 	catch (AudioDecodeError const& e) {
 		// We don't have any good way to report errors here, so just log the
@@ -0,0 +1,234 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include "libaegisub/audio/provider.h"
+
+#include "libaegisub/log.h"
+#include "libaegisub/make_unique.h"
+#include "libaegisub/trace.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+using namespace agi;
+
+/// Samples per channel in each cached block
+const int64_t block_samples = 1 << 16;
+
+class BlockCacheAudioProvider final : public AudioProviderWrapper {
+	struct Block {
+		std::vector<char> data;
+		/// Position of this block in lru
+		std::list<size_t>::iterator lru_pos;
+	};
+
+	/// Protects everything below other than source_lock
+	mutable std::mutex lock;
+	mutable std::unordered_map<size_t, Block> blocks;
+	/// Indices of cached blocks, most recently used first
+	mutable std::list<size_t> lru;
+	mutable AudioCacheStats stats;
+
+	/// Range of blocks which the prefetch thread should decode
+	mutable size_t prefetch_begin = 0;
+	mutable size_t prefetch_end = 0;
+	mutable std::condition_variable prefetch_cv;
+	bool stop = false;
+
+	/// Held while decoding, as most sources can't decode two things at once
+	mutable std::mutex source_lock;
+	std::thread prefetcher;
+
+	size_t BlockCount() const {
+		return static_cast<size_t>((num_samples + block_samples - 1) / block_samples);
+	}
+
+	std::vector<char> Decode(size_t i) const {
+		AGI_TRACE_SCOPE("audio", "BlockCache::Decode");
+		int64_t start = i * block_samples;
+		int64_t count = std::min(block_samples, num_samples - start);
+		std::vector<char> data(static_cast<size_t>(count * bytes_per_sample * channels));
+
+		std::lock_guard<std::mutex> l(source_lock);
+		source->GetAudio(data.data(), start, count);
+		return data;
+	}
+
+	/// Add a decoded block to the cache, discarding the least recently used
+	/// blocks to make room. lock must be held.
+	Block& Insert(size_t i, std::vector<char> data) const {
+		auto it = blocks.find(i);
+		if (it != blocks.end()) // Decoded by another thread at the same time
+			return it->second;
+
+		while (!lru.empty() && stats.bytes + data.size() > stats.max_bytes) {
+			auto& victim = blocks[lru.back()];
+			stats.bytes -= victim.data.size();
+			++stats.evictions;
+			blocks.erase(lru.back());
+			lru.pop_back();
+		}
+
+		stats.bytes += data.size();
+		lru.push_front(i);
+		auto& block = blocks[i];
+		block.data = std::move(data);
+		block.lru_pos = lru.begin();
+		return block;
+	}
+
+	void CopyFromBlock(char *dst, size_t i, int64_t offset, int64_t count) const {
+		const int64_t frame_size = bytes_per_sample * channels;
+
+		std::unique_lock<std::mutex> l(lock);
+		auto it = blocks.find(i);
+		Block *block;
+		if (it == blocks.end()) {
+			++stats.misses;
+			l.unlock();
+			auto data = Decode(i);
+			l.lock();
+			block = &Insert(i, std::move(data));
+		}
+		else {
+			++stats.hits;
+			block = &it->second;
+			lru.splice(lru.begin(), lru, block->lru_pos);
+		}
+
+		memcpy(dst, &block->data[offset * frame_size], count * frame_size);
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto charbuf = static_cast<char *>(buf);
+		while (count > 0) {
+			auto offset = start % block_samples;
+			auto read = std::min(count, block_samples - offset);
+			CopyFromBlock(charbuf, start / block_samples, offset, read);
+			charbuf += read * bytes_per_sample * channels;
+			start += read;
+			count -= read;
+		}
+	}
+
+	/// Read blocks which are already cached from the cache and everything
+	/// else straight from the source, so that a pass over the whole file
+	/// doesn't evict the blocks around what's being worked on
+	void FillBufferUncached(void *buf, int64_t start, int64_t count) const override {
+		const int64_t frame_size = bytes_per_sample * channels;
+		auto charbuf = static_cast<char *>(buf);
+		while (count > 0) {
+			auto offset = start % block_samples;
+			auto read = std::min(count, block_samples - offset);
+			{
+				std::unique_lock<std::mutex> l(lock);
+				auto it = blocks.find(static_cast<size_t>(start / block_samples));
+				if (it != blocks.end()) {
+					++stats.hits;
+					memcpy(charbuf, &it->second.data[offset * frame_size], read * frame_size);
+				}
+				else {
+					++stats.uncached;
+					l.unlock();
+					std::lock_guard<std::mutex> sl(source_lock);
+					source->GetAudio(charbuf, start, read);
+				}
+			}
+			charbuf += read * frame_size;
+			start += read;
+			count -= read;
+		}
+	}
+
+	void RunPrefetch() {
+		std::unique_lock<std::mutex> l(lock);
+		while (true) {
+			prefetch_cv.wait(l, [&] { return stop || prefetch_begin < prefetch_end; });
+			if (stop) return;
+
+			size_t i = prefetch_begin++;
+			if (blocks.count(i)) continue;
+
+			l.unlock();
+			auto data = Decode(i);
+			l.lock();
+			Insert(i, std::move(data));
+			++stats.prefetched;
+		}
+	}
+
+public:
+	BlockCacheAudioProvider(std::unique_ptr<AudioProvider> src, size_t max_bytes)
+	: AudioProviderWrapper(std::move(src))
+	{
+		// Everything is available; it just may have to be decoded first
+		decoded_samples = num_samples;
+		stats.max_bytes = max_bytes;
+		prefetcher = std::thread([&] { RunPrefetch(); });
+	}
+
+	~BlockCacheAudioProvider() {
+		{
+			std::lock_guard<std::mutex> l(lock);
+			stop = true;
+		}
+		prefetch_cv.notify_one();
+		prefetcher.join();
+
+		LOG_D("audio/cache/block") << stats.hits << " hits, " << stats.misses
+			<< " misses, " << stats.prefetched << " prefetched, "
+			<< stats.evictions << " evicted, " << stats.uncached << " read uncached";
+	}
+
+	void Prefetch(int64_t start, int64_t count) const override {
+		start = std::max<int64_t>(0, start);
+		count = std::min(count, num_samples - start);
+		if (count <= 0) return;
+
+		// Never prefetch more than half the cache so that a prefetch can't
+		// evict the blocks around whatever's currently being used
+		const size_t block_size = block_samples * bytes_per_sample * channels;
+		size_t first = static_cast<size_t>(start / block_samples);
+		size_t last = static_cast<size_t>((start + count + block_samples - 1) / block_samples);
+		last = std::min({last, BlockCount(), first + std::max<size_t>(1, stats.max_bytes / 2 / block_size)});
+
+		{
+			// Replaces any previous request, as whatever it was for is no
+			// longer what's being looked at
+			std::lock_guard<std::mutex> l(lock);
+			prefetch_begin = first;
+			prefetch_end = last;
+		}
+		prefetch_cv.notify_one();
+	}
+
+	AudioCacheStats GetCacheStats() const override {
+		std::lock_guard<std::mutex> l(lock);
+		return stats;
+	}
+};
+}
+
+namespace agi {
+std::unique_ptr<AudioProvider> CreateBlockCacheAudioProvider(std::unique_ptr<AudioProvider> src, size_t max_bytes) {
+	return agi::make_unique<BlockCacheAudioProvider>(std::move(src), max_bytes);
+}
+}
@@ -22,9 +22,15 @@
 #include <unicode/uchar.h>
 #include <unicode/utf8.h>
 
-#include <mutex>
+#include <algorithm>
+#include <memory>
 #include <unicode/brkiter.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGI_CHARACTER_COUNT_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace {
 struct utext_deleter {
 	void operator()(UText *ut) { if (ut) utext_close(ut); }
@@ -34,13 +40,14 @@ using utext_ptr = std::unique_ptr<UText, utext_deleter>;
 UChar32 ass_special_chars[] = {'n', 'N', 'h'};
 
 icu::BreakIterator& get_break_iterator(const char *ptr, size_t len) {
-	static std::unique_ptr<icu::BreakIterator> bi;
-	static std::once_flag token;
-	std::call_once(token, [&] {
+	// Break iterators hold the text being iterated over, so each thread needs
+	// its own
+	thread_local std::unique_ptr<icu::BreakIterator> bi;
+	if (!bi) {
 		UErrorCode status = U_ZERO_ERROR;
 		bi.reset(icu::BreakIterator::createCharacterInstance(icu::Locale::getDefault(), status));
 		if (U_FAILURE(status)) throw agi::InternalError("Failed to create character iterator");
-	});
+	}
 
 	UErrorCode err = U_ZERO_ERROR;
 	utext_ptr ut(utext_openUTF8(nullptr, ptr, len, &err));
@@ -52,10 +59,76 @@ icu::BreakIterator& get_break_iterator(const char *ptr, size_t len) {
 	return *bi;
 }
 
+/// Check if text is valid UTF-8 made up only of code points below U+0300
+///
+/// Every such code point is a grapheme cluster on its own other than CR LF,
+/// as the first combining marks are at U+0300, so text like this can be
+/// counted without the break iterator. This covers ASCII and most
+/// Latin-script text.
+bool is_simple(const char *ptr, const char *end) {
+	while (ptr < end) {
+#ifdef AGI_CHARACTER_COUNT_SSE2
+		while (end - ptr >= 16 && !_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr))))
+			ptr += 16;
+		if (ptr == end) break;
+#endif
+		auto c = static_cast<unsigned char>(*ptr);
+		if (c < 0x80) {
+			++ptr;
+			continue;
+		}
+		// Two-byte sequences for U+0080 to U+02FF
+		if (c < 0xC2 || c > 0xCB || end - ptr < 2 || (static_cast<unsigned char>(ptr[1]) & 0xC0) != 0x80)
+			return false;
+		ptr += 2;
+	}
+	return true;
+}
+
+/// Decode the next character of text which is_simple() accepted, returning
+/// the first code point of it
+UChar32 next_simple(const char *& ptr, const char *end) {
+	UChar32 c = static_cast<unsigned char>(*ptr);
+	if (c < 0x80)
+		++ptr;
+	else {
+		c = ((c & 0x1F) << 6) | (ptr[1] & 0x3F);
+		ptr += 2;
+	}
+	if (c == '\r' && ptr != end && *ptr == '\n')
+		++ptr;
+	return c;
+}
+
+/// count_in_range() for text which is_simple() accepted
+size_t count_simple(const char *begin, const char *end, int mask) {
+	size_t count = 0;
+	for (auto ptr = begin; ptr != end; ) {
+		auto start = ptr;
+		UChar32 c = next_simple(ptr, end);
+		if (!mask)
+			++count;
+		else if ((U_GET_GC_MASK(c) & mask) == 0) {
+			if (mask & U_GC_Z_MASK && start != begin && (c == 'n' || c == 'N' || c == 'h')) {
+				if (start[-1] != '\\')
+					++count;
+				else if (!(mask & U_GC_P_MASK))
+					--count;
+			}
+			else
+				++count;
+		}
+	}
+	return count;
+}
+
 template <typename Iterator>
 size_t count_in_range(Iterator begin, Iterator end, int mask) {
 	if (begin == end) return 0;
 
+	if (is_simple(&*begin, &*begin + (end - begin)))
+		return count_simple(&*begin, &*begin + (end - begin), mask);
+
 	auto& character_bi = get_break_iterator(&*begin, end - begin);
 
 	size_t count = 0;
@@ -157,6 +230,15 @@ size_t MaxLineLength(std::string const& text, int mask) {
 
 size_t IndexOfCharacter(std::string const& str, size_t n) {
 	if (str.empty() || n == 0) return 0;
+
+	const char *begin = str.data(), *end = begin + str.size();
+	if (is_simple(begin, end)) {
+		auto ptr = begin;
+		for (; n > 0 && ptr != end; --n)
+			next_simple(ptr, end);
+		return ptr - begin;
+	}
+
 	auto& bi = get_break_iterator(&str[0], str.size());
 
 	for (auto pos = bi.first(), end = bi.next(); ; --n, pos = end, end = bi.next()) {
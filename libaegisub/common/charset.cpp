@@ -21,28 +21,84 @@
 #include "libaegisub/file_mapping.h"
 #include "libaegisub/scoped_ptr.h"
 
+#include <cstring>
+
 #ifdef WITH_UCHARDET
 #include <uchardet.h>
 #endif
 
+namespace {
+/// Number of valid multibyte UTF-8 sequences after which a file with no
+/// invalid ones is assumed to be UTF-8 without looking at the rest of it
+const int utf8_confident_sequences = 64;
+
+/// Stop feeding uchardet once it's been given this much data containing
+/// non-ASCII characters, as more won't change its mind
+const uint64_t max_detection_bytes = 256 * 1024;
+
+/// ASCII-only blocks after the first few are skipped when feeding uchardet
+const uint64_t initial_ascii_bytes = 64 * 1024;
+
+bool is_binaryish(char c) {
+	return (unsigned char)c < 32 && c != '\r' && c != '\n' && c != '\t';
+}
+
+/// Incremental UTF-8 validator which can be fed a file in arbitrary blocks
+class Utf8Validator {
+	int pending = 0;
+	int sequences = 0;
+	bool valid = true;
+
+public:
+	void Feed(const char *buf, size_t len) {
+		for (size_t i = 0; i < len && valid; ++i) {
+			auto c = static_cast<unsigned char>(buf[i]);
+			if (pending) {
+				if ((c & 0xC0) != 0x80)
+					valid = false;
+				else if (--pending == 0)
+					++sequences;
+			}
+			else if (c < 0x80)
+				continue;
+			else if (c >= 0xC2 && c <= 0xDF)
+				pending = 1;
+			else if ((c & 0xF0) == 0xE0)
+				pending = 2;
+			else if (c >= 0xF0 && c <= 0xF4)
+				pending = 3;
+			else
+				valid = false;
+		}
+	}
+
+	bool Valid() const { return valid; }
+	/// Has enough non-ASCII text been seen to be sure this is UTF-8?
+	bool Confident() const { return valid && sequences >= utf8_confident_sequences; }
+};
+}
+
 namespace agi { namespace charset {
 std::string Detect(agi::fs::path const& file) {
 	agi::read_file_mapping fp(file);
+	return Detect(fp);
+}
 
+std::string Detect(agi::read_file_mapping& fp) {
 	// First check for known magic bytes which identify the file type
 	if (fp.size() >= 4) {
 		const char* header = fp.read(0, 4);
-		if (!strncmp(header, "\xef\xbb\xbf", 3))
+		if (!memcmp(header, "\xef\xbb\xbf", 3))
 			return "utf-8";
-		if (!strncmp(header, "\x00\x00\xfe\xff", 4))
+		if (!memcmp(header, "\x00\x00\xfe\xff", 4))
 			return "utf-32be";
-		if (!strncmp(header, "\xff\xfe\x00\x00", 4))
+		if (!memcmp(header, "\xff\xfe\x00\x00", 4))
 			return "utf-32le";
-		if (!strncmp(header, "\xfe\xff", 2))
+		if (!memcmp(header, "\xfe\xff", 2))
 			return "utf-16be";
-		if (!strncmp(header, "\xff\xfe", 2))
+		if (!memcmp(header, "\xff\xfe", 2))
 			return "utf-16le";
-		if (!strncmp(header, "\x1a\x45\xdf\xa3", 4))
+		if (!memcmp(header, "\x1a\x45\xdf\xa3", 4))
 			return "binary"; // Actually EBML/Matroska
 	}
 
@@ -55,29 +111,52 @@ std::string Detect(agi::fs::path const& file) {
 
 #ifdef WITH_UCHARDET
 	agi::scoped_holder<uchardet_t> ud(uchardet_new(), uchardet_delete);
+	Utf8Validator utf8;
+	uint64_t fed = 0;
 	for (uint64_t offset = 0; offset < fp.size(); ) {
 		auto read = std::min<uint64_t>(4096, fp.size() - offset);
 		auto buf = fp.read(offset, read);
-		uchardet_handle_data(ud, buf, read);
 
 		offset += read;
 
 		// A dumb heuristic to detect binary files
+		bool ascii = true;
 		for (size_t i = 0; i < read; ++i) {
-			if ((unsigned char)buf[i] < 32 && (buf[i] != '\r' && buf[i] != '\n' && buf[i] != '\t'))
+			if (is_binaryish(buf[i]))
 				++binaryish;
+			// ESC is included as it's how ISO-2022 switches character sets
+			if ((unsigned char)buf[i] >= 0x80 || buf[i] == 0x1b)
+				ascii = false;
 		}
 
 		if (binaryish > offset / 8)
 			return "binary";
+
+		utf8.Feed(buf, read);
+		if (utf8.Confident())
+			return "utf-8";
+
+		// Pure ASCII blocks tell uchardet nothing new once it's seen a few,
+		// and after enough non-ASCII text it's as sure as it'll ever be
+		if (fed < max_detection_bytes && (!ascii || offset <= initial_ascii_bytes)) {
+			uchardet_handle_data(ud, buf, read);
+			if (!ascii)
+				fed += read;
+		}
 	}
 	uchardet_data_end(ud);
-	return uchardet_get_charset(ud);
+
+	// Short UTF-8 files which never reached the confidence threshold are
+	// still UTF-8 if uchardet has nothing better to say about them
+	std::string charset = uchardet_get_charset(ud);
+	if (charset.empty() && utf8.Valid())
+		return "utf-8";
+	return charset;
 #else
 	auto read = std::min<uint64_t>(4096, fp.size());
 	auto buf = fp.read(0, read);
 	for (size_t i = 0; i < read; ++i) {
-		if ((unsigned char)buf[i] < 32 && (buf[i] != '\r' && buf[i] != '\n' && buf[i] != '\t'))
+		if (is_binaryish(buf[i]))
 			++binaryish;
 	}
 
@@ -19,17 +19,152 @@
 #include "libaegisub/util.h"
 
 #include <atomic>
-#include <boost/asio/io_service.hpp>
-#include <boost/asio/strand.hpp>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace {
-	boost::asio::io_service *service;
+	using agi::dispatch::Priority;
+	using agi::dispatch::Thunk;
+
 	std::function<void (agi::dispatch::Thunk)> invoke_main;
 	std::atomic<uint_fast32_t> threads_running;
 
+	const size_t priority_count = 3;
+
+	/// Work-stealing thread pool with a set of deques per priority
+	///
+	/// Thunks posted from outside the pool go into a shared injection deque,
+	/// while thunks posted by a worker (such as continuations and the next
+	/// step of a serial queue) go into that worker's own deque, which it pops
+	/// from the back and idle workers steal from the front. At each step a
+	/// worker takes the highest priority thunk available from any of these.
+	class ThreadPool {
+		struct Worker {
+			std::mutex lock;
+			std::deque<Thunk> thunks[priority_count];
+		};
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::vector<std::thread> threads;
+
+		std::mutex lock;
+		std::condition_variable cv;
+		std::deque<Thunk> injected[priority_count];
+		/// Number of thunks in any deque; only incremented with lock held
+		std::atomic<size_t> pending{0};
+		bool stopping = false;
+
+		/// Index of the worker running on the current thread, if any
+		static thread_local Worker *current;
+
+		bool TryPop(size_t index, Thunk& out) {
+			Worker& self = *workers[index];
+			for (size_t p = 0; p < priority_count; ++p) {
+				{
+					std::lock_guard<std::mutex> l(self.lock);
+					if (!self.thunks[p].empty()) {
+						out = std::move(self.thunks[p].back());
+						self.thunks[p].pop_back();
+						return true;
+					}
+				}
+
+				{
+					std::lock_guard<std::mutex> l(lock);
+					if (!injected[p].empty()) {
+						out = std::move(injected[p].front());
+						injected[p].pop_front();
+						return true;
+					}
+				}
+
+				for (size_t i = 1; i < workers.size(); ++i) {
+					Worker& victim = *workers[(index + i) % workers.size()];
+					std::lock_guard<std::mutex> l(victim.lock);
+					if (!victim.thunks[p].empty()) {
+						out = std::move(victim.thunks[p].front());
+						victim.thunks[p].pop_front();
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		void Run(size_t index) {
+			current = workers[index].get();
+			for (;;) {
+				Thunk thunk;
+				if (TryPop(index, thunk)) {
+					--pending;
+					thunk();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> l(lock);
+				cv.wait(l, [&] { return pending > 0 || stopping; });
+				if (stopping && pending == 0)
+					return;
+			}
+		}
+
+	public:
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> l(lock);
+				stopping = true;
+			}
+			cv.notify_all();
+#ifndef _WIN32
+			for (auto& thread : threads) thread.join();
+#else
+			// Calling join() after main() returns deadlocks
+			// https://connect.microsoft.com/VisualStudio/feedback/details/747145
+			for (auto& thread : threads) thread.detach();
+			while (threads_running) std::this_thread::yield();
+#endif
+		}
+
+		void Start(size_t count) {
+			for (size_t i = 0; i < count; ++i)
+				workers.emplace_back(new Worker);
+
+			threads.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				threads.emplace_back([=]{
+					++threads_running;
+					agi::util::SetThreadName("Dispatch Worker");
+					Run(i);
+					--threads_running;
+				});
+			}
+		}
+
+		void Post(Thunk thunk, Priority priority) {
+			auto p = static_cast<size_t>(priority);
+			// Only a worker of this pool can be current, as there's only one
+			if (current) {
+				std::lock_guard<std::mutex> l(current->lock);
+				current->thunks[p].push_back(std::move(thunk));
+			}
+
+			{
+				std::lock_guard<std::mutex> l(lock);
+				if (!current)
+					injected[p].push_back(std::move(thunk));
+				++pending;
+			}
+			cv.notify_one();
+		}
+	};
+
+	thread_local ThreadPool::Worker *ThreadPool::current = nullptr;
+
+	ThreadPool *pool;
+
 	class MainQueue final : public agi::dispatch::Queue {
 		void DoInvoke(agi::dispatch::Thunk thunk) override {
 			invoke_main(thunk);
@@ -37,37 +172,65 @@ namespace {
 	};
 
 	class BackgroundQueue final : public agi::dispatch::Queue {
+		Priority priority;
+
 		void DoInvoke(agi::dispatch::Thunk thunk) override {
-			service->post(thunk);
+			pool->Post(std::move(thunk), priority);
 		}
+	public:
+		BackgroundQueue(Priority priority) : priority(priority) { }
 	};
 
+	/// Queue which runs thunks one at a time in the order they were submitted
+	///
+	/// Each thunk is posted to the pool individually once the previous one
+	/// has finished, so that a long serial queue of low priority work doesn't
+	/// hold a worker hostage while higher priority work is waiting.
 	class SerialQueue final : public agi::dispatch::Queue {
-		boost::asio::io_service::strand strand;
+		struct State {
+			std::mutex lock;
+			std::deque<Thunk> thunks;
+			bool running = false;
+			Priority priority;
+		};
+		std::shared_ptr<State> state;
 
-		void DoInvoke(agi::dispatch::Thunk thunk) override {
-			strand.post(thunk);
+		static void Schedule(std::shared_ptr<State> const& state) {
+			pool->Post([=] { RunOne(state); }, state->priority);
 		}
-	public:
-		SerialQueue() : strand(*service) { }
-	};
 
-	struct IOServiceThreadPool {
-		boost::asio::io_service io_service;
-		std::unique_ptr<boost::asio::io_service::work> work;
-		std::vector<std::thread> threads;
+		static void RunOne(std::shared_ptr<State> const& state) {
+			Thunk thunk;
+			{
+				std::lock_guard<std::mutex> l(state->lock);
+				thunk = std::move(state->thunks.front());
+				state->thunks.pop_front();
+			}
 
-		IOServiceThreadPool() : work(new boost::asio::io_service::work(io_service)) { }
-		~IOServiceThreadPool() {
-			work.reset();
-#ifndef _WIN32
-			for (auto& thread : threads) thread.join();
-#else
-			// Calling join() after main() returns deadlocks
-			// https://connect.microsoft.com/VisualStudio/feedback/details/747145
-			for (auto& thread : threads) thread.detach();
-			while (threads_running) std::this_thread::yield();
-#endif
+			thunk();
+
+			{
+				std::lock_guard<std::mutex> l(state->lock);
+				if (state->thunks.empty()) {
+					state->running = false;
+					return;
+				}
+			}
+			Schedule(state);
+		}
+
+		void DoInvoke(agi::dispatch::Thunk thunk) override {
+			{
+				std::lock_guard<std::mutex> l(state->lock);
+				state->thunks.push_back(std::move(thunk));
+				if (state->running) return;
+				state->running = true;
+			}
+			Schedule(state);
+		}
+	public:
+		SerialQueue(Priority priority) : state(std::make_shared<State>()) {
+			state->priority = priority;
 		}
 	};
 }
@@ -75,23 +238,15 @@ namespace {
 namespace agi { namespace dispatch {
 
 void Init(std::function<void (Thunk)> invoke_main) {
-	static IOServiceThreadPool thread_pool;
-	::service = &thread_pool.io_service;
+	static ThreadPool thread_pool;
+	::pool = &thread_pool;
 	::invoke_main = invoke_main;
 
-	thread_pool.threads.reserve(std::max<unsigned>(4, std::thread::hardware_concurrency()));
-	for (size_t i = 0; i < thread_pool.threads.capacity(); ++i) {
-		thread_pool.threads.emplace_back([]{
-			++threads_running;
-			agi::util::SetThreadName("Dispatch Worker");
-			service->run();
-			--threads_running;
-		});
-	}
+	thread_pool.Start(std::max<unsigned>(4, std::thread::hardware_concurrency()));
 }
 
-void Queue::Async(Thunk thunk) {
-	DoInvoke([=] {
+void Queue::Async(Thunk thunk, CancellationToken token) {
+	DoInvoke(Track([=] {
 		try {
 			thunk();
 		}
@@ -99,7 +254,7 @@ void Queue::Async(Thunk thunk) {
 			auto e = std::current_exception();
 			invoke_main([=] { std::rethrow_exception(e); });
 		}
-	});
+	}, std::move(token)));
 }
 
 void Queue::Sync(Thunk thunk) {
@@ -108,7 +263,7 @@ void Queue::Sync(Thunk thunk) {
 	std::unique_lock<std::mutex> l(m);
 	std::exception_ptr e;
 	bool done = false;
-	DoInvoke([&]{
+	DoInvoke(Track([&]{
 		std::unique_lock<std::mutex> l(m);
 		try {
 			thunk();
@@ -118,7 +273,7 @@ void Queue::Sync(Thunk thunk) {
 		}
 		done = true;
 		cv.notify_all();
-	});
+	}, CancellationToken()));
 	cv.wait(l, [&]{ return done; });
 	if (e) std::rethrow_exception(e);
 }
@@ -128,13 +283,19 @@ Queue& Main() {
 	return q;
 }
 
-Queue& Background() {
-	static BackgroundQueue q;
-	return q;
+Queue& Background(Priority priority) {
+	static BackgroundQueue high(Priority::High);
+	static BackgroundQueue normal(Priority::Normal);
+	static BackgroundQueue low(Priority::Low);
+	switch (priority) {
+		case Priority::High: return high;
+		case Priority::Low:  return low;
+		default:             return normal;
+	}
 }
 
-std::unique_ptr<Queue> Create() {
-	return std::unique_ptr<Queue>(new SerialQueue);
+std::unique_ptr<Queue> Create(Priority priority) {
+	return std::unique_ptr<Queue>(new SerialQueue(priority));
 }
 
 } }
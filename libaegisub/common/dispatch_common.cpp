@@ -0,0 +1,241 @@
+// Copyright (c) 2013, Thomas Goyne <plorkyeran@aegisub.org>
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file dispatch_common.cpp
+/// @brief Platform-independent parts of the dispatch queues
+/// @ingroup libaegisub
+
+#include "libaegisub/dispatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Token used for thunks submitted without one, which is never cancelled
+agi::dispatch::CancellationToken const& never_cancelled() {
+	static agi::dispatch::CancellationToken token;
+	return token;
+}
+}
+
+namespace agi { namespace dispatch {
+
+struct Queue::Counters {
+	std::atomic<uint64_t> queued{0};
+	std::atomic<uint64_t> completed{0};
+	std::atomic<uint64_t> cancelled{0};
+	std::atomic<uint64_t> total_latency{0};
+	std::atomic<uint64_t> max_latency{0};
+};
+
+Queue::Queue() : counters(std::make_shared<Counters>()) { }
+Queue::~Queue() { }
+
+Thunk Queue::Track(Thunk thunk, CancellationToken token) {
+	auto counters = this->counters;
+	++counters->queued;
+	auto submitted = std::chrono::steady_clock::now();
+
+	return [=] {
+		--counters->queued;
+		if (token.IsCancelled()) {
+			++counters->cancelled;
+			return;
+		}
+
+		uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - submitted).count();
+		counters->total_latency += latency;
+		uint64_t prev = counters->max_latency;
+		while (prev < latency && !counters->max_latency.compare_exchange_weak(prev, latency)) ;
+
+		thunk();
+		++counters->completed;
+	};
+}
+
+void Queue::Async(Thunk thunk) {
+	Async(std::move(thunk), never_cancelled());
+}
+
+QueueStats Queue::GetStats() const {
+	QueueStats stats;
+	stats.queued = counters->queued;
+	stats.completed = counters->completed;
+	stats.cancelled = counters->cancelled;
+	stats.total_latency = counters->total_latency;
+	stats.max_latency = counters->max_latency;
+	return stats;
+}
+
+struct TaskGroup::State {
+	std::mutex lock;
+	std::condition_variable cv;
+	size_t pending = 0;
+	/// Number of threads posting continuations, which Wait() also waits for
+	/// so that every continuation is queued by the time it returns
+	size_t posting = 0;
+	std::exception_ptr error;
+	std::vector<std::pair<Queue *, Thunk>> continuations;
+	CancellationToken token;
+
+	void Finish() {
+		std::vector<std::pair<Queue *, Thunk>> ready;
+		{
+			std::lock_guard<std::mutex> l(lock);
+			if (--pending != 0) return;
+			ready.swap(continuations);
+			++posting;
+		}
+		for (auto& continuation : ready)
+			continuation.first->Async(std::move(continuation.second));
+
+		std::lock_guard<std::mutex> l(lock);
+		--posting;
+		cv.notify_all();
+	}
+};
+
+TaskGroup::TaskGroup() : state(std::make_shared<State>()) { }
+TaskGroup::~TaskGroup() { }
+
+void TaskGroup::Async(Queue& queue, Thunk thunk) {
+	{
+		std::lock_guard<std::mutex> l(state->lock);
+		++state->pending;
+	}
+
+	// The cancellation check is done here rather than by passing the token
+	// to the queue so that skipped thunks still count as finished
+	auto state = this->state;
+	queue.Async([=] {
+		try {
+			if (!state->token.IsCancelled())
+				thunk();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> l(state->lock);
+			if (!state->error)
+				state->error = std::current_exception();
+		}
+		state->Finish();
+	});
+}
+
+void TaskGroup::Wait() {
+	std::unique_lock<std::mutex> l(state->lock);
+	state->cv.wait(l, [&] { return state->pending == 0 && state->posting == 0; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+void TaskGroup::Then(Queue& queue, Thunk thunk) {
+	{
+		std::lock_guard<std::mutex> l(state->lock);
+		if (state->pending != 0) {
+			state->continuations.emplace_back(&queue, std::move(thunk));
+			return;
+		}
+	}
+	queue.Async(std::move(thunk));
+}
+
+void TaskGroup::Cancel() {
+	state->token.Cancel();
+}
+
+CancellationToken TaskGroup::Token() const {
+	return state->token;
+}
+
+void ParallelFor(size_t count, size_t chunk_size, std::function<void (size_t, size_t)> const& fn) {
+	if (chunk_size == 0) chunk_size = 1;
+	if (count <= chunk_size) {
+		if (count > 0) fn(0, count);
+		return;
+	}
+
+	// Chunks are claimed from a shared counter by the calling thread and by
+	// helpers on the background queue. The caller keeps claiming chunks until
+	// there are none left and then only waits for chunks which have already
+	// started, so it never waits on a helper which is queued behind it. This
+	// matters when the caller is itself on a pool thread. Helpers which don't
+	// start until everything is done find nothing to claim, and never touch
+	// fn, which may no longer exist by then.
+	struct State {
+		std::function<void (size_t, size_t)> const *fn;
+		size_t count, chunk_size, chunks;
+
+		std::mutex lock;
+		std::condition_variable idle;
+		/// Index of the next chunk to run
+		size_t next = 0;
+		/// Number of chunks which are currently running
+		size_t running = 0;
+		std::exception_ptr error;
+
+		void Run() {
+			std::unique_lock<std::mutex> l(lock);
+			while (next < chunks) {
+				size_t begin = next++ * chunk_size;
+				size_t end = std::min(count, begin + chunk_size);
+				++running;
+				l.unlock();
+
+				std::exception_ptr chunk_error;
+				try {
+					(*fn)(begin, end);
+				}
+				catch (...) {
+					chunk_error = std::current_exception();
+				}
+
+				l.lock();
+				--running;
+				if (chunk_error) {
+					if (!error) error = chunk_error;
+					// Don't start anything else
+					next = chunks;
+				}
+			}
+			if (running == 0)
+				idle.notify_all();
+		}
+	};
+
+	auto state = std::make_shared<State>();
+	state->fn = &fn;
+	state->count = count;
+	state->chunk_size = chunk_size;
+	state->chunks = (count + chunk_size - 1) / chunk_size;
+
+	size_t helpers = std::min<size_t>(state->chunks - 1, std::max(1u, std::thread::hardware_concurrency()));
+	for (size_t i = 0; i < helpers; ++i)
+		Background().Async([state] { state->Run(); });
+
+	state->Run();
+
+	std::unique_lock<std::mutex> l(state->lock);
+	state->idle.wait(l, [&] { return state->running == 0; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+} }
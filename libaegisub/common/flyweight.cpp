@@ -0,0 +1,56 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file flyweight.cpp
+/// @brief Interned immutable values which can be shared between threads
+/// @ingroup libaegisub
+
+#include "libaegisub/flyweight.h"
+
+namespace agi { namespace flyweight_detail {
+Node *InternTable::Acquire(std::string_view key, Node *(*create)(void *), void *arg) {
+	size_t hash = std::hash<std::string_view>()(key);
+	auto& shard = ShardFor(hash);
+
+	std::lock_guard<std::mutex> lock(shard.lock);
+	auto it = shard.nodes.find(key);
+	if (it != shard.nodes.end()) {
+		// Nodes are removed from the table under this lock as soon as their
+		// count hits zero, so any node found here is still alive
+		it->second->refs.fetch_add(1, std::memory_order_relaxed);
+		return it->second;
+	}
+
+	Node *node = create(arg);
+	node->hash = hash;
+	shard.nodes.emplace(node->key, node);
+	return node;
+}
+
+void InternTable::ReleaseLast(Node *node) {
+	auto& shard = ShardFor(node->hash);
+	{
+		std::lock_guard<std::mutex> lock(shard.lock);
+		// Someone may have interned the same value again since the caller
+		// saw that it held the last reference
+		if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		shard.nodes.erase(node->key);
+	}
+	node->destroy(node);
+}
+} }
@@ -34,7 +34,7 @@ LogSink *log;
 /// Keep this ordered the same as Severity
 const char *Severity_ID = "EAWID";
 
-LogSink::LogSink() : queue(dispatch::Create()) { }
+LogSink::LogSink() : queue(dispatch::Create(dispatch::Priority::Low)) { }
 
 LogSink::~LogSink() {
 	// The destructor for emitters may try to log messages, so disable all the
@@ -0,0 +1,418 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file matroska.cpp
+/// @brief Indexed reading of a single track's blocks from Matroska files
+/// @ingroup libaegisub
+
+#include "libaegisub/matroska.h"
+
+#include "libaegisub/file_mapping.h"
+#include "libaegisub/trace.h"
+
+namespace {
+using agi::matroska::MatroskaError;
+
+namespace id {
+	const uint32_t EBML = 0x1A45DFA3;
+	const uint32_t Segment = 0x18538067;
+	const uint32_t SeekHead = 0x114D9B74;
+	const uint32_t Info = 0x1549A966;
+	const uint32_t TimecodeScale = 0x2AD7B1;
+	const uint32_t Tracks = 0x1654AE6B;
+	const uint32_t Cues = 0x1C53BB6B;
+	const uint32_t Attachments = 0x1941A469;
+	const uint32_t Chapters = 0x1043A770;
+	const uint32_t Tags = 0x1254C367;
+	const uint32_t Cluster = 0x1F43B675;
+	const uint32_t Timecode = 0xE7;
+	const uint32_t SimpleBlock = 0xA3;
+	const uint32_t BlockGroup = 0xA0;
+	const uint32_t Block = 0xA1;
+	const uint32_t BlockDuration = 0x9B;
+}
+
+const uint64_t unknown_size = ~0ULL;
+
+bool is_top_level(uint32_t element) {
+	switch (element) {
+	case id::SeekHead: case id::Info: case id::Tracks: case id::Cues:
+	case id::Attachments: case id::Chapters: case id::Tags: case id::Cluster:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/// Read a variable-length integer from memory, returning its length in bytes
+size_t read_vint(const uint8_t *data, size_t size, uint64_t& value) {
+	if (!size) throw MatroskaError("Truncated laced block");
+	size_t len = 1;
+	while (len <= 8 && !(data[0] & (0x80 >> (len - 1))))
+		++len;
+	if (len > 8 || len > size)
+		throw MatroskaError("Invalid variable-length integer");
+
+	value = data[0] & (0xFF >> len);
+	for (size_t i = 1; i < len; ++i)
+		value = (value << 8) | data[i];
+	return len;
+}
+
+/// A frame of a block, pointing into the file mapping
+struct Frame {
+	const char *data;
+	size_t size;
+};
+
+/// Split the payload of a block into its frames
+void split_lacing(const char *payload, size_t size, int lacing, std::vector<Frame>& frames) {
+	frames.clear();
+	if (!lacing) {
+		frames.push_back(Frame{payload, size});
+		return;
+	}
+
+	auto data = reinterpret_cast<const uint8_t *>(payload);
+	if (!size) throw MatroskaError("Truncated laced block");
+	size_t count = data[0] + 1u;
+	size_t pos = 1;
+
+	// The sizes of all but the last frame are stored, other than for fixed
+	// lacing where all frames are the same size
+	std::vector<uint64_t> sizes;
+	if (lacing == 1) { // Xiph
+		for (size_t i = 0; i + 1 < count; ++i) {
+			uint64_t frame_size = 0;
+			uint8_t byte;
+			do {
+				if (pos >= size) throw MatroskaError("Truncated laced block");
+				byte = data[pos++];
+				frame_size += byte;
+			} while (byte == 0xFF);
+			sizes.push_back(frame_size);
+		}
+	}
+	else if (lacing == 3 && count > 1) { // EBML
+		uint64_t value;
+		pos += read_vint(data + pos, size - pos, value);
+		sizes.push_back(value);
+		for (size_t i = 1; i + 1 < count; ++i) {
+			size_t len = read_vint(data + pos, size - pos, value);
+			pos += len;
+			// Later sizes are signed differences from the previous one
+			int64_t bias = (int64_t(1) << (7 * len - 1)) - 1;
+			int64_t frame_size = static_cast<int64_t>(sizes.back()) + static_cast<int64_t>(value) - bias;
+			if (frame_size < 0) throw MatroskaError("Invalid laced block");
+			sizes.push_back(static_cast<uint64_t>(frame_size));
+		}
+	}
+
+	uint64_t remaining = size - pos;
+	if (lacing == 2) { // Fixed
+		if (remaining % count) throw MatroskaError("Invalid laced block");
+		sizes.assign(count, remaining / count);
+	}
+	else {
+		for (auto frame_size : sizes) {
+			if (frame_size > remaining) throw MatroskaError("Truncated laced block");
+			remaining -= frame_size;
+		}
+		sizes.push_back(remaining);
+	}
+
+	for (auto frame_size : sizes) {
+		frames.push_back(Frame{payload + pos, static_cast<size_t>(frame_size)});
+		pos += static_cast<size_t>(frame_size);
+	}
+}
+
+struct Element {
+	uint32_t id;
+	/// Position of the start of the element's header
+	uint64_t pos;
+	/// Position of the start of the element's data
+	uint64_t data;
+	/// Size of the element's data, or unknown_size for elements such as
+	/// live-streamed clusters which don't know how big they are
+	uint64_t size;
+
+	uint64_t end() const { return data + size; }
+};
+
+/// Reads EBML elements directly out of the mapped file, so reading an
+/// element's header only touches the pages that the header is on
+class Reader {
+	agi::read_file_mapping& file;
+	const uint64_t file_size;
+
+	const uint8_t *Bytes(uint64_t pos, uint64_t len) {
+		return reinterpret_cast<const uint8_t *>(file.read(pos, len));
+	}
+
+	/// Read a variable-length integer, returning its length in bytes
+	size_t ReadVint(uint64_t pos, uint64_t limit, uint64_t& value, bool keep_marker) {
+		if (pos >= limit) throw MatroskaError("Unexpected end of element");
+		uint8_t first = *Bytes(pos, 1);
+		size_t len = 1;
+		while (len <= 8 && !(first & (0x80 >> (len - 1))))
+			++len;
+		if (len > 8 || pos + len > limit)
+			throw MatroskaError("Invalid variable-length integer");
+
+		auto bytes = Bytes(pos, len);
+		value = keep_marker ? first : first & (0xFF >> len);
+		bool all_ones = value == (0xFFu >> len);
+		for (size_t i = 1; i < len; ++i) {
+			value = (value << 8) | bytes[i];
+			all_ones = all_ones && bytes[i] == 0xFF;
+		}
+		if (!keep_marker && all_ones)
+			value = unknown_size;
+		return len;
+	}
+
+public:
+	Reader(agi::read_file_mapping& file) : file(file), file_size(file.size()) { }
+
+	uint64_t Size() const { return file_size; }
+
+	/// Read the header of the element at pos, clamping its size to limit
+	Element ReadElement(uint64_t pos, uint64_t limit) {
+		uint64_t element_id, size;
+		size_t id_len = ReadVint(pos, limit, element_id, true);
+		if (id_len > 4) throw MatroskaError("Invalid element ID");
+		size_t size_len = ReadVint(pos + id_len, limit, size, false);
+
+		Element e{static_cast<uint32_t>(element_id), pos, pos + id_len + size_len, size};
+		if (e.size != unknown_size && e.size > limit - e.data)
+			e.size = limit - e.data;
+		return e;
+	}
+
+	uint64_t ReadUInt(Element const& e) {
+		if (e.size > 8) throw MatroskaError("Invalid integer element");
+		auto bytes = Bytes(e.data, e.size);
+		uint64_t value = 0;
+		for (uint64_t i = 0; i < e.size; ++i)
+			value = (value << 8) | bytes[i];
+		return value;
+	}
+
+	/// Parse a block's header without touching its payload
+	/// @param[out] lacing Lacing type from the block's flags, or 0 for none
+	/// @return Position in the file of the payload
+	uint64_t ReadBlockHeader(Element const& e, uint64_t& track, int16_t& timecode, int& lacing) {
+		size_t track_len = ReadVint(e.data, e.end(), track, false);
+		if (track_len + 3 > e.size) throw MatroskaError("Truncated block");
+
+		auto header = Bytes(e.data + track_len, 3);
+		timecode = static_cast<int16_t>((header[0] << 8) | header[1]);
+		lacing = (header[2] >> 1) & 3;
+		return e.data + track_len + 3;
+	}
+
+	/// Get the frames of a block whose header has been read
+	void ReadFrames(Element const& e, uint64_t payload, int lacing, std::vector<Frame>& frames) {
+		auto size = static_cast<size_t>(e.end() - payload);
+		split_lacing(file.read(payload, size), size, lacing, frames);
+	}
+
+	/// Find the end of an element, scanning an unknown-sized cluster for the
+	/// start of the next top-level element if needed
+	uint64_t End(Element const& e, uint64_t limit) {
+		if (e.size != unknown_size) return e.end();
+		uint64_t pos = e.data;
+		while (pos < limit) {
+			auto child = ReadElement(pos, limit);
+			if (is_top_level(child.id) || child.size == unknown_size)
+				return pos;
+			pos = child.end();
+		}
+		return limit;
+	}
+};
+
+struct Segment {
+	uint64_t start = 0;
+	uint64_t end = 0;
+	uint64_t timecode_scale = 1000000;
+	uint64_t first_cluster = 0;
+};
+
+/// Read the things needed before any clusters can be read
+Segment read_segment_header(Reader& r) {
+	auto ebml = r.ReadElement(0, r.Size());
+	if (ebml.id != id::EBML || ebml.size == unknown_size)
+		throw MatroskaError("Not a Matroska file");
+
+	auto segment = r.ReadElement(ebml.end(), r.Size());
+	if (segment.id != id::Segment)
+		throw MatroskaError("No segment found in Matroska file");
+
+	Segment ret;
+	ret.start = segment.data;
+	ret.end = segment.size == unknown_size ? r.Size() : segment.end();
+
+	for (uint64_t pos = ret.start; pos < ret.end; ) {
+		auto e = r.ReadElement(pos, ret.end);
+		if (e.id == id::Cluster) {
+			ret.first_cluster = pos;
+			break;
+		}
+		if (e.size == unknown_size)
+			throw MatroskaError("Unknown-sized element before first cluster");
+
+		if (e.id == id::Info) {
+			for (uint64_t child = e.data; child < e.end(); ) {
+				auto c = r.ReadElement(child, e.end());
+				if (c.id == id::TimecodeScale)
+					ret.timecode_scale = r.ReadUInt(c);
+				child = c.end();
+			}
+		}
+		pos = e.end();
+	}
+
+	if (!ret.first_cluster)
+		throw MatroskaError("Matroska file has no clusters");
+	return ret;
+}
+
+/// Get the positions of every cluster in the segment
+std::vector<uint64_t> all_clusters(Reader& r, Segment const& seg) {
+	std::vector<uint64_t> clusters;
+	for (uint64_t pos = seg.first_cluster; pos < seg.end; ) {
+		auto e = r.ReadElement(pos, seg.end);
+		if (e.id == id::Cluster)
+			clusters.push_back(pos);
+		pos = r.End(e, seg.end);
+	}
+	return clusters;
+}
+
+/// Call f(element, cluster timecode) for each block or block group in a cluster
+template<typename Func>
+void for_each_block(Reader& r, Segment const& seg, uint64_t pos, Func&& f) {
+	auto cluster = r.ReadElement(pos, seg.end);
+	if (cluster.id != id::Cluster)
+		throw MatroskaError("Expected a cluster");
+
+	uint64_t end = r.End(cluster, seg.end);
+	uint64_t timecode = 0;
+	for (uint64_t child = cluster.data; child < end; ) {
+		auto e = r.ReadElement(child, end);
+		if (e.size == unknown_size) break;
+		if (e.id == id::Timecode)
+			timecode = r.ReadUInt(e);
+		else if (e.id == id::SimpleBlock || e.id == id::BlockGroup) {
+			if (!f(e, timecode)) return;
+		}
+		child = e.end();
+	}
+}
+
+/// The timecode of the first block in the file, which MatroskaParser and
+/// thus all of the times Aegisub has historically used are relative to
+uint64_t first_timecode(Reader& r, Segment const& seg) {
+	uint64_t ret = 0;
+	for_each_block(r, seg, seg.first_cluster, [&](Element const& e, uint64_t cluster_timecode) -> bool {
+		Element block = e;
+		if (e.id == id::BlockGroup) {
+			for (uint64_t child = e.data; child < e.end(); ) {
+				auto c = r.ReadElement(child, e.end());
+				if (c.id == id::Block) { block = c; break; }
+				child = c.end();
+			}
+			if (block.id != id::Block) return true;
+		}
+
+		uint64_t track;
+		int16_t timecode;
+		int lacing;
+		r.ReadBlockHeader(block, track, timecode, lacing);
+		ret = cluster_timecode + timecode;
+		return false;
+	});
+	return ret;
+}
+}
+
+namespace agi { namespace matroska {
+std::vector<Block> ReadTrack(read_file_mapping& file, uint64_t track,
+	std::function<bool (size_t, size_t)> const& progress, ReadStats *stats)
+{
+	AGI_TRACE_SCOPE("io", "matroska::ReadTrack");
+
+	Reader r(file);
+	auto seg = read_segment_header(r);
+	const auto first = static_cast<int64_t>(first_timecode(r, seg));
+	const auto scale = static_cast<int64_t>(seg.timecode_scale);
+
+	ReadStats local_stats;
+	if (!stats) stats = &local_stats;
+
+	// Cues can't be used to skip clusters: they're optional, and even when
+	// every cluster has a cue for the video track, a muxer may only write
+	// them for some of the subtitle blocks. Finding the clusters and the
+	// blocks of the track in them only reads element headers.
+	auto clusters = all_clusters(r, seg);
+
+	std::vector<Block> blocks;
+	std::vector<Frame> frames;
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		if (!progress(i, clusters.size())) {
+			stats->cancelled = true;
+			break;
+		}
+		++stats->clusters_read;
+
+		for_each_block(r, seg, clusters[i], [&](Element const& e, uint64_t cluster_timecode) -> bool {
+			Element block = e;
+			int64_t duration = 0;
+			if (e.id == id::BlockGroup) {
+				block.id = 0;
+				for (uint64_t child = e.data; child < e.end(); ) {
+					auto c = r.ReadElement(child, e.end());
+					if (c.id == id::Block) block = c;
+					else if (c.id == id::BlockDuration) duration = static_cast<int64_t>(r.ReadUInt(c));
+					child = c.end();
+				}
+				if (block.id != id::Block) return true;
+			}
+
+			uint64_t block_track;
+			int16_t timecode;
+			int lacing;
+			uint64_t payload = r.ReadBlockHeader(block, block_track, timecode, lacing);
+			if (block_track != track) return true;
+
+			// Laced frames have no times of their own, so each gets the
+			// block's times
+			int64_t start = (static_cast<int64_t>(cluster_timecode) + timecode - first) * scale;
+			r.ReadFrames(block, payload, lacing, frames);
+			for (auto const& frame : frames)
+				blocks.push_back(Block{start, start + duration * scale, std::string(frame.data, frame.size)});
+			return true;
+		});
+	}
+	if (!stats->cancelled)
+		progress(clusters.size(), clusters.size());
+
+	stats->blocks = blocks.size();
+	return blocks;
+}
+} }
@@ -14,13 +14,11 @@
 
 #include "libaegisub/mru.h"
 
-#include "libaegisub/cajun/writer.h"
-
-#include "libaegisub/io.h"
 #include "libaegisub/json.h"
 #include "libaegisub/log.h"
 #include "libaegisub/option.h"
 #include "libaegisub/option_value.h"
+#include "libaegisub/persist.h"
 
 namespace {
 const char *mru_names[] = {
@@ -71,6 +69,10 @@ MRUManager::MRUManager(agi::fs::path const& config, std::pair<const char *, size
 		Load(it.first.c_str(), it.second);
 }
 
+MRUManager::~MRUManager() {
+	persist::Flush();
+}
+
 MRUManager::MRUListMap &MRUManager::Find(const char *key) {
 	auto index = mru_index(key);
 	if (index == -1)
@@ -120,7 +122,7 @@ void MRUManager::Flush() {
 			array.push_back(p.string());
 	}
 
-	agi::JsonWriter::Write(out, io::Save(config_name).Get());
+	persist::Write(config_name, std::move(out));
 }
 
 void MRUManager::Prune(const char *key, MRUListMap& map) const {
@@ -19,7 +19,6 @@
 #include "libaegisub/option.h"
 
 #include "libaegisub/cajun/reader.h"
-#include "libaegisub/cajun/writer.h"
 #include "libaegisub/cajun/elements.h"
 #include "libaegisub/cajun/visitor.h"
 
@@ -28,6 +27,7 @@
 #include "libaegisub/io.h"
 #include "libaegisub/log.h"
 #include "libaegisub/option_value.h"
+#include "libaegisub/persist.h"
 #include "libaegisub/make_unique.h"
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -267,7 +267,7 @@ OptionValue *Options::Get(const char *name) {
 	throw agi::InternalError("Option value not found: " + std::string(name));
 }
 
-void Options::Flush() const {
+json::Object Options::Serialize() const {
 	json::Object obj_out;
 
 	for (auto const& ov : values) {
@@ -314,7 +314,15 @@ void Options::Flush() const {
 		}
 	}
 
-	agi::JsonWriter::Write(obj_out, io::Save(config_file).Get());
+	return obj_out;
+}
+
+void Options::Flush() const {
+	persist::WriteNow(config_file, Serialize());
+}
+
+void Options::QueueFlush() const {
+	persist::Write(config_file, Serialize());
 }
 
 } // namespace agi
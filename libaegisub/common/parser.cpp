@@ -19,6 +19,7 @@
 #include "libaegisub/color.h"
 #include "libaegisub/ass/dialogue_parser.h"
 
+#include <algorithm>
 #include <boost/phoenix/core.hpp>
 #include <boost/phoenix/operator.hpp>
 #include <boost/phoenix/fusion.hpp>
@@ -199,26 +200,108 @@ namespace parser {
 }
 
 namespace ass {
+	namespace {
+		using tokenizer_type = dialogue_tokens<lex::lexertl::actor_lexer<>>;
+
+		tokenizer_type const& get_tokenizer(bool karaoke_templater) {
+			static const tokenizer_type kt(true);
+			static const tokenizer_type not_kt(false);
+			return karaoke_templater ? kt : not_kt;
+		}
+
+		/// Lex str starting from offset, which must be somewhere the lexer is
+		/// in its initial state, appending the tokens to data
+		///
+		/// If stop is given, it's called with the offset after each OVR_END
+		/// token and lexing stops if it returns true.
+		template<typename Stop>
+		void tokenize(std::string const& str, size_t offset, bool karaoke_templater, std::vector<DialogueToken>& data, Stop const& stop) {
+			auto const& tokenizer = get_tokenizer(karaoke_templater);
+
+			char const *first = str.c_str() + offset;
+			char const *last = str.c_str() + str.size();
+			auto it = tokenizer.begin(first, last), end = tokenizer.end();
+
+			for (; it != end && token_is_valid(*it); ++it) {
+				int id = it->id();
+				ptrdiff_t len = it->value().end() - it->value().begin();
+				assert(len > 0);
+				if (data.empty() || data.back().type != id)
+					data.push_back(DialogueToken{id, static_cast<size_t>(len)});
+				else
+					data.back().length += len;
+
+				if (id == DialogueTokenType::OVR_END && stop(it->value().end() - str.c_str()))
+					return;
+			}
+		}
+	}
+
 	std::vector<DialogueToken> TokenizeDialogueBody(std::string const& str, bool karaoke_templater) {
-		static const dialogue_tokens<lex::lexertl::actor_lexer<>> kt(true);
-		static const dialogue_tokens<lex::lexertl::actor_lexer<>> not_kt(false);
-		auto const& tokenizer = karaoke_templater ? kt : not_kt;
+		std::vector<DialogueToken> data;
+		tokenize(str, 0, karaoke_templater, data, [](size_t) { return false; });
+		return data;
+	}
 
-		char const *first = str.c_str();
-		char const *last = first + str.size();
+	std::vector<DialogueToken> RetokenizeDialogueBody(std::string const& old_str, std::vector<DialogueToken> const& old_tokens, std::string const& str, bool karaoke_templater) {
+		using namespace DialogueTokenType;
+
+		size_t old_covered = 0;
+		for (auto const& tok : old_tokens)
+			old_covered += tok.length;
+		// The lexer gives up on some invalid input, and nothing after that
+		// point can be reused. Templater expressions can span override
+		// blocks, so an edit can change how text before the edit is lexed.
+		if (karaoke_templater || old_covered != old_str.size())
+			return TokenizeDialogueBody(str, karaoke_templater);
+
+		size_t max_common = std::min(old_str.size(), str.size());
+		size_t prefix = 0;
+		while (prefix < max_common && old_str[prefix] == str[prefix])
+			++prefix;
+		size_t suffix = 0;
+		while (suffix < max_common - prefix && old_str[old_str.size() - suffix - 1] == str[str.size() - suffix - 1])
+			++suffix;
+
+		// The lexer is always in its initial state after the end of an
+		// override block, so lexing can restart after the last one which
+		// ends before the first change...
 		std::vector<DialogueToken> data;
-		auto it = tokenizer.begin(first, last), end = tokenizer.end();
-
-		for (; it != end && token_is_valid(*it); ++it) {
-			int id = it->id();
-			ptrdiff_t len = it->value().end() - it->value().begin();
-			assert(len > 0);
-			if (data.empty() || data.back().type != id)
-				data.push_back(DialogueToken{id, static_cast<size_t>(len)});
-			else
-				data.back().length += len;
+		size_t restart = 0;
+		size_t old_index = 0;
+		{
+			size_t pos = 0, keep = 0;
+			for (size_t i = 0; i < old_tokens.size(); ++i) {
+				pos += old_tokens[i].length;
+				if (pos > prefix) break;
+				if (old_tokens[i].type == OVR_END) {
+					restart = pos;
+					keep = i + 1;
+				}
+			}
+			data.assign(old_tokens.begin(), old_tokens.begin() + keep);
 		}
 
+		// ...and can stop at the end of an override block in the unchanged
+		// suffix which was also the end of one in the old tokens, as
+		// everything from there on will lex the same as it did before
+		const size_t new_suffix_start = str.size() - suffix;
+		const ptrdiff_t shift = static_cast<ptrdiff_t>(old_str.size()) - static_cast<ptrdiff_t>(str.size());
+		size_t old_pos = 0;
+		bool resynced = false;
+		tokenize(str, restart, karaoke_templater, data, [&](size_t end) {
+			if (end <= new_suffix_start) return false;
+			size_t old_end = end + shift;
+			while (old_index < old_tokens.size() && old_pos < old_end)
+				old_pos += old_tokens[old_index++].length;
+			if (old_pos != old_end || old_tokens[old_index - 1].type != OVR_END)
+				return false;
+			resynced = true;
+			return true;
+		});
+
+		if (resynced)
+			data.insert(data.end(), old_tokens.begin() + old_index, old_tokens.end());
 		return data;
 	}
 }
@@ -0,0 +1,197 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file persist.cpp
+/// @brief Deferred, coalesced writing of JSON settings files
+/// @ingroup libaegisub io
+
+#include "libaegisub/persist.h"
+
+#include "libaegisub/cajun/writer.h"
+#include "libaegisub/io.h"
+#include "libaegisub/log.h"
+#include "libaegisub/trace.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+using namespace agi;
+using steady = std::chrono::steady_clock;
+
+/// A queued write, either a document or text which has already been
+/// serialized
+struct Document {
+	json::UnknownElement json;
+	std::string text;
+	bool serialized = false;
+};
+
+void write_file(fs::path const& file, json::UnknownElement const& document) {
+	AGI_TRACE_SCOPE("io", "persist::write");
+	JsonWriter::Write(document, io::Save(file).Get());
+}
+
+void write_file(fs::path const& file, Document const& document) {
+	if (!document.serialized)
+		return write_file(file, document.json);
+
+	AGI_TRACE_SCOPE("io", "persist::write");
+	io::Save(file).Get() << document.text;
+}
+
+class Writer {
+	/// Protects everything below other than write_lock
+	std::mutex lock;
+	/// Signalled when a write is queued or a flush is requested
+	std::condition_variable wake;
+	/// Signalled when the worker finishes a batch of writes
+	std::condition_variable idle;
+
+	/// Held while files are being written so that WriteNow can't race with a
+	/// batch the worker has already taken
+	std::mutex write_lock;
+
+	std::map<fs::path, Document> pending;
+	std::chrono::milliseconds delay{1000};
+	/// When the oldest pending write was queued
+	steady::time_point oldest;
+	/// When the pending writes should be written if nothing else is queued
+	steady::time_point deadline;
+	/// Number of threads waiting in Flush()
+	int flushers = 0;
+	bool writing = false;
+	bool stop = false;
+
+	std::thread thread;
+
+	void Run() {
+		std::unique_lock<std::mutex> l(lock);
+		while (true) {
+			wake.wait(l, [&] { return stop || !pending.empty(); });
+			if (pending.empty()) return;
+
+			while (!stop && flushers == 0 && steady::now() < deadline)
+				wake.wait_until(l, deadline);
+
+			l.unlock();
+			std::lock_guard<std::mutex> wl(write_lock);
+			l.lock();
+
+			auto batch = std::move(pending);
+			pending.clear();
+			writing = true;
+			l.unlock();
+
+			for (auto const& file : batch) {
+				try {
+					write_file(file.first, file.second);
+				}
+				catch (agi::Exception const& e) {
+					LOG_E("agi/persist") << "Failed to write " << file.first << ": " << e.GetMessage();
+				}
+				catch (std::exception const& e) {
+					LOG_E("agi/persist") << "Failed to write " << file.first << ": " << e.what();
+				}
+			}
+
+			l.lock();
+			writing = false;
+			idle.notify_all();
+		}
+	}
+
+public:
+	~Writer() {
+		{
+			std::lock_guard<std::mutex> l(lock);
+			stop = true;
+		}
+		wake.notify_one();
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void Write(fs::path const& file, Document document) {
+		std::lock_guard<std::mutex> l(lock);
+		auto now = steady::now();
+		if (pending.empty())
+			oldest = now;
+		pending[file] = std::move(document);
+		deadline = std::min(now + delay, oldest + 5 * delay);
+
+		if (!thread.joinable())
+			thread = std::thread([=] { Run(); });
+		wake.notify_one();
+	}
+
+	void WriteNow(fs::path const& file, json::UnknownElement const& document) {
+		{
+			std::lock_guard<std::mutex> l(lock);
+			pending.erase(file);
+		}
+		std::lock_guard<std::mutex> wl(write_lock);
+		write_file(file, document);
+	}
+
+	void Flush() {
+		std::unique_lock<std::mutex> l(lock);
+		++flushers;
+		wake.notify_one();
+		idle.wait(l, [&] { return pending.empty() && !writing; });
+		--flushers;
+	}
+
+	void SetDelay(std::chrono::milliseconds new_delay) {
+		std::lock_guard<std::mutex> l(lock);
+		delay = new_delay;
+	}
+};
+
+Writer& writer() {
+	static Writer writer;
+	return writer;
+}
+}
+
+namespace agi { namespace persist {
+void Write(fs::path const& file, json::UnknownElement document) {
+	Document doc;
+	doc.json = std::move(document);
+	writer().Write(file, std::move(doc));
+}
+
+void Write(fs::path const& file, std::string text) {
+	Document doc;
+	doc.text = std::move(text);
+	doc.serialized = true;
+	writer().Write(file, std::move(doc));
+}
+
+void WriteNow(fs::path const& file, json::UnknownElement const& document) {
+	writer().WriteNow(file, document);
+}
+
+void Flush() {
+	writer().Flush();
+}
+
+void SetDelay(std::chrono::milliseconds delay) {
+	writer().SetDelay(delay);
+}
+} }
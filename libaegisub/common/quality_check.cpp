@@ -0,0 +1,168 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file quality_check.cpp
+/// @brief Incremental checking of subtitle lines for common problems
+/// @ingroup libaegisub
+
+#include "libaegisub/quality_check.h"
+
+#include "libaegisub/character_count.h"
+#include "libaegisub/dispatch.h"
+#include "libaegisub/trace.h"
+
+#include <algorithm>
+#include <boost/algorithm/string/case_conv.hpp>
+
+namespace {
+/// Below this many lines checking on the calling thread is faster than
+/// handing them out to the background queue
+const size_t lines_per_task = 512;
+
+bool by_time(agi::qc::Line const *a, agi::qc::Line const *b) {
+	if (a->start != b->start) return a->start < b->start;
+	if (a->end != b->end) return a->end < b->end;
+	return a->id < b->id;
+}
+}
+
+namespace agi { namespace qc {
+
+void Checker::CheckLine(Entry& entry) const {
+	auto const& line = entry.line;
+	auto& diag = entry.diag;
+
+	// The overlap flag is set by CheckOverlaps()
+	diag.issues &= ISSUE_OVERLAP;
+	diag.cps = -1;
+
+	// Same rules as the CPS column in the subtitles grid
+	int duration = line.end - line.start;
+	if (duration > 100 && line.text.size() <= static_cast<size_t>(duration))
+		diag.cps = static_cast<int>(CharacterCount(line.text, settings.ignore | IGNORE_BLOCKS) * 1000 / duration);
+	if (settings.max_cps > 0 && diag.cps > settings.max_cps)
+		diag.issues |= ISSUE_CPS;
+
+	diag.line_length = MaxLineLength(line.text, settings.ignore);
+	if (settings.max_line_length > 0 && diag.line_length > settings.max_line_length)
+		diag.issues |= ISSUE_LINE_LENGTH;
+
+	if (!styles.count(boost::to_lower_copy(line.style)))
+		diag.issues |= ISSUE_MISSING_STYLE;
+}
+
+void Checker::CheckLines(std::vector<Entry *> const& entries) const {
+	AGI_TRACE_SCOPE("subtitles", "qc::CheckLines");
+	dispatch::ParallelFor(entries.size(), lines_per_task, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			CheckLine(*entries[i]);
+	});
+}
+
+void Checker::CheckOverlaps() {
+	AGI_TRACE_SCOPE("subtitles", "qc::CheckOverlaps");
+
+	std::vector<Entry *> sorted;
+	sorted.reserve(lines.size());
+	for (auto& entry : lines) {
+		entry.second.diag.issues &= ~ISSUE_OVERLAP;
+		if (!entry.second.line.comment)
+			sorted.push_back(&entry.second);
+	}
+	std::sort(begin(sorted), end(sorted), [](Entry const *a, Entry const *b) {
+		return by_time(&a->line, &b->line);
+	});
+
+	// Every line which is still visible when a line starts overlaps it, but
+	// only the one which ends last can have not been flagged already: any
+	// other visible line either started while an earlier one was visible
+	// or was itself the one ending last until a line which overlaps it
+	// replaced it.
+	Entry *last_ending = nullptr;
+	for (auto entry : sorted) {
+		if (last_ending && entry->line.start < last_ending->line.end) {
+			entry->diag.issues |= ISSUE_OVERLAP;
+			last_ending->diag.issues |= ISSUE_OVERLAP;
+		}
+		if (!last_ending || entry->line.end > last_ending->line.end)
+			last_ending = entry;
+	}
+}
+
+void Checker::SetSettings(Settings const& new_settings) {
+	settings = new_settings;
+
+	std::vector<Entry *> entries;
+	entries.reserve(lines.size());
+	for (auto& entry : lines)
+		entries.push_back(&entry.second);
+	CheckLines(entries);
+}
+
+void Checker::SetStyles(std::vector<std::string> const& names) {
+	styles.clear();
+	for (auto const& name : names)
+		styles.insert(boost::to_lower_copy(name));
+
+	for (auto& entry : lines) {
+		auto& diag = entry.second.diag;
+		diag.issues &= ~ISSUE_MISSING_STYLE;
+		if (!styles.count(boost::to_lower_copy(entry.second.line.style)))
+			diag.issues |= ISSUE_MISSING_STYLE;
+	}
+}
+
+void Checker::Update(std::vector<Line> changed, std::vector<int> const& removed) {
+	for (int id : removed)
+		lines.erase(id);
+
+	std::vector<Entry *> entries;
+	entries.reserve(changed.size());
+	for (auto& line : changed) {
+		auto& entry = lines[line.id];
+		entry.line = std::move(line);
+		entries.push_back(&entry);
+	}
+	CheckLines(entries);
+	CheckOverlaps();
+}
+
+void Checker::Clear() {
+	lines.clear();
+}
+
+Diagnostic Checker::Get(int id) const {
+	auto it = lines.find(id);
+	return it == lines.end() ? Diagnostic() : it->second.diag;
+}
+
+std::vector<int> Checker::LinesWithIssues(int mask) const {
+	std::vector<Line const *> found;
+	for (auto const& entry : lines) {
+		if (entry.second.diag.issues & mask)
+			found.push_back(&entry.second.line);
+	}
+	std::sort(begin(found), end(found), by_time);
+
+	std::vector<int> ids;
+	ids.reserve(found.size());
+	for (auto line : found)
+		ids.push_back(line->id);
+	return ids;
+}
+
+} }
@@ -0,0 +1,131 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file scene_change.cpp
+/// @brief Detection of scene changes in video for use as keyframes
+/// @ingroup libaegisub video
+
+#include "libaegisub/scene_change.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGI_SCENE_CHANGE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+using namespace agi::scene_change;
+
+/// Differences are averaged over this many preceding frames to get the
+/// typical amount of motion in the current scene
+const size_t history_frames = 10;
+/// A frame must differ from the previous one by this many times the typical
+/// difference to be a scene change...
+const uint32_t relative_threshold = 3;
+/// ...and by at least this much per pixel on average, so that a static
+/// scene with a little noise doesn't turn a small change into a cut
+const uint32_t min_pixel_difference = 12;
+/// Minimum number of frames between scene changes, so that flashes and
+/// fades don't produce runs of keyframes
+const int min_scene_length = 8;
+}
+
+namespace agi { namespace scene_change {
+void Thumbnail(const uint8_t *bgra, size_t width, size_t height, size_t pitch, bool flipped, uint8_t *out) {
+	for (size_t ty = 0; ty < thumb_height; ++ty) {
+		size_t y0 = ty * height / thumb_height;
+		size_t y1 = std::max(y0 + 1, (ty + 1) * height / thumb_height);
+		y1 = std::min(y1, height);
+
+		for (size_t tx = 0; tx < thumb_width; ++tx) {
+			size_t x0 = tx * width / thumb_width;
+			size_t x1 = std::max(x0 + 1, (tx + 1) * width / thumb_width);
+			x1 = std::min(x1, width);
+
+			uint64_t sum = 0;
+			for (size_t y = y0; y < y1; ++y) {
+				const uint8_t *row = bgra + (flipped ? height - y - 1 : y) * pitch;
+				for (size_t x = x0; x < x1; ++x) {
+					const uint8_t *px = row + x * 4;
+					// BT.601 luma in 8.8 fixed point
+					sum += 29 * px[0] + 150 * px[1] + 77 * px[2];
+				}
+			}
+
+			size_t count = (y1 - y0) * (x1 - x0);
+			out[ty * thumb_width + tx] = count ? static_cast<uint8_t>(sum / count >> 8) : 0;
+		}
+	}
+}
+
+uint32_t Difference(const uint8_t *a, const uint8_t *b) {
+	static_assert(thumb_size % 16 == 0, "Thumbnail size must be a multiple of the vector size");
+#ifdef AGI_SCENE_CHANGE_SSE2
+	__m128i sum = _mm_setzero_si128();
+	for (size_t i = 0; i < thumb_size; i += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+	}
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+#else
+	uint32_t sum = 0;
+	for (size_t i = 0; i < thumb_size; ++i)
+		sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	return sum;
+#endif
+}
+
+std::vector<int> Detect(std::vector<uint32_t> const& differences) {
+	std::vector<int> scenes;
+	if (differences.empty()) return scenes;
+	scenes.push_back(0);
+
+	const uint64_t min_difference = uint64_t(min_pixel_difference) * thumb_size;
+
+	// Ring buffer of the differences within the current scene
+	std::vector<uint32_t> history;
+	history.reserve(history_frames);
+	size_t history_next = 0;
+	uint64_t history_sum = 0;
+
+	for (size_t i = 1; i < differences.size(); ++i) {
+		uint32_t diff = differences[i];
+		uint64_t typical = history.empty() ? 0 : history_sum / history.size();
+
+		if (diff >= min_difference && diff > typical * relative_threshold && static_cast<int>(i) - scenes.back() >= min_scene_length) {
+			scenes.push_back(static_cast<int>(i));
+			// The motion of the previous scene says nothing about the new one
+			history.clear();
+			history_next = 0;
+			history_sum = 0;
+			continue;
+		}
+
+		if (history.size() < history_frames)
+			history.push_back(diff);
+		else {
+			history_sum -= history[history_next];
+			history[history_next] = diff;
+			history_next = (history_next + 1) % history_frames;
+		}
+		history_sum += diff;
+	}
+
+	return scenes;
+}
+} }
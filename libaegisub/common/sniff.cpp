@@ -0,0 +1,230 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file sniff.cpp
+/// @brief Identification of subtitle and timing files from their contents
+/// @ingroup libaegisub io
+
+#include "libaegisub/sniff.h"
+
+#include "libaegisub/charset.h"
+#include "libaegisub/file_mapping.h"
+#include "libaegisub/fs.h"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace {
+using namespace agi::sniff;
+using boost::starts_with;
+
+/// Cached results are discarded once there are this many
+const size_t max_cache_entries = 64;
+
+struct CacheEntry {
+	time_t modified;
+	uintmax_t size;
+	Result result;
+};
+
+std::mutex cache_lock;
+std::map<agi::fs::path, CacheEntry> cache;
+
+/// Headers which identify the keyframe formats agi::keyframe::Load supports
+const char *keyframe_headers[] = {
+	"# keyframe format v1",
+	"# XviD 2pass stat file",
+	"# ffmpeg 2-pass log file, using xvid codec",
+	"# avconv 2-pass log file, using xvid codec",
+	"##map version",
+	"#options:",
+	"# WWXD log file, using qpfile format",
+};
+
+bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+/// Splits text into lines with surrounding whitespace removed, skipping
+/// blank ones
+class LineReader {
+	std::string const& text;
+	size_t pos = 0;
+
+public:
+	LineReader(std::string const& text, size_t pos) : text(text), pos(pos) { }
+
+	bool Next(std::string& line) {
+		while (pos < text.size()) {
+			size_t end = text.find('\n', pos);
+			if (end == std::string::npos) end = text.size();
+			size_t begin = pos;
+			pos = end + 1;
+
+			while (begin < end && is_space(text[begin])) ++begin;
+			while (end > begin && is_space(text[end - 1])) --end;
+			if (begin < end) {
+				line.assign(text, begin, end - begin);
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+/// Consume a run of digits, returning false if there are none
+bool digits(std::string const& str, size_t& pos) {
+	size_t start = pos;
+	while (pos < str.size() && is_digit(str[pos])) ++pos;
+	return pos > start;
+}
+
+bool all_digits(std::string const& str) {
+	size_t pos = 0;
+	return digits(str, pos) && pos == str.size();
+}
+
+/// {start}{end} or [start][end]
+bool is_microdvd_line(std::string const& line) {
+	size_t pos = 0;
+	for (int i = 0; i < 2; ++i) {
+		if (pos >= line.size() || (line[pos] != '{' && line[pos] != '[')) return false;
+		++pos;
+		if (!digits(line, pos)) return false;
+		if (pos >= line.size() || (line[pos] != '}' && line[pos] != ']')) return false;
+		++pos;
+	}
+	return true;
+}
+
+/// h:mm:ss,mmm --> with either a comma or a period before the milliseconds
+bool is_srt_timing_line(std::string const& line) {
+	size_t pos = 0;
+	for (int i = 0; i < 2; ++i) {
+		if (!digits(line, pos) || pos >= line.size() || line[pos] != ':') return false;
+		++pos;
+	}
+	if (!digits(line, pos) || pos >= line.size() || (line[pos] != ',' && line[pos] != '.')) return false;
+	++pos;
+	if (!digits(line, pos)) return false;
+	while (pos < line.size() && is_space(line[pos])) ++pos;
+	return line.compare(pos, 3, "-->") == 0;
+}
+
+/// Reduce UTF-16 or UTF-32 text to one byte per code unit, replacing
+/// everything outside of ASCII, as all of the signatures are ASCII
+std::string narrow(const char *data, size_t len, size_t width, bool big_endian) {
+	std::string ret;
+	ret.reserve(len / width);
+	for (size_t i = width; i + width <= len; i += width) {
+		uint32_t unit = 0;
+		for (size_t j = 0; j < width; ++j) {
+			auto byte = static_cast<unsigned char>(data[i + (big_endian ? j : width - 1 - j)]);
+			unit = (unit << 8) | byte;
+		}
+		ret += unit < 0x80 ? static_cast<char>(unit) : '?';
+	}
+	return ret;
+}
+
+Result sniff_file(agi::fs::path const& file) {
+	agi::read_file_mapping fp(file);
+	Result ret;
+	ret.encoding = agi::charset::Detect(fp);
+
+	auto len = static_cast<size_t>(std::min<uint64_t>(fp.size(), sniff_bytes));
+	const char *data = len ? fp.read(0, len) : "";
+
+	if (len >= 4 && !memcmp(data, "\x1a\x45\xdf\xa3", 4))
+		ret.format = Format::Matroska;
+	// The GSI block starts with the code page number followed by the
+	// disk format code "STL25.01" or "STL30.01"
+	else if (len >= 11 && !memcmp(data + 3, "STL", 3) && !memcmp(data + 8, ".01", 3))
+		ret.format = Format::Ebu3264;
+	else if (ret.encoding == "binary")
+		ret.format = Format::Binary;
+	else if (ret.encoding == "utf-16le" || ret.encoding == "utf-16be")
+		ret.format = Identify(narrow(data, len, 2, ret.encoding == "utf-16be"));
+	else if (ret.encoding == "utf-32le" || ret.encoding == "utf-32be")
+		ret.format = Identify(narrow(data, len, 4, ret.encoding == "utf-32be"));
+	else
+		ret.format = Identify(std::string(data, len));
+	return ret;
+}
+}
+
+namespace agi { namespace sniff {
+Format Identify(std::string const& text) {
+	LineReader lines(text, starts_with(text, "\xef\xbb\xbf") ? 3 : 0);
+	std::string first;
+	if (!lines.Next(first)) return Format::Unknown;
+
+	if (boost::istarts_with(first, "[Script Info]"))
+		return Format::Ass;
+	if (starts_with(first, "WEBVTT") && (first.size() == 6 || is_space(first[6])))
+		return Format::WebVtt;
+	if (starts_with(first, "<?xml") || starts_with(first, "<TextStream"))
+		return text.find("<TextStream") != std::string::npos ? Format::Ttxt : Format::Unknown;
+	if (starts_with(first, "# timecode format v1") || starts_with(first, "# timecode format v2") || starts_with(first, "Assume "))
+		return Format::Timecodes;
+	for (auto header : keyframe_headers) {
+		if (starts_with(first, header))
+			return Format::Keyframes;
+	}
+	if (is_microdvd_line(first))
+		return Format::MicroDvd;
+	if (is_srt_timing_line(first))
+		return Format::Srt;
+
+	std::string second;
+	if (all_digits(first) && lines.Next(second) && is_srt_timing_line(second))
+		return Format::Srt;
+
+	return Format::Unknown;
+}
+
+Result Sniff(fs::path const& file) {
+	auto modified = fs::ModifiedTime(file);
+	auto size = fs::Size(file);
+
+	{
+		std::lock_guard<std::mutex> l(cache_lock);
+		auto it = cache.find(file);
+		if (it != cache.end() && it->second.modified == modified && it->second.size == size)
+			return it->second.result;
+	}
+
+	auto result = sniff_file(file);
+
+	std::lock_guard<std::mutex> l(cache_lock);
+	if (cache.size() >= max_cache_entries)
+		cache.clear();
+	cache[file] = CacheEntry{modified, size, result};
+	return result;
+}
+
+void ClearCache() {
+	std::lock_guard<std::mutex> l(cache_lock);
+	cache.clear();
+}
+} }
@@ -0,0 +1,203 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file timing_processor.cpp
+/// @brief Batch adjustment of line timing to lead-in, keyframes and speech
+/// @ingroup libaegisub
+
+#include "libaegisub/timing_processor.h"
+
+#include "libaegisub/ass/time.h"
+#include "libaegisub/audio/envelope.h"
+#include "libaegisub/dispatch.h"
+#include "libaegisub/trace.h"
+#include "libaegisub/vfr.h"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+
+namespace {
+using namespace agi::timing;
+
+/// Below this many lines processing on the calling thread is faster than
+/// handing them out to the background queue
+const size_t lines_per_task = 256;
+
+/// Clamp and round a time in the same way as storing it in an agi::Time
+int round_time(int ms) {
+	return agi::Time(ms);
+}
+
+template<typename Func>
+void for_each_line(size_t count, Func&& func) {
+	agi::dispatch::ParallelFor(count, lines_per_task, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			func(i);
+	});
+}
+
+/// Index of the keyframe closest to a frame, preferring the earlier one on ties
+size_t closest_keyframe(std::vector<int> const& keyframes, int frame) {
+	auto pos = std::upper_bound(keyframes.begin(), keyframes.end(), frame);
+	if (pos == keyframes.end()) return keyframes.size() - 1;
+	if (pos != keyframes.begin() && frame - *(pos - 1) <= *pos - frame)
+		--pos;
+	return pos - keyframes.begin();
+}
+
+void snap_to_speech(std::vector<Line *> const& lines, int distance, agi::EnergyEnvelope const& envelope) {
+	for_each_line(lines.size(), [&](size_t i) {
+		Line& line = *lines[i];
+		int start = envelope.NearestOnset(line.start, distance);
+		int end = envelope.NearestOffset(line.end, distance);
+		if (start < 0) start = line.start;
+		if (end < 0) end = line.end;
+		if (start < end) {
+			line.start = round_time(start);
+			line.end = round_time(end);
+		}
+	});
+}
+
+/// Move each start earlier by up to lead_in, but not past the end of an
+/// earlier line which ends before it starts
+void add_lead_in(std::vector<Line *> const& lines, int lead_in) {
+	// As the lines are sorted by start time, an earlier line overlaps a line
+	// exactly when it ends after the line starts, so the limit is the latest
+	// end time no greater than the start time of all the earlier lines
+	std::multiset<int> ends;
+	for (auto line : lines) {
+		int start = line->start - lead_in;
+		auto it = ends.upper_bound(line->start);
+		if (it != ends.begin())
+			start = std::max(start, *std::prev(it));
+		ends.insert(line->end);
+		line->start = round_time(start);
+	}
+}
+
+/// Move each end later by up to lead_out, but not past the start of a later
+/// line which starts after it ends
+void add_lead_out(std::vector<Line *> const& lines, int lead_out) {
+	std::vector<int> ends(lines.size());
+	for_each_line(lines.size(), [&](size_t i) {
+		Line const& line = *lines[i];
+		int end = line.end + lead_out;
+		// Later lines which start after the new end time can't limit it, and
+		// they're sorted by start time so the search can stop at the first
+		for (size_t j = i + 1; j < lines.size() && lines[j]->start < end; ++j) {
+			Line const& next = *lines[j];
+			bool collides = line.start < next.start ? next.start < line.end : line.start < next.end;
+			if (!collides)
+				end = std::min(end, next.start);
+		}
+		ends[i] = round_time(end);
+	});
+
+	for (size_t i = 0; i < lines.size(); ++i)
+		lines[i]->end = ends[i];
+}
+
+/// Close small gaps and overlaps between each line and the next one
+void make_adjacent(std::vector<Line *> const& lines, Settings const& settings) {
+	// Each pair only touches the end of the first line and the start of the
+	// second, so no two pairs touch the same time
+	for_each_line(lines.size(), [&](size_t i) {
+		if (i == 0) return;
+		Line& prev = *lines[i - 1];
+		Line& cur = *lines[i];
+
+		int dist = cur.start - prev.end;
+		if ((dist < 0 && -dist <= settings.adjacent_overlap) || (dist > 0 && dist <= settings.adjacent_gap)) {
+			int pos = round_time(prev.end + int(dist * settings.adjacent_bias));
+			cur.start = pos;
+			prev.end = pos;
+		}
+	});
+}
+
+void snap_to_keyframes(std::vector<Line *> const& lines, Settings const& settings, std::vector<int> const& keyframes, agi::vfr::Framerate const& fps) {
+	if (keyframes.empty()) return;
+
+	// Times which start and end times snap to for each keyframe, computed
+	// once rather than for each line which lands near the keyframe
+	std::vector<int> start_times(keyframes.size());
+	std::vector<int> end_times(keyframes.size());
+	for_each_line(keyframes.size(), [&](size_t i) {
+		start_times[i] = fps.TimeAtFrame(keyframes[i], agi::vfr::START);
+		end_times[i] = fps.TimeAtFrame(keyframes[i] - 1, agi::vfr::END);
+	});
+
+	for_each_line(lines.size(), [&](size_t i) {
+		Line& line = *lines[i];
+		int start_frame = fps.FrameAtTime(line.start, agi::vfr::START);
+		int end_frame = fps.FrameAtTime(line.end, agi::vfr::END);
+
+		size_t kf = closest_keyframe(keyframes, start_frame);
+		int time = start_times[kf];
+		if ((keyframes[kf] > start_frame && time - line.start <= settings.keyframe_before_start) ||
+			(keyframes[kf] < start_frame && line.start - time <= settings.keyframe_after_start))
+			line.start = round_time(time);
+
+		// Lines end on the frame before the keyframe
+		kf = closest_keyframe(keyframes, end_frame);
+		int frame = keyframes[kf] - 1;
+		time = end_times[kf];
+		if ((frame > end_frame && time - line.end <= settings.keyframe_before_end) ||
+			(frame < end_frame && line.end - time <= settings.keyframe_after_end))
+			line.end = round_time(time);
+	});
+}
+
+void sort_by_start(std::vector<Line *>& lines) {
+	std::stable_sort(lines.begin(), lines.end(), [](Line const *a, Line const *b) {
+		return a->start < b->start;
+	});
+}
+}
+
+namespace agi { namespace timing {
+void Process(std::vector<Line>& lines, Settings const& settings, std::vector<int> const& keyframes, vfr::Framerate const& fps, EnergyEnvelope const* envelope) {
+	AGI_TRACE_SCOPE("timing", "timing::Process");
+	if (lines.empty()) return;
+
+	std::vector<Line *> sorted(lines.size());
+	for (size_t i = 0; i < lines.size(); ++i) {
+		sorted[i] = &lines[i];
+		sorted[i]->start = round_time(sorted[i]->start);
+		sorted[i]->end = round_time(sorted[i]->end);
+	}
+	sort_by_start(sorted);
+
+	// Snap to speech first, as the lead-in and lead-out should be relative
+	// to where the speech actually is
+	if (settings.speech && envelope) {
+		snap_to_speech(sorted, settings.speech_distance, *envelope);
+		sort_by_start(sorted);
+	}
+
+	// Lead-in never changes the order of the lines
+	if (settings.lead_in)
+		add_lead_in(sorted, settings.lead_in);
+	if (settings.lead_out)
+		add_lead_out(sorted, settings.lead_out);
+	if (settings.adjacent)
+		make_adjacent(sorted, settings);
+	if (settings.keyframes)
+		snap_to_keyframes(sorted, settings, keyframes, fps);
+}
+} }
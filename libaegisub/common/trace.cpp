@@ -0,0 +1,146 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file trace.cpp
+/// @brief Lightweight timing of hot paths for finding what's slow
+/// @ingroup libaegisub
+
+#include "libaegisub/trace.h"
+
+#include "libaegisub/cajun/elements.h"
+#include "libaegisub/cajun/writer.h"
+
+#include <algorithm>
+#include <boost/core/demangle.hpp>
+#include <map>
+#include <mutex>
+
+namespace {
+using namespace agi::trace;
+using steady = std::chrono::steady_clock;
+
+/// Maximum number of events to keep
+const size_t capacity = 1 << 16;
+
+std::mutex lock;
+/// Ring buffer of events; once full, next wraps around and overwrites the
+/// oldest event
+std::vector<Event> events;
+size_t next = 0;
+steady::time_point epoch;
+
+uint32_t thread_id() {
+	static std::atomic<uint32_t> next_id{0};
+	thread_local uint32_t id = next_id++;
+	return id;
+}
+
+uint64_t microseconds(steady::duration d) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+}
+
+namespace agi { namespace trace {
+namespace detail {
+std::atomic<bool> enabled{false};
+
+void Record(const char *category, const char *name, bool mangled, steady::time_point start) {
+	auto end = steady::now();
+	Event event{category, name, mangled, 0, microseconds(end - start), thread_id()};
+
+	std::lock_guard<std::mutex> l(lock);
+	event.start = start > epoch ? microseconds(start - epoch) : 0;
+	if (events.size() < capacity)
+		events.push_back(event);
+	else
+		events[next] = event;
+	next = (next + 1) % capacity;
+}
+}
+
+void SetEnabled(bool enable) {
+	std::lock_guard<std::mutex> l(lock);
+	if (enable && epoch == steady::time_point())
+		epoch = steady::now();
+	detail::enabled = enable;
+}
+
+void Clear() {
+	std::lock_guard<std::mutex> l(lock);
+	events.clear();
+	next = 0;
+}
+
+std::vector<Event> Events() {
+	std::lock_guard<std::mutex> l(lock);
+	if (events.size() < capacity)
+		return events;
+
+	std::vector<Event> ret;
+	ret.reserve(capacity);
+	ret.insert(ret.end(), events.begin() + next, events.end());
+	ret.insert(ret.end(), events.begin(), events.begin() + next);
+	return ret;
+}
+
+std::string EventName(Event const& event) {
+	return event.mangled ? boost::core::demangle(event.name) : event.name;
+}
+
+std::vector<Summary> Summarize() {
+	std::map<std::pair<const char *, const char *>, Summary> totals;
+	for (auto const& event : Events()) {
+		auto& summary = totals[std::make_pair(event.category, event.name)];
+		if (summary.count == 0) {
+			summary.category = event.category;
+			summary.name = EventName(event);
+		}
+		++summary.count;
+		summary.total += event.duration;
+		summary.max = std::max(summary.max, event.duration);
+	}
+
+	std::vector<Summary> ret;
+	ret.reserve(totals.size());
+	for (auto& total : totals)
+		ret.push_back(std::move(total.second));
+	std::sort(begin(ret), end(ret), [](Summary const& a, Summary const& b) {
+		return a.total > b.total;
+	});
+	return ret;
+}
+
+void WriteChromeTrace(std::ostream& out) {
+	json::Array trace_events;
+	for (auto const& event : Events()) {
+		json::Object obj;
+		obj["name"] = EventName(event);
+		obj["cat"] = event.category;
+		obj["ph"] = "X";
+		obj["ts"] = static_cast<int64_t>(event.start);
+		obj["dur"] = static_cast<int64_t>(event.duration);
+		obj["pid"] = static_cast<int64_t>(1);
+		obj["tid"] = static_cast<int64_t>(event.thread);
+		trace_events.push_back(std::move(obj));
+	}
+
+	json::Object root;
+	root["traceEvents"] = std::move(trace_events);
+	root["displayTimeUnit"] = "ms";
+	JsonWriter::Write(root, out);
+}
+
+} }
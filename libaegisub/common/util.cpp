@@ -15,6 +15,8 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include "libaegisub/util.h"
+
+#include "libaegisub/format.h"
 #include "libaegisub/util_osx.h"
 
 #include <boost/locale/boundary.hpp>
@@ -72,6 +74,15 @@ void parse_blocks(std::vector<std::pair<size_t, size_t>>& blocks, std::string co
 
 namespace agi { namespace util {
 
+std::string float_to_string(double val, int precision) {
+	std::string fmt = "%." + std::to_string(precision) + "f";
+	std::string s = agi::format(fmt.c_str(), val);
+	size_t pos = s.find_last_not_of("0");
+	if (pos != s.find(".")) ++pos;
+	s.erase(begin(s) + pos, end(s));
+	return s;
+}
+
 std::string strftime(const char *fmt, const tm *tmptr) {
 	if (!tmptr) {
 		time_t t = time(nullptr);
@@ -18,9 +18,9 @@
 
 #include "libaegisub/vfr.h"
 
-#include "libaegisub/charset.h"
 #include "libaegisub/io.h"
 #include "libaegisub/line_iterator.h"
+#include "libaegisub/sniff.h"
 
 #include <algorithm>
 #include <boost/interprocess/streams/bufferstream.hpp>
@@ -137,7 +137,7 @@ Framerate::Framerate(double fps)
 {
 	if (fps < 0.) throw InvalidFramerate("FPS must be greater than zero");
 	if (fps > 1000.) throw InvalidFramerate("FPS must not be greater than 1000");
-	timecodes.push_back(0);
+	SetTimecodes({0});
 }
 
 Framerate::Framerate(int64_t numerator, int64_t denominator, bool drop)
@@ -148,44 +148,138 @@ Framerate::Framerate(int64_t numerator, int64_t denominator, bool drop)
 	if (numerator <= 0 || denominator <= 0)
 		throw InvalidFramerate("Numerator and denominator must both be greater than zero");
 	if (numerator / denominator > 1000) throw InvalidFramerate("FPS must not be greater than 1000");
-	timecodes.push_back(0);
+	SetTimecodes({0});
 }
 
-void Framerate::SetFromTimecodes() {
+void Framerate::SetFromTimecodes(std::vector<int> timecodes) {
 	validate_timecodes(timecodes);
 	normalize_timecodes(timecodes);
 	denominator = default_denominator;
 	numerator = (timecodes.size() - 1) * denominator * 1000 / timecodes.back();
 	last = (timecodes.size() - 1) * denominator * 1000;
+	SetTimecodes(timecodes);
+}
+
+void Framerate::SetTimecodes(std::vector<int> const& timecodes) {
+	runs.clear();
+	offsets.clear();
+	frame_count = (int)timecodes.size();
+	last_time = timecodes.back();
+
+	// Frame durations repeat with a period of at most a few hundred frames
+	// for any sensible constant frame rate; e.g. 119.88 fps rounded to
+	// milliseconds repeats every 120 frames. A run has to cover at least
+	// min_periods periods to be worth storing as a run rather than as part
+	// of an irregular section.
+	const int max_period = 256;
+	const int min_periods = 3;
+
+	auto delta = [&](int i) { return timecodes[i + 1] - timecodes[i]; };
+
+	auto add_run = [&](int first, int count, int period) {
+		Run run;
+		run.first_frame = first;
+		run.first_time = timecodes[first];
+		run.count = count;
+		run.period = period;
+		run.period_ms = period < count
+			? timecodes[first + period] - timecodes[first]
+			: timecodes[first + count - 1] - timecodes[first];
+		run.offset = offsets.size();
+		for (int i = 0; i < period; ++i)
+			offsets.push_back(timecodes[first + i] - run.first_time);
+		runs.push_back(run);
+	};
+
+	int irregular_start = 0;
+	int i = 0;
+	while (i < frame_count) {
+		// Find the period which repeats for the longest span from here. Short
+		// periods can match rounded timecodes locally without being the
+		// actual period (e.g. 119.88 fps looks like it has a period of three
+		// frames for a while), so every candidate has to be checked.
+		int period = 0;
+		int end = 0;
+		for (int p = 1; p <= max_period && i + p * min_periods < frame_count; ++p) {
+			int j = i + p;
+			while (j + 1 < frame_count && delta(j) == delta(j - p))
+				++j;
+			if (j >= i + p * min_periods && j > end) {
+				period = p;
+				end = j;
+				if (end + 1 == frame_count)
+					break;
+			}
+		}
+
+		if (!period) {
+			++i;
+			continue;
+		}
+
+		if (irregular_start < i)
+			add_run(irregular_start, i - irregular_start, i - irregular_start);
+
+		add_run(i, end - i + 1, period);
+		i = irregular_start = end + 1;
+	}
+
+	if (irregular_start < frame_count)
+		add_run(irregular_start, frame_count - irregular_start, frame_count - irregular_start);
+}
+
+std::vector<Framerate::Run>::const_iterator Framerate::RunAtFrame(int frame) const {
+	return std::prev(std::upper_bound(begin(runs), end(runs), frame,
+		[](int frame, Run const& run) { return frame < run.first_frame; }));
+}
+
+int Framerate::FrameInRun(Run const& run, int ms) const {
+	int64_t rem = ms - run.first_time;
+	if (run.period_ms == 0)
+		return run.count - 1;
+
+	int64_t periods = rem / run.period_ms;
+	rem -= periods * run.period_ms;
+
+	auto first = begin(offsets) + run.offset;
+	int64_t frame = periods * run.period
+		+ std::distance(first, std::upper_bound(first, first + run.period, (int)rem)) - 1;
+	return (int)std::min<int64_t>(frame, run.count - 1);
+}
+
+int Framerate::TimeInRun(Run const& run, int frame) const {
+	frame -= run.first_frame;
+	return run.first_time + frame / run.period * run.period_ms + offsets[run.offset + frame % run.period];
 }
 
 Framerate::Framerate(std::vector<int> timecodes)
-: timecodes(std::move(timecodes))
 {
-	SetFromTimecodes();
+	SetFromTimecodes(std::move(timecodes));
 }
 
 Framerate::Framerate(std::initializer_list<int> timecodes)
-: timecodes(timecodes)
 {
-	SetFromTimecodes();
+	SetFromTimecodes(timecodes);
 }
 
 Framerate::Framerate(fs::path const& filename)
 : denominator(default_denominator)
 {
 	auto file = agi::io::Open(filename);
-	auto encoding = agi::charset::Detect(filename);
+	auto encoding = agi::sniff::Sniff(filename).encoding;
 	auto line = *line_iterator<std::string>(*file, encoding);
 	if (line == "# timecode format v2") {
+		std::vector<int> timecodes;
 		copy(line_iterator<int>(*file, encoding), line_iterator<int>(), back_inserter(timecodes));
-		SetFromTimecodes();
+		SetFromTimecodes(std::move(timecodes));
 		return;
 	}
 	if (line == "# timecode format v1" || line.substr(0, 7) == "Assume ") {
 		if (line[0] == '#')
 			line = *line_iterator<std::string>(*file, encoding);
+		std::vector<int> timecodes;
 		numerator = v1_parse(line_iterator<std::string>(*file, encoding), line, timecodes, last);
+		SetTimecodes(timecodes);
 		return;
 	}
 
@@ -197,8 +291,11 @@ void Framerate::Save(fs::path const& filename, int length) const {
 	auto &out = file.Get();
 
 	out << "# timecode format v2\n";
-	boost::copy(timecodes, std::ostream_iterator<int>(out, "\n"));
-	for (int written = (int)timecodes.size(); written < length; ++written)
+	for (auto const& run : runs) {
+		for (int frame = run.first_frame; frame < run.first_frame + run.count; ++frame)
+			out << TimeInRun(run, frame) << '\n';
+	}
+	for (int written = frame_count; written < length; ++written)
 		out << TimeAtFrame(written) << std::endl;
 }
 
@@ -224,10 +321,49 @@ int Framerate::FrameAtTime(int ms, Time type) const {
 	if (ms < 0)
 		return int((ms * numerator / denominator - 999) / 1000);
 
-	if (ms > timecodes.back())
-		return int((ms * numerator - numerator / 2 - last + numerator - 1) / denominator / 1000) + (int)timecodes.size() - 1;
+	if (ms > last_time)
+		return int((ms * numerator - numerator / 2 - last + numerator - 1) / denominator / 1000) + frame_count - 1;
+
+	// Find the last run starting at or before the given time, as consecutive
+	// runs may share a start time if there are duplicate timecodes
+	auto run = std::prev(std::upper_bound(begin(runs), end(runs), ms,
+		[](int ms, Run const& run) { return ms < run.first_time; }));
+	return run->first_frame + FrameInRun(*run, ms);
+}
+
+std::vector<int> Framerate::FramesAtTimes(std::vector<int> const& times, Time type) const {
+	std::vector<int> frames;
+	frames.reserve(times.size());
+
+	// Remember the run used for the previous time, since for sorted input
+	// the next time is usually in either the same run or the one after it
+	auto run = begin(runs);
+	auto in_run = [&](std::vector<Run>::const_iterator it, int ms) {
+		return it->first_time <= ms && (next(it) == end(runs) || next(it)->first_time > ms);
+	};
+
+	for (int ms : times) {
+		if (type != EXACT)
+			--ms;
+
+		int frame;
+		if (ms < 0 || ms > last_time)
+			frame = FrameAtTime(ms);
+		else {
+			if (!in_run(run, ms)) {
+				if (next(run) != end(runs) && in_run(next(run), ms))
+					++run;
+				else
+					run = std::prev(std::upper_bound(begin(runs), end(runs), ms,
+						[](int ms, Run const& run) { return ms < run.first_time; }));
+			}
+			frame = run->first_frame + FrameInRun(*run, ms);
+		}
+
+		frames.push_back(type == START ? frame + 1 : frame);
+	}
 
-	return (int)distance(lower_bound(timecodes.rbegin(), timecodes.rend(), ms, std::greater<int>()), timecodes.rend()) - 1;
+	return frames;
 }
 
 int Framerate::TimeAtFrame(int frame, Time type) const {
@@ -247,12 +383,50 @@ int Framerate::TimeAtFrame(int frame, Time type) const {
 	if (frame < 0)
 		return (int)(frame * denominator * 1000 / numerator);
 
-	if (frame >= (signed)timecodes.size()) {
-		int64_t frames_past_end = frame - (int)timecodes.size() + 1;
+	if (frame >= frame_count) {
+		int64_t frames_past_end = frame - frame_count + 1;
 		return int((frames_past_end * 1000 * denominator + last + numerator / 2) / numerator);
 	}
 
-	return timecodes[frame];
+	return TimeInRun(*RunAtFrame(frame), frame);
+}
+
+std::vector<int> Framerate::TimesAtFrames(std::vector<int> const& frames, Time type) const {
+	std::vector<int> times;
+	times.reserve(frames.size());
+
+	auto run = begin(runs);
+	auto in_run = [&](std::vector<Run>::const_iterator it, int frame) {
+		return frame >= it->first_frame && frame < it->first_frame + it->count;
+	};
+	auto time_at = [&](int frame) {
+		if (frame < 0 || frame >= frame_count)
+			return TimeAtFrame(frame);
+		if (!in_run(run, frame)) {
+			if (next(run) != end(runs) && in_run(next(run), frame))
+				++run;
+			else
+				run = RunAtFrame(frame);
+		}
+		return TimeInRun(*run, frame);
+	};
+
+	for (int frame : frames) {
+		if (type == START) {
+			int prev = time_at(frame - 1);
+			int cur = time_at(frame);
+			times.push_back(prev + (cur - prev + 1) / 2);
+		}
+		else if (type == END) {
+			int cur = time_at(frame);
+			int next = time_at(frame + 1);
+			times.push_back(cur + (next - cur + 1) / 2);
+		}
+		else
+			times.push_back(time_at(frame));
+	}
+
+	return times;
 }
 
 void Framerate::SmpteAtFrame(int frame, int *h, int *m, int *s, int *f) const {
@@ -80,6 +80,17 @@ namespace agi {
 		/// Tokenize the passed string as the body of a dialogue line
 		std::vector<DialogueToken> TokenizeDialogueBody(std::string const& str, bool karaoke_templater=false);
 
+		/// @brief Tokenize an edited string, reusing the tokens of the string before the edit
+		/// @param old_str String before the edit
+		/// @param old_tokens TokenizeDialogueBody(old_str) (not split into words)
+		/// @param str String after the edit
+		///
+		/// Only the override blocks around the part of the string which
+		/// changed are lexed again, so small edits to very long lines are
+		/// cheap. The result is the same as TokenizeDialogueBody(str).
+		/// Karaoke templater lines are always lexed in full.
+		std::vector<DialogueToken> RetokenizeDialogueBody(std::string const& old_str, std::vector<DialogueToken> const& old_tokens, std::string const& str, bool karaoke_templater=false);
+
 		/// Convert the body of drawings to DRAWING tokens
 		void MarkDrawings(std::string const& str, std::vector<DialogueToken> &tokens);
 
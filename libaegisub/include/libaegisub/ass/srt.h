@@ -0,0 +1,72 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file srt.h
+/// @brief Parsing and formatting of SubRip and WebVTT subtitles
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <libaegisub/exception.h>
+
+#include <string>
+#include <vector>
+
+namespace agi { namespace ass {
+DEFINE_EXCEPTION(SrtParseError, InvalidInputException);
+
+/// The two closely related formats handled here. WebVTT has a header, a
+/// different timestamp format, optional cue identifiers, entities and a
+/// different set of tags, but is otherwise the same as SubRip.
+enum class SrtDialect {
+	SubRip,
+	WebVtt
+};
+
+struct SrtCue {
+	/// Start time in milliseconds
+	int start = 0;
+	/// End time in milliseconds
+	int end = 0;
+	/// Text of the cue with lines joined by \N, and tags not yet converted
+	std::string text;
+};
+
+/// @brief Parse a SubRip or WebVTT file
+/// @param begin Start of the file's contents, in UTF-8
+/// @param end End of the file's contents
+/// @param dialect Format of the file
+///
+/// This is a single pass over the file and does no allocation other than for
+/// the cues themselves, so it's suitable for use on a mapped file. Converting
+/// the cues' text is left to SrtToAss so that it can be done in parallel.
+/// @throws SrtParseError if the file is malformed
+std::vector<SrtCue> ParseSrt(const char *begin, const char *end, SrtDialect dialect);
+
+/// @brief Convert the HTML-like tags in the text of a cue to ASS overrides
+///
+/// SubRip's b, i, u, s and font tags and WebVTT's b, i and u tags are
+/// converted, as are WebVTT's entities. Other WebVTT tags are dropped, while
+/// other SubRip tags are left as-is.
+std::string SrtToAss(std::string const& text, SrtDialect dialect);
+
+/// Format a time in milliseconds as a SubRip or WebVTT timestamp
+std::string SrtTime(int ms, SrtDialect dialect);
+
+/// Escape the characters which can't appear as-is in WebVTT cue text
+std::string EscapeWebVtt(std::string const& text);
+} }
@@ -0,0 +1,96 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file transform.h
+/// @brief Per-line arithmetic of the resolution and framerate transforms
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <libaegisub/vfr.h>
+
+#include <string>
+
+namespace agi { namespace ass {
+	/// @brief Scale and shift the coordinates of a vector drawing
+	/// @param drawing Drawing commands, as in \p or \clip
+	/// @param shift_x Amount to add to each X coordinate before scaling
+	/// @param shift_y Amount to add to each Y coordinate before scaling
+	/// @param scale_x Horizontal scale factor
+	/// @param scale_y Vertical scale factor
+	/// @return The transformed drawing, with coordinates rounded to eighths
+	///         of a pixel and anything unrecognized dropped
+	std::string TransformDrawing(std::string const& drawing, int shift_x, int shift_y, double scale_x, double scale_y);
+
+	/// @class FramerateTransform
+	/// @brief Convert times between frame rates, keeping each time on the
+	///        same frame
+	///
+	/// Only reads its members once constructed, so one transform may be used
+	/// from several threads at once.
+	class FramerateTransform {
+		vfr::Framerate from;
+		vfr::Framerate to;
+
+	public:
+		/// @param from Frame rate which times are currently relative to
+		/// @param to Frame rate to convert times to
+		FramerateTransform(vfr::Framerate from, vfr::Framerate to);
+
+		/// @brief Convert a time
+		/// @param time Time in ms to convert
+		/// @return Time in ms
+		///
+		/// This preserves two things:
+		///   1. The frame number
+		///   2. The relative distance between the beginning of the frame which
+		///      time is in and the beginning of the next frame
+		int ConvertTime(int time) const;
+
+		/// @class Line
+		/// @brief Conversion of a single line and the times in its override tags
+		///
+		/// Tags must be converted in the order they appear in the line, as
+		/// karaoke durations depend on the ones before them.
+		class Line {
+			FramerateTransform const& transform;
+			int start;
+			int end;
+			int new_start;
+			int new_end;
+			int old_k = 0;
+			int new_k = 0;
+
+		public:
+			/// @param transform Transform to apply
+			/// @param start Start time of the line in ms
+			/// @param end End time of the line in ms
+			Line(FramerateTransform const& transform, int start, int end);
+
+			/// New start time of the line
+			int Start() const { return new_start; }
+			/// New end time of the line
+			int End() const { return new_end; }
+
+			/// Convert a tag time which is relative to the start of the line
+			int RelativeToStart(int value);
+			/// Convert a tag time which is relative to the end of the line
+			int RelativeToEnd(int value);
+			/// Convert a karaoke duration in centiseconds
+			int Karaoke(int value);
+		};
+	};
+} }
@@ -0,0 +1,88 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace agi {
+class AudioProvider;
+
+/// @class EnergyEnvelope
+/// @brief RMS energy of a stream of audio along with where speech appears to
+///        start and stop
+///
+/// The energy is stored as one byte per window, so an hour of audio takes
+/// about 350 KB. Speech is found by thresholding the energy relative to the
+/// noise floor of the whole stream with hysteresis, which is crude but works
+/// well for dialogue over quiet or steady backgrounds.
+class EnergyEnvelope {
+	/// Energy of each window in half-decibels above -96 dBFS
+	std::vector<uint8_t> levels;
+	/// Start times in milliseconds of each detected speech segment
+	std::vector<int> onsets;
+	/// End times in milliseconds of each detected speech segment
+	std::vector<int> offsets;
+
+	void Segment();
+
+public:
+	/// Length of each window in milliseconds
+	static const int window_ms = 10;
+
+	/// Number of level steps per decibel
+	static const int steps_per_db = 2;
+
+	/// @brief Build an envelope from precomputed window levels
+	/// @param levels Energy of each window, in the same units as Levels()
+	explicit EnergyEnvelope(std::vector<uint8_t> levels);
+
+	/// @brief Compute the envelope of an audio provider
+	/// @param provider Provider to read audio from
+	/// @param cancelled Polled between blocks of audio; if it ever returns
+	///                  true, UserCancelException is thrown
+	///
+	/// If the provider is a cache which is still filling, this waits for
+	/// each block of audio to be decoded before reading it. Audio is read with
+	/// GetInt16MonoAudioUncached so that a bounded cache isn't flushed by
+	/// the scan.
+	static std::unique_ptr<EnergyEnvelope> Compute(AudioProvider const& provider, std::function<bool ()> const& cancelled);
+
+	/// Energy of each window in half-decibels above -96 dBFS
+	std::vector<uint8_t> const& Levels() const { return levels; }
+
+	/// Start times in milliseconds of each detected speech segment, sorted
+	std::vector<int> const& Onsets() const { return onsets; }
+
+	/// End times in milliseconds of each detected speech segment, sorted
+	std::vector<int> const& Offsets() const { return offsets; }
+
+	/// @brief Find the speech onset nearest to a time
+	/// @param ms Time in milliseconds
+	/// @param max_distance Maximum distance from ms to accept
+	/// @return Time of the onset, or -1 if there are none within range
+	int NearestOnset(int ms, int max_distance) const;
+
+	/// @brief Find the speech offset nearest to a time
+	/// @param ms Time in milliseconds
+	/// @param max_distance Maximum distance from ms to accept
+	/// @return Time of the offset, or -1 if there are none within range
+	int NearestOffset(int ms, int max_distance) const;
+};
+}
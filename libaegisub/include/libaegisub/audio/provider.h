@@ -24,6 +24,24 @@
 #include <memory>
 
 namespace agi {
+/// Usage statistics for a caching audio provider
+struct AudioCacheStats {
+	/// Number of block lookups which found the block already decoded
+	uint64_t hits = 0;
+	/// Number of block lookups which had to wait for the block to be decoded
+	uint64_t misses = 0;
+	/// Number of blocks decoded ahead of time in the background
+	uint64_t prefetched = 0;
+	/// Number of blocks discarded to stay within the size limit
+	uint64_t evictions = 0;
+	/// Number of blocks decoded for a single pass without being cached
+	uint64_t uncached = 0;
+	/// Bytes of decoded audio currently cached
+	size_t bytes = 0;
+	/// Maximum bytes of decoded audio to cache
+	size_t max_bytes = 0;
+};
+
 class AudioProvider {
 protected:
 	int channels = 0;
@@ -38,6 +56,12 @@ protected:
 
 	virtual void FillBuffer(void *buf, int64_t start, int64_t count) const = 0;
 	virtual void FillBufferInt16Mono(int16_t* buf, int64_t start, int64_t count) const;
+	/// FillBuffer for a single pass over the audio. Providers which keep a
+	/// bounded amount of decoded audio override this to not cache it.
+	virtual void FillBufferUncached(void *buf, int64_t start, int64_t count) const { FillBuffer(buf, start, count); }
+
+	void FillInt16Mono(int16_t* buf, int64_t start, int64_t count, bool uncached) const;
+	void GetInt16Mono(int16_t* buf, int64_t start, int64_t count, bool uncached) const;
 
 	void ZeroFill(void *buf, int64_t count) const;
 
@@ -48,6 +72,12 @@ public:
 	void GetAudioWithVolume(void *buf, int64_t start, int64_t count, double volume) const;
 	void GetInt16MonoAudio(int16_t* buf, int64_t start, int64_t count) const;
 	void GetInt16MonoAudioWithVolume(int16_t *buf, int64_t start, int64_t count, double volume) const;
+	/// @brief Get audio for a single pass over the whole file
+	///
+	/// The same as GetInt16MonoAudio, except that providers which keep a
+	/// bounded amount of decoded audio don't cache what this decodes, so
+	/// that a scan of the file doesn't evict the audio being worked on.
+	void GetInt16MonoAudioUncached(int16_t* buf, int64_t start, int64_t count) const;
 
 	int64_t GetNumSamples()     const { return num_samples; }
 	int64_t GetDecodedSamples() const { return decoded_samples; }
@@ -58,6 +88,15 @@ public:
 
 	/// Does this provider benefit from external caching?
 	virtual bool NeedsCache() const { return false; }
+
+	/// @brief Hint that a range of audio is likely to be needed soon
+	///
+	/// Caching providers which decode on demand start decoding the range in
+	/// the background; everything else ignores this.
+	virtual void Prefetch(int64_t start, int64_t count) const { }
+
+	/// Get usage statistics for the cache, if this is a caching provider
+	virtual AudioCacheStats GetCacheStats() const { return AudioCacheStats(); }
 };
 
 /// Helper base class for an audio provider which wraps another provider
@@ -94,6 +133,14 @@ std::unique_ptr<AudioProvider> CreateConvertAudioProvider(std::unique_ptr<AudioP
 std::unique_ptr<AudioProvider> CreateLockAudioProvider(std::unique_ptr<AudioProvider> source_provider);
 std::unique_ptr<AudioProvider> CreateHDAudioProvider(std::unique_ptr<AudioProvider> source_provider, fs::path const& dir);
 std::unique_ptr<AudioProvider> CreateRAMAudioProvider(std::unique_ptr<AudioProvider> source_provider);
+/// @brief Create a provider which keeps a bounded number of decoded blocks in memory
+/// @param source_provider Provider to cache, which must support seeking
+/// @param max_bytes Approximate maximum bytes of decoded audio to keep
+///
+/// Blocks are decoded when they're first requested or when a range including
+/// them is prefetched, and the least recently used ones are discarded once
+/// the limit is reached.
+std::unique_ptr<AudioProvider> CreateBlockCacheAudioProvider(std::unique_ptr<AudioProvider> source_provider, size_t max_bytes);
 
 void SaveAudioClip(AudioProvider const& provider, fs::path const& path, int start_time, int end_time);
 }
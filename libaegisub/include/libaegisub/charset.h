@@ -21,6 +21,8 @@
 #include <string>
 
 namespace agi {
+	class read_file_mapping;
+
 	/// Character set conversion and detection.
 	namespace charset {
 
@@ -29,5 +31,12 @@ namespace agi {
 /// @return Detected character set.
 std::string Detect(agi::fs::path const& file);
 
+/// @brief Returns the character set with the highest confidence
+/// @param file Already-opened file to check
+///
+/// Stops reading as soon as the file is certainly UTF-8 or more data would
+/// not change the answer, so this is usually cheap even for large files.
+std::string Detect(agi::read_file_mapping& file);
+
 	} // namespace util
 } // namespace agi
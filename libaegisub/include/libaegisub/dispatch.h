@@ -14,6 +14,8 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -21,19 +23,130 @@ namespace agi {
 	namespace dispatch {
 		typedef std::function<void()> Thunk;
 
+		/// Scheduling class of work run on the background thread pool
+		///
+		/// Pending work of a higher priority is always started before pending
+		/// work of a lower priority, but work which has already started is
+		/// never interrupted.
+		enum class Priority {
+			/// Work the user is actively waiting on
+			High,
+			/// Everything else
+			Normal,
+			/// Speculative or housekeeping work which can be delayed freely
+			Low
+		};
+
+		/// A flag shared between the code which schedules work and the work
+		/// itself, used to abandon work which is no longer needed
+		class CancellationToken {
+			std::shared_ptr<std::atomic<bool>> cancelled;
+		public:
+			CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) { }
+
+			/// Request cancellation. Thunks which have not yet started will
+			/// not be run, and running ones can check IsCancelled().
+			void Cancel() { *cancelled = true; }
+			bool IsCancelled() const { return *cancelled; }
+		};
+
+		/// Counters describing the work submitted to a queue
+		struct QueueStats {
+			/// Thunks submitted but not yet started
+			uint64_t queued = 0;
+			/// Thunks which have finished running
+			uint64_t completed = 0;
+			/// Thunks which were skipped due to being cancelled
+			uint64_t cancelled = 0;
+			/// Total time in microseconds completed thunks spent waiting to
+			/// be started
+			uint64_t total_latency = 0;
+			/// Longest time in microseconds any thunk spent waiting to be
+			/// started
+			uint64_t max_latency = 0;
+		};
+
 		class Queue {
 			virtual void DoInvoke(Thunk thunk)=0;
+
+			/// Counters backing GetStats(), shared with pending thunks so that
+			/// they can outlive the queue
+			struct Counters;
+			std::shared_ptr<Counters> counters;
+
+		protected:
+			/// Wrap a thunk to update this queue's counters and skip it if
+			/// the token has been cancelled by the time it would run
+			Thunk Track(Thunk thunk, CancellationToken token);
+
 		public:
-			virtual ~Queue() { }
+			Queue();
+			virtual ~Queue();
 
 			/// Invoke the thunk on this processing queue, returning immediately
 			void Async(Thunk thunk);
 
+			/// Invoke the thunk on this processing queue, returning immediately
+			///
+			/// The thunk is not run at all if the token is cancelled before it
+			/// starts.
+			void Async(Thunk thunk, CancellationToken token);
+
 			/// Invoke the thunk on this processing queue, returning only when
 			/// it's complete
 			void Sync(Thunk thunk);
+
+			/// Get a snapshot of the counters for this queue
+			QueueStats GetStats() const;
 		};
 
+		/// A set of thunks which can be waited on or followed by a
+		/// continuation as a unit
+		class TaskGroup {
+			struct State;
+			std::shared_ptr<State> state;
+		public:
+			TaskGroup();
+			~TaskGroup();
+
+			/// Invoke the thunk on the given queue as part of this group
+			///
+			/// Thunks are not started once the group has been cancelled.
+			/// Exceptions thrown by the thunk are rethrown from Wait().
+			void Async(Queue& queue, Thunk thunk);
+
+			/// Block until every thunk added to the group so far has finished
+			/// and the continuations added with Then() have been queued
+			///
+			/// Rethrows the first exception thrown by any of the thunks.
+			void Wait();
+
+			/// Invoke a thunk on the given queue once every thunk added to the
+			/// group so far has finished, returning immediately
+			void Then(Queue& queue, Thunk thunk);
+
+			/// Cancel all thunks in the group which have not yet started
+			void Cancel();
+
+			/// Get the token used by the thunks in this group, for checking
+			/// for cancellation from within long-running thunks
+			CancellationToken Token() const;
+		};
+
+		/// Run a function over the range [0, count) in parallel on the
+		/// background queue and the calling thread, and wait for it to finish
+		/// @param count Number of items
+		/// @param chunk_size Number of consecutive items to give each thunk
+		/// @param fn Function called with the half-open range of items to process
+		///
+		/// Ranges never overlap, so fn can write to per-item output without
+		/// locking. If the whole range fits in one chunk it is run on the
+		/// calling thread. The calling thread runs chunks itself rather than
+		/// only waiting, so this may be called from thunks on any queue.
+		/// Rethrows the first exception thrown by fn, after which no more
+		/// chunks are started.
+		void ParallelFor(size_t count, size_t chunk_size, std::function<void (size_t, size_t)> const& fn);
+
 		/// Initialize the dispatch thread pools
 		/// @param invoke_main A function which invokes the thunk on the GUI thread
 		void Init(std::function<void (Thunk)> invoke_main);
@@ -42,9 +155,11 @@ namespace agi {
 		Queue& Main();
 
 		/// Get the generic background queue, which runs thunks in parallel
-		Queue& Background();
+		/// @param priority Scheduling class for thunks on the queue
+		Queue& Background(Priority priority = Priority::Normal);
 
 		/// Create a new serial queue
-		std::unique_ptr<Queue> Create();
+		/// @param priority Scheduling class for thunks on the queue
+		std::unique_ptr<Queue> Create(Priority priority = Priority::Normal);
 	}
 }
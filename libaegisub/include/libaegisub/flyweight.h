@@ -0,0 +1,234 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file flyweight.h
+/// @brief Interned immutable values which can be shared between threads
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace agi {
+namespace flyweight_detail {
+/// An interned value and its reference count
+struct Node {
+	/// Number of flyweights referring to this node. Only ever drops from 1 to
+	/// 0 or rises from 0 to 1 with the lock of the node's shard held, so
+	/// copying and destroying a flyweight which isn't the last reference to
+	/// its value never has to lock anything.
+	std::atomic<size_t> refs{1};
+	/// Hash of key, cached to find the shard again on release
+	size_t hash = 0;
+	/// The bytes of the value, which are what the table is keyed on
+	std::string_view key;
+	/// Delete this node
+	void (*destroy)(Node *) = nullptr;
+};
+
+template<typename T>
+struct ValueNode final : Node {
+	T value;
+
+	template<typename... Args>
+	ValueNode(Args&&... args) : value(std::forward<Args>(args)...) { }
+};
+
+/// Get the bytes which identify a value
+inline std::string_view key_of(std::string const& str) { return str; }
+inline std::string_view key_of(std::string_view str) { return str; }
+template<typename T>
+std::string_view key_of(std::vector<T> const& vec) {
+	static_assert(std::is_trivially_copyable<T>::value, "vectors are compared bytewise");
+	return std::string_view(reinterpret_cast<const char *>(vec.data()), vec.size() * sizeof(T));
+}
+
+/// @class InternTable
+/// @brief A set of interned values split into independently locked shards
+///
+/// Interning a value locks only the shard its hash falls in, so threads
+/// interning different values rarely wait on each other.
+class InternTable {
+	struct alignas(64) Shard {
+		std::mutex lock;
+		std::unordered_map<std::string_view, Node *> nodes;
+	};
+	static const size_t shard_count = 64;
+	std::array<Shard, shard_count> shards;
+
+	Shard& ShardFor(size_t hash) { return shards[(hash >> 8) % shard_count]; }
+	void ReleaseLast(Node *node);
+
+public:
+	/// @brief Get a new reference to the node for a key
+	/// @param key Bytes of the value to look up
+	/// @param create Called with arg to create the node if there isn't one
+	Node *Acquire(std::string_view key, Node *(*create)(void *arg), void *arg);
+
+	/// Drop a reference to a node, deleting it if it was the last one
+	void Release(Node *node) {
+		size_t refs = node->refs.load(std::memory_order_relaxed);
+		while (refs > 1) {
+			if (node->refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release, std::memory_order_relaxed))
+				return;
+		}
+		ReleaseLast(node);
+	}
+};
+}
+
+/// @class flyweight
+/// @brief A reference to an interned immutable value
+///
+/// A replacement for boost::flyweight with the same interface. Copying,
+/// comparing for equality and destroying are just atomic operations on the
+/// value's reference count, and interning a new value locks only one shard
+/// of the table rather than a global mutex, so background threads copying
+/// entire files don't contend with the GUI thread. Strings can be interned
+/// from a pointer and length without first building a std::string.
+template<typename T>
+class flyweight {
+	using Node = flyweight_detail::ValueNode<T>;
+	Node *node;
+
+	static flyweight_detail::InternTable& table() {
+		// Deliberately leaked so that flyweights with static storage
+		// duration can be destroyed in any order
+		static auto table = new flyweight_detail::InternTable;
+		return *table;
+	}
+
+	template<typename Arg>
+	static Node *intern(std::string_view key, Arg&& arg) {
+		using ArgType = typename std::remove_reference<Arg>::type;
+		return static_cast<Node *>(table().Acquire(key, [](void *arg) -> flyweight_detail::Node * {
+			auto node = new Node(std::forward<Arg>(*static_cast<ArgType *>(arg)));
+			node->key = flyweight_detail::key_of(node->value);
+			node->destroy = [](flyweight_detail::Node *node) { delete static_cast<Node *>(node); };
+			return node;
+		}, const_cast<void *>(static_cast<const void *>(&arg))));
+	}
+
+	template<typename... Args>
+	static Node *make(Args&&... args) {
+		if constexpr (std::is_same<T, std::string>::value && std::is_constructible<std::string_view, Args...>::value) {
+			std::string_view str(std::forward<Args>(args)...);
+			return intern(str, str);
+		}
+		else {
+			T value(std::forward<Args>(args)...);
+			return intern(flyweight_detail::key_of(value), std::move(value));
+		}
+	}
+
+	static Node *default_node() {
+		// Never released, so default-constructing doesn't need the table
+		static Node *node = intern(flyweight_detail::key_of(T()), T());
+		return node;
+	}
+
+public:
+	using value_type = T;
+
+	flyweight() : node(default_node()) {
+		node->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	explicit flyweight(T const& value) : node(intern(flyweight_detail::key_of(value), value)) { }
+	explicit flyweight(T&& value) : node(intern(flyweight_detail::key_of(value), std::move(value))) { }
+
+	template<typename Arg, typename... Args, typename = typename std::enable_if<
+		sizeof...(Args) != 0 || !std::is_same<typename std::decay<Arg>::type, flyweight>::value>::type>
+	explicit flyweight(Arg&& arg, Args&&... args)
+	: node(make(std::forward<Arg>(arg), std::forward<Args>(args)...))
+	{
+	}
+
+	flyweight(flyweight const& other) : node(other.node) {
+		node->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	~flyweight() {
+		table().Release(node);
+	}
+
+	flyweight& operator=(flyweight const& other) {
+		if (node != other.node) {
+			other.node->refs.fetch_add(1, std::memory_order_relaxed);
+			table().Release(node);
+			node = other.node;
+		}
+		return *this;
+	}
+
+	flyweight& operator=(T const& value) { return *this = flyweight(value); }
+	flyweight& operator=(T&& value) { return *this = flyweight(std::move(value)); }
+	template<typename Arg, typename = typename std::enable_if<
+		!std::is_same<typename std::decay<Arg>::type, flyweight>::value &&
+		!std::is_same<typename std::decay<Arg>::type, T>::value>::type>
+	flyweight& operator=(Arg&& arg) { return *this = flyweight(std::forward<Arg>(arg)); }
+
+	T const& get() const { return node->value; }
+	operator T const&() const { return node->value; }
+
+	void swap(flyweight& other) { std::swap(node, other.node); }
+
+	friend bool operator==(flyweight const& lft, flyweight const& rgt) { return lft.node == rgt.node; }
+	friend bool operator!=(flyweight const& lft, flyweight const& rgt) { return lft.node != rgt.node; }
+	friend bool operator<(flyweight const& lft, flyweight const& rgt) { return lft.node != rgt.node && lft.get() < rgt.get(); }
+	friend bool operator>(flyweight const& lft, flyweight const& rgt) { return rgt < lft; }
+	friend bool operator<=(flyweight const& lft, flyweight const& rgt) { return !(rgt < lft); }
+	friend bool operator>=(flyweight const& lft, flyweight const& rgt) { return !(lft < rgt); }
+};
+
+template<typename T> struct is_flyweight : std::false_type { };
+template<typename T> struct is_flyweight<flyweight<T>> : std::true_type { };
+
+/// Comparisons with things other than flyweights compare the values
+#define AGI_FLYWEIGHT_COMPARE(op) \
+	template<typename T, typename U, typename = typename std::enable_if<!is_flyweight<U>::value>::type> \
+	bool operator op(flyweight<T> const& lft, U const& rgt) { return lft.get() op rgt; } \
+	template<typename T, typename U, typename = typename std::enable_if<!is_flyweight<U>::value>::type> \
+	bool operator op(U const& lft, flyweight<T> const& rgt) { return lft op rgt.get(); }
+
+AGI_FLYWEIGHT_COMPARE(==)
+AGI_FLYWEIGHT_COMPARE(!=)
+AGI_FLYWEIGHT_COMPARE(<)
+AGI_FLYWEIGHT_COMPARE(>)
+AGI_FLYWEIGHT_COMPARE(<=)
+AGI_FLYWEIGHT_COMPARE(>=)
+
+#undef AGI_FLYWEIGHT_COMPARE
+
+template<typename T>
+void swap(flyweight<T>& lft, flyweight<T>& rgt) { lft.swap(rgt); }
+
+template<typename Char, typename T>
+std::basic_ostream<Char>& operator<<(std::basic_ostream<Char>& out, flyweight<T> const& value) {
+	return out << value.get();
+}
+}
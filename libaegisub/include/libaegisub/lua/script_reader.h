@@ -22,7 +22,17 @@ struct lua_State;
 
 namespace agi { namespace lua {
 	/// Load a Lua or Moonscript file at the given path
+	///
+	/// Recently used compiled files are cached in memory, and on disk if a
+	/// cache directory has been set, and are reused as long as the file's
+	/// modification time and contents are unchanged. This doesn't remove old
+	/// files from the disk cache itself; Aegisub caps the directory with
+	/// CleanCache at startup, at 32 MB and 1000 files (see
+	/// LuaScriptFactory in auto4_lua.cpp).
 	bool LoadFile(lua_State *L, agi::fs::path const& filename);
+
+	/// Set the directory in which compiled files are cached between runs
+	void SetChunkCacheDirectory(agi::fs::path const& dir);
 	/// Install our module loader and add include_path to the module search
 	/// path of the given lua state
 	bool Install(lua_State *L, std::vector<fs::path> const& include_path);
@@ -0,0 +1,73 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file matroska.h
+/// @brief Indexed reading of a single track's blocks from Matroska files
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <libaegisub/exception.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace agi {
+class read_file_mapping;
+
+namespace matroska {
+DEFINE_EXCEPTION(MatroskaError, InvalidInputException);
+
+/// A block of the track being read
+struct Block {
+	/// Start time in nanoseconds, relative to the first block in the file
+	int64_t start;
+	/// End time in nanoseconds; the same as start if the block has no duration
+	int64_t end;
+	/// Contents of the block, still compressed if the track uses compression
+	std::string data;
+};
+
+/// Information about how much of the file had to be read
+struct ReadStats {
+	/// Number of clusters whose blocks were looked at
+	size_t clusters_read = 0;
+	/// Number of blocks belonging to the track
+	size_t blocks = 0;
+	/// Was reading stopped early by the progress callback?
+	bool cancelled = false;
+};
+
+/// @brief Read every block of one track of a Matroska file
+/// @param file File to read from
+/// @param track Matroska track number (not index) of the track to read
+/// @param progress Called with the number of clusters read so far and the
+///                 total number to read; returning false stops reading and
+///                 returns the blocks found so far
+/// @param stats If not null, filled in with how much had to be read
+///
+/// Only the headers of elements are read other than for blocks of the
+/// requested track, so that the pages of a file holding other tracks are
+/// mostly never touched. Cues aren't used, as they may not list every
+/// block of a subtitle track. Each frame of a laced block is returned as a
+/// separate block with the times of the whole block.
+///
+/// @throws MatroskaError if the file isn't a valid Matroska file
+std::vector<Block> ReadTrack(read_file_mapping& file, uint64_t track,
+	std::function<bool (size_t, size_t)> const& progress, ReadStats *stats = nullptr);
+} }
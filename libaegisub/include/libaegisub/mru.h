@@ -49,6 +49,9 @@ public:
 	MRUManager(agi::fs::path const& file, const char (&default_config)[N])
 	: MRUManager(file, {default_config, N - 1}) { }
 
+	/// Destructor; waits for any pending writes of the lists to finish
+	~MRUManager();
+
 	/// @brief Add entry to the list.
 	/// @param key List name
 	/// @param entry Entry to add
@@ -72,7 +75,8 @@ public:
 	/// @exception MRUError thrown when an invalid key is used.
 	agi::fs::path const& GetEntry(const char *key, const size_t entry);
 
-	/// Write MRU lists to disk.
+	/// Queue writing the MRU lists to disk. The write happens in the
+	/// background shortly afterwards; see agi::persist::Write.
 	void Flush();
 
 private:
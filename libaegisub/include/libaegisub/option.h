@@ -56,6 +56,9 @@ private:
 	/// @param ignore_errors Log invalid entires in the option file and continue rather than throwing an exception
 	void LoadConfig(std::istream& stream, bool ignore_errors = false);
 
+	/// Build the JSON document written to the user config file
+	json::Object Serialize() const;
+
 public:
 	/// @brief Constructor
 	/// @param file User config that will be loaded from and written back to.
@@ -89,6 +92,10 @@ public:
 
 	/// Write the user configuration to disk, throws an exception if something goes wrong.
 	void Flush() const;
+
+	/// Queue writing the user configuration to disk in the background. Errors
+	/// are logged rather than thrown; see agi::persist::Write.
+	void QueueFlush() const;
 };
 
 } // namespace agi
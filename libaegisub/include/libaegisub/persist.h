@@ -0,0 +1,70 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file persist.h
+/// @brief Deferred, coalesced writing of JSON settings files
+/// @ingroup libaegisub io
+
+#pragma once
+
+#include <libaegisub/cajun/elements.h>
+#include <libaegisub/fs_fwd.h>
+
+#include <boost/filesystem/path.hpp>
+#include <chrono>
+#include <string>
+
+namespace agi { namespace persist {
+	/// @brief Queue a document to be written to a file
+	/// @param file File to write to
+	/// @param document Document to write
+	///
+	/// The document is serialized and written on a background thread once no
+	/// more writes have been queued for a short while, so that things such as
+	/// the MRU list can be saved every time they change without blocking the
+	/// GUI on disk IO. If another document is queued for the same file before
+	/// the first is written, only the newer one is written. Files are written
+	/// to a temporary file and then renamed over the old one, so a crash never
+	/// leaves a half-written file behind.
+	///
+	/// Errors are logged rather than reported to the caller.
+	void Write(fs::path const& file, json::UnknownElement document);
+
+	/// @brief Queue already-serialized JSON to be written to a file
+	///
+	/// For callers which need to keep their document, as documents can't be
+	/// copied. Serializing is usually cheap compared to the disk IO which this
+	/// still moves off the calling thread.
+	void Write(fs::path const& file, std::string text);
+
+	/// @brief Write a document to a file immediately on the calling thread
+	/// @param file File to write to
+	/// @param document Document to write
+	///
+	/// Any write queued for the same file is discarded, as it is older than
+	/// this one.
+	/// @throws agi::fs::FileSystemError on failure
+	void WriteNow(fs::path const& file, json::UnknownElement const& document);
+
+	/// Block until all queued writes have been written
+	void Flush();
+
+	/// @brief Set how long to wait after a write is queued before writing it
+	///
+	/// Each write queued restarts the wait, up to five times the delay after
+	/// the oldest unwritten one.
+	void SetDelay(std::chrono::milliseconds delay);
+} }
@@ -0,0 +1,125 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file quality_check.h
+/// @brief Incremental checking of subtitle lines for common problems
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace agi { namespace qc {
+	/// Problems which can be found with a line
+	enum Issue {
+		/// More characters per second than the limit
+		ISSUE_CPS = 1 << 0,
+		/// Visible at the same time as another non-comment line
+		ISSUE_OVERLAP = 1 << 1,
+		/// A line of the text is longer than the limit
+		ISSUE_LINE_LENGTH = 1 << 2,
+		/// Uses a style which isn't in the file
+		ISSUE_MISSING_STYLE = 1 << 3
+	};
+
+	/// The parts of a subtitle line which are checked
+	struct Line {
+		/// Identifier which is unique within the file and stable across edits
+		int id = 0;
+		int start = 0;
+		int end = 0;
+		bool comment = false;
+		std::string style;
+		std::string text;
+	};
+
+	/// Limits which lines are checked against
+	struct Settings {
+		/// Maximum characters per second, or 0 for no limit
+		int max_cps = 0;
+		/// Maximum characters per line of the text, or 0 for no limit
+		size_t max_line_length = 0;
+		/// agi::CharacterCount ignore mask used for both limits
+		int ignore = 0;
+	};
+
+	/// Results of checking a single line
+	struct Diagnostic {
+		/// Bitmask of Issue
+		int issues = 0;
+		/// Characters per second, or -1 if the line is too short to say
+		int cps = -1;
+		/// Length in characters of the longest line of the text
+		size_t line_length = 0;
+	};
+
+	/// @class Checker
+	/// @brief Per-line diagnostics for a file which are kept up to date as
+	///        lines change
+	///
+	/// Only the lines passed to Update() are rechecked for the per-line
+	/// problems, which are the expensive ones as they involve counting
+	/// characters. Overlaps are found with a sweep over the lines sorted by
+	/// start time, which is cheap enough to redo on every update.
+	///
+	/// Not thread-safe, but checks lines in parallel on the background queue
+	/// when there are enough of them to be worth it.
+	class Checker {
+		struct Entry {
+			Line line;
+			Diagnostic diag;
+		};
+
+		Settings settings;
+		std::unordered_map<int, Entry> lines;
+		/// Lowercased names of the styles in the file
+		std::unordered_set<std::string> styles;
+
+		void CheckLines(std::vector<Entry *> const& entries) const;
+		void CheckLine(Entry& entry) const;
+		void CheckOverlaps();
+
+	public:
+		/// Change the limits and recheck every line
+		void SetSettings(Settings const& new_settings);
+
+		/// Set the styles which exist in the file and recheck every line's style
+		void SetStyles(std::vector<std::string> const& names);
+
+		/// @brief Update the lines being checked
+		/// @param changed Lines which have been added or modified
+		/// @param removed Ids of lines which have been deleted
+		void Update(std::vector<Line> changed, std::vector<int> const& removed);
+
+		/// Remove every line
+		void Clear();
+
+		/// Get the diagnostics for a line, which are empty if the line isn't known
+		Diagnostic Get(int id) const;
+
+		/// Get the ids of every line with at least one of the given issues,
+		/// sorted by start time
+		std::vector<int> LinesWithIssues(int mask) const;
+
+		/// Number of lines being checked
+		size_t size() const { return lines.size(); }
+	};
+} }
@@ -0,0 +1,63 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file scene_change.h
+/// @brief Detection of scene changes in video for use as keyframes
+/// @ingroup libaegisub video
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace agi { namespace scene_change {
+	/// Width of the luma thumbnails which frames are compared at
+	const size_t thumb_width = 64;
+	/// Height of the luma thumbnails which frames are compared at
+	const size_t thumb_height = 36;
+	/// Number of bytes in a thumbnail
+	const size_t thumb_size = thumb_width * thumb_height;
+
+	/// @brief Shrink a BGRA image to a luma thumbnail
+	/// @param bgra Image data
+	/// @param width Width of the image in pixels
+	/// @param height Height of the image in pixels
+	/// @param pitch Bytes per row of the image
+	/// @param flipped Is the image stored bottom row first?
+	/// @param out Buffer of thumb_size bytes to write the thumbnail to
+	///
+	/// Each thumbnail pixel is the average luma of the corresponding block of
+	/// the image, which also smooths away most of the noise and grain which
+	/// would otherwise look like motion.
+	void Thumbnail(const uint8_t *bgra, size_t width, size_t height, size_t pitch, bool flipped, uint8_t *out);
+
+	/// @brief Sum of the absolute differences between two thumbnails
+	/// @param a Thumbnail of thumb_size bytes
+	/// @param b Thumbnail of thumb_size bytes
+	uint32_t Difference(const uint8_t *a, const uint8_t *b);
+
+	/// @brief Pick out scene changes from the differences between frames
+	/// @param differences differences[i] is the difference between frame i-1
+	///                    and frame i; differences[0] is ignored
+	/// @return Sorted frame numbers of the first frame of each scene, always
+	///         including frame 0 if there are any frames
+	///
+	/// A frame starts a new scene if it differs from the previous one by
+	/// much more than the recent frames have differed from each other, so
+	/// that high-motion scenes don't produce a keyframe on every frame.
+	std::vector<int> Detect(std::vector<uint32_t> const& differences);
+} }
@@ -14,9 +14,12 @@
 
 #pragma once
 
+#include <libaegisub/trace.h>
+
 #include <boost/config.hpp>
 #include <functional>
 #include <memory>
+#include <typeinfo>
 #include <vector>
 
 namespace agi { namespace signal {
@@ -128,28 +131,35 @@ namespace detail {
 template<typename... Args>
 class Signal final : private detail::SignalBase {
 	using Slot = std::function<void(Args...)>;
-	std::vector<std::pair<detail::ConnectionToken*, Slot>> slots; /// Signals currently connected to this slot
+	struct Connected {
+		detail::ConnectionToken *token;
+		Slot slot;
+		/// Type of the function or object the slot was created from, used
+		/// to identify the slot when tracing
+		std::type_info const *type;
+	};
+	std::vector<Connected> slots; /// Signals currently connected to this slot
 
 	void Disconnect(detail::ConnectionToken *tok) override {
 		for (auto it = begin(slots), e = end(slots); it != e; ++it) {
-			if (tok == it->first) {
+			if (tok == it->token) {
 				slots.erase(it);
 				return;
 			}
 		}
 	}
 
-	UnscopedConnection DoConnect(Slot sig) {
+	UnscopedConnection DoConnect(Slot sig, std::type_info const& type) {
 		auto token = MakeToken();
-		slots.emplace_back(token, sig);
+		slots.push_back(Connected{token, std::move(sig), &type});
 		return UnscopedConnection(token);
 	}
 
 public:
 	~Signal() {
 		for (auto& slot : slots) {
-			DisconnectToken(slot.first);
-			if (!TokenClaimed(slot.first)) delete slot.first;
+			DisconnectToken(slot.token);
+			if (!TokenClaimed(slot.token)) delete slot.token;
 		}
 	}
 
@@ -159,8 +169,10 @@ public:
 	/// not be relied on
 	void operator()(Args... args) {
 		for (size_t i = slots.size(); i > 0; --i) {
-			if (!Blocked(slots[i - 1].first))
-				slots[i - 1].second(args...);
+			if (!Blocked(slots[i - 1].token)) {
+				trace::Scope scope("signal", *slots[i - 1].type);
+				slots[i - 1].slot(args...);
+			}
 		}
 	}
 
@@ -168,19 +180,20 @@ public:
 	/// @param sig Signal to connect
 	/// @return The connection object
 	UnscopedConnection Connect(Slot sig) {
-		return DoConnect(sig);
+		auto const& type = sig.target_type();
+		return DoConnect(std::move(sig), type);
 	}
 
 	// Convenience wrapper for a member function which matches the signal's signature
 	template<typename T>
 	UnscopedConnection Connect(void (T::*func)(Args...), T* a1) {
-		return DoConnect([=](Args... args) { (a1->*func)(args...); });
+		return DoConnect([=](Args... args) { (a1->*func)(args...); }, typeid(T));
 	}
 
 	// Convenience wrapper for a callable which does not use any signal args
 	template<typename Thunk, typename = decltype((*(Thunk *)0)())>
 	UnscopedConnection Connect(Thunk&& func) {
-		return DoConnect([=](Args... args) mutable { func(); });
+		return DoConnect([=](Args... args) mutable { func(); }, typeid(Thunk));
 	}
 
 	// Convenience wrapper for a member function which does not use any signal
@@ -188,14 +201,14 @@ public:
 	// same signature when the signal has no args.
 	template<typename T, typename MemberThunk>
 	UnscopedConnection Connect(MemberThunk func, T* obj) {
-		return DoConnect([=](Args... args) { (obj->*func)(); });
+		return DoConnect([=](Args... args) { (obj->*func)(); }, typeid(T));
 	}
 
 	// Convenience wrapper for a member function which uses only the first
 	// signal arg.
 	template<typename T, typename Arg1>
 	UnscopedConnection Connect(void (T::*func)(Arg1), T* a1) {
-		return DoConnect(std::bind(func, a1, std::placeholders::_1));
+		return DoConnect(std::bind(func, a1, std::placeholders::_1), typeid(T));
 	}
 };
 
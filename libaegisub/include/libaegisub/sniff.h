@@ -0,0 +1,78 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file sniff.h
+/// @brief Identification of subtitle and timing files from their contents
+/// @ingroup libaegisub io
+
+#pragma once
+
+#include <libaegisub/fs_fwd.h>
+
+#include <boost/filesystem/path.hpp>
+#include <string>
+
+namespace agi { namespace sniff {
+	/// Kinds of files which can be told apart by their first few KB
+	enum class Format {
+		/// Text which doesn't look like anything in particular
+		Unknown,
+		/// Binary data other than the binary formats below
+		Binary,
+		Ass,
+		Srt,
+		WebVtt,
+		MicroDvd,
+		Ttxt,
+		Matroska,
+		Ebu3264,
+		Timecodes,
+		Keyframes
+	};
+
+	struct Result {
+		/// Character set as returned by agi::charset::Detect
+		std::string encoding;
+		Format format = Format::Unknown;
+	};
+
+	/// Number of bytes at the start of a file which are looked at to
+	/// determine its format
+	const size_t sniff_bytes = 4096;
+
+	/// @brief Determine the format of some text from its beginning
+	/// @param text The start of a file, converted to UTF-8 or some other
+	///             ASCII-compatible encoding; it need not end on a line or
+	///             character boundary
+	///
+	/// Only looks for signatures which identify a format, so a file which
+	/// this identifies may still fail to load.
+	Format Identify(std::string const& text);
+
+	/// @brief Determine the character set and format of a file
+	/// @param file File to check
+	///
+	/// Maps the file once, reading only as much as is needed to detect the
+	/// encoding and the first sniff_bytes bytes for the format. Results are
+	/// cached by path, size and modification time so that reopening or
+	/// reloading an unchanged file doesn't read it again.
+	/// @throws agi::fs::FileNotFound if the file does not exist
+	Result Sniff(fs::path const& file);
+
+	/// Discard all cached results
+	void ClearCache();
+} }
@@ -0,0 +1,96 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file timing_processor.h
+/// @brief Batch adjustment of line timing to lead-in, keyframes and speech
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <vector>
+
+namespace agi {
+class EnergyEnvelope;
+namespace vfr { class Framerate; }
+
+namespace timing {
+	/// The parts of a subtitle line which the processor adjusts
+	struct Line {
+		int start = 0;
+		int end = 0;
+	};
+
+	/// Which adjustments to make. All times are in milliseconds.
+	struct Settings {
+		/// Time to move start times earlier by, or 0 for none
+		int lead_in = 0;
+		/// Time to move end times later by, or 0 for none
+		int lead_out = 0;
+
+		/// Snap the end of each line and the start of the next together
+		bool adjacent = false;
+		/// Maximum gap between lines to close
+		int adjacent_gap = 0;
+		/// Maximum overlap between lines to remove
+		int adjacent_overlap = 0;
+		/// Where between the two times to meet, from 0 (the end of the first
+		/// line) to 1 (the start of the second)
+		double adjacent_bias = 0.5;
+
+		/// Snap times to nearby keyframes
+		bool keyframes = false;
+		/// Maximum distance to move start times later to a keyframe
+		int keyframe_before_start = 0;
+		/// Maximum distance to move start times earlier to a keyframe
+		int keyframe_after_start = 0;
+		/// Maximum distance to move end times later to a keyframe
+		int keyframe_before_end = 0;
+		/// Maximum distance to move end times earlier to a keyframe
+		int keyframe_after_end = 0;
+
+		/// Snap times to the nearest detected start and end of speech
+		bool speech = false;
+		/// Maximum distance to move a time to the start or end of speech
+		int speech_distance = 0;
+	};
+
+	/// @brief Adjust the timing of a set of lines
+	/// @param lines Lines to adjust in place, in any order, none with end
+	///              before start
+	/// @param settings Adjustments to make
+	/// @param keyframes Sorted frame numbers of keyframes. Usually includes the
+	///                  last frame of the video so that lines can snap to it.
+	/// @param fps Frame rate for converting between frames and times
+	/// @param envelope Speech detection for snapping to speech, or nullptr
+	///
+	/// Lines are snapped to speech, then given lead-in, then lead-out, then
+	/// made adjacent, then snapped to keyframes, with each step seeing the
+	/// results of the previous one. The steps other than lead-in are done in
+	/// parallel, and nothing compares every pair of lines, so this is fast
+	/// enough for whole seasons of subtitles at once. Times are rounded to
+	/// centiseconds like agi::Time does.
+	///
+	/// The parallel steps run on agi::dispatch's background queue, so
+	/// agi::dispatch::Init must have been called first. Aegisub does this at
+	/// startup; other programs using this must do it themselves.
+	///
+	/// Besides the timing post-processor dialog, this is available to
+	/// automation scripts as aegisub.process_timing, and from the command
+	/// line with tools/timing-processor.cpp.
+	void Process(std::vector<Line>& lines, Settings const& settings,
+		std::vector<int> const& keyframes, vfr::Framerate const& fps,
+		EnergyEnvelope const* envelope);
+} }
@@ -0,0 +1,143 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file trace.h
+/// @brief Lightweight timing of hot paths for finding what's slow
+/// @ingroup libaegisub
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace agi { namespace trace {
+	/// A single timed region
+	struct Event {
+		/// Category of the event, such as "signal" or "video"
+		const char *category;
+		/// Name of the event
+		const char *name;
+		/// Is name a mangled type name from std::type_info which needs to be
+		/// demangled before display?
+		bool mangled;
+		/// Start time in microseconds since tracing was first enabled
+		uint64_t start;
+		/// Duration in microseconds
+		uint64_t duration;
+		/// Small number identifying the thread the event happened on
+		uint32_t thread;
+	};
+
+	/// Totals for all events with the same category and name
+	struct Summary {
+		std::string category;
+		std::string name;
+		uint64_t count = 0;
+		/// Total duration in microseconds
+		uint64_t total = 0;
+		/// Longest single duration in microseconds
+		uint64_t max = 0;
+	};
+
+	namespace detail {
+		extern std::atomic<bool> enabled;
+		void Record(const char *category, const char *name, bool mangled, std::chrono::steady_clock::time_point start);
+	}
+
+	/// Is tracing currently enabled?
+	///
+	/// This is a single relaxed atomic load so that instrumented code costs
+	/// next to nothing when tracing is off.
+	inline bool Enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+	/// Turn recording of events on or off. Events already recorded are kept.
+	void SetEnabled(bool enabled);
+
+	/// Discard all recorded events
+	void Clear();
+
+	/// Get a copy of the recorded events, oldest first
+	///
+	/// Only the most recent events are kept; older ones are overwritten once
+	/// the buffer is full.
+	std::vector<Event> Events();
+
+	/// Get the recorded events grouped by category and name, with the most
+	/// total time first
+	std::vector<Summary> Summarize();
+
+	/// Get the readable name of an event
+	std::string EventName(Event const& event);
+
+	/// Write the recorded events in the Chrome trace event JSON format, which
+	/// can be loaded in chrome://tracing or Perfetto
+	void WriteChromeTrace(std::ostream& out);
+
+	/// Times the scope it's declared in if tracing is enabled when it's
+	/// created
+	class Scope {
+		const char *category;
+		const char *name;
+		std::chrono::steady_clock::time_point start;
+		bool mangled;
+		bool active;
+
+		Scope(Scope const&) = delete;
+		Scope& operator=(Scope const&) = delete;
+	public:
+		/// @param category Category of the event; must be a string literal
+		/// @param name Name of the event; must have static storage duration
+		Scope(const char *category, const char *name)
+		: category(category)
+		, name(name)
+		, mangled(false)
+		, active(Enabled())
+		{
+			if (active)
+				start = std::chrono::steady_clock::now();
+		}
+
+		/// @param category Category of the event; must be a string literal
+		/// @param type Type whose name is used as the event name
+		Scope(const char *category, std::type_info const& type)
+		: category(category)
+		, name(type.name())
+		, mangled(true)
+		, active(Enabled())
+		{
+			if (active)
+				start = std::chrono::steady_clock::now();
+		}
+
+		~Scope() {
+			if (active)
+				detail::Record(category, name, mangled, start);
+		}
+	};
+} }
+
+#define AGI_TRACE_CONCAT_(a, b) a##b
+#define AGI_TRACE_CONCAT(a, b) AGI_TRACE_CONCAT_(a, b)
+
+/// Time the rest of the enclosing scope as an event with the given category
+/// and name
+#define AGI_TRACE_SCOPE(category, name) \
+	agi::trace::Scope AGI_TRACE_CONCAT(agi_trace_scope_, __LINE__)(category, name)
@@ -29,6 +29,10 @@ namespace agi { namespace util {
 	bool try_parse(std::string const& str, double *out);
 	bool try_parse(std::string const& str, int *out);
 
+	/// Format a number with at most `precision` decimal places and no
+	/// trailing zeros
+	std::string float_to_string(double val, int precision = 3);
+
 	/// strftime, but on std::string rather than a fixed buffer
 	/// @param fmt strftime format string
 	/// @param tmptr Time to format, or nullptr for current time
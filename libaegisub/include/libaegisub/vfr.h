@@ -67,14 +67,58 @@ class Framerate {
 	/// rounding past the end of the final override range.
 	int64_t last = 0;
 
-	/// Start time in milliseconds of each frame
-	std::vector<int> timecodes;
+	/// A section of the timecodes whose frame durations repeat with a fixed
+	/// period
+	///
+	/// Frame first_frame + n starts at first_time + (n / period) * period_ms +
+	/// offsets[offset + n % period]. CFR video (including rounded NTSC rates)
+	/// collapses into a single run; irregular sections become a run with a
+	/// single period covering the whole section.
+	struct Run {
+		/// First frame in this run
+		int first_frame;
+		/// Start time in milliseconds of the first frame in this run
+		int first_time;
+		/// Number of frames in this run
+		int count;
+		/// Number of frames before the durations repeat
+		int period;
+		/// Total duration of one period in milliseconds
+		int period_ms;
+		/// Index of this run's first offset in offsets
+		size_t offset;
+	};
+
+	/// Runs covering the frames with explicit timecodes, in frame order
+	std::vector<Run> runs;
+
+	/// Start time of each frame in a period relative to the period's start,
+	/// for all runs
+	std::vector<int> offsets;
+
+	/// Number of frames with explicit timecodes
+	int frame_count = 0;
+
+	/// Start time in milliseconds of the final frame with an explicit timecode
+	int last_time = 0;
+
+	/// Replace the runs with a compressed form of the given timecodes
+	void SetTimecodes(std::vector<int> const& timecodes);
+
+	/// Get the run containing the given frame, which must be in [0, frame_count)
+	std::vector<Run>::const_iterator RunAtFrame(int frame) const;
+
+	/// Get the last frame in the run whose start time is <= the given time
+	int FrameInRun(Run const& run, int ms) const;
+
+	/// Get the start time of the given frame relative to the run
+	int TimeInRun(Run const& run, int frame) const;
 
 	/// Does this frame rate need drop frames and have them enabled?
 	bool drop = false;
 
-	/// Set FPS properties from the timecodes vector
-	void SetFromTimecodes();
+	/// Set FPS properties from a vector of timecodes
+	void SetFromTimecodes(std::vector<int> timecodes);
 public:
 	Framerate(Framerate const&) = default;
 	Framerate& operator=(Framerate const&) = default;
@@ -117,6 +161,15 @@ public:
 	/// start/end time would first/last be visible
 	int FrameAtTime(int ms, Time type = EXACT) const;
 
+	/// @brief Get the frames visible at each of the given times
+	/// @param times Times in milliseconds
+	/// @param type Time mode
+	/// @return Frame for each time, as if FrameAtTime had been called on each
+	///
+	/// This is considerably faster than calling FrameAtTime repeatedly when
+	/// the times are sorted, but works correctly for times in any order.
+	std::vector<int> FramesAtTimes(std::vector<int> const& times, Time type = EXACT) const;
+
 	/// @brief Get the time at a given frame
 	/// @param frame Frame number
 	/// @param type Time mode
@@ -134,6 +187,13 @@ public:
 	/// results for all frame numbers
 	int TimeAtFrame(int frame, Time type = EXACT) const;
 
+	/// @brief Get the time of each of the given frames
+	/// @param frames Frame numbers
+	/// @param type Time mode
+	/// @return Time for each frame, as if TimeAtFrame had been called on each
+	/// @see FramesAtTimes
+	std::vector<int> TimesAtFrames(std::vector<int> const& frames, Time type = EXACT) const;
+
 	/// @brief Get the components of the SMPTE timecode for the given time
 	/// @param[out] h Hours component
 	/// @param[out] m Minutes component
@@ -193,7 +253,7 @@ public:
 	void Save(fs::path const& file, int length = -1) const;
 
 	/// Is this frame rate possibly variable?
-	bool IsVFR() const {return timecodes.size() > 1; }
+	bool IsVFR() const {return frame_count > 1; }
 
 	/// Does this represent a valid frame rate?
 	bool IsLoaded() const { return numerator > 0; }
@@ -17,14 +17,266 @@
 #include "libaegisub/lua/script_reader.h"
 
 #include "libaegisub/file_mapping.h"
+#include "libaegisub/fs.h"
+#include "libaegisub/io.h"
 #include "libaegisub/log.h"
 #include "libaegisub/lua/utils.h"
 #include "libaegisub/split.h"
 
 #include <boost/algorithm/string/replace.hpp>
+#include <algorithm>
+#include <boost/crc.hpp>
+#include <cstdio>
+#include <cstring>
 #include <lauxlib.h>
+#include <luajit.h>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+namespace {
+	/// Positions in the MoonScript source of each line of the Lua code it
+	/// was compiled to, as (Lua line, character offset) pairs
+	typedef std::vector<std::pair<int32_t, int32_t>> LineTable;
+
+	/// A compiled chunk, along with what it was compiled from
+	struct Chunk {
+		time_t modified = 0;
+		uint32_t checksum = 0;
+		std::string bytecode;
+		LineTable line_table;
+		/// Value of use_counter when this chunk was last used
+		uint64_t last_used = 0;
+	};
+
+	/// Header written at the start of cached chunk files. Bytecode is only
+	/// valid for the exact build of LuaJIT which wrote it.
+	const std::string cache_header = "Aegisub compiled chunk 2\n" LUAJIT_VERSION "\n";
+
+	/// Maximum total size of the bytecode kept in memory
+	const size_t max_memory_cache = 32 * 1024 * 1024;
+
+	std::mutex cache_lock;
+	std::unordered_map<std::string, Chunk> chunk_cache;
+	size_t chunk_cache_size = 0;
+	uint64_t use_counter = 0;
+	agi::fs::path cache_dir;
+
+	uint32_t checksum(const char *data, size_t size) {
+		boost::crc_32_type crc;
+		crc.process_bytes(data, size);
+		return crc.checksum();
+	}
+
+	/// The name of the cache file for a script. Different paths can give the
+	/// same name, so the files also store the full path they're for.
+	agi::fs::path cache_filename(agi::fs::path const& dir, std::string const& filename) {
+		// 64-bit FNV-1a
+		uint64_t hash = 14695981039346656037ULL;
+		for (unsigned char c : filename)
+			hash = (hash ^ c) * 1099511628211ULL;
+		char name[32];
+		snprintf(name, sizeof name, "%016llx.ljbc", static_cast<unsigned long long>(hash));
+		return dir/name;
+	}
+
+	int write_chunk(lua_State *, const void *p, size_t sz, void *ud) {
+		static_cast<std::string *>(ud)->append(static_cast<const char *>(p), sz);
+		return 0;
+	}
+
+	/// Push the table which MoonScript uses to map line numbers in errors
+	/// back to the source, or return false if MoonScript isn't available
+	bool push_line_tables(lua_State *L) {
+		if (luaL_dostring(L, "return require 'moonscript.line_tables'") || !lua_istable(L, -1)) {
+			lua_pop(L, 1);
+			return false;
+		}
+		return true;
+	}
+
+	LineTable get_line_table(lua_State *L, std::string const& chunk_name) {
+		LineTable ret;
+		if (!push_line_tables(L)) return ret;
+
+		lua_getfield(L, -1, chunk_name.c_str());
+		if (lua_istable(L, -1)) {
+			lua_pushnil(L);
+			while (lua_next(L, -2)) {
+				if (lua_type(L, -2) == LUA_TNUMBER && lua_type(L, -1) == LUA_TNUMBER)
+					ret.emplace_back(static_cast<int32_t>(lua_tointeger(L, -2)), static_cast<int32_t>(lua_tointeger(L, -1)));
+				lua_pop(L, 1);
+			}
+		}
+		lua_pop(L, 2);
+		return ret;
+	}
+
+	/// Restore the line table which compiling the chunk with MoonScript would
+	/// have created, as loading the cached bytecode skips MoonScript entirely
+	void set_line_table(lua_State *L, std::string const& chunk_name, LineTable const& line_table) {
+		if (!push_line_tables(L)) return;
+
+		lua_createtable(L, 0, static_cast<int>(line_table.size()));
+		for (auto const& line : line_table) {
+			lua_pushinteger(L, line.second);
+			lua_rawseti(L, -2, line.first);
+		}
+		lua_setfield(L, -2, chunk_name.c_str());
+		lua_pop(L, 1);
+	}
+
+	/// Add a chunk to the memory cache, discarding the least recently used
+	/// ones if it's gotten too big. Must be called with cache_lock held.
+	void insert_chunk(std::string const& filename, Chunk chunk) {
+		auto& entry = chunk_cache[filename];
+		chunk_cache_size -= entry.bytecode.size();
+		chunk_cache_size += chunk.bytecode.size();
+		entry = std::move(chunk);
+		entry.last_used = ++use_counter;
+
+		while (chunk_cache_size > max_memory_cache && chunk_cache.size() > 1) {
+			auto oldest = std::min_element(chunk_cache.begin(), chunk_cache.end(), [](std::pair<const std::string, Chunk> const& a, std::pair<const std::string, Chunk> const& b) {
+				return a.second.last_used < b.second.last_used;
+			});
+			chunk_cache_size -= oldest->second.bytecode.size();
+			chunk_cache.erase(oldest);
+		}
+	}
+
+	/// Reads the fields of a cached chunk file, failing if it's truncated
+	class ChunkReader {
+		const char *pos;
+		const char *end;
+	public:
+		ChunkReader(const char *data, size_t size) : pos(data), end(data + size) { }
+
+		size_t remaining() const { return end - pos; }
+
+		template<typename T>
+		bool read(T& value) {
+			if (remaining() < sizeof(T)) return false;
+			memcpy(&value, pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+
+		bool read(std::string& value, size_t size) {
+			if (remaining() < size) return false;
+			value.assign(pos, size);
+			pos += size;
+			return true;
+		}
+	};
+
+	bool read_chunk_file(agi::fs::path const& path, std::string const& filename, Chunk& chunk) {
+		agi::read_file_mapping file(path);
+		ChunkReader reader(file.read(), static_cast<size_t>(file.size()));
+
+		std::string header, file_path;
+		int64_t file_modified;
+		uint32_t path_size, line_count;
+		if (!reader.read(header, cache_header.size()) || header != cache_header) return false;
+		if (!reader.read(file_modified) || !reader.read(chunk.checksum)) return false;
+		if (!reader.read(path_size) || !reader.read(file_path, path_size) || file_path != filename) return false;
+		if (!reader.read(line_count) || line_count > reader.remaining() / sizeof(LineTable::value_type)) return false;
+
+		chunk.modified = static_cast<time_t>(file_modified);
+		chunk.line_table.resize(line_count);
+		for (auto& line : chunk.line_table) {
+			if (!reader.read(line.first) || !reader.read(line.second)) return false;
+		}
+		return reader.read(chunk.bytecode, reader.remaining()) && !chunk.bytecode.empty();
+	}
+
+	/// Look for a compiled version of the file in the memory and disk caches
+	bool find_chunk(std::string const& filename, time_t modified, uint32_t sum, Chunk& out) {
+		agi::fs::path dir;
+		{
+			std::lock_guard<std::mutex> lock(cache_lock);
+			auto it = chunk_cache.find(filename);
+			if (it != chunk_cache.end() && it->second.modified == modified && it->second.checksum == sum) {
+				it->second.last_used = ++use_counter;
+				out = it->second;
+				return true;
+			}
+			dir = cache_dir;
+		}
+
+		if (dir.empty()) return false;
+
+		Chunk chunk;
+		try {
+			auto path = cache_filename(dir, filename);
+			if (!agi::fs::FileExists(path)) return false;
+			if (!read_chunk_file(path, filename, chunk)) return false;
+			if (chunk.modified != modified || chunk.checksum != sum) return false;
+
+			// Mark the file as recently used so that cleaning the cache
+			// removes the ones which haven't been used in the longest time
+			agi::fs::Touch(path);
+		}
+		catch (agi::Exception const& e) {
+			LOG_D("auto4/lua") << "Error reading compiled chunk for " << filename << ": " << e.GetMessage();
+			return false;
+		}
+
+		out = chunk;
+		std::lock_guard<std::mutex> lock(cache_lock);
+		insert_chunk(filename, std::move(chunk));
+		return true;
+	}
+
+	/// Store the compiled function on the top of the stack in the caches
+	void store_chunk(lua_State *L, std::string const& filename, time_t modified, uint32_t sum, LineTable line_table) {
+		Chunk chunk;
+		if (lua_dump(L, write_chunk, &chunk.bytecode) != 0 || chunk.bytecode.empty())
+			return;
+		chunk.modified = modified;
+		chunk.checksum = sum;
+		chunk.line_table = std::move(line_table);
+
+		agi::fs::path dir;
+		{
+			std::lock_guard<std::mutex> lock(cache_lock);
+			insert_chunk(filename, chunk);
+			dir = cache_dir;
+		}
+
+		if (dir.empty()) return;
+
+		try {
+			agi::fs::CreateDirectory(dir);
+			int64_t file_modified = modified;
+			uint32_t path_size = static_cast<uint32_t>(filename.size());
+			uint32_t line_count = static_cast<uint32_t>(chunk.line_table.size());
+
+			agi::io::Save file(cache_filename(dir, filename), true);
+			auto& out = file.Get();
+			out.write(cache_header.data(), cache_header.size());
+			out.write(reinterpret_cast<const char *>(&file_modified), sizeof(file_modified));
+			out.write(reinterpret_cast<const char *>(&sum), sizeof(sum));
+			out.write(reinterpret_cast<const char *>(&path_size), sizeof(path_size));
+			out.write(filename.data(), filename.size());
+			out.write(reinterpret_cast<const char *>(&line_count), sizeof(line_count));
+			for (auto const& line : chunk.line_table) {
+				out.write(reinterpret_cast<const char *>(&line.first), sizeof(line.first));
+				out.write(reinterpret_cast<const char *>(&line.second), sizeof(line.second));
+			}
+			out.write(chunk.bytecode.data(), chunk.bytecode.size());
+		}
+		catch (agi::Exception const& e) {
+			LOG_D("auto4/lua") << "Error writing compiled chunk for " << filename << ": " << e.GetMessage();
+		}
+	}
+}
 
 namespace agi { namespace lua {
+	void SetChunkCacheDirectory(agi::fs::path const& dir) {
+		std::lock_guard<std::mutex> lock(cache_lock);
+		cache_dir = dir;
+	}
+
 	bool LoadFile(lua_State *L, agi::fs::path const& raw_filename) {
 		auto filename = raw_filename;
 		try {
@@ -44,31 +296,58 @@ namespace agi { namespace lua {
 			size -= 3;
 		}
 
-		if (!agi::fs::HasExtension(filename, "moon"))
-			return luaL_loadbuffer(L, buff, size, filename.string().c_str()) == 0;
+		bool moon = agi::fs::HasExtension(filename, "moon");
+		if (moon) {
+			// Save the text we'll be loading for the line number rewriting in
+			// the error handling
+			lua_pushlstring(L, buff, size);
+			lua_setfield(L, LUA_REGISTRYINDEX, ("raw moonscript: " + filename.string()).c_str());
+		}
+
+		// Compiled chunks keep the name they were compiled with and MoonScript
+		// line tables are cached along with them, so loading from the cache
+		// gives the same error messages and stack traces
+		auto const& chunk_name = filename.string();
+		time_t modified = agi::fs::ModifiedTime(filename);
+		uint32_t sum = checksum(buff, size);
+		Chunk chunk;
+		if (find_chunk(chunk_name, modified, sum, chunk)) {
+			if (luaL_loadbuffer(L, chunk.bytecode.data(), chunk.bytecode.size(), chunk_name.c_str()) == 0) {
+				if (moon)
+					set_line_table(L, chunk_name, chunk.line_table);
+				return true;
+			}
+
+			// Most likely written by a different build of LuaJIT, so just
+			// compile it again
+			LOG_D("auto4/lua") << "Discarding compiled chunk for " << filename << ": " << get_string_or_default(L, -1);
+			lua_pop(L, 1);
+		}
+
+		if (!moon) {
+			if (luaL_loadbuffer(L, buff, size, chunk_name.c_str()) != 0)
+				return false;
+			store_chunk(L, chunk_name, modified, sum, LineTable());
+			return true;
+		}
 
 		// We have a MoonScript file, so we need to load it with that
-		// It might be nice to have a dedicated lua state for compiling
-		// MoonScript to Lua
+		// Caching the compiled result means that each file only has to be
+		// compiled once rather than once per Lua state
 		lua_getfield(L, LUA_REGISTRYINDEX, "moonscript");
-
-		// Save the text we'll be loading for the line number rewriting in the
-		// error handling
 		lua_pushlstring(L, buff, size);
-		lua_pushvalue(L, -1);
-		lua_setfield(L, LUA_REGISTRYINDEX, ("raw moonscript: " + filename.string()).c_str());
-
 		push_value(L, filename);
 		if (lua_pcall(L, 2, 2, 0))
 			return false; // Leaves error message on stack
 
 		// loadstring returns nil, error on error or a function on success
-		if (lua_isnil(L, 1)) {
-			lua_remove(L, 1);
+		if (lua_isnil(L, -2)) {
+			lua_remove(L, -2);
 			return false;
 		}
 
 		lua_pop(L, 1); // Remove the extra nil for the stackchecker
+		store_chunk(L, chunk_name, modified, sum, get_line_table(L, chunk_name));
 		return true;
 	}
 
@@ -90,21 +90,36 @@ void Init(std::function<void (Thunk)> invoke_main) {
     ::invoke_main = std::move(invoke_main);
 }
 
-void Queue::Async(Thunk thunk) { DoInvoke(std::move(thunk)); }
-void Queue::Sync(Thunk thunk) { static_cast<OSXQueue *>(this)->DoSync(std::move(thunk)); }
+void Queue::Async(Thunk thunk, CancellationToken token) { DoInvoke(Track(std::move(thunk), std::move(token))); }
+void Queue::Sync(Thunk thunk) { static_cast<OSXQueue *>(this)->DoSync(Track(std::move(thunk), CancellationToken())); }
 
 Queue& Main() {
     static MainQueue q;
     return q;
 }
 
-Queue& Background() {
-    static GCDQueue q(dispatch_get_global_queue(0, DISPATCH_QUEUE_PRIORITY_DEFAULT));
-    return q;
+static long gcd_priority(Priority priority) {
+    switch (priority) {
+        case Priority::High: return DISPATCH_QUEUE_PRIORITY_HIGH;
+        case Priority::Low:  return DISPATCH_QUEUE_PRIORITY_LOW;
+        default:             return DISPATCH_QUEUE_PRIORITY_DEFAULT;
+    }
+}
+
+Queue& Background(Priority priority) {
+    static GCDQueue high(dispatch_get_global_queue(gcd_priority(Priority::High), 0));
+    static GCDQueue normal(dispatch_get_global_queue(gcd_priority(Priority::Normal), 0));
+    static GCDQueue low(dispatch_get_global_queue(gcd_priority(Priority::Low), 0));
+    switch (priority) {
+        case Priority::High: return high;
+        case Priority::Low:  return low;
+        default:             return normal;
+    }
 }
 
-std::unique_ptr<Queue> Create() {
-    return std::unique_ptr<Queue>(new GCDQueue(dispatch_queue_create("Aegisub worker queue",
-                                                                     DISPATCH_QUEUE_SERIAL)));
+std::unique_ptr<Queue> Create(Priority priority) {
+    auto queue = dispatch_queue_create("Aegisub worker queue", DISPATCH_QUEUE_SERIAL);
+    dispatch_set_target_queue(queue, dispatch_get_global_queue(gcd_priority(priority), 0));
+    return std::unique_ptr<Queue>(new GCDQueue(queue));
 }
 } }
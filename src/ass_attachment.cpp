@@ -52,9 +52,13 @@ size_t AssAttachment::GetSize() const {
 	return entry_data.get().size() - header_end - 1;
 }
 
-void AssAttachment::Extract(agi::fs::path const& filename) const {
+std::vector<char> AssAttachment::Decode() const {
 	auto header_end = entry_data.get().find('\n');
-	auto decoded = agi::ass::UUDecode(entry_data.get().c_str() + header_end + 1, &entry_data.get().back() + 1);
+	return agi::ass::UUDecode(entry_data.get().c_str() + header_end + 1, &entry_data.get().back() + 1);
+}
+
+void AssAttachment::Extract(agi::fs::path const& filename) const {
+	auto decoded = Decode();
 	agi::io::Save(filename, true).Get().write(&decoded[0], decoded.size());
 }
 
@@ -14,19 +14,22 @@
 //
 // Aegisub Project http://www.aegisub.org/
 
+#pragma once
+
 #include "ass_entry.h"
 
+#include <libaegisub/flyweight.h>
 #include <libaegisub/fs_fwd.h>
 
-#include <boost/flyweight.hpp>
+#include <vector>
 
 /// @class AssAttachment
 class AssAttachment final : public AssEntry {
 	/// ASS uuencoded entry data, including header.
-	boost::flyweight<std::string> entry_data;
+	agi::flyweight<std::string> entry_data;
 
 	/// Name of the attached file, with SSA font mangling if it is a ttf
-	boost::flyweight<std::string> filename;
+	agi::flyweight<std::string> filename;
 
 	AssEntryGroup group;
 
@@ -37,6 +40,9 @@ public:
 	/// Add a line of data (without newline) read from a subtitle file
 	void AddData(std::string const& data) { entry_data = entry_data.get() + data + "\r\n"; }
 
+	/// Decode the contents of this attachment
+	std::vector<char> Decode() const;
+
 	/// Extract the contents of this attachment to a file
 	/// @param filename Path to save the attachment to
 	void Extract(agi::fs::path const& filename) const;
@@ -37,6 +37,7 @@
 
 #include <libaegisub/of_type_adaptor.h>
 #include <libaegisub/split.h>
+#include <libaegisub/trace.h>
 #include <libaegisub/make_unique.h>
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -47,9 +48,13 @@
 #include <boost/spirit/include/karma_generate.hpp>
 #include <boost/spirit/include/karma_int.hpp>
 
+#include <atomic>
+
 using namespace boost::adaptors;
 
-static int next_id = 0;
+// Lines are copied off the main thread (autosave, subtitle rendering), so
+// IDs must be handed out atomically to stay unique
+static std::atomic<int> next_id{0};
 
 AssDialogue::AssDialogue() {
 	Id = ++next_id;
@@ -60,6 +65,7 @@ AssDialogue::AssDialogue(AssDialogue const& that)
 , AssEntryListHook(that)
 {
 	Id = ++next_id;
+	std::atomic_store(&parsed_tags, std::atomic_load(&that.parsed_tags));
 }
 
 AssDialogue::AssDialogue(AssDialogueBase const& that) : AssDialogueBase(that) { }
@@ -196,17 +202,17 @@ std::string AssDialogue::GetEntryData() const {
 	return str;
 }
 
-std::vector<std::unique_ptr<AssDialogueBlock>> AssDialogue::ParseTags() const {
+static std::vector<std::unique_ptr<AssDialogueBlock>> parse_tags(std::string const& text) {
+	AGI_TRACE_SCOPE("subtitles", "ParseTags");
 	std::vector<std::unique_ptr<AssDialogueBlock>> Blocks;
 
 	// Empty line, make an empty block
-	if (Text.get().empty()) {
+	if (text.empty()) {
 		Blocks.push_back(agi::make_unique<AssDialogueBlockPlain>());
 		return Blocks;
 	}
 
 	int drawingLevel = 0;
-	std::string const& text(Text.get());
 
 	for (size_t len = text.size(), cur = 0; cur < len; ) {
 		// Overrides block
@@ -266,6 +272,44 @@ plain:
 	return Blocks;
 }
 
+std::vector<std::unique_ptr<AssDialogueBlock>> AssDialogue::ParseTags() const {
+	return parse_tags(Text.get());
+}
+
+/// Parse the nested blocks of \t tags, which are otherwise parsed lazily on
+/// first access and so can't be shared between threads
+static void parse_nested_blocks(AssDialogueBlockOverride *block) {
+	for (auto& tag : block->Tags) {
+		for (auto& param : tag.Params) {
+			if (!param.omitted && param.GetType() == VariableDataType::BLOCK)
+				parse_nested_blocks(param.Get<AssDialogueBlockOverride*>());
+		}
+	}
+}
+
+AssParsedText::AssParsedText(std::vector<std::unique_ptr<AssDialogueBlock>> parsed) {
+	blocks.reserve(parsed.size());
+	for (auto& block : parsed) {
+		if (block->GetType() == AssBlockType::OVERRIDE) {
+			parse_nested_blocks(static_cast<AssDialogueBlockOverride*>(block.get()));
+			has_overrides = true;
+		}
+		blocks.emplace_back(std::move(block));
+	}
+}
+
+std::shared_ptr<const AssParsedText> AssDialogue::GetParsedTags() const {
+	auto text = Text;
+	auto cache = std::atomic_load(&parsed_tags);
+	// Flyweights with the same value share storage, so this is a pointer
+	// comparison
+	if (!cache || cache->text != text) {
+		cache = std::make_shared<const ParsedTagsCache>(ParsedTagsCache{text, parse_tags(text.get())});
+		std::atomic_store(&parsed_tags, cache);
+	}
+	return std::shared_ptr<const AssParsedText>(cache, &cache->tags);
+}
+
 void AssDialogue::StripTags() {
 	Text = GetStrippedText();
 }
@@ -281,8 +325,8 @@ bool AssDialogue::CollidesWith(const AssDialogue *target) const {
 	return ((Start < target->Start) ? (target->Start < End) : (Start < target->End));
 }
 
-static std::string get_text_p(AssDialogueBlock *d) { return d->GetText(); }
+static std::string get_text_p(const AssDialogueBlock *d) { return d->GetText(); }
 std::string AssDialogue::GetStrippedText() const {
-	auto blocks = ParseTags();
-	return join(blocks | agi::of_type<AssDialogueBlockPlain>() | transformed(get_text_p), "");
+	auto blocks = GetParsedTags();
+	return join(*blocks | agi::of_type<AssDialogueBlockPlain>() | transformed(get_text_p), "");
 }
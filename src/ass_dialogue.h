@@ -33,9 +33,10 @@
 #include "fold_controller.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/flyweight.h>
 
 #include <array>
-#include <boost/flyweight.hpp>
+#include <memory>
 #include <vector>
 
 enum class AssBlockType {
@@ -74,7 +75,7 @@ public:
 	virtual ~AssDialogueBlock() = default;
 
 	virtual AssBlockType GetType() const = 0;
-	virtual std::string GetText() { return text; }
+	virtual std::string GetText() const { return text; }
 };
 
 class AssDialogueBlockPlain final : public AssDialogueBlock {
@@ -106,7 +107,7 @@ public:
 	std::vector<AssOverrideTag> Tags;
 
 	AssBlockType GetType() const override { return AssBlockType::OVERRIDE; }
-	std::string GetText() override;
+	std::string GetText() const override;
 	void ParseTags();
 	void AddTag(std::string const& tag);
 
@@ -118,6 +119,34 @@ public:
 	void ProcessParameters(ProcessParametersCallback callback, void *userData);
 };
 
+/// @class AssParsedText
+/// @brief Read-only parsed form of a dialogue line's text
+///
+/// Returned by AssDialogue::GetParsedTags(), which only parses the text again
+/// when it has changed. Copies of a line share a single AssParsedText until
+/// their text is changed, so it is never modified after being created, and
+/// can be read from several threads at once.
+class AssParsedText {
+	std::vector<std::unique_ptr<const AssDialogueBlock>> blocks;
+	bool has_overrides = false;
+public:
+	typedef std::vector<std::unique_ptr<const AssDialogueBlock>>::const_iterator const_iterator;
+	typedef const_iterator iterator;
+
+	/// @param blocks Result of parsing the text with AssDialogue::ParseTags
+	AssParsedText(std::vector<std::unique_ptr<AssDialogueBlock>> blocks);
+
+	const_iterator begin() const { return blocks.begin(); }
+	const_iterator end() const { return blocks.end(); }
+	size_t size() const { return blocks.size(); }
+	AssDialogueBlock const& operator[](size_t i) const { return *blocks[i]; }
+
+	/// Does the text have any override blocks? Text without any (and so
+	/// also without drawings) is unchanged by anything which only modifies
+	/// tags.
+	bool HasOverrides() const { return has_overrides; }
+};
+
 struct AssDialogueBase {
 	/// Unique ID of this line. Copies of the line for Undo/Redo purposes
 	/// preserve the unique ID, so that the equivalent lines can be found in
@@ -140,27 +169,44 @@ struct AssDialogueBase {
 	/// Ending time
 	agi::Time End = 5000;
 	/// Style name
-	boost::flyweight<std::string> Style = boost::flyweight<std::string>("Default");
+	agi::flyweight<std::string> Style = agi::flyweight<std::string>("Default");
 	/// Actor name
-	boost::flyweight<std::string> Actor;
+	agi::flyweight<std::string> Actor;
 	/// Effect name
-	boost::flyweight<std::string> Effect;
+	agi::flyweight<std::string> Effect;
 	/// IDs of extradata entries for line
-	boost::flyweight<std::vector<uint32_t>> ExtradataIds;
+	agi::flyweight<std::vector<uint32_t>> ExtradataIds;
 	/// Raw text data
-	boost::flyweight<std::string> Text;
+	agi::flyweight<std::string> Text;
 };
 
 class AssDialogue final : public AssEntry, public AssDialogueBase, public AssEntryListHook {
 	/// @brief Parse raw ASS data into everything else
 	/// @param data ASS line
 	void Parse(std::string const& data);
+
+	struct ParsedTagsCache {
+		/// Value of Text which tags was made from
+		agi::flyweight<std::string> text;
+		AssParsedText tags;
+	};
+	/// Cached result of GetParsedTags(). Only ever accessed with the atomic
+	/// shared_ptr functions, as it may be read from any thread that has
+	/// read access to the line.
+	mutable std::shared_ptr<const ParsedTagsCache> parsed_tags;
 public:
 	AssEntryGroup Group() const override { return AssEntryGroup::DIALOGUE; }
 
 	/// Parse text as ASS and return block information
 	std::vector<std::unique_ptr<AssDialogueBlock>> ParseTags() const;
 
+	/// @brief Get the parsed form of the text for reading only
+	///
+	/// Unlike ParseTags(), the result is cached and is only recomputed when
+	/// Text changes, so this should be used whenever the blocks are not
+	/// going to be modified.
+	std::shared_ptr<const AssParsedText> GetParsedTags() const;
+
 	/// Strip all ASS tags from the text
 	void StripTags();
 	/// Strip a specific ASS tag from the text
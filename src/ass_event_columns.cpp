@@ -0,0 +1,125 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file ass_event_columns.cpp
+/// @brief Packed column-oriented copies of the fields of dialogue lines
+/// @ingroup subs_storage
+
+#include "ass_event_columns.h"
+
+#include "ass_dialogue.h"
+
+#include <unordered_map>
+
+namespace {
+/// @brief Replace each line's value of a string field with its rank among
+///        the distinct values of that field
+///
+/// Flyweights with the same value share storage, so the distinct values
+/// are found by address without hashing or comparing any strings, and only
+/// the distinct values are sorted.
+template<typename Getter>
+std::vector<uint32_t> intern(std::vector<AssDialogue *> const& lines, Getter get) {
+	std::unordered_map<const std::string *, uint32_t> ids;
+	std::vector<const std::string *> values;
+	std::vector<uint32_t> ret;
+	ret.reserve(lines.size());
+
+	for (auto line : lines) {
+		const std::string *value = &get(line).get();
+		auto it = ids.emplace(value, static_cast<uint32_t>(values.size())).first;
+		if (it->second == values.size())
+			values.push_back(value);
+		ret.push_back(it->second);
+	}
+
+	std::vector<uint32_t> order(values.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return *values[a] < *values[b];
+	});
+
+	// Equal strings may still have been given separate ids if they were
+	// somehow not the same flyweight, so give them the same rank
+	std::vector<uint32_t> rank(values.size());
+	uint32_t next_rank = 0;
+	for (size_t i = 0; i < order.size(); ++i) {
+		if (i > 0 && *values[order[i - 1]] < *values[order[i]])
+			++next_rank;
+		rank[order[i]] = next_rank;
+	}
+
+	for (auto& id : ret)
+		id = rank[id];
+	return ret;
+}
+}
+
+AssEventColumns::AssEventColumns(std::vector<AssDialogue *> lines, int columns)
+: columns(columns)
+, lines(std::move(lines))
+{
+	const size_t count = this->lines.size();
+
+	if (columns & COLUMN_TIMES) {
+		start.reserve(count);
+		end.reserve(count);
+		for (auto line : this->lines) {
+			start.push_back(line->Start);
+			end.push_back(line->End);
+		}
+	}
+
+	if (columns & COLUMN_LAYER) {
+		layer.reserve(count);
+		for (auto line : this->lines)
+			layer.push_back(line->Layer);
+	}
+
+	if (columns & COLUMN_MARGINS) {
+		margin.reserve(count);
+		for (auto line : this->lines)
+			margin.push_back(line->Margin);
+	}
+
+	if (columns & COLUMN_COMMENT) {
+		comment.reserve(count);
+		for (auto line : this->lines)
+			comment.push_back(line->Comment);
+	}
+
+	if (columns & COLUMN_STYLE)
+		style = intern(this->lines, [](AssDialogue *line) -> agi::flyweight<std::string> const& { return line->Style; });
+	if (columns & COLUMN_ACTOR)
+		actor = intern(this->lines, [](AssDialogue *line) -> agi::flyweight<std::string> const& { return line->Actor; });
+	if (columns & COLUMN_EFFECT)
+		effect = intern(this->lines, [](AssDialogue *line) -> agi::flyweight<std::string> const& { return line->Effect; });
+}
+
+size_t AssEventColumns::StoreTimes() const {
+	size_t changed = 0;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		auto line = lines[i];
+		agi::Time new_start = start[i], new_end = end[i];
+		if (line->Start != new_start || line->End != new_end) {
+			line->Start = new_start;
+			line->End = new_end;
+			++changed;
+		}
+	}
+	return changed;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file ass_event_columns.h
+/// @brief Packed column-oriented copies of the fields of dialogue lines
+/// @ingroup subs_storage
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+class AssDialogue;
+
+/// Fields of dialogue lines which can be copied into columns
+enum AssEventColumn {
+	COLUMN_TIMES   = 1 << 0,
+	COLUMN_LAYER   = 1 << 1,
+	COLUMN_MARGINS = 1 << 2,
+	COLUMN_STYLE   = 1 << 3,
+	COLUMN_ACTOR   = 1 << 4,
+	COLUMN_EFFECT  = 1 << 5,
+	COLUMN_COMMENT = 1 << 6,
+	COLUMN_ALL     = (1 << 7) - 1
+};
+
+/// @class AssEventColumns
+/// @brief The fields of a set of dialogue lines, stored as contiguous arrays
+///
+/// Passes over every line which only look at a few fields, such as sorting
+/// and shifting times, spend most of their time following list pointers and
+/// comparing strings. This copies just the requested fields into arrays
+/// indexed in the same order as the lines, with the style, actor and effect
+/// replaced by small integers which compare in the same order as the
+/// strings do, so that such passes can run over the arrays instead. The
+/// lines themselves remain the authoritative copy: anything changed in the
+/// columns has to be written back with StoreTimes().
+class AssEventColumns {
+	/// Which columns were filled in
+	int columns;
+
+public:
+	/// The lines the columns were copied from
+	std::vector<AssDialogue *> lines;
+
+	std::vector<int> start;
+	std::vector<int> end;
+	std::vector<int> layer;
+	std::vector<std::array<int, 3>> margin;
+	std::vector<uint32_t> style;
+	std::vector<uint32_t> actor;
+	std::vector<uint32_t> effect;
+	std::vector<uint8_t> comment;
+
+	/// @brief Copy fields from lines
+	/// @param lines Lines to copy from
+	/// @param columns Bitmask of AssEventColumn values to copy
+	AssEventColumns(std::vector<AssDialogue *> lines, int columns = COLUMN_ALL);
+
+	/// Copy fields from every line in a list of lines
+	template<typename Container>
+	static AssEventColumns FromList(Container& list, int columns = COLUMN_ALL) {
+		std::vector<AssDialogue *> lines;
+		for (auto& line : list)
+			lines.push_back(&line);
+		return AssEventColumns(std::move(lines), columns);
+	}
+
+	size_t size() const { return lines.size(); }
+	bool Has(AssEventColumn column) const { return !!(columns & column); }
+
+	/// @brief Get the order the lines should be in when stably sorted by a column
+	/// @param column One of the column arrays, which must have been copied
+	/// @return Indices into lines in sorted order
+	template<typename T>
+	std::vector<size_t> SortedOrder(std::vector<T> const& column) const {
+		std::vector<size_t> order(lines.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			return column[a] < column[b];
+		});
+		return order;
+	}
+
+	/// @brief Write start and end times back to the lines
+	/// @return Number of lines whose times actually changed
+	size_t StoreTimes() const;
+};
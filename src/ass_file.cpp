@@ -18,11 +18,15 @@
 
 #include "ass_attachment.h"
 #include "ass_dialogue.h"
+#include "ass_event_columns.h"
+#include "ass_file_snapshot.h"
 #include "ass_info.h"
 #include "ass_style.h"
 #include "ass_style_storage.h"
 #include "options.h"
 
+#include <libaegisub/trace.h>
+
 #include <algorithm>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -77,6 +81,18 @@ AssFile::AssFile(const AssFile &from)
 		[](AssDialogue *e) { delete e; });
 }
 
+AssFile::AssFile(AssFileSnapshot const& snapshot)
+: Info(snapshot.Info)
+, Attachments(snapshot.Attachments)
+, Extradata(snapshot.Extradata)
+, next_extradata_id(snapshot.next_extradata_id)
+{
+	for (auto const& style : snapshot.Styles)
+		Styles.push_back(*new AssStyle(style));
+	for (auto const& line : snapshot.Events)
+		Events.push_back(*new AssDialogue(*line));
+}
+
 void AssFile::swap(AssFile& from) throw() {
 	Info.swap(from.Info);
 	Styles.swap(from.Styles);
@@ -85,6 +101,9 @@ void AssFile::swap(AssFile& from) throw() {
 	Extradata.swap(from.Extradata);
 	std::swap(Properties, from.Properties);
 	std::swap(next_extradata_id, from.next_extradata_id);
+	rows.swap(from.rows);
+	last_snapshot.swap(from.last_snapshot);
+	std::swap(snapshot_changes, from.snapshot_changes);
 }
 
 AssFile& AssFile::operator=(AssFile from) {
@@ -92,6 +111,15 @@ AssFile& AssFile::operator=(AssFile from) {
 	return *this;
 }
 
+std::shared_ptr<const AssFileSnapshot> AssFile::Snapshot() const {
+	auto const& changes = snapshot_changes;
+	if (!last_snapshot || changes.sections || changes.line || changes.all_lines) {
+		last_snapshot = std::make_shared<const AssFileSnapshot>(*this, last_snapshot.get(), changes);
+		snapshot_changes = AssFileChanges();
+	}
+	return last_snapshot;
+}
+
 EntryList<AssDialogue>::iterator AssFile::iterator_to(AssDialogue& line) {
 	using l = EntryList<AssDialogue>;
 	bool in_list = !l::node_algorithms::inited(l::value_traits::to_node_ptr(line));
@@ -169,10 +197,38 @@ AssStyle *AssFile::GetStyle(std::string const& name) {
 }
 
 int AssFile::Commit(wxString const& desc, int type, int amend_id, AssDialogue *single_line) {
+	AGI_TRACE_SCOPE("subtitles", "AssFile::Commit");
+
 	if (type == COMMIT_NEW || (type & COMMIT_DIAG_ADDREM) || (type & COMMIT_ORDER)) {
+		// Lines before the first added, removed or moved line already have
+		// the correct row, so only the rows after that need to be rewritten
 		int i = 0;
-		for (auto& event : Events)
-			event.Row = i++;
+		auto it = Events.begin();
+		for (; it != Events.end() && static_cast<size_t>(i) < rows.size(); ++it, ++i) {
+			if (rows[i] != &*it || it->Row != i)
+				break;
+		}
+
+		rows.resize(i);
+		for (; it != Events.end(); ++it, ++i) {
+			it->Row = i;
+			rows.push_back(&*it);
+		}
+	}
+
+	// Record what changed so that the next snapshot can share the rest with
+	// the previous one
+	auto& changes = snapshot_changes;
+	if (type == COMMIT_NEW) {
+		changes.sections = ~0;
+		changes.all_lines = true;
+	}
+	else {
+		changes.sections |= type & (COMMIT_SCRIPTINFO | COMMIT_STYLES | COMMIT_ATTACHMENT);
+		if (single_line && !(type & (COMMIT_ORDER | COMMIT_DIAG_ADDREM)) && (!changes.line || changes.line == single_line))
+			changes.line = single_line;
+		else if (single_line || (type & (COMMIT_ORDER | COMMIT_DIAG_ADDREM | COMMIT_DIAG_FULL | COMMIT_EXTRADATA)))
+			changes.all_lines = true;
 	}
 
 	AnnouncePreCommit(type, single_line);
@@ -209,13 +265,49 @@ bool AssFile::CompTextStripped(AssDialogue const& lft, AssDialogue const& rgt) {
 	return lft.GetStrippedText() < rgt.GetStrippedText();
 }
 
+namespace {
+/// The column which a comparison function compares, or 0 if it isn't one
+/// that can be done on columns
+int column_for(AssFile::CompFunc comp) {
+	if (comp == AssFile::CompStart || comp == AssFile::CompEnd) return COLUMN_TIMES;
+	if (comp == AssFile::CompStyle) return COLUMN_STYLE;
+	if (comp == AssFile::CompActor) return COLUMN_ACTOR;
+	if (comp == AssFile::CompEffect) return COLUMN_EFFECT;
+	if (comp == AssFile::CompLayer) return COLUMN_LAYER;
+	return 0;
+}
+
+void sort_list(EntryList<AssDialogue>& lst, AssFile::CompFunc comp) {
+	int column = column_for(comp);
+	if (!column) {
+		lst.sort(comp);
+		return;
+	}
+
+	// Sorting the list directly chases pointers and compares strings for
+	// every comparison; sorting indices by a packed key is much faster
+	auto columns = AssEventColumns::FromList(lst, column);
+	std::vector<size_t> order;
+	if (comp == AssFile::CompStart)       order = columns.SortedOrder(columns.start);
+	else if (comp == AssFile::CompEnd)    order = columns.SortedOrder(columns.end);
+	else if (comp == AssFile::CompStyle)  order = columns.SortedOrder(columns.style);
+	else if (comp == AssFile::CompActor)  order = columns.SortedOrder(columns.actor);
+	else if (comp == AssFile::CompEffect) order = columns.SortedOrder(columns.effect);
+	else                                  order = columns.SortedOrder(columns.layer);
+
+	lst.clear();
+	for (size_t i : order)
+		lst.push_back(*columns.lines[i]);
+}
+}
+
 void AssFile::Sort(CompFunc comp, std::set<AssDialogue*> const& limit) {
 	Sort(Events, comp, limit);
 }
 
 void AssFile::Sort(EntryList<AssDialogue> &lst, CompFunc comp, std::set<AssDialogue*> const& limit) {
 	if (limit.empty()) {
-		lst.sort(comp);
+		sort_list(lst, comp);
 		return;
 	}
 
@@ -228,7 +320,7 @@ void AssFile::Sort(EntryList<AssDialogue> &lst, CompFunc comp, std::set<AssDialo
 		// sort doesn't support only sorting a sublist, so move them to a temp list
 		EntryList<AssDialogue> tmp;
 		tmp.splice(tmp.begin(), lst, begin, end);
-		tmp.sort(comp);
+		sort_list(tmp, comp);
 		lst.splice(end, tmp);
 
 		begin = --end;
@@ -36,11 +36,13 @@
 
 #include <boost/intrusive/list.hpp>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
 class AssAttachment;
 class AssDialogue;
+class AssFileSnapshot;
 class AssInfo;
 class AssStyle;
 class wxString;
@@ -61,6 +63,17 @@ struct AssFileCommit {
 	AssDialogue *single_line;
 };
 
+/// What has been committed to an AssFile since its last snapshot was taken
+struct AssFileChanges {
+	/// AssFile::CommitType flags of the non-dialogue sections which changed
+	int sections = 0;
+	/// The only dialogue line which changed, if just one did
+	const AssDialogue *line = nullptr;
+	/// Dialogue lines other than line may have been changed, added, removed
+	/// or reordered
+	bool all_lines = false;
+};
+
 struct ProjectProperties {
 	std::string automation_scripts;
 	std::string export_filters;
@@ -87,6 +100,16 @@ class AssFile {
 	agi::signal::Signal<int, const AssDialogue*> AnnouncePreCommit;
 	agi::signal::Signal<AssFileCommit> PushState;
 
+	/// Row number -> dialogue line, updated along with AssDialogue::Row by
+	/// commits which add, remove or reorder lines
+	std::vector<AssDialogue*> rows;
+
+	/// The last snapshot taken of this file, which the next one shares
+	/// unchanged lines with
+	mutable std::shared_ptr<const AssFileSnapshot> last_snapshot;
+	/// Changes committed since last_snapshot was taken
+	mutable AssFileChanges snapshot_changes;
+
 	void SetExtradataValue(AssDialogue& line, std::string const& key, std::string const& value, bool del);
 public:
 	/// The lines in the file
@@ -101,6 +124,8 @@ public:
 
 	AssFile();
 	AssFile(const AssFile &from);
+	/// Make a modifiable copy of a snapshot
+	explicit AssFile(AssFileSnapshot const& snapshot);
 	AssFile& operator=(AssFile from);
 	~AssFile();
 
@@ -112,6 +137,16 @@ public:
 	void LoadDefault(bool defline = true, std::string const& style_catalog = std::string());
 	/// Attach a file to the ass file
 	void InsertAttachment(agi::fs::path const& filename);
+	/// @brief Get the dialogue line at a row
+	/// @param row Row number
+	/// @return Line, or nullptr if row is out of range
+	///
+	/// Only valid directly after a commit, like AssDialogue::Row
+	AssDialogue *GetDialogueAtRow(int row) const {
+		return static_cast<size_t>(row) < rows.size() ? rows[row] : nullptr;
+	}
+	/// Number of dialogue lines as of the last commit
+	int GetRowCount() const { return (int)rows.size(); }
 	/// Get the names of all of the styles available
 	std::vector<std::string> GetStyles() const;
 	/// @brief Get a style by name
@@ -121,6 +156,15 @@ public:
 
 	void swap(AssFile &) throw();
 
+	/// @brief Get an immutable copy of the file which other threads can read
+	///
+	/// The snapshot reflects the file as of the most recent commit. Only
+	/// the lines and sections which commits since the previous snapshot
+	/// changed are copied, and if nothing was committed the previous
+	/// snapshot is returned. Must be called from the thread which owns the
+	/// file.
+	std::shared_ptr<const AssFileSnapshot> Snapshot() const;
+
 	/// @brief Get the script resolution
 	/// @param[out] w Width
 	/// @param[in] h Height
@@ -0,0 +1,117 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file ass_file_snapshot.cpp
+/// @brief Immutable copies of subtitle files for use off the main thread
+/// @ingroup subs_storage
+
+#include "ass_file_snapshot.h"
+
+#include "ass_dialogue.h"
+
+#include <libaegisub/trace.h>
+
+#include <unordered_map>
+
+namespace {
+/// Check if a copy of a line can stand in for the line. The string fields
+/// are flyweights, so this is just a series of integer comparisons.
+bool unchanged(AssDialogue const& copy, AssDialogue const& line) {
+	return copy.Comment == line.Comment
+		&& copy.Layer == line.Layer
+		&& copy.Margin == line.Margin
+		&& copy.Start == line.Start
+		&& copy.End == line.End
+		&& copy.Style == line.Style
+		&& copy.Actor == line.Actor
+		&& copy.Effect == line.Effect
+		&& copy.Text == line.Text
+		&& copy.ExtradataIds == line.ExtradataIds;
+}
+}
+
+AssFileSnapshot::AssFileSnapshot(AssFile const& file, AssFileSnapshot const* previous, AssFileChanges const& changes)
+: info(previous && !(changes.sections & AssFile::COMMIT_SCRIPTINFO)
+	? previous->info
+	: std::make_shared<const std::vector<AssInfo>>(file.Info))
+, styles(previous && !(changes.sections & AssFile::COMMIT_STYLES)
+	? previous->styles
+	: std::make_shared<const std::vector<AssStyle>>(file.Styles.begin(), file.Styles.end()))
+, attachments(previous && !(changes.sections & AssFile::COMMIT_ATTACHMENT)
+	? previous->attachments
+	: std::make_shared<const std::vector<AssAttachment>>(file.Attachments))
+// Entries are only ever appended with a new ID or removed, as commits don't
+// report extradata changes reliably
+, extradata(previous && previous->next_extradata_id == file.next_extradata_id && previous->Extradata.size() == file.Extradata.size()
+	? previous->extradata
+	: std::make_shared<const std::vector<ExtradataEntry>>(file.Extradata))
+, Info(*info)
+, Styles(*styles)
+, Attachments(*attachments)
+, Extradata(*extradata)
+, next_extradata_id(file.next_extradata_id)
+{
+	AGI_TRACE_SCOPE("subtitles", "AssFileSnapshot");
+
+	// Copies keep the ID of the line they were made from so that the next
+	// snapshot can find them
+	auto copy = [](AssDialogue const& line) {
+		return std::make_shared<const AssDialogue>(static_cast<AssDialogueBase const&>(line));
+	};
+
+	if (previous && !changes.all_lines) {
+		// Row is up to date as nothing has been added, removed or moved
+		auto line = changes.line;
+		if (!line) {
+			Events = previous->Events;
+			return;
+		}
+		size_t row = static_cast<size_t>(line->Row);
+		if (line->Row >= 0 && row < previous->Events.size() && previous->Events[row]->Id == line->Id) {
+			Events = previous->Events;
+			Events[row] = copy(*line);
+			return;
+		}
+	}
+
+	// Look lines up by ID first so that inserting or removing lines doesn't
+	// stop everything after them from being shared, and then by position as
+	// undo replaces every line with a copy with a new ID
+	std::unordered_map<int, size_t> ids;
+	if (previous) {
+		ids.reserve(previous->Events.size());
+		for (size_t i = 0; i < previous->Events.size(); ++i)
+			ids[previous->Events[i]->Id] = i;
+	}
+
+	size_t index = 0;
+	for (auto const& line : file.Events) {
+		std::shared_ptr<const AssDialogue> shared;
+		if (previous) {
+			auto it = ids.find(line.Id);
+			if (it != ids.end() && unchanged(*previous->Events[it->second], line))
+				shared = previous->Events[it->second];
+			else if (index < previous->Events.size() && unchanged(*previous->Events[index], line))
+				shared = previous->Events[index];
+		}
+		if (!shared)
+			shared = copy(line);
+
+		++index;
+		Events.push_back(std::move(shared));
+	}
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file ass_file_snapshot.h
+/// @brief Immutable copies of subtitle files for use off the main thread
+/// @ingroup subs_storage
+
+#pragma once
+
+#include "ass_attachment.h"
+#include "ass_file.h"
+#include "ass_info.h"
+#include "ass_style.h"
+
+#include <memory>
+#include <vector>
+
+/// @class AssFileSnapshot
+/// @brief An immutable copy of the contents of an AssFile
+///
+/// Snapshots are for handing the file to background work such as rendering
+/// and autosaving, which used to each make a deep copy of the file on every
+/// commit. Each snapshot shares everything which hasn't changed with the
+/// file's previous snapshot: the dialogue lines are held by shared pointers,
+/// and each of the other sections is shared as a whole. When the commits
+/// since the previous snapshot only changed one line, taking a snapshot
+/// copies the previous snapshot's list of line pointers and that one line.
+/// Otherwise every line is compared with the previous snapshot's, and only
+/// the ones which differ are copied.
+///
+/// Nothing in a snapshot is ever modified after it is created, so any number
+/// of threads can read one at once.
+class AssFileSnapshot {
+	std::shared_ptr<const std::vector<AssInfo>> info;
+	std::shared_ptr<const std::vector<AssStyle>> styles;
+	std::shared_ptr<const std::vector<AssAttachment>> attachments;
+	std::shared_ptr<const std::vector<ExtradataEntry>> extradata;
+
+public:
+	std::vector<AssInfo> const& Info;
+	std::vector<AssStyle> const& Styles;
+	std::vector<std::shared_ptr<const AssDialogue>> Events;
+	std::vector<AssAttachment> const& Attachments;
+	std::vector<ExtradataEntry> const& Extradata;
+	uint32_t next_extradata_id;
+
+	/// @brief Take a snapshot of a file
+	/// @param file File to copy
+	/// @param previous Earlier snapshot of the same file to share with, if any
+	/// @param changes What has been committed to the file since previous was
+	///                taken
+	AssFileSnapshot(AssFile const& file, AssFileSnapshot const* previous, AssFileChanges const& changes);
+};
@@ -88,7 +88,8 @@ void AssKaraoke::SetLine(const AssDialogue *line, bool auto_split, bool normaliz
 }
 
 void AssKaraoke::ParseSyllables(const AssDialogue *line, Syllable &syl) {
-	for (auto& block : line->ParseTags()) {
+	auto blocks = line->GetParsedTags();
+	for (auto& block : *blocks) {
 		std::string text = block->GetText();
 
 		switch (block->GetType()) {
@@ -102,7 +103,7 @@ void AssKaraoke::ParseSyllables(const AssDialogue *line, Syllable &syl) {
 			syl.ovr_tags[syl.text.size()] += text;
 			break;
 		case AssBlockType::OVERRIDE:
-			auto ovr = static_cast<AssDialogueBlockOverride*>(block.get());
+			auto ovr = static_cast<const AssDialogueBlockOverride*>(block.get());
 			bool in_tag = false;
 			for (auto& tag : ovr->Tags) {
 				if (tag.IsValid() && boost::istarts_with(tag.Name, "\\k")) {
@@ -113,7 +114,7 @@ void AssKaraoke::ParseSyllables(const AssDialogue *line, Syllable &syl) {
 
 					// Dealing with both \K and \kf is mildly annoying so just
 					// convert them both to \kf
-					if (tag.Name == "\\K") tag.Name = "\\kf";
+					std::string tag_type = tag.Name == "\\K" ? "\\kf" : tag.Name;
 
 					// Don't bother including zero duration zero length syls
 					if (syl.duration > 0 || !syl.text.empty()) {
@@ -122,7 +123,7 @@ void AssKaraoke::ParseSyllables(const AssDialogue *line, Syllable &syl) {
 						syl.ovr_tags.clear();
 					}
 
-					syl.tag_type = tag.Name;
+					syl.tag_type = tag_type;
 					syl.start_time += syl.duration;
 					syl.duration = tag.Params[0].Get(0) * 10;
 				}
@@ -36,6 +36,7 @@
 #include <libaegisub/exception.h>
 #include <libaegisub/format.h>
 #include <libaegisub/make_unique.h>
+#include <libaegisub/util.h>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -43,6 +44,7 @@
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <functional>
+#include <mutex>
 
 using namespace boost::adaptors;
 
@@ -110,7 +112,7 @@ template<> void AssOverrideParameter::Set<int>(int new_value) {
 }
 
 template<> void AssOverrideParameter::Set<double>(double new_value) {
-	Set(float_to_string(new_value));
+	Set(agi::util::float_to_string(new_value));
 }
 
 template<> void AssOverrideParameter::Set<bool>(bool new_value) {
@@ -174,9 +176,8 @@ struct AssOverrideTagProto {
 };
 
 static std::vector<AssOverrideTagProto> proto;
+static std::once_flag protos_loaded;
 static void load_protos() {
-	if (!proto.empty()) return;
-
 	proto.resize(56);
 	int i = 0;
 
@@ -411,9 +412,8 @@ void AssDialogueBlockOverride::AddTag(std::string const& tag) {
 }
 
 static std::string tag_str(AssOverrideTag const& t) { return t; }
-std::string AssDialogueBlockOverride::GetText() {
-	text = "{" + join(Tags | transformed(tag_str), std::string()) + "}";
-	return text;
+std::string AssDialogueBlockOverride::GetText() const {
+	return "{" + join(Tags | transformed(tag_str), std::string()) + "}";
 }
 
 void AssDialogueBlockOverride::ProcessParameters(ProcessParametersCallback callback, void *userData) {
@@ -441,7 +441,8 @@ void AssOverrideTag::Clear() {
 }
 
 void AssOverrideTag::SetText(const std::string &text) {
-	load_protos();
+	// Lines may be parsed on several threads at once
+	std::call_once(protos_loaded, load_protos);
 	for (auto cur = proto.begin(); cur != proto.end(); ++cur) {
 		if (boost::starts_with(text, cur->name)) {
 			Name = cur->name;
@@ -18,12 +18,15 @@
 
 #include "ass_dialogue.h"
 #include "ass_file.h"
-#include "export_fixstyle.h"
+#include "ass_file_snapshot.h"
 #include "include/aegisub/subtitles_provider.h"
 #include "video_frame.h"
 #include "video_provider_manager.h"
 
 #include <libaegisub/dispatch.h>
+#include <libaegisub/trace.h>
+
+#include <algorithm>
 
 #if BOOST_VERSION >= 106900
 #include <boost/gil.hpp>
@@ -36,6 +39,9 @@ enum {
 	SUBS_FILE_ALREADY_LOADED = -2
 };
 
+/// Maximum number of frames to render ahead of the playback clock
+static const size_t playback_queue_size = 8;
+
 std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, double time, bool raw) {
 	// Find an unused buffer to use or allocate a new one if needed
 	std::shared_ptr<VideoFrame> frame;
@@ -52,6 +58,7 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, doub
 	}
 
 	try {
+		AGI_TRACE_SCOPE("video", "GetFrame");
 		source_provider->GetFrame(frame_number, *frame);
 	}
 	catch (VideoProviderError const& err) { throw VideoProviderErrorEvent(err); }
@@ -59,6 +66,7 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, doub
 	if (raw || !subs_provider || !subs) return frame;
 
 	try {
+		AGI_TRACE_SCOPE("subtitles", "LoadSubtitles");
 		if (single_frame != frame_number && single_frame != SUBS_FILE_ALREADY_LOADED) {
 			// Generally edits and seeks come in groups; if the last thing done
 			// was seek it is more likely that the user will seek again and
@@ -67,19 +75,19 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::ProcFrame(int frame_number, doub
 			// other lines will probably not be viewed before the file changes
 			// again), and if it's a different frame, export the entire file.
 			if (single_frame != NEW_SUBS_FILE) {
-				subs_provider->LoadSubtitles(subs.get());
+				subs_provider->LoadSubtitles(*subs);
 				single_frame = SUBS_FILE_ALREADY_LOADED;
 			}
 			else {
-				AssFixStylesFilter::ProcessSubs(subs.get());
 				single_frame = frame_number;
-				subs_provider->LoadSubtitles(subs.get(), time);
+				subs_provider->LoadSubtitles(*subs, time);
 			}
 		}
 	}
 	catch (agi::Exception const& err) { throw SubtitlesProviderErrorEvent(err.GetMessage()); }
 
 	try {
+		AGI_TRACE_SCOPE("subtitles", "DrawSubtitles");
 		subs_provider->DrawSubtitles(*frame, time / 1000.);
 	}
 	catch (agi::UserCancelException const&) { }
@@ -107,7 +115,7 @@ VideoFrame AsyncVideoProvider::GetSubtitles(double time) {
 	if (!subs) return frame_black;
 	VideoFrame frame_white = GetBlankFrame(true);
 
-	subs_provider->LoadSubtitles(subs.get());
+	subs_provider->LoadSubtitles(*subs);
 	subs_provider->DrawSubtitles(frame_black, time / 1000.);
 	subs_provider->DrawSubtitles(frame_white, time / 1000.);
 
@@ -147,7 +155,7 @@ static std::unique_ptr<SubtitlesProvider> get_subs_provider(wxEvtHandler *evt_ha
 }
 
 AsyncVideoProvider::AsyncVideoProvider(agi::fs::path const& video_filename, std::string const& colormatrix, wxEvtHandler *parent, agi::BackgroundRunner *br)
-: worker(agi::dispatch::Create())
+: worker(agi::dispatch::Create(agi::dispatch::Priority::High))
 , subs_provider(get_subs_provider(parent, br))
 , source_provider(VideoProviderFactory::GetProvider(video_filename, colormatrix, br))
 , parent(parent)
@@ -155,38 +163,31 @@ AsyncVideoProvider::AsyncVideoProvider(agi::fs::path const& video_filename, std:
 }
 
 AsyncVideoProvider::~AsyncVideoProvider() {
+	// Stop the playback producer from queuing more work
+	StopPlayback();
+
 	// Block until all currently queued jobs are complete
 	worker->Sync([]{});
 }
 
-void AsyncVideoProvider::LoadSubtitles(const AssFile *new_subs) throw() {
+void AsyncVideoProvider::QueueSubtitles(const AssFile *new_subs, bool check_updated) {
 	uint_fast32_t req_version = ++version;
 
-	auto copy = new AssFile(*new_subs);
+	auto snapshot = new_subs->Snapshot();
 	worker->Async([=]{
-		subs.reset(copy);
+		subs = snapshot;
 		single_frame = NEW_SUBS_FILE;
-		ProcAsync(req_version, false);
+		FlushPlaybackQueue();
+		ProcAsync(req_version, check_updated);
 	});
 }
 
-void AsyncVideoProvider::UpdateSubtitles(const AssFile *new_subs, const AssDialogue *changed) throw() {
-	uint_fast32_t req_version = ++version;
-
-	// Copy just the line which were changed, then replace the line at the
-	// same index in the worker's copy of the file with the new entry
-	auto copy = new AssDialogue(*changed);
-	worker->Async([=]{
-		int i = 0;
-		auto it = subs->Events.begin();
-		std::advance(it, copy->Row - i);
-		i = copy->Row;
-		subs->Events.insert(it, *copy);
-		delete &*it--;
+void AsyncVideoProvider::LoadSubtitles(const AssFile *new_subs) throw() {
+	QueueSubtitles(new_subs, false);
+}
 
-		single_frame = NEW_SUBS_FILE;
-		ProcAsync(req_version, true);
-	});
+void AsyncVideoProvider::UpdateSubtitles(const AssFile *new_subs) throw() {
+	QueueSubtitles(new_subs, true);
 }
 
 void AsyncVideoProvider::RequestFrame(int new_frame, double new_time) throw() {
@@ -232,10 +233,16 @@ void AsyncVideoProvider::ProcAsync(uint_fast32_t req_version, bool check_updated
 	// Only actually produce the frame if there's no queued changes waiting
 	if (req_version < version || frame_number < 0) return;
 
+	// Frames are presented from the playback queue while playing
+	{
+		std::lock_guard<std::mutex> lock(playback_lock);
+		if (playing) return;
+	}
+
 	std::vector<AssDialogueBase const*> visible_lines;
 	for (auto const& line : subs->Events) {
-		if (!line.Comment && !(line.Start > time || line.End <= time))
-			visible_lines.push_back(&line);
+		if (!line->Comment && !(line->Start > time || line->End <= time))
+			visible_lines.push_back(line.get());
 	}
 
 	if (check_updated && !NeedUpdate(visible_lines)) return;
@@ -263,6 +270,133 @@ std::shared_ptr<VideoFrame> AsyncVideoProvider::GetFrame(int frame, double time,
 	return ret;
 }
 
+void AsyncVideoProvider::GetRawFrame(int frame, VideoFrame &out) {
+	worker->Sync([&]{
+		AGI_TRACE_SCOPE("video", "GetFrame");
+		source_provider->GetFrame(frame, out);
+	});
+}
+
+void AsyncVideoProvider::StartPlayback(int first_frame, int end_frame, agi::vfr::Framerate const& fps) {
+	uint_fast32_t generation;
+	{
+		std::lock_guard<std::mutex> lock(playback_lock);
+		generation = ++playback_generation;
+		playback_queue.clear();
+		playback_fps = fps;
+		playback_next = first_frame;
+		playback_end = end_frame;
+		playback_clock = fps.TimeAtFrame(first_frame);
+		playing = true;
+		producing = true;
+	}
+	worker->Async([=] { ProducePlaybackFrame(generation); });
+}
+
+void AsyncVideoProvider::StopPlayback() {
+	std::lock_guard<std::mutex> lock(playback_lock);
+	++playback_generation;
+	playback_queue.clear();
+	playing = false;
+	producing = false;
+}
+
+void AsyncVideoProvider::ProducePlaybackFrame(uint_fast32_t generation) {
+	int frame_n;
+	double frame_time;
+	{
+		std::lock_guard<std::mutex> lock(playback_lock);
+		if (generation != playback_generation) return;
+		if (playback_queue.size() >= playback_queue_size || playback_next >= playback_end) {
+			producing = false;
+			return;
+		}
+
+		// If rendering has fallen behind, skip straight to the frame which
+		// is currently due rather than rendering frames which will only be
+		// thrown away
+		int due = playback_fps.FrameAtTime(playback_clock);
+		if (due > playback_next) {
+			int skip_to = std::min(due, playback_end);
+			stats.dropped += skip_to - playback_next;
+			playback_next = skip_to;
+			if (playback_next >= playback_end) {
+				producing = false;
+				return;
+			}
+		}
+
+		frame_n = playback_next++;
+		frame_time = playback_fps.TimeAtFrame(frame_n);
+	}
+
+	std::shared_ptr<VideoFrame> frame;
+	try {
+		frame = ProcFrame(frame_n, frame_time);
+	}
+	catch (wxEvent const& err) {
+		std::lock_guard<std::mutex> lock(playback_lock);
+		if (generation == playback_generation)
+			producing = false;
+		parent->QueueEvent(err.Clone());
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(playback_lock);
+		if (generation != playback_generation) return;
+		QueuedFrame queued;
+		queued.frame_n = frame_n;
+		queued.time = frame_time;
+		queued.frame = std::move(frame);
+		playback_queue.push_back(std::move(queued));
+	}
+	worker->Async([=] { ProducePlaybackFrame(generation); });
+}
+
+void AsyncVideoProvider::FlushPlaybackQueue() {
+	std::lock_guard<std::mutex> lock(playback_lock);
+	if (!playing || playback_queue.empty()) return;
+
+	// Subtitles are rendered into the frames, so anything rendered before
+	// the change is stale
+	playback_next = playback_queue.front().frame_n;
+	playback_queue.clear();
+	if (!producing) {
+		producing = true;
+		auto generation = playback_generation;
+		worker->Async([=] { ProducePlaybackFrame(generation); });
+	}
+}
+
+bool AsyncVideoProvider::PresentFrame(int ms, QueuedFrame& frame) {
+	std::lock_guard<std::mutex> lock(playback_lock);
+	playback_clock = ms;
+
+	bool found = false;
+	while (!playback_queue.empty() && playback_queue.front().time <= ms) {
+		if (found) ++stats.late;
+		frame = std::move(playback_queue.front());
+		playback_queue.pop_front();
+		found = true;
+	}
+
+	if (found) {
+		++stats.presented;
+		if (playing && !producing && playback_next < playback_end) {
+			producing = true;
+			auto generation = playback_generation;
+			worker->Async([=] { ProducePlaybackFrame(generation); });
+		}
+	}
+	return found;
+}
+
+AsyncVideoProvider::PlaybackStats AsyncVideoProvider::GetPlaybackStats() {
+	std::lock_guard<std::mutex> lock(playback_lock);
+	return stats;
+}
+
 void AsyncVideoProvider::SetColorSpace(std::string const& matrix) {
 	worker->Async([=] { source_provider->SetColorSpace(matrix); });
 }
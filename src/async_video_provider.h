@@ -20,12 +20,14 @@
 #include <libaegisub/fs_fwd.h>
 
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <wx/event.h>
 
-class AssDialogue;
 class AssFile;
+class AssFileSnapshot;
 class SubtitlesProvider;
 class VideoProvider;
 class VideoProviderError;
@@ -51,8 +53,8 @@ class AsyncVideoProvider {
 	int frame_number = -1; ///< Last frame number requested
 	double time = -1.; ///< Time of the frame to pass to the subtitle renderer
 
-	/// Copy of the subtitles file to avoid having to touch the project context
-	std::unique_ptr<AssFile> subs;
+	/// Snapshot of the subtitles file to avoid having to touch the project context
+	std::shared_ptr<const AssFileSnapshot> subs;
 
 	/// If >= 0, the subtitles provider current has just the lines visible on
 	/// that frame loaded. If -1, the entire file is loaded. If -2, the
@@ -72,12 +74,66 @@ class AsyncVideoProvider {
 	/// Produce a frame if req_version is still the current version
 	void ProcAsync(uint_fast32_t req_version, bool check_updated);
 
+	/// Snapshot subs and send it to the worker to be drawn
+	void QueueSubtitles(const AssFile *subs, bool check_updated);
+
 	/// Monotonic counter used to drop frames when changes arrive faster than
 	/// they can be rendered
 	std::atomic<uint_fast32_t> version{ 0 };
 
 	std::vector<std::shared_ptr<VideoFrame>> buffers;
 
+public:
+	/// A frame rendered ahead of time for playback
+	struct QueuedFrame {
+		int frame_n = -1;
+		/// Time at which the frame should be presented in milliseconds
+		double time = 0;
+		std::shared_ptr<VideoFrame> frame;
+	};
+
+	/// Counters describing how well playback has kept up
+	struct PlaybackStats {
+		/// Frames handed to the display
+		uint64_t presented = 0;
+		/// Frames which were rendered but were already superseded by a later
+		/// frame by the time they would have been presented
+		uint64_t late = 0;
+		/// Frames which were never rendered because the clock had already
+		/// passed them when the worker got to them
+		uint64_t dropped = 0;
+	};
+
+private:
+	/// Protects everything related to playback below
+	std::mutex playback_lock;
+	/// Rendered frames waiting to be presented, in presentation order
+	std::deque<QueuedFrame> playback_queue;
+	/// Timecodes used to pick frame times during playback
+	agi::vfr::Framerate playback_fps;
+	/// Is playback currently running?
+	bool playing = false;
+	/// Is there a ProducePlaybackFrame call queued or running?
+	bool producing = false;
+	/// Next frame to render for playback
+	int playback_next = 0;
+	/// Frame to stop rendering at
+	int playback_end = 0;
+	/// Most recent presentation time passed to PresentFrame
+	int playback_clock = 0;
+	/// Incremented whenever playback starts or stops so that stale
+	/// producer calls can tell that they should do nothing
+	uint_fast32_t playback_generation = 0;
+	PlaybackStats stats;
+
+	/// Render the next playback frame into the queue, then queue another
+	/// call to itself if there's room for more
+	void ProducePlaybackFrame(uint_fast32_t generation);
+
+	/// Throw away all queued frames so that they are rendered again with
+	/// the current subtitles. Must be called on the worker.
+	void FlushPlaybackQueue();
+
 	// Returns a monochromatic frame with the current dimensions
 	VideoFrame GetBlankFrame(bool white);
 
@@ -85,17 +141,16 @@ public:
 	/// @brief Load the passed subtitle file
 	/// @param subs File to load
 	///
-	/// This function blocks until is it is safe for the calling thread to
-	/// modify subs
+	/// A snapshot of the file is taken before returning, so the calling
+	/// thread is free to modify subs afterwards
 	void LoadSubtitles(const AssFile *subs) throw();
 
-	/// @brief Update a previously loaded subtitle file
+	/// @brief Load the passed subtitle file after changes to only its lines
 	/// @param subs Subtitle file which was last passed to LoadSubtitles
-	/// @param changes Set of lines which have changed
 	///
-	/// This function only supports changes to existing lines, and not
-	/// insertions or deletions.
-	void UpdateSubtitles(const AssFile *subs, const AssDialogue *changes) throw();
+	/// The current frame is only redrawn if the lines visible on it changed,
+	/// so this must not be used if anything other than lines has changed.
+	void UpdateSubtitles(const AssFile *subs) throw();
 
 	/// @brief Queue a request for a frame
 	/// @brief frame Frame number
@@ -111,6 +166,15 @@ public:
 	/// @brief raw   Get raw frame without subtitles
 	std::shared_ptr<VideoFrame> GetFrame(int frame, double time, bool raw = false);
 
+	/// @brief Synchronously decode a frame without subtitles into a caller-owned buffer
+	/// @brief frame Frame number
+	/// @brief out   Frame to decode into
+	///
+	/// Unlike GetFrame, this doesn't use the provider's pool of frame buffers,
+	/// so callers which need to hold on to many frames at once don't
+	/// permanently grow the pool.
+	void GetRawFrame(int frame, VideoFrame &out);
+
 	/// @brief Synchronously get the subtitles with transparent background
 	/// @brief time  Exact start time of the frame in seconds
 	///
@@ -120,6 +184,31 @@ public:
 	/// purposes like copying the current subtitles to the clipboard.
 	VideoFrame GetSubtitles(double time);
 
+	/// @brief Start rendering frames ahead of time for playback
+	/// @param first_frame First frame to play
+	/// @param end_frame Frame to stop at, which is not played
+	/// @param fps Timecodes to use for presentation times
+	///
+	/// Up to a fixed number of frames are decoded and rendered ahead of the
+	/// clock passed to PresentFrame. If rendering falls behind, frames the
+	/// clock has already passed are skipped rather than rendered late.
+	void StartPlayback(int first_frame, int end_frame, agi::vfr::Framerate const& fps);
+
+	/// Stop playback and discard any frames rendered ahead
+	void StopPlayback();
+
+	/// @brief Get the frame to display at the given time during playback
+	/// @param ms   Current playback clock in milliseconds
+	/// @param[out] frame The most recent frame due at that time
+	/// @return Was there a new frame due?
+	///
+	/// Frames which were due but superseded by a later due frame are dropped
+	/// and counted as late.
+	bool PresentFrame(int ms, QueuedFrame& frame);
+
+	/// Get the playback counters accumulated since the video was opened
+	PlaybackStats GetPlaybackStats();
+
 	/// Ask the video provider to change YCbCr matricies
 	void SetColorSpace(std::string const& matrix);
 
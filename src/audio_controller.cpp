@@ -35,10 +35,25 @@
 #include "options.h"
 #include "project.h"
 
+#include <libaegisub/audio/envelope.h>
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/dispatch.h>
+#include <libaegisub/log.h>
+#include <libaegisub/make_unique.h>
 
 #include <algorithm>
 
+namespace {
+void log_cache_stats(agi::AudioProvider const& provider, const char *when) {
+	auto stats = provider.GetCacheStats();
+	if (!stats.max_bytes) return;
+	LOG_D("audio/cache") << when << ": " << (stats.bytes >> 10) << " of "
+		<< (stats.max_bytes >> 10) << " KB used, " << stats.hits << " hits, "
+		<< stats.misses << " misses, " << stats.prefetched << " prefetched, "
+		<< stats.evictions << " evicted, " << stats.uncached << " read uncached";
+}
+}
+
 AudioController::AudioController(agi::Context *context)
 : context(context)
 , playback_timer(this)
@@ -56,6 +71,7 @@ AudioController::AudioController(agi::Context *context)
 
 AudioController::~AudioController()
 {
+	CancelEnvelope();
 	Stop();
 }
 
@@ -111,10 +127,56 @@ void AudioController::OnAudioPlayerChanged()
 
 void AudioController::OnAudioProvider(agi::AudioProvider *new_provider)
 {
+	CancelEnvelope();
+	if (provider)
+		log_cache_stats(*provider, "Closing audio");
+	if (envelope) {
+		envelope.reset();
+		AnnounceEnvelopeChanged();
+	}
+
 	provider = new_provider;
 	Stop();
 	player.reset();
 	OnAudioPlayerChanged();
+
+	if (!provider) return;
+
+	envelope_task = agi::make_unique<agi::dispatch::TaskGroup>();
+	auto token = envelope_task->Token();
+	envelope_task->Async(agi::dispatch::Background(agi::dispatch::Priority::Low), [=] {
+		std::shared_ptr<const agi::EnergyEnvelope> result;
+		try {
+			result = agi::EnergyEnvelope::Compute(*new_provider, [=] { return token.IsCancelled(); });
+		}
+		catch (agi::UserCancelException const&) {
+			return;
+		}
+		catch (agi::Exception const& e) {
+			LOG_E("audio/envelope") << "Failed computing energy envelope: " << e.GetMessage();
+			return;
+		}
+
+		agi::dispatch::Main().Async([=] {
+			// The token is cancelled before the controller is destroyed or
+			// the provider changes, so this is safe to check first
+			if (token.IsCancelled()) return;
+			log_cache_stats(*new_provider, "Energy envelope computed");
+			envelope = result;
+			AnnounceEnvelopeChanged();
+		});
+	});
+}
+
+void AudioController::CancelEnvelope()
+{
+	if (!envelope_task) return;
+	envelope_task->Cancel();
+	try {
+		envelope_task->Wait();
+	}
+	catch (...) { }
+	envelope_task.reset();
 }
 
 void AudioController::SetTimingController(std::unique_ptr<AudioTimingController> new_controller)
@@ -136,6 +198,7 @@ void AudioController::PlayRange(const TimeRange &range)
 {
 	if (!player) return;
 
+	provider->Prefetch(SamplesFromMilliseconds(range.begin()), SamplesFromMilliseconds(range.length()));
 	player->Play(SamplesFromMilliseconds(range.begin()), SamplesFromMilliseconds(range.length()));
 	playback_mode = PM_Range;
 	playback_timer.Start(20);
@@ -162,6 +225,7 @@ void AudioController::PlayToEnd(int start_ms)
 	if (!player) return;
 
 	int64_t start_sample = SamplesFromMilliseconds(start_ms);
+	provider->Prefetch(start_sample, provider->GetNumSamples() - start_sample);
 	player->Play(start_sample, provider->GetNumSamples()-start_sample);
 	playback_mode = PM_ToEnd;
 	playback_timer.Start(20);
@@ -31,6 +31,7 @@
 #include <libaegisub/signal.h>
 
 #include <cstdint>
+#include <memory>
 #include <wx/event.h>
 #include <wx/power.h>
 #include <wx/timer.h>
@@ -39,7 +40,9 @@ class AudioPlayer;
 class AudioTimingController;
 class TimeRange;
 namespace agi { class AudioProvider; }
+namespace agi { class EnergyEnvelope; }
 namespace agi { struct Context; }
+namespace agi { namespace dispatch { class TaskGroup; } }
 
 /// @class AudioController
 /// @brief Manage playback of an open audio stream
@@ -65,6 +68,10 @@ class AudioController final : public wxEvtHandler {
 	/// A new audio player was created
 	agi::signal::Signal<> AnnounceAudioPlayerOpened;
 
+	/// The energy envelope of the current audio has finished being computed,
+	/// or was discarded due to the audio being closed
+	agi::signal::Signal<> AnnounceEnvelopeChanged;
+
 	/// The audio output object
 	std::unique_ptr<AudioPlayer> player;
 
@@ -87,6 +94,17 @@ class AudioController final : public wxEvtHandler {
 	agi::AudioProvider *provider = nullptr;
 	agi::signal::Connection provider_connection;
 
+	/// Energy envelope of the current audio, or nullptr if it hasn't been
+	/// computed yet
+	std::shared_ptr<const agi::EnergyEnvelope> envelope;
+
+	/// Background computation of the energy envelope
+	std::unique_ptr<agi::dispatch::TaskGroup> envelope_task;
+
+	/// Cancel the envelope computation and wait for it to stop reading from
+	/// the provider
+	void CancelEnvelope();
+
 	void OnAudioProvider(agi::AudioProvider *new_provider);
 
 	/// Event handler for the playback timer
@@ -176,6 +194,13 @@ public:
 	/// @param volume The new amplification factor for the audio
 	void SetVolume(double volume);
 
+	/// @brief Get the energy envelope of the open audio
+	/// @return The envelope, or nullptr if it's still being computed
+	///
+	/// The envelope is computed in the background after audio is opened,
+	/// following the audio cache as it decodes.
+	std::shared_ptr<const agi::EnergyEnvelope> GetEnergyEnvelope() const { return envelope; }
+
 	/// @brief Return the current timing controller
 	/// @return The current timing controller or 0
 	AudioTimingController *GetTimingController() const { return timing_controller.get(); }
@@ -188,4 +213,5 @@ public:
 	DEFINE_SIGNAL_ADDERS(AnnouncePlaybackStop,            AddPlaybackStopListener)
 	DEFINE_SIGNAL_ADDERS(AnnounceTimingControllerChanged, AddTimingControllerListener)
 	DEFINE_SIGNAL_ADDERS(AnnounceAudioPlayerOpened,       AddAudioPlayerOpenListener)
+	DEFINE_SIGNAL_ADDERS(AnnounceEnvelopeChanged,         AddEnvelopeListener)
 };
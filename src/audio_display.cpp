@@ -626,6 +626,16 @@ void AudioDisplay::ScrollPixelToLeft(int pixel_position)
 	scroll_left = pixel_position;
 	scrollbar->SetPosition(scroll_left);
 	timeline->SetPosition(scroll_left);
+
+	// Start decoding what's visible plus a screen to either side so that
+	// rendering and nearby playback don't have to wait for it
+	if (provider) {
+		const int64_t rate = provider->GetSampleRate();
+		const int64_t start = int64_t((scroll_left - client_width) * ms_per_pixel) * rate / 1000;
+		const int64_t length = int64_t(3 * client_width * ms_per_pixel) * rate / 1000;
+		provider->Prefetch(start, length);
+	}
+
 	Refresh();
 }
 
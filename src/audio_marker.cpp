@@ -21,12 +21,14 @@
 
 #include "audio_marker.h"
 
+#include "audio_controller.h"
 #include "include/aegisub/context.h"
 #include "options.h"
 #include "pen.h"
 #include "project.h"
 #include "video_controller.h"
 
+#include <libaegisub/audio/envelope.h>
 #include <libaegisub/make_unique.h>
 
 #include <algorithm>
@@ -69,8 +71,8 @@ void AudioMarkerProviderKeyframes::Update() {
 
 	markers.clear();
 	markers.reserve(keyframes.size());
-	for (int frame : keyframes)
-		markers.emplace_back(style.get(), timecodes.TimeAtFrame(frame, agi::vfr::START));
+	for (int time : timecodes.TimesAtFrames(keyframes, agi::vfr::START))
+		markers.emplace_back(style.get(), time);
 	AnnounceMarkerMoved();
 }
 
@@ -84,6 +86,61 @@ void AudioMarkerProviderKeyframes::GetMarkers(TimeRange const& range, AudioMarke
 		out.push_back(&*a);
 }
 
+class AudioMarkerVoiceActivity final : public AudioMarker {
+	Pen *style;
+	int position;
+	FeetStyle feet;
+public:
+	AudioMarkerVoiceActivity(Pen *style, int position, FeetStyle feet) : style(style), position(position), feet(feet) { }
+	int GetPosition() const override { return position; }
+	FeetStyle GetFeet() const override { return feet; }
+	wxPen GetStyle() const override { return *style; }
+	operator int() const { return position; }
+};
+
+AudioMarkerProviderVoiceActivity::AudioMarkerProviderVoiceActivity(agi::Context *c)
+: ac(c->audioController.get())
+, envelope_slot(ac->AddEnvelopeListener(&AudioMarkerProviderVoiceActivity::Update, this))
+, enabled_slot(OPT_SUB("Audio/Display/Draw/Voice Activity", &AudioMarkerProviderVoiceActivity::Update, this))
+, enabled_opt(OPT_GET("Audio/Display/Draw/Voice Activity"))
+, style(agi::make_unique<Pen>("Colour/Audio Display/Voice Activity", 1, wxPENSTYLE_SHORT_DASH))
+{
+	Update();
+}
+
+AudioMarkerProviderVoiceActivity::~AudioMarkerProviderVoiceActivity() { }
+
+void AudioMarkerProviderVoiceActivity::Update() {
+	auto envelope = ac->GetEnergyEnvelope();
+	if (!envelope || !enabled_opt->GetBool()) {
+		if (!markers.empty()) {
+			markers.clear();
+			AnnounceMarkerMoved();
+		}
+		return;
+	}
+
+	auto const& onsets = envelope->Onsets();
+	auto const& offsets = envelope->Offsets();
+
+	// Segments never overlap, so interleaving the onsets and offsets gives
+	// a sorted list
+	markers.clear();
+	markers.reserve(onsets.size() + offsets.size());
+	for (size_t i = 0; i < onsets.size(); ++i) {
+		markers.emplace_back(style.get(), onsets[i], AudioMarker::Feet_Right);
+		markers.emplace_back(style.get(), offsets[i], AudioMarker::Feet_Left);
+	}
+	AnnounceMarkerMoved();
+}
+
+void AudioMarkerProviderVoiceActivity::GetMarkers(TimeRange const& range, AudioMarkerVector &out) const {
+	auto a = lower_bound(markers.begin(), markers.end(), range.begin());
+	auto b = upper_bound(markers.begin(), markers.end(), range.end());
+	for (; a != b; ++a)
+		out.push_back(&*a);
+}
+
 class VideoPositionMarker final : public AudioMarker {
 	Pen style{"Colour/Audio Display/Play Cursor"};
 	int position = -1;
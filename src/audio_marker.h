@@ -24,7 +24,9 @@
 #include <vector>
 #include <wx/string.h>
 
+class AudioController;
 class AudioMarkerKeyframe;
+class AudioMarkerVoiceActivity;
 class Pen;
 class Project;
 class VideoController;
@@ -138,6 +140,36 @@ public:
 	void GetMarkers(TimeRange const& range, AudioMarkerVector &out) const override;
 };
 
+/// Marker provider for the starts and ends of speech found in the audio's
+/// energy envelope
+class AudioMarkerProviderVoiceActivity final : public AudioMarkerProvider {
+	AudioController *ac;
+
+	agi::signal::Connection envelope_slot;
+	agi::signal::Connection enabled_slot;
+	const agi::OptionValue *enabled_opt;
+
+	/// Markers for each onset and offset, sorted by position
+	std::vector<AudioMarkerVoiceActivity> markers;
+
+	/// Pen used for all voice activity markers
+	std::unique_ptr<Pen> style;
+
+	/// Regenerate the list of markers
+	void Update();
+
+public:
+	/// Constructor
+	/// @param c Project context; must have the audio controller initialized
+	AudioMarkerProviderVoiceActivity(agi::Context *c);
+	~AudioMarkerProviderVoiceActivity();
+
+	/// Get all onset and offset markers within a range
+	/// @param range Time range to get markers for
+	/// @param[out] out Vector to fill with markers in the range
+	void GetMarkers(TimeRange const& range, AudioMarkerVector &out) const override;
+};
+
 /// Marker provider for the current video playback position
 class VideoPositionMarkerProvider final : public AudioMarkerProvider {
 	VideoController *vc;
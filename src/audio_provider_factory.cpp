@@ -27,6 +27,7 @@
 #include <libaegisub/log.h>
 #include <libaegisub/path.h>
 
+#include <algorithm>
 #include <boost/range/iterator_range.hpp>
 
 using namespace agi;
@@ -158,6 +159,12 @@ std::unique_ptr<agi::AudioProvider> GetAudioProvider(fs::path const& filename,
 	// Convert to RAM
 	if (cache == 1) return CreateRAMAudioProvider(std::move(provider));
 
+	// Keep a bounded number of blocks in RAM
+	if (cache == 3) {
+		auto size = OPT_GET("Audio/Cache/Block/Size")->GetInt();
+		return CreateBlockCacheAudioProvider(std::move(provider), static_cast<size_t>(std::max<int64_t>(size, 1)) << 20);
+	}
+
 	// Convert to HD
 	if (cache == 2) {
 		auto path = OPT_GET("Audio/Cache/HD/Location")->GetString();
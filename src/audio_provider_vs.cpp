@@ -30,6 +30,7 @@
 #include <libaegisub/format.h>
 #include <libaegisub/path.h>
 #include <libaegisub/make_unique.h>
+#include <libaegisub/trace.h>
 
 #include <mutex>
 
@@ -43,6 +44,7 @@ class VapourSynthAudioProvider final : public agi::AudioProvider {
 	VSScript *script = nullptr;
 	VSNode *node = nullptr;
 	const VSAudioInfo *vi = nullptr;
+	std::unique_ptr<VSFrameRequests> requests;
 
 	void FillBufferWithFrame(void *buf, int frame, int64_t start, int64_t count) const;
 	void FillBuffer(void *buf, int64_t start, int64_t count) const override;
@@ -88,6 +90,10 @@ VapourSynthAudioProvider::VapourSynthAudioProvider(agi::fs::path const& filename
 	sample_rate = vi->sampleRate;
 	channels = vi->format.numChannels;
 	num_samples = vi->numSamples;
+
+	VSCoreInfo core_info;
+	vs.GetAPI()->getCoreInfo(core, &core_info);
+	requests = agi::make_unique<VSFrameRequests>(vs.GetAPI(), node, core_info.numThreads);
 }
 catch (VapourSynthError const& err) {
 	throw agi::AudioProviderError(err.GetMessage());
@@ -105,11 +111,7 @@ static void PackChannels(const uint8_t **Src, void *Dst, size_t Length, size_t C
 }
 
 void VapourSynthAudioProvider::FillBufferWithFrame(void *buf, int n, int64_t start, int64_t count) const {
-	char errorMsg[1024];
-	const VSFrame *frame = vs.GetAPI()->getFrame(n, node, errorMsg, sizeof(errorMsg));
-	if (frame == nullptr) {
-		throw VapourSynthError(agi::format("Error getting frame: %s", errorMsg));
-	}
+	const VSFrame *frame = requests->Get(n);
 	if (vs.GetAPI()->getFrameLength(frame) < count) {
 		vs.GetAPI()->freeFrame(frame);
 		throw VapourSynthError("Audio frame too short");
@@ -146,6 +148,12 @@ void VapourSynthAudioProvider::FillBuffer(void *buf, int64_t start, int64_t coun
 	int endframe = (end - 1) / VS_AUDIO_FRAME_SAMPLES;
 	int offset = start - (VS_AUDIO_FRAME_SAMPLES * startframe);
 
+	AGI_TRACE_SCOPE("audio", "VapourSynth::FillBuffer");
+
+	// Request every frame in the range up front so that they're all filtered
+	// in parallel rather than one after another
+	requests->Request(startframe, endframe + 1);
+
 	for (int frame = startframe; frame <= endframe; frame++) {
 		int framestart = frame * VS_AUDIO_FRAME_SAMPLES;
 		int frameend = (frame + 1) * VS_AUDIO_FRAME_SAMPLES;
@@ -157,6 +165,8 @@ void VapourSynthAudioProvider::FillBuffer(void *buf, int64_t start, int64_t coun
 }
 
 VapourSynthAudioProvider::~VapourSynthAudioProvider() {
+	// Wait for any outstanding requests before freeing the node
+	requests.reset();
 	if (node != nullptr) {
 		vs.GetAPI()->freeNode(node);
 	}
@@ -311,6 +311,9 @@ class AudioTimingControllerDialogue final : public AudioTimingController {
 	/// Marker provider for video playback position
 	VideoPositionMarkerProvider video_position_provider;
 
+	/// Marker provider for detected starts and ends of speech
+	AudioMarkerProviderVoiceActivity voice_activity_provider;
+
 	/// Marker provider for seconds lines
 	SecondsMarkerProvider seconds_provider;
 
@@ -416,6 +419,7 @@ AudioTimingControllerDialogue::AudioTimingControllerDialogue(agi::Context *c)
 : active_line(AudioStyle_Primary, &style_left, &style_right)
 , keyframes_provider(c, "Audio/Display/Draw/Keyframes in Dialogue Mode")
 , video_position_provider(c)
+, voice_activity_provider(c)
 , context(c)
 , commit_connection(c->ass->AddCommitListener(&AudioTimingControllerDialogue::OnFileChanged, this))
 , inactive_line_mode_connection(OPT_SUB("Audio/Inactive Lines Display Mode", &AudioTimingControllerDialogue::RegenerateInactiveLines, this))
@@ -425,6 +429,7 @@ AudioTimingControllerDialogue::AudioTimingControllerDialogue(agi::Context *c)
 {
 	keyframes_provider.AddMarkerMovedListener([=]{ AnnounceMarkerMoved(); });
 	video_position_provider.AddMarkerMovedListener([=]{ AnnounceMarkerMoved(); });
+	voice_activity_provider.AddMarkerMovedListener([=]{ AnnounceMarkerMoved(); });
 	seconds_provider.AddMarkerMovedListener([=]{ AnnounceMarkerMoved(); });
 
 	Revert();
@@ -443,6 +448,7 @@ void AudioTimingControllerDialogue::GetMarkers(const TimeRange &range, AudioMark
 		boost::upper_bound(markers, range.end(), marker_ptr_cmp()),
 		back_inserter(out_markers));
 
+	voice_activity_provider.GetMarkers(range, out_markers);
 	keyframes_provider.GetMarkers(range, out_markers);
 	video_position_provider.GetMarkers(range, out_markers);
 }
@@ -897,6 +903,7 @@ int AudioTimingControllerDialogue::SnapMarkers(int snap_range, std::vector<Audio
 		TimeRange range(pos - snap_range, pos + snap_range);
 		keyframes_provider.GetMarkers(range, snap_markers);
 		video_position_provider.GetMarkers(range, snap_markers);
+		voice_activity_provider.GetMarkers(range, snap_markers);
 
 		for (const auto marker : snap_markers)
 		{
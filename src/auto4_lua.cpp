@@ -63,6 +63,8 @@
 #include <libaegisub/lua/utils.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/timing_processor.h>
+#include <libaegisub/vfr.h>
 
 #include <algorithm>
 #include <boost/algorithm/string/case_conv.hpp>
@@ -329,6 +331,98 @@ namespace {
 		return 1;
 	}
 
+	/// Read an optional number from the settings table for process_timing
+	template<typename T>
+	void get_setting(lua_State *L, const char *name, T& value)
+	{
+		lua_getfield(L, 2, name);
+		if (!lua_isnil(L, -1)) {
+			if (!lua_isnumber(L, -1))
+				error(L, "process_timing: %s must be a number", name);
+			value = static_cast<T>(lua_tonumber(L, -1));
+		}
+		lua_pop(L, 1);
+	}
+
+	void get_setting(lua_State *L, const char *name, bool& value)
+	{
+		lua_getfield(L, 2, name);
+		if (!lua_isnil(L, -1))
+			value = !!lua_toboolean(L, -1);
+		lua_pop(L, 1);
+	}
+
+	/// aegisub.process_timing(lines, settings): run the timing post-processor
+	/// on an array of dialogue line tables, updating their start_time and
+	/// end_time fields in place
+	int process_timing(lua_State *L)
+	{
+		luaL_checktype(L, 1, LUA_TTABLE);
+		if (lua_isnoneornil(L, 2)) {
+			lua_settop(L, 1);
+			lua_newtable(L);
+		}
+		luaL_checktype(L, 2, LUA_TTABLE);
+
+		agi::timing::Settings settings;
+		get_setting(L, "lead_in", settings.lead_in);
+		get_setting(L, "lead_out", settings.lead_out);
+		get_setting(L, "adjacent", settings.adjacent);
+		get_setting(L, "adjacent_gap", settings.adjacent_gap);
+		get_setting(L, "adjacent_overlap", settings.adjacent_overlap);
+		get_setting(L, "adjacent_bias", settings.adjacent_bias);
+		get_setting(L, "keyframes", settings.keyframes);
+		get_setting(L, "keyframe_before_start", settings.keyframe_before_start);
+		get_setting(L, "keyframe_after_start", settings.keyframe_after_start);
+		get_setting(L, "keyframe_before_end", settings.keyframe_before_end);
+		get_setting(L, "keyframe_after_end", settings.keyframe_after_end);
+		get_setting(L, "speech", settings.speech);
+		get_setting(L, "speech_distance", settings.speech_distance);
+
+		const agi::Context *c = get_context(L);
+		agi::vfr::Framerate fps;
+		std::vector<int> kf;
+		if (settings.keyframes) {
+			if (!c || !c->project->Timecodes().IsLoaded())
+				error(L, "process_timing: keyframe snapping requires video or timecodes to be loaded");
+			fps = c->project->Timecodes();
+			kf = c->project->Keyframes();
+			if (auto provider = c->project->VideoProvider()) {
+				int last_frame = provider->GetFrameCount() - 1;
+				if (kf.empty() || kf.back() < last_frame)
+					kf.push_back(last_frame);
+			}
+		}
+		std::shared_ptr<const agi::EnergyEnvelope> envelope;
+		if (settings.speech && c)
+			envelope = c->audioController->GetEnergyEnvelope();
+
+		size_t count = lua_objlen(L, 1);
+		std::vector<agi::timing::Line> lines(count);
+		for (size_t i = 0; i < count; ++i) {
+			lua_rawgeti(L, 1, i + 1);
+			if (!lua_istable(L, -1))
+				error(L, "process_timing: line %d is not a table", (int)i + 1);
+			lua_getfield(L, -1, "start_time");
+			lua_getfield(L, -2, "end_time");
+			if (!lua_isnumber(L, -2) || !lua_isnumber(L, -1))
+				error(L, "process_timing: line %d has no start_time or end_time", (int)i + 1);
+			lines[i].start = lua_tointeger(L, -2);
+			lines[i].end = lua_tointeger(L, -1);
+			lua_pop(L, 3);
+		}
+
+		agi::timing::Process(lines, settings, kf, fps, envelope.get());
+
+		for (size_t i = 0; i < count; ++i) {
+			lua_rawgeti(L, 1, i + 1);
+			set_field(L, "start_time", lines[i].start);
+			set_field(L, "end_time", lines[i].end);
+			lua_pop(L, 1);
+		}
+		return 0;
+	}
+
 	int decode_path(lua_State *L)
 	{
 		std::string path = check_string(L, 1);
@@ -346,6 +440,16 @@ namespace {
 		throw error_tag();
 	}
 
+	int register_nothing(lua_State *)
+	{
+		return 0;
+	}
+
+	int parallel_map_in_worker(lua_State *L)
+	{
+		return error(L, "aegisub.parallel_map cannot be used from within a parallel_map function");
+	}
+
 	int lua_text_textents(lua_State *L)
 	{
 		argcheck(L, !!lua_istable(L, 1), 1, "");
@@ -368,6 +472,10 @@ namespace {
 		if (typeid(*et) != typeid(AssStyle))
 			return error(L, "Not a style entry");
 
+		// Scripts may call this from several parallel_map workers at once
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
+
 		double width, height, descent, extlead;
 		if (!Automation4::CalculateTextExtents(static_cast<AssStyle*>(et.get()),
 				check_string(L, 2), width, height, descent, extlead))
@@ -548,7 +656,14 @@ namespace {
 		/// destroy internal structures, unreg features and delete environment
 		void Destroy();
 
+		/// Set up a new Lua state and run the script in it
+		/// @param L State to set up
+		/// @param worker Is the state a parallel_map worker rather than the script's own state?
+		/// @return Error message, or an empty string on success
+		std::string InitState(lua_State *L, bool worker);
+
 		static int LuaInclude(lua_State *L);
+		static int LuaParallelMap(lua_State *L);
 
 	public:
 		LuaScript(agi::fs::path const& filename);
@@ -594,6 +709,36 @@ namespace {
 
 		bool loaded = false;
 		BOOST_SCOPE_EXIT_ALL(&) { if (!loaded) Destroy(); };
+
+		description = InitState(L, false);
+		if (!description.empty())
+			return;
+
+		LuaStackcheck stackcheck(L);
+		lua_getglobal(L, "version");
+		if (lua_isnumber(L, -1) && lua_tointeger(L, -1) == 3) {
+			lua_pop(L, 1); // just to avoid tripping the stackcheck in debug
+			description = "Attempted to load an Automation 3 script as an Automation 4 Lua script. Automation 3 is no longer supported.";
+			stackcheck.check_stack(0);
+			return;
+		}
+
+		name = get_global_string(L, "script_name");
+		description = get_global_string(L, "script_description");
+		author = get_global_string(L, "script_author");
+		version = get_global_string(L, "script_version");
+
+		if (name.empty())
+			name = GetPrettyFilename().string();
+
+		lua_pop(L, 1);
+		stackcheck.check_stack(0);
+		// if we got this far, the script should be ready
+		loaded = true;
+	}
+
+	std::string LuaScript::InitState(lua_State *L, bool worker)
+	{
 		LuaStackcheck stackcheck(L);
 
 		// register standard libs
@@ -611,9 +756,9 @@ namespace {
 		// Replace the default lua module loader with our unicode compatible
 		// one and set the module search path
 		if (!Install(L, include_path)) {
-			description = get_string_or_default(L, 1);
+			std::string err = get_string_or_default(L, 1);
 			lua_pop(L, 1);
-			return;
+			return err;
 		}
 		stackcheck.check_stack(0);
 
@@ -631,15 +776,26 @@ namespace {
 
 		// make "aegisub" table
 		lua_pushstring(L, "aegisub");
-		lua_createtable(L, 0, 13);
-
-		set_field<LuaCommand::LuaRegister>(L, "register_macro");
-		set_field<LuaExportFilter::LuaRegister>(L, "register_filter");
+		lua_createtable(L, 0, 14);
+
+		if (worker) {
+			// Workers only exist to run functions for parallel_map, so the
+			// script's features are registered by the main state alone
+			set_field<register_nothing>(L, "register_macro");
+			set_field<register_nothing>(L, "register_filter");
+			set_field<parallel_map_in_worker>(L, "parallel_map");
+		}
+		else {
+			set_field<LuaCommand::LuaRegister>(L, "register_macro");
+			set_field<LuaExportFilter::LuaRegister>(L, "register_filter");
+			set_field<LuaParallelMap>(L, "parallel_map");
+		}
 		set_field<lua_text_textents>(L, "text_extents");
 		set_field<frame_from_ms>(L, "frame_from_ms");
 		set_field<ms_from_frame>(L, "ms_from_frame");
 		set_field<video_size>(L, "video_size");
 		set_field<get_keyframes>(L, "keyframes");
+		set_field<process_timing>(L, "process_timing");
 		set_field<decode_path>(L, "decode_path");
 		set_field<cancel_script>(L, "cancel");
 		set_field(L, "lua_automation_version", 4);
@@ -664,9 +820,9 @@ namespace {
 
 		// load user script
 		if (!LoadFile(L, GetFilename())) {
-			description = get_string_or_default(L, 1);
+			std::string err = get_string_or_default(L, 1);
 			lua_pop(L, 1);
-			return;
+			return err;
 		}
 		stackcheck.check_stack(1);
 
@@ -678,35 +834,17 @@ namespace {
 		// this is where features are registered
 		if (lua_pcall(L, 0, 0, -2)) {
 			// error occurred, assumed to be on top of Lua stack
-			description = agi::format("Error initialising Lua script \"%s\":\n\n%s", GetPrettyFilename().string(), get_string_or_default(L, -1));
+			std::string err = agi::format("Error initialising Lua script \"%s\":\n\n%s", GetPrettyFilename().string(), get_string_or_default(L, -1));
 			lua_pop(L, 2); // error + error handler
-			return;
+			return err;
 		}
 		lua_pop(L, 1); // error handler
 		stackcheck.check_stack(0);
 
-		lua_getglobal(L, "version");
-		if (lua_isnumber(L, -1) && lua_tointeger(L, -1) == 3) {
-			lua_pop(L, 1); // just to avoid tripping the stackcheck in debug
-			description = "Attempted to load an Automation 3 script as an Automation 4 Lua script. Automation 3 is no longer supported.";
-			stackcheck.check_stack(0);
-			return;
-		}
-
-		name = get_global_string(L, "script_name");
-		description = get_global_string(L, "script_description");
-		author = get_global_string(L, "script_author");
-		version = get_global_string(L, "script_version");
-
-		if (name.empty())
-			name = GetPrettyFilename().string();
-
-		lua_pop(L, 1);
-		stackcheck.check_stack(0);
-		// if we got this far, the script should be ready
-		loaded = true;
+		return "";
 	}
 
+
 	void LuaScript::Destroy()
 	{
 		// Assume the script object is clean if there's no Lua state
@@ -790,6 +928,29 @@ namespace {
 		return lua_gettop(L) - pretop;
 	}
 
+	int LuaScript::LuaParallelMap(lua_State *L)
+	{
+		LuaScript *s = GetScriptObject(L);
+		const agi::Context *c = get_context(L);
+		return Automation4::LuaParallelMap(L, [=] {
+			lua_State *worker = luaL_newstate();
+			if (!worker)
+				throw agi::EnvironmentError("Could not initialize Lua state");
+
+			std::string err = s->InitState(worker, true);
+			if (!err.empty()) {
+				lua_close(worker);
+				throw agi::EnvironmentError(err);
+			}
+
+			// Give the workers the same view of the project as the calling
+			// script so that results match those of a serial run
+			if (c)
+				set_context(worker, c);
+			return worker;
+		});
+	}
+
 	void LuaThreadedCall(lua_State *L, int nargs, int nresults, std::string const& title, wxWindow *parent, bool can_open_config)
 	{
 		bool failed = false;
@@ -1206,6 +1367,9 @@ namespace Automation4 {
 	LuaScriptFactory::LuaScriptFactory()
 	: ScriptFactory("Lua", "*.lua,*.moon")
 	{
+		auto cache_dir = config::path->Decode("?local/luacache/");
+		agi::lua::SetChunkCacheDirectory(cache_dir);
+		CleanCache(cache_dir, "*.ljbc", 32, 1000);
 	}
 
 	std::unique_ptr<Script> LuaScriptFactory::Produce(agi::fs::path const& filename) const
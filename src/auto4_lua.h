@@ -30,6 +30,7 @@
 #include "auto4_base.h"
 
 #include <deque>
+#include <functional>
 #include <vector>
 #include <wx/string.h>
 
@@ -222,4 +223,14 @@ namespace Automation4 {
 		std::string Serialise() override;
 		void Unserialise(const std::string &serialised) override;
 	};
+
+	/// @brief Implementation of aegisub.parallel_map
+	/// @param L Calling state, with the function name, items and shared table as arguments
+	/// @param create_worker Creates a new state with the calling script loaded into it
+	/// @return Number of values pushed onto L
+	///
+	/// Runs the named global function over each item on a pool of Lua states,
+	/// each created with create_worker. Values are copied between states, so
+	/// only nil, booleans, numbers, strings and tables of them can be passed.
+	int LuaParallelMap(lua_State *L, std::function<lua_State *()> const& create_worker);
 }
@@ -0,0 +1,385 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+/// @file auto4_lua_parallel.cpp
+/// @brief Running a script function over many items on a pool of Lua states
+/// @ingroup scripting
+///
+
+#include "auto4_lua.h"
+
+#include "ass_file.h"
+
+#include <libaegisub/dispatch.h>
+#include <libaegisub/lua/utils.h>
+#include <libaegisub/make_unique.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/scope_exit.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+using namespace agi::lua;
+using namespace Automation4;
+
+namespace {
+	struct LuaTable;
+
+	/// A plain Lua value copied out of one state so that it can be pushed
+	/// into another
+	struct LuaValue {
+		int type = LUA_TNIL;
+		bool boolean = false;
+		lua_Number number = 0;
+		std::string string;
+		std::shared_ptr<LuaTable> table;
+	};
+
+	struct LuaTable {
+		/// Key/value pairs in the order lua_next returned them, which puts
+		/// the array part first
+		std::vector<std::pair<LuaValue, LuaValue>> fields;
+	};
+
+	/// Copies values out of a state, preserving tables which are referenced
+	/// more than once (including cycles)
+	class ValueReader {
+		lua_State *L;
+		std::unordered_map<const void *, std::shared_ptr<LuaTable>> seen;
+
+	public:
+		ValueReader(lua_State *L) : L(L) { }
+
+		LuaValue Read(int idx) {
+			LuaValue value;
+			switch (lua_type(L, idx)) {
+				case LUA_TNONE:
+				case LUA_TNIL:
+					break;
+				case LUA_TBOOLEAN:
+					value.type = LUA_TBOOLEAN;
+					value.boolean = !!lua_toboolean(L, idx);
+					break;
+				case LUA_TNUMBER:
+					value.type = LUA_TNUMBER;
+					value.number = lua_tonumber(L, idx);
+					break;
+				case LUA_TSTRING: {
+					value.type = LUA_TSTRING;
+					size_t len;
+					const char *str = lua_tolstring(L, idx, &len);
+					value.string.assign(str, len);
+					break;
+				}
+				case LUA_TTABLE: {
+					value.type = LUA_TTABLE;
+					auto& table = seen[lua_topointer(L, idx)];
+					if (table) {
+						value.table = table;
+						break;
+					}
+
+					table = std::make_shared<LuaTable>();
+					value.table = table;
+
+					if (!lua_checkstack(L, 2))
+						throw agi::InvalidInputException("Table is too deeply nested to pass to parallel_map");
+					lua_pushnil(L);
+					while (lua_next(L, idx)) {
+						int top = lua_gettop(L);
+						auto key = Read(top - 1);
+						value.table->fields.emplace_back(std::move(key), Read(top));
+						lua_pop(L, 1);
+					}
+					break;
+				}
+				default:
+					throw agi::InvalidInputException(std::string("Cannot pass a value of type ") + lua_typename(L, lua_type(L, idx)) + " to or from parallel_map");
+			}
+			return value;
+		}
+	};
+
+	/// Pushes copied values into a state, creating one table for each table
+	/// in the source no matter how many times it's pushed
+	class ValueWriter {
+		lua_State *L;
+		std::unordered_map<const LuaTable *, int> refs;
+
+	public:
+		ValueWriter(lua_State *L) : L(L) { }
+		~ValueWriter() {
+			for (auto const& ref : refs)
+				luaL_unref(L, LUA_REGISTRYINDEX, ref.second);
+		}
+
+		void Push(LuaValue const& value) {
+			if (!lua_checkstack(L, 3))
+				throw agi::InvalidInputException("Table is too deeply nested to pass to parallel_map");
+
+			switch (value.type) {
+				case LUA_TBOOLEAN: lua_pushboolean(L, value.boolean); return;
+				case LUA_TNUMBER:  lua_pushnumber(L, value.number); return;
+				case LUA_TSTRING:  push_value(L, value.string); return;
+				case LUA_TTABLE:   break;
+				default:           lua_pushnil(L); return;
+			}
+
+			auto it = refs.find(value.table.get());
+			if (it != refs.end()) {
+				lua_rawgeti(L, LUA_REGISTRYINDEX, it->second);
+				return;
+			}
+
+			auto const& fields = value.table->fields;
+			int narr = 0;
+			for (auto const& field : fields) {
+				if (field.first.type != LUA_TNUMBER || field.first.number != narr + 1)
+					break;
+				++narr;
+			}
+
+			lua_createtable(L, narr, fields.size() - narr);
+			lua_pushvalue(L, -1);
+			refs[value.table.get()] = luaL_ref(L, LUA_REGISTRYINDEX);
+
+			for (auto const& field : fields) {
+				Push(field.first);
+				Push(field.second);
+				lua_rawset(L, -3);
+			}
+		}
+	};
+
+	/// Progress sink for workers, which buffers log output so that it can be
+	/// replayed in item order by the calling thread
+	class WorkerProgressSink final : public agi::ProgressSink {
+		agi::ProgressSink *parent;
+
+	public:
+		std::string log;
+
+		WorkerProgressSink(agi::ProgressSink *parent) : parent(parent) { }
+
+		// Overall progress is reported by the calling thread
+		void SetIndeterminate() override { }
+		void SetTitle(std::string const&) override { }
+		void SetMessage(std::string const&) override { }
+		void SetProgress(int64_t, int64_t) override { }
+		void SetStayOpen(bool) override { }
+
+		void Log(std::string const& str) override { log += str; }
+		bool IsCancelled() override { return parent && parent->IsCancelled(); }
+	};
+
+	/// A Lua state running the calling script, along with the things it
+	/// refers to which have to outlive it
+	struct Worker {
+		/// Empty file for the worker's LuaAssFile, which is needed for
+		/// aegisub.parse_karaoke_data
+		AssFile subs;
+		WorkerProgressSink sink;
+		ProgressSink ps;
+		lua_State *L;
+		LuaAssFile *file;
+		std::unique_ptr<LuaProgressSink> lps;
+
+		Worker(lua_State *L, ProgressSink *parent)
+		: sink(parent)
+		, ps(&sink, nullptr)
+		, L(L)
+		, file(new LuaAssFile(L, &subs))
+		, lps(agi::make_unique<LuaProgressSink>(L, &ps, false))
+		{
+			// LuaAssFile leaves its userdata on the stack; keep it there so
+			// that it stays alive until the state is closed
+		}
+
+		~Worker() {
+			lps.reset();
+			file->Cancel();
+			lua_close(L);
+		}
+	};
+}
+
+namespace Automation4 {
+	int LuaParallelMap(lua_State *L, std::function<lua_State *()> const& create_worker)
+	{
+		std::string function = check_string(L, 1);
+		argcheck(L, !!lua_istable(L, 2), 2, "table expected");
+		argcheck(L, lua_isnoneornil(L, 3) || lua_istable(L, 3), 3, "table expected");
+
+		lua_getglobal(L, function.c_str());
+		if (!lua_isfunction(L, -1))
+			return error(L, "parallel_map: '%s' is not a global function", function.c_str());
+		lua_pop(L, 1);
+
+		// Copy everything out of the calling state up front, sharing one
+		// reader so that tables referenced from both the items and the
+		// shared table stay the same table in the workers
+		ValueReader reader(L);
+		size_t count = lua_objlen(L, 2);
+		std::vector<LuaValue> items;
+		items.reserve(count);
+		for (size_t i = 1; i <= count; ++i) {
+			lua_rawgeti(L, 2, i);
+			items.push_back(reader.Read(lua_gettop(L)));
+			lua_pop(L, 1);
+		}
+		LuaValue shared = reader.Read(3);
+
+		ProgressSink *ps = nullptr;
+		lua_getfield(L, LUA_REGISTRYINDEX, "progress_sink");
+		if (lua_isuserdata(L, -1))
+			ps = LuaProgressSink::GetObjPointer(L, -1);
+		lua_pop(L, 1);
+
+		std::vector<LuaValue> results(count);
+		std::vector<std::string> logs(count);
+		std::vector<char> finished(count, 0);
+
+		std::mutex lock;
+		std::condition_variable cv;
+		std::atomic<size_t> next{0};
+		std::atomic<bool> stop{false};
+		size_t completed = 0;
+		// Lowest-numbered item which failed, which is the one a serial run
+		// would have stopped at, or count if none did
+		size_t error_index = count;
+		bool error_has_message = false;
+		std::string error_message;
+		// Failures not caused by any particular item
+		std::string fatal_error;
+
+		size_t worker_count = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		size_t running = worker_count;
+
+		auto run_worker = [&] {
+			BOOST_SCOPE_EXIT_ALL(&) {
+				std::lock_guard<std::mutex> l(lock);
+				--running;
+				cv.notify_all();
+			};
+
+			try {
+				Worker worker(create_worker(), ps);
+				lua_State *W = worker.L;
+				ValueWriter writer(W);
+				writer.Push(shared);
+				int shared_idx = lua_gettop(W);
+
+				// Items are claimed in increasing order and every claimed item
+				// runs to completion, so after a failure every lower-numbered
+				// item still finishes and the reported error is deterministic
+				while (!stop && !worker.sink.IsCancelled()) {
+					size_t i = next++;
+					if (i >= count) break;
+
+					lua_pushcclosure(W, add_stack_trace, 0);
+					lua_getglobal(W, function.c_str());
+					writer.Push(items[i]);
+					lua_pushvalue(W, shared_idx);
+
+					LuaValue value;
+					bool failed = !!lua_pcall(W, 2, 1, -4);
+					bool has_message = true;
+					std::string message;
+					if (!failed) {
+						try {
+							value = ValueReader(W).Read(lua_gettop(W));
+						}
+						catch (agi::Exception const& e) {
+							failed = true;
+							message = e.GetMessage();
+						}
+					}
+					else if (lua_isnil(W, -1))
+						has_message = false; // aegisub.cancel()
+					else
+						message = get_string_or_default(W, -1);
+					lua_pop(W, 2);
+
+					std::lock_guard<std::mutex> l(lock);
+					results[i] = std::move(value);
+					logs[i] = std::move(worker.sink.log);
+					worker.sink.log.clear();
+					finished[i] = 1;
+					++completed;
+					if (failed) {
+						stop = true;
+						if (i < error_index) {
+							error_index = i;
+							error_has_message = has_message;
+							error_message = std::move(message);
+						}
+					}
+					cv.notify_all();
+				}
+			}
+			catch (agi::Exception const& e) {
+				stop = true;
+				std::lock_guard<std::mutex> l(lock);
+				if (fatal_error.empty())
+					fatal_error = e.GetMessage();
+			}
+		};
+
+		agi::dispatch::TaskGroup group;
+		for (size_t i = 0; i < worker_count; ++i)
+			group.Async(agi::dispatch::Background(agi::dispatch::Priority::High), run_worker);
+
+		{
+			size_t flushed = 0;
+			std::unique_lock<std::mutex> l(lock);
+			while (true) {
+				// Replay the workers' log output in the order a serial run
+				// would have produced it
+				for (; flushed < count && flushed <= error_index && finished[flushed]; ++flushed) {
+					if (ps && !logs[flushed].empty())
+						ps->Log(logs[flushed]);
+				}
+				if (ps && count)
+					ps->SetProgress(completed, count);
+				if (running == 0) break;
+				cv.wait(l);
+			}
+		}
+		group.Wait();
+
+		if (!fatal_error.empty())
+			return error(L, "parallel_map: %s", fatal_error.c_str());
+		if (error_index < count || completed < count) {
+			// Cancelled, either by the user or by the function
+			if (error_index == count || !error_has_message)
+				lua_pushnil(L);
+			else
+				push_value(L, error_message);
+			throw error_tag();
+		}
+
+		lua_createtable(L, count, 0);
+		ValueWriter writer(L);
+		for (size_t i = 0; i < count; ++i) {
+			writer.Push(results[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		return 1;
+	}
+}
@@ -41,6 +41,7 @@
 #include "grid_column.h"
 #include "options.h"
 #include "project.h"
+#include "quality_checker.h"
 #include "utils.h"
 #include "selection_controller.h"
 #include "subs_controller.h"
@@ -93,6 +94,7 @@ BaseGrid::BaseGrid(wxWindow* parent, agi::Context *context)
 
 		context->selectionController->AddActiveLineListener(&BaseGrid::OnActiveLineChanged, this),
 		context->selectionController->AddSelectionListener([&]{ Refresh(false); }),
+		context->qualityChecker->AddResultsListener([&]{ Refresh(false); }),
 
 		OPT_SUB("Subtitle/Grid/Font Face", &BaseGrid::UpdateStyle, this),
 		OPT_SUB("Subtitle/Grid/Font Size", &BaseGrid::UpdateStyle, this),
@@ -131,8 +133,12 @@ BEGIN_EVENT_TABLE(BaseGrid,wxWindow)
 END_EVENT_TABLE()
 
 void BaseGrid::OnSubtitlesCommit(int type) {
-	if (type == AssFile::COMMIT_NEW || type & AssFile::COMMIT_ORDER || type & AssFile::COMMIT_DIAG_ADDREM || type & AssFile::COMMIT_FOLD)
-		UpdateMaps();
+	// The row maps themselves are maintained by AssFile and FoldController
+	if (type == AssFile::COMMIT_NEW || type & AssFile::COMMIT_ORDER || type & AssFile::COMMIT_DIAG_ADDREM || type & AssFile::COMMIT_FOLD) {
+		SetColumnWidths();
+		AdjustScrollbar();
+		Refresh(false);
+	}
 
 	if (type & AssFile::COMMIT_DIAG_META || type & AssFile::COMMIT_DIAG_TIME) {
 		SetColumnWidths();
@@ -197,21 +203,6 @@ void BaseGrid::UpdateStyle() {
 	Refresh(false);
 }
 
-void BaseGrid::UpdateMaps() {
-	index_line_map.clear();
-	vis_index_line_map.clear();
-
-	for (auto& curdiag : context->ass->Events)
-		index_line_map.push_back(&curdiag);
-
-	for (AssDialogue *curdiag = &*context->ass->Events.begin(); curdiag != nullptr; curdiag = curdiag->Fold.getNextVisible())
-		vis_index_line_map.push_back(&*curdiag);
-
-	SetColumnWidths();
-	AdjustScrollbar();
-	Refresh(false);
-}
-
 void BaseGrid::OnActiveLineChanged(AssDialogue *new_active) {
 	if (new_active) {
 		if (new_active->Row != active_row)
@@ -237,9 +228,9 @@ void BaseGrid::MakeVisRowVisible(int row) {
 }
 
 void BaseGrid::SelectRow(int row, bool addToSelected, bool select) {
-	if (row < 0 || (size_t)row >= vis_index_line_map.size()) return;
+	if (row < 0 || row >= GetVisRows()) return;
 
-	AssDialogue *line = vis_index_line_map[row];
+	AssDialogue *line = GetVisDialogue(row);
 
 	if (!addToSelected) {
 		context->selectionController->SetSelectedSet(Selection{line});
@@ -263,7 +254,7 @@ void BaseGrid::OnSeek() {
 
 	auto it = begin(visible_rows);
 	for (int i : boost::irange(yPos, yPos + lines)) {
-		if (IsDisplayed(vis_index_line_map[i])) {
+		if (IsDisplayed(GetVisDialogue(i))) {
 			if (it == end(visible_rows) || *it != i) {
 				Refresh(false);
 				return;
@@ -360,7 +351,7 @@ void BaseGrid::OnPaint(wxPaintEvent &) {
 
 	for (int i : agi::util::range(nDraw)) {
 		wxBrush color = row_colors.Default;
-		AssDialogue *curDiag = vis_index_line_map[i + yPos];
+		AssDialogue *curDiag = GetVisDialogue(i + yPos);
 
 		bool inSel = !!selection.count(curDiag);
 		if (inSel && curDiag->Comment)
@@ -648,14 +639,22 @@ void BaseGrid::SetColumnWidths() {
 	width_helper->Age();
 }
 
+int BaseGrid::GetRows() const {
+	return context->ass->GetRowCount();
+}
+
+int BaseGrid::GetVisRows() const {
+	return context->foldController->GetVisibleLines().size();
+}
+
 AssDialogue *BaseGrid::GetDialogue(int n) const {
-	if (static_cast<size_t>(n) >= index_line_map.size()) return nullptr;
-	return index_line_map[n];
+	return context->ass->GetDialogueAtRow(n);
 }
 
 AssDialogue *BaseGrid::GetVisDialogue(int n) const {
-	if (static_cast<size_t>(n) >= vis_index_line_map.size()) return nullptr;
-	return vis_index_line_map[n];
+	auto const& lines = context->foldController->GetVisibleLines();
+	if (static_cast<size_t>(n) >= lines.size()) return nullptr;
+	return lines[n];
 }
 
 int BaseGrid::VisRowToRow(int n) const {
@@ -85,9 +85,6 @@ class BaseGrid final : public wxWindow {
 		wxBrush FoldClosed;
 	} row_colors;
 
-	std::vector<AssDialogue*> index_line_map;  ///< Row number -> dialogue line
-	std::vector<AssDialogue*> vis_index_line_map;  ///< Visible Row number -> dialogue line
-
 	/// Connection for video seek event. Stored explicitly so that it can be
 	/// blocked if the relevant option is disabled
 	agi::signal::Connection seek_listener;
@@ -113,13 +110,12 @@ class BaseGrid final : public wxWindow {
 
 	bool IsDisplayed(const AssDialogue *line) const;
 
-	void UpdateMaps();
 	void UpdateStyle();
 
 	void SelectRow(int row, bool addToSelected = false, bool select=true);
 
-	int GetRows() const { return index_line_map.size(); }
-	int GetVisRows() const { return vis_index_line_map.size(); }
+	int GetRows() const;
+	int GetVisRows() const;
 	void MakeRowVisible(int row);
 	void MakeVisRowVisible(int row);
 
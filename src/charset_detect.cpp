@@ -36,8 +36,8 @@
 
 #include "compat.h"
 
-#include <libaegisub/charset.h>
 #include <libaegisub/charset_conv.h>
+#include <libaegisub/sniff.h>
 
 #include <wx/arrstr.h>
 #include <wx/choicdlg.h>
@@ -46,7 +46,7 @@
 namespace CharSetDetect {
 
 std::string GetEncoding(agi::fs::path const& filename) {
-	auto encoding = agi::charset::Detect(filename);
+	auto encoding = agi::sniff::Sniff(filename).encoding;
 	if (!encoding.empty())
 		return encoding;
 
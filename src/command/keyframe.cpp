@@ -61,6 +61,22 @@ struct keyframe_close final : public Command {
 	}
 };
 
+struct keyframe_detect final : public Command {
+	CMD_NAME("keyframe/detect")
+	STR_MENU("Detect Scene Changes")
+	STR_DISP("Detect Scene Changes")
+	STR_HELP("Use scene changes found in the video as the keyframes")
+	CMD_TYPE(COMMAND_VALIDATE)
+
+	bool Validate(const agi::Context *c) override {
+		return !!c->project->VideoProvider();
+	}
+
+	void operator()(agi::Context *c) override {
+		c->project->DetectKeyframes();
+	}
+};
+
 struct keyframe_open final : public Command {
 	CMD_NAME("keyframe/open")
 	CMD_ICON(open_keyframes_menu)
@@ -107,6 +123,7 @@ struct keyframe_save final : public Command {
 namespace cmd {
 	void init_keyframe() {
 		reg(agi::make_unique<keyframe_close>());
+		reg(agi::make_unique<keyframe_detect>());
 		reg(agi::make_unique<keyframe_open>());
 		reg(agi::make_unique<keyframe_save>());
 	}
@@ -101,6 +101,17 @@ struct tool_line_select final : public Command {
 	}
 };
 
+struct tool_quality_check final : public Command {
+	CMD_NAME("tool/quality_check")
+	STR_MENU("&Quality Check...")
+	STR_DISP("Quality Check")
+	STR_HELP("List lines which are too fast, too long, overlap other lines or use missing styles")
+
+	void operator()(agi::Context *c) override {
+		ShowQualityCheckDialog(c);
+	}
+};
+
 struct tool_resampleres final : public Command {
 	CMD_NAME("tool/resampleres")
 	CMD_ICON(resample_toolbutton)
@@ -281,6 +292,7 @@ namespace cmd {
 		reg(agi::make_unique<tool_export>());
 		reg(agi::make_unique<tool_font_collector>());
 		reg(agi::make_unique<tool_line_select>());
+		reg(agi::make_unique<tool_quality_check>());
 		reg(agi::make_unique<tool_resampleres>());
 		reg(agi::make_unique<tool_style_assistant>());
 		reg(agi::make_unique<tool_styling_assistant_commit>());
@@ -24,6 +24,7 @@
 #include "initial_line_state.h"
 #include "options.h"
 #include "project.h"
+#include "quality_checker.h"
 #include "search_replace_engine.h"
 #include "selection_controller.h"
 #include "subs_controller.h"
@@ -46,6 +47,7 @@ Context::Context()
 , audioController(make_unique<AudioController>(this))
 , initialLineState(make_unique<InitialLineState>(this))
 , search(make_unique<SearchReplaceEngine>(this))
+, qualityChecker(make_unique<QualityChecker>(this))
 , path(make_unique<Path>(*config::path))
 , dialog(make_unique<DialogManager>())
 {
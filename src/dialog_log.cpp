@@ -31,13 +31,18 @@
 #include "dialog_manager.h"
 #include "format.h"
 #include "include/aegisub/context.h"
+#include "utils.h"
 
 #include <libaegisub/dispatch.h>
+#include <libaegisub/io.h>
 #include <libaegisub/log.h>
+#include <libaegisub/trace.h>
 
 #include <ctime>
 #include <wx/button.h>
+#include <wx/checkbox.h>
 #include <wx/dialog.h>
+#include <wx/msgdlg.h>
 #include <wx/sizer.h>
 #include <wx/stattext.h>
 #include <wx/textctrl.h>
@@ -90,6 +95,10 @@ public:
 
 class LogWindow : public wxDialog {
 	agi::log::Emitter *emit_log;
+	wxTextCtrl *text_ctrl;
+
+	void OnShowSummary(wxCommandEvent&);
+	void OnExportTrace(wxCommandEvent&);
 
 public:
 	LogWindow(agi::Context *c);
@@ -99,12 +108,28 @@ public:
 LogWindow::LogWindow(agi::Context *c)
 : wxDialog(c->parent, -1, _("Log window"), wxDefaultPosition, wxDefaultSize, wxCAPTION | wxCLOSE_BOX | wxRESIZE_BORDER)
 {
-	wxTextCtrl *text_ctrl = new wxTextCtrl(this, -1, "", wxDefaultPosition, wxSize(700,300), wxTE_MULTILINE|wxTE_READONLY);
+	text_ctrl = new wxTextCtrl(this, -1, "", wxDefaultPosition, wxSize(700,300), wxTE_MULTILINE|wxTE_READONLY);
 	text_ctrl->SetDefaultStyle(wxTextAttr(wxNullColour, wxNullColour, wxFont(8, wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL)));
 
+	auto trace_check = new wxCheckBox(this, -1, _("&Record performance trace"));
+	trace_check->SetValue(agi::trace::Enabled());
+	trace_check->Bind(wxEVT_CHECKBOX, [](wxCommandEvent& evt) { agi::trace::SetEnabled(!!evt.GetInt()); });
+
+	auto summary_button = new wxButton(this, -1, _("Trace &summary"));
+	summary_button->Bind(wxEVT_BUTTON, &LogWindow::OnShowSummary, this);
+	auto export_button = new wxButton(this, -1, _("&Export trace..."));
+	export_button->Bind(wxEVT_BUTTON, &LogWindow::OnExportTrace, this);
+
+	wxSizer *button_sizer = new wxBoxSizer(wxHORIZONTAL);
+	button_sizer->Add(trace_check, wxSizerFlags(0).Center().Border(wxRIGHT));
+	button_sizer->Add(summary_button, wxSizerFlags(0).Border(wxRIGHT));
+	button_sizer->Add(export_button, wxSizerFlags(0));
+	button_sizer->AddStretchSpacer(1);
+	button_sizer->Add(new wxButton(this, wxID_OK), wxSizerFlags(0));
+
 	wxSizer *sizer = new wxBoxSizer(wxVERTICAL);
 	sizer->Add(text_ctrl, wxSizerFlags(1).Expand().Border());
-	sizer->Add(new wxButton(this, wxID_OK), wxSizerFlags(0).Border().Right());
+	sizer->Add(button_sizer, wxSizerFlags(0).Expand().Border());
 	SetSizerAndFit(sizer);
 
 	agi::log::log->Subscribe(std::unique_ptr<agi::log::Emitter>(emit_log = new EmitLog(text_ctrl)));
@@ -113,6 +138,37 @@ LogWindow::LogWindow(agi::Context *c)
 LogWindow::~LogWindow() {
 	agi::log::log->Unsubscribe(emit_log);
 }
+
+void LogWindow::OnShowSummary(wxCommandEvent&) {
+	auto summary = agi::trace::Summarize();
+	if (summary.empty()) {
+		text_ctrl->AppendText(_("No trace events have been recorded.\n"));
+		return;
+	}
+
+	// The full list of signal slots and such can be very long, so only show
+	// the ones which took the most time
+	text_ctrl->AppendText(fmt_wx("%-10s %-50s %8s %12s %10s\n", "Category", "Name", "Count", "Total (ms)", "Max (ms)"));
+	for (size_t i = 0; i < summary.size() && i < 25; ++i) {
+		auto const& s = summary[i];
+		auto name = s.name.size() > 50 ? "..." + s.name.substr(s.name.size() - 47) : s.name;
+		text_ctrl->AppendText(fmt_wx("%-10s %-50s %8d %12.2f %10.2f\n",
+			s.category, name, s.count, s.total / 1000., s.max / 1000.));
+	}
+}
+
+void LogWindow::OnExportTrace(wxCommandEvent&) {
+	auto path = SaveFileSelector(_("Export trace"), "", "aegisub-trace.json", ".json",
+		"Chrome trace files (*.json)|*.json", this);
+	if (path.empty()) return;
+
+	try {
+		agi::trace::WriteChromeTrace(agi::io::Save(path).Get());
+	}
+	catch (agi::Exception const& e) {
+		wxMessageBox(to_wx(e.GetMessage()), _("Error exporting trace"), wxOK | wxICON_ERROR | wxCENTER, this);
+	}
+}
 }
 
 void ShowLogWindow(agi::Context *c) {
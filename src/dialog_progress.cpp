@@ -158,7 +158,7 @@ void DialogProgress::Run(std::function<void(agi::ProgressSink*)> task) {
 	this->ps = &ps;
 
 	auto current_title = from_wx(title->GetLabelText());
-	agi::dispatch::Background().Async([=]{
+	agi::dispatch::Background(agi::dispatch::Priority::High).Async([=]{
 		agi::osx::AppNapDisabler app_nap_disabler(current_title);
 		try {
 			task(this->ps);
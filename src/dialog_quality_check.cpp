@@ -0,0 +1,190 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file dialog_quality_check.cpp
+/// @brief List of lines with problems found by the quality checker
+/// @ingroup main_ui
+
+#include "ass_dialogue.h"
+#include "ass_file.h"
+#include "compat.h"
+#include "dialog_manager.h"
+#include "dialogs.h"
+#include "format.h"
+#include "include/aegisub/context.h"
+#include "quality_checker.h"
+#include "selection_controller.h"
+
+#include <libaegisub/signal.h>
+
+#include <unordered_map>
+#include <wx/button.h>
+#include <wx/choice.h>
+#include <wx/dialog.h>
+#include <wx/listctrl.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+
+namespace {
+using namespace agi::qc;
+
+wxString describe(int issues) {
+	wxString ret;
+	auto add = [&](int issue, wxString const& name) {
+		if (!(issues & issue)) return;
+		if (!ret.empty()) ret += ", ";
+		ret += name;
+	};
+	add(ISSUE_CPS, _("Too fast"));
+	add(ISSUE_OVERLAP, _("Overlap"));
+	add(ISSUE_LINE_LENGTH, _("Too long"));
+	add(ISSUE_MISSING_STYLE, _("Missing style"));
+	return ret;
+}
+
+/// Virtual list so that files with thousands of problems don't have to
+/// create a list item for each one
+class IssueList final : public wxListView {
+	agi::Context *c;
+
+	wxString OnGetItemText(long item, long column) const override {
+		if (static_cast<size_t>(item) >= lines.size()) return wxString();
+		auto line = lines[item];
+		auto diag = c->qualityChecker->Get(line);
+		switch (column) {
+			case 0: return std::to_wstring(line->Row + 1);
+			case 1: return to_wx(line->Start.GetAssFormatted());
+			case 2: return describe(diag.issues);
+			case 3: return diag.cps < 0 ? wxString() : wxString(std::to_wstring(diag.cps));
+			case 4: return std::to_wstring(diag.line_length);
+			case 5: return to_wx(line->Text);
+		}
+		return wxString();
+	}
+
+public:
+	std::vector<AssDialogue *> lines;
+
+	IssueList(wxWindow *parent, agi::Context *c)
+	: wxListView(parent, -1, wxDefaultPosition, wxSize(700, 250), wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL)
+	, c(c)
+	{
+		InsertColumn(0, _("#"), wxLIST_FORMAT_RIGHT, 50);
+		InsertColumn(1, _("Start"), wxLIST_FORMAT_LEFT, 80);
+		InsertColumn(2, _("Issues"), wxLIST_FORMAT_LEFT, 150);
+		InsertColumn(3, _("CPS"), wxLIST_FORMAT_RIGHT, 45);
+		InsertColumn(4, _("Length"), wxLIST_FORMAT_RIGHT, 55);
+		InsertColumn(5, _("Text"), wxLIST_FORMAT_LEFT, 300);
+	}
+};
+
+class DialogQualityCheck final : public wxDialog {
+	agi::Context *c;
+	IssueList *list;
+	wxChoice *filter;
+	wxStaticText *summary;
+	std::vector<agi::signal::Connection> connections;
+
+	/// Issue mask for each entry in the filter
+	std::vector<int> filter_masks;
+
+	void Rebuild();
+	void OnActivate(wxListEvent& evt);
+
+public:
+	DialogQualityCheck(agi::Context *c);
+};
+
+DialogQualityCheck::DialogQualityCheck(agi::Context *c)
+: wxDialog(c->parent, -1, _("Quality Check"), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER)
+, c(c)
+, list(new IssueList(this, c))
+{
+	wxArrayString filters;
+	filters.Add(_("All issues")); filter_masks.push_back(~0);
+	filters.Add(_("Too many characters per second")); filter_masks.push_back(ISSUE_CPS);
+	filters.Add(_("Overlapping lines")); filter_masks.push_back(ISSUE_OVERLAP);
+	filters.Add(_("Lines too long")); filter_masks.push_back(ISSUE_LINE_LENGTH);
+	filters.Add(_("Missing styles")); filter_masks.push_back(ISSUE_MISSING_STYLE);
+	filter = new wxChoice(this, -1, wxDefaultPosition, wxDefaultSize, filters);
+	filter->SetSelection(0);
+	filter->Bind(wxEVT_CHOICE, [=](wxCommandEvent&) { Rebuild(); });
+
+	summary = new wxStaticText(this, -1, "");
+	list->Bind(wxEVT_LIST_ITEM_ACTIVATED, &DialogQualityCheck::OnActivate, this);
+	list->Bind(wxEVT_LIST_ITEM_SELECTED, &DialogQualityCheck::OnActivate, this);
+
+	auto top_sizer = new wxBoxSizer(wxHORIZONTAL);
+	top_sizer->Add(new wxStaticText(this, -1, _("Show:")), wxSizerFlags().Center().Border(wxRIGHT));
+	top_sizer->Add(filter, wxSizerFlags());
+	top_sizer->AddStretchSpacer(1);
+	top_sizer->Add(summary, wxSizerFlags().Center());
+
+	auto button_sizer = new wxStdDialogButtonSizer;
+	button_sizer->AddButton(new wxButton(this, wxID_CANCEL, _("&Close")));
+	button_sizer->Realize();
+
+	auto main_sizer = new wxBoxSizer(wxVERTICAL);
+	main_sizer->Add(top_sizer, wxSizerFlags().Expand().Border());
+	main_sizer->Add(list, wxSizerFlags(1).Expand().Border(wxLEFT | wxRIGHT));
+	main_sizer->Add(button_sizer, wxSizerFlags().Expand().Border());
+	SetSizerAndFit(main_sizer);
+	CenterOnParent();
+
+	connections = agi::signal::make_vector({
+		c->qualityChecker->AddResultsListener(&DialogQualityCheck::Rebuild, this),
+		// Lines in the list may have just been deleted, so this can't wait
+		// for the checker to catch up
+		c->ass->AddCommitListener(&DialogQualityCheck::Rebuild, this),
+	});
+
+	Rebuild();
+}
+
+void DialogQualityCheck::Rebuild() {
+	std::unordered_map<int, AssDialogue *> by_id;
+	by_id.reserve(c->ass->Events.size());
+	for (auto& line : c->ass->Events)
+		by_id[line.Id] = &line;
+
+	int mask = filter_masks[filter->GetSelection()];
+	auto const& ids = c->qualityChecker->LinesWithIssues();
+
+	list->lines.clear();
+	for (int id : ids) {
+		auto it = by_id.find(id);
+		if (it != by_id.end() && c->qualityChecker->Get(it->second).issues & mask)
+			list->lines.push_back(it->second);
+	}
+
+	list->SetItemCount(list->lines.size());
+	list->Refresh();
+	summary->SetLabel(fmt_plural(list->lines.size(), "One line", "%u lines", list->lines.size()));
+	Layout();
+}
+
+void DialogQualityCheck::OnActivate(wxListEvent& evt) {
+	auto item = evt.GetIndex();
+	if (item < 0 || static_cast<size_t>(item) >= list->lines.size()) return;
+	auto line = list->lines[item];
+	c->selectionController->SetSelectionAndActive({line}, line);
+}
+}
+
+void ShowQualityCheckDialog(agi::Context *c) {
+	c->dialog->Show<DialogQualityCheck>(c);
+}
@@ -15,6 +15,7 @@
 // Aegisub Project http://www.aegisub.org/
 
 #include "ass_dialogue.h"
+#include "ass_event_columns.h"
 #include "ass_file.h"
 #include "compat.h"
 #include "dialog_manager.h"
@@ -29,9 +30,11 @@
 #include "timeedit_ctrl.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/io.h>
 #include <libaegisub/log.h>
+#include <libaegisub/persist.h>
 #include <libaegisub/path.h>
 #include <libaegisub/signal.h>
 #include <libaegisub/vfr.h>
@@ -41,6 +44,7 @@
 #include <libaegisub/cajun/writer.h>
 
 #include <boost/filesystem/path.hpp>
+#include <sstream>
 #include <wx/dialog.h>
 #include <wx/listbox.h>
 #include <wx/radiobox.h>
@@ -324,12 +328,9 @@ void DialogShiftTimes::SaveHistory(json::Array shifted_blocks) {
 	if (history.size() > 50)
 		history.resize(50);
 
-	try {
-		agi::JsonWriter::Write(history, agi::io::Save(history_filename).Get());
-	}
-	catch (agi::fs::FileSystemError const& e) {
-		LOG_E("dialog_shift_times/save_history") << "Cannot save shift times history: " << e.GetMessage();
-	}
+	std::ostringstream out;
+	agi::JsonWriter::Write(history, out);
+	agi::persist::Write(history_filename, out.str());
 }
 
 void DialogShiftTimes::LoadHistory() {
@@ -386,6 +387,7 @@ void DialogShiftTimes::Process(wxCommandEvent &) {
 	// Track which rows were shifted for the log
 	int block_start = 0;
 	json::Array shifted_blocks;
+	std::vector<AssDialogue *> lines;
 
 	for (auto& line : context->ass->Events) {
 		if (!sel.count(&line)) {
@@ -402,12 +404,22 @@ void DialogShiftTimes::Process(wxCommandEvent &) {
 		else if (!block_start)
 			block_start = line.Row + 1;
 
-		if (start)
-			line.Start = Shift(line.Start, shift, by_time, agi::vfr::START);
-		if (end)
-			line.End = Shift(line.End, shift, by_time, agi::vfr::END);
+		lines.push_back(&line);
 	}
 
+	// Converting times to frames and back is slow enough to be worth
+	// spreading over threads for big files
+	AssEventColumns columns(std::move(lines), COLUMN_TIMES);
+	agi::dispatch::ParallelFor(columns.size(), 256, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			if (start)
+				columns.start[i] = Shift(columns.start[i], shift, by_time, agi::vfr::START);
+			if (end)
+				columns.end[i] = Shift(columns.end[i], shift, by_time, agi::vfr::END);
+		}
+	});
+	columns.StoreTimes();
+
 	context->ass->Commit(_("shifting"), AssFile::COMMIT_DIAG_TIME);
 
 	if (block_start) {
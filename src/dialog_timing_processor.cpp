@@ -30,6 +30,7 @@
 #include "ass_dialogue.h"
 #include "ass_file.h"
 #include "async_video_provider.h"
+#include "audio_controller.h"
 #include "compat.h"
 #include "format.h"
 #include "help_button.h"
@@ -42,6 +43,8 @@
 
 #include <libaegisub/address_of_adaptor.h>
 #include <libaegisub/ass/time.h>
+#include <libaegisub/audio/envelope.h>
+#include <libaegisub/timing_processor.h>
 
 #include <algorithm>
 #include <boost/range/adaptor/filtered.hpp>
@@ -78,12 +81,14 @@ struct DialogTimingProcessor {
 	int afterEnd;    ///< Maximum time in milliseconds to move end time of line forwards to land on a keyframe
 	int adjGap;      ///< Maximum gap in milliseconds to snap adjacent lines to each other
 	int adjOverlap;  ///< Maximum overlap in milliseconds to snap adjacent lines to each other
+	int speechDist;  ///< Maximum distance in milliseconds to move start and end times to land on a detected start or end of speech
 
 	wxCheckBox *onlySelection; ///< Only process selected lines of the selected styles
 	wxCheckBox *hasLeadIn;     ///< Enable adding lead-in
 	wxCheckBox *hasLeadOut;    ///< Enable adding lead-out
 	wxCheckBox *keysEnable;    ///< Enable snapping to keyframes
 	wxCheckBox *adjsEnable;    ///< Enable snapping adjacent lines to each other
+	wxCheckBox *speechEnable;  ///< Enable snapping to starts and ends of speech
 	wxSlider *adjacentBias;    ///< Bias between shifting start and end times when snapping adjacent lines
 	wxCheckListBox *StyleList; ///< List of styles to process
 	wxButton *ApplyButton;     ///< Button to apply the processing
@@ -152,6 +157,7 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	afterEnd = OPT_GET("Tool/Timing Post Processor/Threshold/Key End After")->GetInt();
 	adjGap = OPT_GET("Tool/Timing Post Processor/Threshold/Adjacent Gap")->GetInt();
 	adjOverlap = OPT_GET("Tool/Timing Post Processor/Threshold/Adjacent Overlap")->GetInt();
+	speechDist = OPT_GET("Tool/Timing Post Processor/Threshold/Speech")->GetInt();
 
 	// Styles box
 	auto LeftSizer = new wxStaticBoxSizer(wxVERTICAL,&d,_("Apply to styles"));
@@ -243,6 +249,22 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	KeyframesSizer->Add(KeyframesFlexSizer,0,wxEXPAND);
 	KeyframesSizer->AddStretchSpacer(1);
 
+	// Speech sizer
+	auto SpeechSizer = new wxStaticBoxSizer(wxHORIZONTAL, &d, _("Speech snapping"));
+	speechEnable = make_check(SpeechSizer, _("Ena&ble"),
+		"Tool/Timing Post Processor/Enable/Speech",
+		_("Enable snapping of start times to the nearest detected start of speech and end times to the nearest detected end of speech, if distance is within threshold"));
+	make_ctrl(SpeechSizer, _("Max distance:"), &speechDist, speechEnable,
+		_("Maximum distance to move a start or end time to snap it to speech, in milliseconds"));
+	SpeechSizer->AddStretchSpacer(1);
+
+	// Speech detection runs in the background after audio is opened, so it
+	// may not be available yet
+	if (!c->audioController->GetEnergyEnvelope()) {
+		speechEnable->SetValue(false);
+		speechEnable->Enable(false);
+	}
+
 	// Button sizer
 	auto ButtonSizer = d.CreateStdDialogButtonSizer(wxOK | wxCANCEL | wxHELP);
 	ApplyButton = ButtonSizer->GetAffirmativeButton();
@@ -254,6 +276,7 @@ DialogTimingProcessor::DialogTimingProcessor(agi::Context *c)
 	RightSizer->Add(LeadSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->Add(AdjacentSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->Add(KeyframesSizer,0,wxBOTTOM|wxEXPAND,5);
+	RightSizer->Add(SpeechSizer,0,wxBOTTOM|wxEXPAND,5);
 	RightSizer->AddStretchSpacer(1);
 	RightSizer->Add(ButtonSizer,0,wxLEFT|wxRIGHT|wxBOTTOM|wxEXPAND,0);
 
@@ -299,7 +322,7 @@ void DialogTimingProcessor::UpdateControls() {
 	size_t len = StyleList->GetCount();
 	for (size_t i = 0; !any_checked && i < len; ++i)
 		any_checked = StyleList->IsChecked(i);
-	ApplyButton->Enable(any_checked && (hasLeadIn->IsChecked() || hasLeadOut->IsChecked() || keysEnable->IsChecked() || adjsEnable->IsChecked()));
+	ApplyButton->Enable(any_checked && (hasLeadIn->IsChecked() || hasLeadOut->IsChecked() || keysEnable->IsChecked() || adjsEnable->IsChecked() || speechEnable->IsChecked()));
 }
 
 void DialogTimingProcessor::OnApply(wxCommandEvent &) {
@@ -313,11 +336,13 @@ void DialogTimingProcessor::OnApply(wxCommandEvent &) {
 	OPT_SET("Tool/Timing Post Processor/Threshold/Key End After")->SetInt(afterEnd);
 	OPT_SET("Tool/Timing Post Processor/Threshold/Adjacent Gap")->SetInt(adjGap);
 	OPT_SET("Tool/Timing Post Processor/Threshold/Adjacent Overlap")->SetInt(adjOverlap);
+	OPT_SET("Tool/Timing Post Processor/Threshold/Speech")->SetInt(speechDist);
 	OPT_SET("Tool/Timing Post Processor/Adjacent Bias")->SetDouble(adjacentBias->GetValue() / 100.0);
 	OPT_SET("Tool/Timing Post Processor/Enable/Lead/IN")->SetBool(hasLeadIn->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Enable/Lead/OUT")->SetBool(hasLeadOut->IsChecked());
 	if (keysEnable->IsEnabled()) OPT_SET("Tool/Timing Post Processor/Enable/Keyframe")->SetBool(keysEnable->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Enable/Adjacent")->SetBool(adjsEnable->IsChecked());
+	if (speechEnable->IsEnabled()) OPT_SET("Tool/Timing Post Processor/Enable/Speech")->SetBool(speechEnable->IsChecked());
 	OPT_SET("Tool/Timing Post Processor/Only Selection")->SetBool(onlySelection->IsChecked());
 
 	Process();
@@ -325,10 +350,10 @@ void DialogTimingProcessor::OnApply(wxCommandEvent &) {
 }
 
 std::vector<AssDialogue*> DialogTimingProcessor::SortDialogues() {
-	std::set<boost::flyweight<std::string>> styles;
+	std::set<agi::flyweight<std::string>> styles;
 	for (size_t i = 0; i < StyleList->GetCount(); ++i) {
 		if (StyleList->IsChecked(i))
-			styles.insert(boost::flyweight<std::string>(from_wx(StyleList->GetString(i))));
+			styles.insert(agi::flyweight<std::string>(from_wx(StyleList->GetString(i))));
 	}
 
 	std::vector<AssDialogue*> sorted;
@@ -360,86 +385,48 @@ std::vector<AssDialogue*> DialogTimingProcessor::SortDialogues() {
 	return sorted;
 }
 
-static int get_closest_kf(std::vector<int> const& kf, int frame) {
-	const auto pos = boost::upper_bound(kf, frame);
-	// Return last keyframe if this is after the last one
-	if (pos == end(kf)) return kf.back();
-	// *pos is greater than frame, and *(pos - 1) is less than or equal to frame
-	return (pos == begin(kf) || *pos - frame < frame - *(pos - 1)) ? *pos : *(pos - 1);
-}
-
-template<class Iter, class Field>
-static int safe_time(Iter begin, Iter end, AssDialogue *comp, int initial, Field field, int const& (*cmp)(int const&, int const&)) {
-	// Compare to every previous line (yay for O(n^2)!) to see if it's OK to add lead-in
-	for (; begin != end; ++begin) {
-		// If the line doesn't already collide with this line, extend it only
-		// to the edge of the line
-		if (!comp->CollidesWith(*begin))
-			initial = cmp(initial, (*begin)->*field);
-	}
-	return initial;
-}
-
 void DialogTimingProcessor::Process() {
 	std::vector<AssDialogue*> sorted = SortDialogues();
 	if (sorted.empty()) return;
 
-	// Add lead-in/out
-	if (hasLeadIn->IsChecked() && leadIn) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->Start = safe_time(sorted.rend() - i, sorted.rend(),
-				sorted[i], sorted[i]->Start - leadIn,
-				&AssDialogue::End, &std::max<int>);
-	}
-
-	if (hasLeadOut->IsChecked() && leadOut) {
-		for (size_t i = 0; i < sorted.size(); ++i)
-			sorted[i]->End = safe_time(sorted.begin() + i + 1, sorted.end(),
-				sorted[i], sorted[i]->End + leadOut,
-				&AssDialogue::Start, &std::min<int>);
+	agi::timing::Settings settings;
+	if (hasLeadIn->IsChecked())
+		settings.lead_in = leadIn;
+	if (hasLeadOut->IsChecked())
+		settings.lead_out = leadOut;
+	settings.adjacent = adjsEnable->IsChecked();
+	settings.adjacent_gap = adjGap;
+	settings.adjacent_overlap = adjOverlap;
+	settings.adjacent_bias = adjacentBias->GetValue() / 100.0;
+	settings.keyframes = keysEnable->IsChecked();
+	settings.keyframe_before_start = beforeStart;
+	settings.keyframe_after_start = afterStart;
+	settings.keyframe_before_end = beforeEnd;
+	settings.keyframe_after_end = afterEnd;
+	settings.speech = speechEnable->IsChecked();
+	settings.speech_distance = speechDist;
+
+	std::vector<int> kf;
+	if (settings.keyframes) {
+		kf = c->project->Keyframes();
+		if (auto provider = c->project->VideoProvider()) {
+			int last_frame = provider->GetFrameCount() - 1;
+			if (kf.empty() || kf.back() < last_frame)
+				kf.push_back(last_frame);
+		}
 	}
+	auto envelope = c->audioController->GetEnergyEnvelope();
 
-	// Make adjacent
-	if (adjsEnable->IsChecked()) {
-		double bias = adjacentBias->GetValue() / 100.0;
+	std::vector<agi::timing::Line> lines;
+	lines.reserve(sorted.size());
+	for (auto line : sorted)
+		lines.push_back({line->Start, line->End});
 
-		for (size_t i = 1; i < sorted.size(); ++i) {
-			AssDialogue *prev = sorted[i - 1];
-			AssDialogue *cur = sorted[i];
+	agi::timing::Process(lines, settings, kf, c->project->Timecodes(), envelope.get());
 
-			int dist = cur->Start - prev->End;
-			if ((dist < 0 && -dist <= adjOverlap) || (dist > 0 && dist <= adjGap)) {
-				int setPos = prev->End + int(dist * bias);
-				cur->Start = setPos;
-				prev->End = setPos;
-			}
-		}
-	}
-
-	// Keyframe snapping
-	if (keysEnable->IsChecked()) {
-		std::vector<int> kf = c->project->Keyframes();
-		auto fps = c->project->Timecodes();
-		if (auto provider = c->project->VideoProvider())
-			kf.push_back(provider->GetFrameCount() - 1);
-
-		for (AssDialogue *cur : sorted) {
-			// Get start/end frames
-			int startF = fps.FrameAtTime(cur->Start, agi::vfr::START);
-			int endF = fps.FrameAtTime(cur->End, agi::vfr::END);
-
-			// Get closest for start
-			int closest = get_closest_kf(kf, startF);
-			int time = fps.TimeAtFrame(closest, agi::vfr::START);
-			if ((closest > startF && time - cur->Start <= beforeStart) || (closest < startF && cur->Start - time <= afterStart))
-				cur->Start = time;
-
-			// Get closest for end
-			closest = get_closest_kf(kf, endF) - 1;
-			time = fps.TimeAtFrame(closest, agi::vfr::END);
-			if ((closest > endF && time - cur->End <= beforeEnd) || (closest < endF && cur->End - time <= afterEnd))
-				cur->End = time;
-		}
+	for (size_t i = 0; i < sorted.size(); ++i) {
+		sorted[i]->Start = lines[i].start;
+		sorted[i]->End = lines[i].end;
 	}
 
 	c->ass->Commit(_("timing processor"), AssFile::COMMIT_DIAG_TIME);
@@ -63,6 +63,11 @@ void ShowVideoDetailsDialog(agi::Context *c) {
 		framecount, agi::Time(fps.TimeAtFrame(framecount - 1)).GetAssFormatted(true)));
 	make_field(_("Decoder:"), to_wx(provider->GetDecoderName()));
 
+	auto stats = provider->GetPlaybackStats();
+	make_field(_("Frames played:"), std::to_wstring(stats.presented));
+	make_field(_("Late frames:"), std::to_wstring(stats.late));
+	make_field(_("Dropped frames:"), std::to_wstring(stats.dropped));
+
 	auto video_sizer = new wxStaticBoxSizer(wxVERTICAL, &d, _("Video"));
 	video_sizer->Add(fg);
 
@@ -37,9 +37,12 @@
 #include "include/aegisub/context.h"
 #include "project.h"
 
+#include <libaegisub/ass/transform.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/of_type_adaptor.h>
 
 #include <utility>
+#include <vector>
 #include <wx/button.h>
 #include <wx/checkbox.h>
 #include <wx/panel.h>
@@ -147,78 +150,55 @@ void AssTransformFramerateFilter::LoadSettings(bool is_default, agi::Context *c)
 	}
 }
 
-/// Truncate a time to centisecond precision
-static int trunc_cs(int time) {
-	return (time / 10) * 10;
-}
-
-void AssTransformFramerateFilter::TransformTimeTags(std::string const& name, AssOverrideParameter *curParam, void *curData) {
+/// Transform a single tag of a line
+static void transform_time_tags(std::string const& name, AssOverrideParameter *curParam, void *curData) {
 	VariableDataType type = curParam->GetType();
 	if (type != VariableDataType::INT && type != VariableDataType::FLOAT) return;
 
-	AssTransformFramerateFilter *instance = static_cast<AssTransformFramerateFilter*>(curData);
-	AssDialogue *curDiag = instance->line;
-
+	auto state = static_cast<agi::ass::FramerateTransform::Line*>(curData);
 	int parVal = curParam->Get<int>();
 
 	switch (curParam->classification) {
-		case AssParameterClass::RELATIVE_TIME_START: {
-			int value = instance->ConvertTime(trunc_cs(curDiag->Start) + parVal) - instance->newStart;
-
-			// An end time of 0 is actually the end time of the line, so ensure
-			// nonzero is never converted to 0
-			// Needed here rather than the end case because start/end here mean
-			// which end of the line the time is relative to, not whether it's
-			// the start or end time (compare \move and \fad)
-			if (value == 0 && parVal != 0) value = 1;
-			curParam->Set(value);
+		case AssParameterClass::RELATIVE_TIME_START:
+			curParam->Set(state->RelativeToStart(parVal));
 			break;
-		}
 		case AssParameterClass::RELATIVE_TIME_END:
-			curParam->Set(instance->newEnd - instance->ConvertTime(trunc_cs(curDiag->End) - parVal));
+			curParam->Set(state->RelativeToEnd(parVal));
 			break;
-		case AssParameterClass::KARAOKE: {
-			int start = curDiag->Start / 10 + instance->oldK + parVal;
-			int value = (instance->ConvertTime(start * 10) - instance->newStart) / 10 - instance->newK;
-			instance->oldK += parVal;
-			instance->newK += value;
-			curParam->Set(value);
+		case AssParameterClass::KARAOKE:
+			curParam->Set(state->Karaoke(parVal));
 			break;
-		}
 		default:
 			return;
 	}
 }
 
-void AssTransformFramerateFilter::TransformFrameRate(AssFile *subs) {
-	if (!Input.IsLoaded() || !Output.IsLoaded()) return;
-	for (auto& curDialogue : subs->Events) {
-		line = &curDialogue;
-		newK = 0;
-		oldK = 0;
-		newStart = trunc_cs(ConvertTime(curDialogue.Start));
-		newEnd = trunc_cs(ConvertTime(curDialogue.End) + 9);
-
-		// Process stuff
+static void transform_line(agi::ass::FramerateTransform const& transform, AssDialogue *line) {
+	agi::ass::FramerateTransform::Line state(transform, line->Start, line->End);
+
+	// Process stuff
+	if (line->GetParsedTags()->HasOverrides()) {
 		auto blocks = line->ParseTags();
 		for (auto block : blocks | agi::of_type<AssDialogueBlockOverride>())
-			block->ProcessParameters(TransformTimeTags, this);
-		curDialogue.Start = newStart;
-		curDialogue.End = newEnd;
-		curDialogue.UpdateText(blocks);
+			block->ProcessParameters(transform_time_tags, &state);
+		line->UpdateText(blocks);
 	}
+	line->Start = state.Start();
+	line->End = state.End();
 }
 
-int AssTransformFramerateFilter::ConvertTime(int time) {
-	int frame = Output.FrameAtTime(time);
-	int frameStart = Output.TimeAtFrame(frame);
-	int frameEnd = Output.TimeAtFrame(frame + 1);
-	int frameDur = frameEnd - frameStart;
-	double dist = double(time - frameStart) / frameDur;
-
-	int newStart = Input.TimeAtFrame(frame);
-	int newEnd = Input.TimeAtFrame(frame + 1);
-	int newDur = newEnd - newStart;
+void AssTransformFramerateFilter::TransformFrameRate(AssFile *subs) {
+	if (!Input.IsLoaded() || !Output.IsLoaded()) return;
 
-	return newStart + newDur * dist;
+	// Output is the frame rate the times are currently in; see the comment
+	// on the members
+	agi::ass::FramerateTransform transform(Output, Input);
+
+	std::vector<AssDialogue *> lines;
+	for (auto& line : subs->Events)
+		lines.push_back(&line);
+	agi::dispatch::ParallelFor(lines.size(), 256, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			transform_line(transform, lines[i]);
+	});
 }
@@ -31,8 +31,6 @@
 
 #include <libaegisub/vfr.h>
 
-class AssDialogue;
-class AssOverrideParameter;
 class wxCheckBox;
 class wxRadioButton;
 class wxTextCtrl;
@@ -41,11 +39,6 @@ class wxTextCtrl;
 /// @brief Transform subtitle times, including those in override tags, from an input framerate to an output framerate
 class AssTransformFramerateFilter final : public AssExportFilter {
 	agi::Context *c = nullptr;
-	AssDialogue *line = nullptr;
-	int newStart = 0;
-	int newEnd = 0;
-	int newK = 0;
-	int oldK = 0;
 
 	// Yes, these are backwards. It sort of makes sense if you think about what it's doing.
 	agi::vfr::Framerate Input;  ///< Destination frame rate
@@ -62,21 +55,6 @@ class AssTransformFramerateFilter final : public AssExportFilter {
 	/// @brief Apply the transformation to a file
 	/// @param subs File to process
 	void TransformFrameRate(AssFile *subs);
-	/// @brief Transform a single tag
-	/// @param name Name of the tag
-	/// @param curParam Current parameter being processed
-	/// @param userdata Filter instance
-	static void TransformTimeTags(std::string const& name, AssOverrideParameter *curParam, void *userdata);
-
-	/// @brief Convert a time from the input frame rate to the output frame rate
-	/// @param time Time in ms to convert
-	/// @return Time in ms
-	///
-	/// This preserves two things:
-	///   1. The frame number
-	///   2. The relative distance between the beginning of the frame which time
-	///      is in and the beginning of the next frame
-	int ConvertTime(int time);
 public:
 	AssTransformFramerateFilter();
 	void ProcessSubs(AssFile *subs, wxWindow *) override;
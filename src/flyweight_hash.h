@@ -16,12 +16,12 @@
 
 #pragma once
 
-#include <boost/flyweight.hpp>
+#include <libaegisub/flyweight.h>
 
 namespace std {
 	template <typename T>
-	struct hash<boost::flyweight<T>> {
-		size_t operator()(boost::flyweight<T> const& ss) const {
+	struct hash<agi::flyweight<T>> {
+		size_t operator()(agi::flyweight<T> const& ss) const {
 			return hash<const void*>()(&ss.get());
 		}
 	};
@@ -40,9 +40,10 @@ bool FoldController::CanAddFold(AssDialogue& start, AssDialogue& end) {
 		return false;
 	}
 	int folddepth = 0;
-	for (auto it = std::next(context->ass->Events.begin(), start.Row); it->Row < end.Row; it++) {
-		if (it->Fold.valid) {
-			folddepth += it->Fold.side ? -1 : 1;
+	for (int row = start.Row; row < end.Row; row++) {
+		AssDialogue *line = context->ass->GetDialogueAtRow(row);
+		if (line->Fold.valid) {
+			folddepth += line->Fold.side ? -1 : 1;
 		}
 		if (folddepth < 0) {
 			return false;
@@ -251,6 +252,7 @@ void FoldController::LinkFolds() {
 	AssDialogue *lastVisible = nullptr;
 
 	maxdepth = 0;
+	visible_lines.clear();
 
 	int visibleRow = 0;
 	int highestFolded = 1;
@@ -265,6 +267,7 @@ void FoldController::LinkFolds() {
 				lastVisible->Fold.nextVisible = &*line;
 			}
 			lastVisible = &*line;
+			visible_lines.push_back(&*line);
 			visibleRow++;
 		}
 		if (line->Fold.valid && !line->Fold.side) {
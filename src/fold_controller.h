@@ -99,6 +99,9 @@ class FoldController {
 	int maxdepth = 0;
 	int max_fold_id = 0;
 
+	/// Visible row number -> dialogue line
+	std::vector<AssDialogue *> visible_lines;
+
 	bool CanAddFold(AssDialogue& start, AssDialogue& end);
 
 	void RawAddFold(AssDialogue& start, AssDialogue& end, bool collapsed);
@@ -127,7 +130,8 @@ class FoldController {
 	/// Cleans up extradata entries if they've been invalid for long enough.
 	void FixFolds();
 
-	/// Once the fold base data is valid, sets up all the cached links in the FoldData.
+	/// Once the fold base data is valid, sets up all the cached links in the FoldData
+	/// and the visible row map.
 	void LinkFolds();
 
 public:
@@ -135,6 +139,11 @@ public:
 
 	int GetMaxDepth();
 
+	/// @brief Get the lines which are not hidden by folds, indexed by visible row
+	///
+	/// Only valid directly after a commit.
+	std::vector<AssDialogue *> const& GetVisibleLines() const { return visible_lines; }
+
 	// All of the following functions are only valid directly after a commit.
 	// Their behaviour is undefined as soon as any uncommitted change is made to the Events.
 
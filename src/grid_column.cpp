@@ -21,6 +21,7 @@
 #include "compat.h"
 #include "include/aegisub/context.h"
 #include "options.h"
+#include "quality_checker.h"
 #include "video_controller.h"
 #include "fold_controller.h"
 
@@ -38,7 +39,7 @@ void WidthHelper::Age() {
 	++age;
 }
 
-int WidthHelper::operator()(boost::flyweight<std::string> const& str) {
+int WidthHelper::operator()(agi::flyweight<std::string> const& str) {
 	if (str.get().empty()) return 0;
 	auto it = widths.find(str);
 	if (it != end(widths)) {
@@ -103,6 +104,8 @@ namespace {
 	public: wxString const& Description() const override { return description; }
 
 struct GridColumnLineNumber final : GridColumn {
+	const agi::OptionValue *issue_color = OPT_GET("Colour/Subtitle Grid/CPS Error");
+
 	COLUMN_HEADER(_("#"))
 	COLUMN_DESCRIPTION(_("Line Number"))
 	bool Centered() const override { return true; }
@@ -111,6 +114,16 @@ struct GridColumnLineNumber final : GridColumn {
 		return std::to_wstring(d->Row + 1);
 	}
 
+	void Paint(wxDC &dc, int x, int y, const AssDialogue *d, const agi::Context *c) const override {
+		// Mark lines which the quality checker found problems with
+		if (c->qualityChecker->Get(d).issues) {
+			dc.SetBrush(wxBrush(to_wx(issue_color->GetColor())));
+			dc.SetPen(*wxTRANSPARENT_PEN);
+			dc.DrawRectangle(x, y + 1, 3, dc.GetCharHeight() + 3);
+		}
+		GridColumn::Paint(dc, x, y, d, c);
+	}
+
 	int Width(const agi::Context *c, WidthHelper &helper) const override {
 		return helper(Value(&c->ass->Events.back()));
 	}
@@ -346,6 +359,12 @@ class GridColumnCPS final : public GridColumn {
 	const agi::OptionValue *cps_error = OPT_GET("Subtitle/Character Counter/CPS Error Threshold");
 	const agi::OptionValue *bg_color = OPT_GET("Colour/Subtitle Grid/CPS Error");
 
+	/// Character counts of line texts, as every visible row is counted on
+	/// every paint and most of them haven't changed since the last one
+	mutable std::unordered_map<agi::flyweight<std::string>, size_t> counts;
+	/// Ignore mask which counts were computed with
+	mutable int counts_ignore = -1;
+
 public:
 	COLUMN_HEADER(_("CPS"))
 	COLUMN_DESCRIPTION(_("Characters Per Second"))
@@ -369,7 +388,20 @@ public:
 		if (ignore_punctuation->GetBool())
 			ignore |= agi::IGNORE_PUNCTUATION;
 
-		return agi::CharacterCount(text, ignore) * 1000 / duration;
+		if (ignore != counts_ignore) {
+			counts.clear();
+			counts_ignore = ignore;
+		}
+
+		auto it = counts.find(d->Text);
+		if (it == counts.end()) {
+			// Don't hang on to the text of every line ever displayed
+			if (counts.size() > 50000)
+				counts.clear();
+			it = counts.emplace(d->Text, agi::CharacterCount(text, ignore)).first;
+		}
+
+		return it->second * 1000 / duration;
 	}
 
 	int Width(const agi::Context *c, WidthHelper &helper) const override {
@@ -34,7 +34,7 @@ class WidthHelper {
 	};
 	int age = 0;
 	wxDC *dc = nullptr;
-	std::unordered_map<boost::flyweight<std::string>, Entry> widths;
+	std::unordered_map<agi::flyweight<std::string>, Entry> widths;
 #ifdef _WIN32
 	wxString scratch;
 #endif
@@ -44,7 +44,7 @@ public:
 	void Age();
 	void ClearCache() { widths.clear(); };
 
-	int operator()(boost::flyweight<std::string> const& str);
+	int operator()(agi::flyweight<std::string> const& str);
 	int operator()(std::string const& str);
 	int operator()(wxString const& str);
 	int operator()(const char *str);
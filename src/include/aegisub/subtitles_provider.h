@@ -38,16 +38,31 @@
 #include <string>
 #include <vector>
 
+class AssAttachment;
 class AssFile;
+class AssFileSnapshot;
 struct VideoFrame;
 
 class SubtitlesProvider {
 	std::vector<char> buffer;
 	virtual void LoadSubtitles(const char *data, size_t len)=0;
 
+	/// @brief Hand the script's embedded fonts to the renderer directly
+	/// @param fonts Font attachments of the script being loaded
+	/// @return false if the renderer can't do this and the fonts should be
+	///         written into the script passed to LoadSubtitles instead
+	///
+	/// Called before LoadSubtitles on every load, even if there are no
+	/// fonts. The attachments are only valid for the duration of the call.
+	virtual bool LoadFonts(std::vector<const AssAttachment *> const& fonts) { return false; }
+
+	template<typename File>
+	void LoadFile(File const& subs, int time);
+
 public:
 	virtual ~SubtitlesProvider() = default;
 	void LoadSubtitles(AssFile *subs, int time = -1);
+	void LoadSubtitles(AssFileSnapshot const& subs, int time = -1);
 	virtual void DrawSubtitles(VideoFrame &dst, double time)=0;
 	virtual void Reinitialize() { }
 };
@@ -63,6 +63,7 @@
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/persist.h>
 #include <libaegisub/util.h>
 
 #include <boost/interprocess/streams/bufferstream.hpp>
@@ -368,6 +369,9 @@ int AegisubApp::OnExit() {
 
 	AssExportFilterChain::Clear();
 
+	// Write anything still waiting to be saved while logging still works
+	agi::persist::Flush();
+
 	// Keep this last!
 	delete agi::log::log;
 	crash_writer::Cleanup();
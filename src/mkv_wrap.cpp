@@ -38,12 +38,16 @@
 #include "ass_parser.h"
 #include "compat.h"
 #include "dialog_progress.h"
+#include "format.h"
 #include "MatroskaParser.h"
 #include "options.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/file_mapping.h>
 #include <libaegisub/format.h>
+#include <libaegisub/log.h>
+#include <libaegisub/matroska.h>
 #include <libaegisub/scoped_ptr.h>
 
 #include <algorithm>
@@ -51,7 +55,9 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/range/irange.hpp>
 #include <boost/tokenizer.hpp>
+#include <chrono>
 #include <iterator>
+#include <zlib.h>
 
 #include <wx/choicdlg.h> // Keep this last so wxUSE_CHOICEDLG is set.
 
@@ -114,93 +120,148 @@ struct MkvStdIO final : InputStream {
 	}
 };
 
-static bool read_subtitles(agi::ProgressSink *ps, MatroskaFile *file, MkvStdIO *input, bool srt, double totalTime, AssParser *parser, CompressedStream *cs) {
-	std::vector<std::pair<int, std::string>> subList;
-
-	// Load blocks
-	uint64_t startTime, endTime, filePos;
-	unsigned int rt, frameSize, frameFlags;
-
-	std::vector<char> uncompBuf(cs ? 256 : 0);
-
-	while (mkv_ReadFrame(file, 0, &rt, &startTime, &endTime, &filePos, &frameSize, &frameFlags) == 0) {
-		if (ps->IsCancelled()) return true;
-		if (frameSize == 0) continue;
-
-		const char *readBuf;
-		const char *readBufEnd;
-
-		if (cs) {
-			cs_NextFrame(cs, filePos, frameSize);
-			int bytesRead = 0;
+/// Undo a track's content compression
+static std::string decompress(TrackInfo const& track, std::string const& data) {
+	if (!track.CompEnabled) return data;
+
+	switch (track.CompMethod) {
+	case 0: { // zlib
+		z_stream zs{};
+		if (inflateInit(&zs) != Z_OK)
+			throw MatroskaException("Failed to initialize zlib");
+
+		std::string out(std::max<size_t>(256, data.size() * 4), '\0');
+		zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		zs.avail_in = static_cast<uInt>(data.size());
+		int res;
+		do {
+			if (zs.total_out == out.size())
+				out.resize(out.size() * 2);
+			zs.next_out = reinterpret_cast<Bytef *>(&out[zs.total_out]);
+			zs.avail_out = static_cast<uInt>(out.size() - zs.total_out);
+			res = inflate(&zs, Z_NO_FLUSH);
+		} while (res == Z_OK);
+		inflateEnd(&zs);
+
+		if (res != Z_STREAM_END)
+			throw MatroskaException("Failed to decompress subtitles");
+		out.resize(zs.total_out);
+		return out;
+	}
+	case 3: // Header stripping
+		return std::string(static_cast<const char *>(track.CompMethodPrivate), track.CompMethodPrivateSize) + data;
+	default:
+		throw MatroskaException("Unsupported subtitle compression method");
+	}
+}
 
-			int res;
-			do {
-				res = cs_ReadData(cs, &uncompBuf[bytesRead], uncompBuf.size() - bytesRead);
-				if (res == -1) {
-					const char *err = cs_GetLastError(cs);
-					if (!err) err = "Unknown error";
-					ps->Log("Failed to decompress subtitles: " + std::string(err));
-					ps->SetStayOpen(true);
-					return false;
-				}
+namespace {
+struct SubtitleLine {
+	/// ReadOrder of ASS lines; SRT lines are already in order
+	int order = 0;
+	std::string text;
+};
+}
 
-				bytesRead += res;
+/// Convert a subtitle block to a line, returning false if the block is
+/// malformed and should be skipped
+static bool block_to_line(agi::matroska::Block const& block, std::string const& data, bool srt, SubtitleLine& line) {
+	// Get start and end times
+	agi::Time subStart = block.start / 1000000;
+	agi::Time subEnd = block.end / 1000000;
+
+	using str_range = boost::iterator_range<const char *>;
+	const char *readBuf = data.data();
+	const char *readBufEnd = readBuf + data.size();
+
+	// Process SRT
+	if (srt) {
+		line.text = agi::format("Dialogue: 0,%s,%s,Default,,0,0,0,,%s"
+			, subStart.GetAssFormatted()
+			, subEnd.GetAssFormatted()
+			, str_range(readBuf, readBufEnd));
+		boost::replace_all(line.text, "\r\n", "\\N");
+		boost::replace_all(line.text, "\r", "\\N");
+		boost::replace_all(line.text, "\n", "\\N");
+		return true;
+	}
 
-				if (bytesRead >= uncompBuf.size())
-					uncompBuf.resize(2 * uncompBuf.size());
-			} while (res != 0);
+	// Process SSA/ASS
+	auto first = std::find(readBuf, readBufEnd, ',');
+	if (first == readBufEnd) return false;
+	auto second = std::find(first + 1, readBufEnd, ',');
+	if (second == readBufEnd) return false;
 
-			readBuf = &uncompBuf[0];
-			readBufEnd = readBuf + bytesRead;
-		} else {
-			readBuf = input->file.read(filePos, frameSize);
-			readBufEnd = readBuf + frameSize;
-		}
+	try {
+		line.order = boost::lexical_cast<int>(str_range(readBuf, first));
+		line.text = agi::format("Dialogue: %d,%s,%s,%s"
+			, boost::lexical_cast<int>(str_range(first + 1, second))
+			, subStart.GetAssFormatted()
+			, subEnd.GetAssFormatted()
+			, str_range(second + 1, readBufEnd));
+	}
+	catch (boost::bad_lexical_cast const&) {
+		return false;
+	}
+	return true;
+}
 
-		// Get start and end times
-		int64_t timecodeScaleLow = 1000000;
-		agi::Time subStart = startTime / timecodeScaleLow;
-		agi::Time subEnd = endTime / timecodeScaleLow;
-
-		using str_range = boost::iterator_range<const char *>;
-
-		// Process SSA/ASS
-		if (!srt) {
-			auto first = std::find(readBuf, readBufEnd, ',');
-			if (first == readBufEnd) continue;
-			auto second = std::find(first + 1, readBufEnd, ',');
-			if (second == readBufEnd) continue;
-
-			subList.emplace_back(
-				boost::lexical_cast<int>(str_range(readBuf, first)),
-				agi::format("Dialogue: %d,%s,%s,%s"
-					, boost::lexical_cast<int>(str_range(first + 1, second))
-					, subStart.GetAssFormatted()
-					, subEnd.GetAssFormatted()
-					, str_range(second + 1, readBufEnd)));
+/// Read the track's lines into the parser. If cancelled, the lines read so
+/// far are still added.
+static void read_subtitles(agi::ProgressSink *ps, MkvStdIO *input, TrackInfo const& track, bool srt, AssParser *parser) {
+	using namespace std::chrono;
+	auto start_time = steady_clock::now();
+	auto last_update = start_time;
+
+	// Find the blocks, reporting the estimated time remaining every so often
+	agi::matroska::ReadStats stats;
+	auto blocks = agi::matroska::ReadTrack(input->file, track.Number, [&](size_t done, size_t total) {
+		if (ps->IsCancelled()) return false;
+		ps->SetProgress(done, total);
+
+		auto now = steady_clock::now();
+		if (done > 0 && now - last_update > milliseconds(250)) {
+			last_update = now;
+			auto remaining = duration_cast<seconds>((now - start_time) * (total - done) / done).count();
+			ps->SetMessage(from_wx(fmt_tl("Reading subtitles from Matroska file.\nAbout %d seconds remaining.", remaining)));
 		}
-		// Process SRT
-		else {
-			auto line = agi::format("Dialogue: 0,%s,%s,Default,,0,0,0,,%s"
-				, subStart.GetAssFormatted()
-				, subEnd.GetAssFormatted()
-				, str_range(readBuf, readBufEnd));
-			boost::replace_all(line, "\r\n", "\\N");
-			boost::replace_all(line, "\r", "\\N");
-			boost::replace_all(line, "\n", "\\N");
-
-			subList.emplace_back(subList.size(), std::move(line));
-		}
-
-		ps->SetProgress(startTime / timecodeScaleLow, totalTime);
+		return true;
+	}, &stats);
+
+	// Decompress and convert the blocks in parallel
+	ps->SetMessage(from_wx(_("Decoding subtitles...")));
+	std::vector<SubtitleLine> lines(blocks.size());
+	std::vector<char> valid(blocks.size());
+	const size_t chunk_size = 256;
+	agi::dispatch::TaskGroup group;
+	for (size_t chunk = 0; chunk < blocks.size(); chunk += chunk_size) {
+		group.Async(agi::dispatch::Background(), [&, chunk] {
+			for (size_t i = chunk; i < std::min(chunk + chunk_size, blocks.size()); ++i) {
+				if (!blocks[i].data.empty())
+					valid[i] = block_to_line(blocks[i], decompress(track, blocks[i].data), srt, lines[i]);
+			}
+		});
+	}
+	group.Wait();
+
+	// Insert into file in ReadOrder; the sort is stable so SRT lines and
+	// duplicate ReadOrders keep the order they appear in the file
+	std::vector<size_t> order;
+	order.reserve(lines.size());
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (valid[i]) order.push_back(i);
 	}
+	if (!srt) {
+		std::stable_sort(begin(order), end(order), [&](size_t a, size_t b) {
+			return lines[a].order < lines[b].order;
+		});
+	}
+	for (auto i : order)
+		parser->AddLine(lines[i].text);
 
-	// Insert into file
-	sort(begin(subList), end(subList));
-	for (auto order_value_pair : subList)
-		parser->AddLine(order_value_pair.second);
-	return true;
+	LOG_I("mkv/subtitles") << "Read " << stats.blocks << " subtitle blocks from "
+		<< stats.clusters_read << " clusters" << (stats.cancelled ? " before being cancelled" : "")
+		<< " in " << duration_cast<milliseconds>(steady_clock::now() - start_time).count() << " ms";
 }
 
 void MatroskaWrapper::GetSubtitles(agi::fs::path const& filename, AssFile *target) {
@@ -249,7 +310,6 @@ void MatroskaWrapper::GetSubtitles(agi::fs::path const& filename, AssFile *targe
 	}
 
 	// Picked track
-	mkv_SetTrackMask(file, ~(1 << trackToRead));
 	auto trackInfo = mkv_GetTrackInfo(file, trackToRead);
 	std::string CodecID(trackInfo->CodecID);
 	bool srt = CodecID == "S_TEXT/UTF8";
@@ -273,25 +333,30 @@ void MatroskaWrapper::GetSubtitles(agi::fs::path const& filename, AssFile *targe
 
 	parser.AddLine("[Events]");
 
-	agi::scoped_holder<CompressedStream *, decltype(&cs_Destroy)> cs(nullptr, cs_Destroy);
-	if (trackInfo->CompEnabled) {
-		cs = cs_Create(file, trackToRead, err, sizeof(err));
-		if (!cs)
-			throw MatroskaException(err);
-	}
-
-	// Read timecode scale
-	auto segInfo = mkv_GetFileInfo(file);
-	int64_t timecodeScale = mkv_TruncFloat(trackInfo->TimecodeScale) * segInfo->TimecodeScale;
-
-	// Progress bar
-	auto totalTime = double(segInfo->Duration) / timecodeScale;
 	DialogProgress progress(nullptr, _("Parsing Matroska"), _("Reading subtitles from Matroska file."));
-	bool result;
-	progress.Run([&](agi::ProgressSink *ps) { result = read_subtitles(ps, file, &input, srt, totalTime, &parser, cs); });
+	bool result = false;
+	std::string error;
+	try {
+		progress.Run([&](agi::ProgressSink *ps) {
+			try {
+				read_subtitles(ps, &input, *trackInfo, srt, &parser);
+				result = true;
+			}
+			catch (agi::Exception const& e) {
+				error = e.GetMessage();
+				ps->Log("Failed to read subtitles: " + error);
+				ps->SetStayOpen(true);
+			}
+		});
+	}
+	catch (agi::UserCancelException const&) {
+		// Cancelling stops reading the file, but the lines read before then
+		// are kept
+		if (!result) throw;
+	}
 
 	if (!result)
-		throw MatroskaException("Failed to read subtitles");
+		throw MatroskaException(error.empty() ? "Failed to read subtitles" : "Failed to read subtitles: " + error);
 }
 
 bool MatroskaWrapper::HasSubtitles(agi::fs::path const& filename) {
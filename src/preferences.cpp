@@ -152,6 +152,7 @@ void Audio(wxTreebook *book, Preferences *parent) {
 	p->OptionAdd(display, _("Cursor time"), "Audio/Display/Draw/Cursor Time");
 	p->OptionAdd(display, _("Video position"), "Audio/Display/Draw/Video Position");
 	p->OptionAdd(display, _("Seconds boundaries"), "Audio/Display/Draw/Seconds");
+	p->OptionAdd(display, _("Voice activity"), "Audio/Display/Draw/Voice Activity");
 	p->CellSkip(display);
 	p->OptionChoice(display, _("Waveform Style"), AudioWaveformRenderer::GetWaveformStyles(), "Audio/Display/Waveform Style");
 
@@ -263,6 +264,7 @@ void Interface_Colours(wxTreebook *book, Preferences *parent) {
 	p->OptionAdd(audio, _("Line boundary inactive line"), "Colour/Audio Display/Line Boundary Inactive Line");
 	p->OptionAdd(audio, _("Syllable boundaries"), "Colour/Audio Display/Syllable Boundaries");
 	p->OptionAdd(audio, _("Seconds boundaries"), "Colour/Audio Display/Seconds Line");
+	p->OptionAdd(audio, _("Voice activity"), "Colour/Audio Display/Voice Activity");
 
 	auto syntax = p->PageSizer(_("Syntax Highlighting"));
 	p->OptionAdd(syntax, _("Background"), "Colour/Subtitle/Background");
@@ -393,10 +395,11 @@ void Advanced_Audio(wxTreebook *book, Preferences *parent) {
 	p->OptionChoice(expert, _("Audio player"), apl_choice, "Audio/Player");
 
 	auto cache = p->PageSizer(_("Cache"));
-	const wxString ct_arr[3] = { _("None (NOT RECOMMENDED)"), _("RAM"), _("Hard Disk") };
-	wxArrayString ct_choice(3, ct_arr);
+	const wxString ct_arr[4] = { _("None (NOT RECOMMENDED)"), _("RAM"), _("Hard Disk"), _("RAM (limited size)") };
+	wxArrayString ct_choice(4, ct_arr);
 	p->OptionChoice(cache, _("Cache type"), ct_choice, "Audio/Cache/Type");
 	p->OptionBrowse(cache, _("Path"), "Audio/Cache/HD/Location");
+	p->OptionAdd(cache, _("Limited cache size (MB)"), "Audio/Cache/Block/Size", 16, 65536);
 
 	auto spectrum = p->PageSizer(_("Spectrum"));
 
@@ -764,7 +767,7 @@ void Preferences::OnApply(wxCommandEvent &) {
 	pending_callbacks.clear();
 
 	applyButton->Enable(false);
-	config::opt->Flush();
+	config::opt->QueueFlush();
 }
 
 void Preferences::OnResetDefault(wxCommandEvent&) {
@@ -776,7 +779,7 @@ void Preferences::OnResetDefault(wxCommandEvent&) {
 		if (!opt->IsDefault())
 			opt->Reset();
 	}
-	config::opt->Flush();
+	config::opt->QueueFlush();
 
 	agi::hotkey::Hotkey def_hotkeys("", GET_DEFAULT_CONFIG(default_hotkey));
 	hotkey::inst->SetHotkeyMap(def_hotkeys.GetHotkeyMap());
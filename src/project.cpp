@@ -36,19 +36,79 @@
 #include "utils.h"
 #include "video_controller.h"
 #include "video_display.h"
+#include "video_frame.h"
 
 #include <libaegisub/audio/provider.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/format_path.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/keyframe.h>
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/scene_change.h>
+#include <libaegisub/sniff.h>
 
+#include <algorithm>
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/crc.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <thread>
 #include <wx/msgdlg.h>
 
+namespace {
+/// Get the file that scene changes detected in a video are cached in, named
+/// the same way as the FFMS2 index cache so that a changed video gets a new
+/// cache file
+agi::fs::path scene_change_cache(agi::fs::path const& video) {
+	boost::crc_32_type hash;
+	hash.process_bytes(video.string().c_str(), video.string().size());
+
+	auto result = config::path->Decode("?local/scenecache/" + std::to_string(hash.checksum()) + "_" + std::to_string(agi::fs::Size(video)) + "_" + std::to_string(agi::fs::ModifiedTime(video)) + ".key.txt");
+	agi::fs::CreateDirectory(result.parent_path());
+	return result;
+}
+
+std::vector<int> detect_scene_changes(AsyncVideoProvider *provider, agi::ProgressSink *ps) {
+	using namespace agi::scene_change;
+
+	const int frame_count = provider->GetFrameCount();
+	// Decoding has to be done one frame at a time, but thumbnailing each
+	// frame can run in parallel with decoding the following ones
+	const int batch_size = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+
+	std::vector<VideoFrame> frames(batch_size);
+	std::vector<uint8_t> thumbs((batch_size + 1) * thumb_size);
+	std::vector<uint32_t> differences(frame_count);
+
+	for (int batch = 0; batch < frame_count; batch += batch_size) {
+		if (ps->IsCancelled()) return {};
+		ps->SetProgress(batch, frame_count);
+
+		// The first thumbnail slot holds the last frame of the previous batch
+		const int count = std::min(batch_size, frame_count - batch);
+		agi::dispatch::TaskGroup group;
+		for (int i = 0; i < count; ++i) {
+			VideoFrame *frame = &frames[i];
+			uint8_t *thumb = &thumbs[(i + 1) * thumb_size];
+			provider->GetRawFrame(batch + i, *frame);
+			group.Async(agi::dispatch::Background(), [=] {
+				Thumbnail(frame->data.data(), frame->width, frame->height, frame->pitch, frame->flipped, thumb);
+			});
+		}
+		group.Wait();
+
+		for (int i = 0; i < count; ++i) {
+			if (batch + i > 0)
+				differences[batch + i] = Difference(&thumbs[i * thumb_size], &thumbs[(i + 1) * thumb_size]);
+		}
+		std::copy_n(&thumbs[count * thumb_size], thumb_size, thumbs.begin());
+	}
+
+	return Detect(differences);
+}
+}
+
 Project::Project(agi::Context *c) : context(c) {
 	OPT_SUB("Audio/Cache/Type", &Project::ReloadAudio, this);
 	OPT_SUB("Audio/Provider", &Project::ReloadAudio, this);
@@ -100,9 +160,11 @@ void Project::SetPath(agi::fs::path& var, const char *token, const char *mru, ag
 }
 
 bool Project::DoLoadSubtitles(agi::fs::path const& path, std::string encoding, ProjectProperties &properties) {
+	auto format = agi::sniff::Format::Unknown;
 	try {
 		if (encoding.empty())
 			encoding = CharSetDetect::GetEncoding(path);
+		format = agi::sniff::Sniff(path).format;
 	}
 	catch (agi::UserCancelException const&) {
 		return false;
@@ -113,12 +175,15 @@ bool Project::DoLoadSubtitles(agi::fs::path const& path, std::string encoding, P
 		return false;
 	}
 
-	if (encoding != "binary") {
-		// Try loading as timecodes and keyframes first since we can't
-		// distinguish them based on filename alone, and just ignore failures
-		// rather than trying to differentiate between malformed timecodes
-		// files and things that aren't timecodes files at all
+	// Timecodes and keyframes files can't be distinguished from subtitles
+	// based on filename alone, so check their headers. Failures are ignored
+	// and the file loaded as subtitles instead rather than trying to
+	// differentiate between malformed timecodes files and things that just
+	// happen to start with a similar line.
+	if (format == agi::sniff::Format::Timecodes) {
 		try { DoLoadTimecodes(path); return false; } catch (...) { }
+	}
+	else if (format == agi::sniff::Format::Keyframes) {
 		try { DoLoadKeyframes(path); return false; } catch (...) { }
 	}
 
@@ -241,9 +306,12 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 	if (!progress)
 		progress = new DialogProgress(context->parent);
 
+	// The old provider is kept alive until everything has been told about
+	// the new one, as listeners may have work in flight which reads from it
+	std::unique_ptr<agi::AudioProvider> new_provider;
 	try {
 		try {
-			audio_provider = GetAudioProvider(path, *context->path, progress);
+			new_provider = GetAudioProvider(path, *context->path, progress);
 		}
 		catch (agi::UserCancelException const&) { return; }
 		catch (...) {
@@ -269,6 +337,7 @@ void Project::DoLoadAudio(agi::fs::path const& path, bool quiet) {
 		return ShowError(e.GetMessage());
 	}
 
+	audio_provider.swap(new_provider);
 	SetPath(audio_file, "?audio", "Audio", path);
 	AnnounceAudioProviderModified(audio_provider.get());
 }
@@ -407,6 +476,49 @@ void Project::CloseKeyframes() {
 	AnnounceKeyframesModified(keyframes);
 }
 
+std::vector<int> Project::DoDetectKeyframes() {
+	auto cache = scene_change_cache(video_file);
+	if (agi::fs::FileExists(cache)) {
+		try {
+			return agi::keyframe::Load(cache);
+		}
+		catch (agi::Exception const& e) {
+			LOG_E("project/keyframes") << "Discarding unreadable scene change cache: " << e.GetMessage();
+		}
+	}
+
+	if (!progress)
+		progress = new DialogProgress(context->parent);
+
+	std::vector<int> scenes;
+	progress->Run([&](agi::ProgressSink *ps) {
+		ps->SetTitle(from_wx(_("Detecting scene changes")));
+		ps->SetMessage(from_wx(_("Reading video frames...")));
+		scenes = detect_scene_changes(video_provider.get(), ps);
+	});
+
+	if (!scenes.empty())
+		agi::keyframe::Save(cache, scenes);
+	return scenes;
+}
+
+void Project::DetectKeyframes() {
+	if (!video_provider) return;
+	context->videoController->Stop();
+
+	try {
+		auto scenes = DoDetectKeyframes();
+		if (scenes.empty()) return;
+		keyframes = std::move(scenes);
+		SetPath(keyframes_file, "", "", scene_change_cache(video_file));
+		AnnounceKeyframesModified(keyframes);
+	}
+	catch (agi::UserCancelException const&) { }
+	catch (agi::fs::FileSystemError const& e) {
+		ShowError(e.GetMessage());
+	}
+}
+
 void Project::LoadList(std::vector<agi::fs::path> const& files) {
 	// Keep these lists sorted
 
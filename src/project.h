@@ -57,6 +57,7 @@ class Project {
 	bool DoLoadVideo(agi::fs::path const& path);
 	void DoLoadTimecodes(agi::fs::path const& path);
 	void DoLoadKeyframes(agi::fs::path const& path);
+	std::vector<int> DoDetectKeyframes();
 
 	void LoadUnloadFiles(ProjectProperties properties);
 	void UpdateRelativePaths();
@@ -91,6 +92,9 @@ public:
 	void LoadKeyframes(agi::fs::path path);
 	void CloseKeyframes();
 	bool CanCloseKeyframes() const { return !keyframes_file.empty(); }
+	/// Use scene changes detected in the video as the keyframes, detecting
+	/// them first if they aren't already cached for the video
+	void DetectKeyframes();
 	std::vector<int> const& Keyframes() const { return keyframes; }
 
 	void LoadList(std::vector<agi::fs::path> const& files);
@@ -0,0 +1,196 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file quality_checker.cpp
+/// @brief Background checking of the open file for common problems
+/// @ingroup main
+
+#include "quality_checker.h"
+
+#include "ass_dialogue.h"
+#include "ass_file.h"
+#include "include/aegisub/context.h"
+#include "options.h"
+
+#include <libaegisub/character_count.h>
+#include <libaegisub/make_unique.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+agi::qc::Line to_line(AssDialogue const& diag) {
+	agi::qc::Line line;
+	line.id = diag.Id;
+	line.start = diag.Start;
+	line.end = diag.End;
+	line.comment = diag.Comment;
+	line.style = diag.Style;
+	line.text = diag.Text;
+	return line;
+}
+
+agi::qc::Settings current_settings() {
+	agi::qc::Settings settings;
+	settings.max_cps = OPT_GET("Subtitle/Character Counter/CPS Warning Threshold")->GetInt();
+	settings.max_line_length = static_cast<size_t>(std::max<int64_t>(0, OPT_GET("Subtitle/Character Limit")->GetInt()));
+	if (OPT_GET("Subtitle/Character Counter/Ignore Whitespace")->GetBool())
+		settings.ignore |= agi::IGNORE_WHITESPACE;
+	if (OPT_GET("Subtitle/Character Counter/Ignore Punctuation")->GetBool())
+		settings.ignore |= agi::IGNORE_PUNCTUATION;
+	return settings;
+}
+}
+
+QualityChecker::QualityChecker(agi::Context *c)
+: c(c)
+, queue(agi::dispatch::Create(agi::dispatch::Priority::Low))
+, checker(std::make_shared<agi::qc::Checker>())
+{
+	connections = agi::signal::make_vector({
+		c->ass->AddCommitListener(&QualityChecker::OnCommit, this),
+		OPT_SUB("Subtitle/Character Counter/CPS Warning Threshold", &QualityChecker::OnSettingsChanged, this),
+		OPT_SUB("Subtitle/Character Counter/Ignore Whitespace", &QualityChecker::OnSettingsChanged, this),
+		OPT_SUB("Subtitle/Character Counter/Ignore Punctuation", &QualityChecker::OnSettingsChanged, this),
+		OPT_SUB("Subtitle/Character Limit", &QualityChecker::OnSettingsChanged, this),
+	});
+
+	auto checker = this->checker;
+	auto settings = current_settings();
+	queue->Async([=] { checker->SetSettings(settings); });
+}
+
+QualityChecker::~QualityChecker() {
+	alive.Cancel();
+	// Let anything in flight finish, as it holds its own reference to the
+	// checker but nothing in it should outlive the context
+	queue->Sync([] { });
+}
+
+void QualityChecker::OnCommit(int type, const AssDialogue *single_line) {
+	if (type == AssFile::COMMIT_NEW) {
+		sent.clear();
+		results.clear();
+		issue_lines.clear();
+		auto checker = this->checker;
+		queue->Async([=] { checker->Clear(); });
+		SendStyles();
+	}
+	else if (type & AssFile::COMMIT_STYLES)
+		SendStyles();
+
+	if (type != AssFile::COMMIT_NEW && !(type & (AssFile::COMMIT_DIAG_ADDREM | AssFile::COMMIT_DIAG_FULL))) {
+		if (type & AssFile::COMMIT_STYLES)
+			Publish();
+		return;
+	}
+
+	std::vector<agi::qc::Line> changed;
+	std::vector<int> removed;
+
+	auto check = [&](AssDialogue const& diag) {
+		auto it = sent.find(diag.Id);
+		if (it != sent.end()) {
+			auto& state = it->second;
+			// Flyweights compare by identity, so this is cheap even for
+			// long lines
+			if (state.text == diag.Text && state.style == diag.Style &&
+				state.start == diag.Start && state.end == diag.End &&
+				state.comment == diag.Comment)
+				return;
+			state = LineState{diag.Text, diag.Style, diag.Start, diag.End, diag.Comment};
+		}
+		else
+			sent.emplace(diag.Id, LineState{diag.Text, diag.Style, diag.Start, diag.End, diag.Comment});
+		changed.push_back(to_line(diag));
+	};
+
+	// Edits to a single line only need to look at that line
+	if (single_line && !(type & AssFile::COMMIT_DIAG_ADDREM))
+		check(*single_line);
+	else {
+		std::unordered_set<int> seen;
+		seen.reserve(c->ass->Events.size());
+		for (auto const& diag : c->ass->Events) {
+			seen.insert(diag.Id);
+			check(diag);
+		}
+
+		for (auto it = sent.begin(); it != sent.end(); ) {
+			if (seen.count(it->first))
+				++it;
+			else {
+				removed.push_back(it->first);
+				it = sent.erase(it);
+			}
+		}
+	}
+
+	if (!changed.empty() || !removed.empty())
+		Send(std::move(changed), std::move(removed));
+	else if (type & AssFile::COMMIT_STYLES)
+		Publish();
+}
+
+void QualityChecker::OnSettingsChanged() {
+	auto checker = this->checker;
+	auto settings = current_settings();
+	queue->Async([=] { checker->SetSettings(settings); });
+	Publish();
+}
+
+void QualityChecker::SendStyles() {
+	auto checker = this->checker;
+	auto styles = c->ass->GetStyles();
+	queue->Async([=] { checker->SetStyles(styles); });
+}
+
+void QualityChecker::Send(std::vector<agi::qc::Line> changed, std::vector<int> removed) {
+	auto checker = this->checker;
+	// std::function needs copyable thunks, so move the lines into a
+	// shared_ptr rather than copying every line's text
+	auto update = std::make_shared<std::pair<std::vector<agi::qc::Line>, std::vector<int>>>(std::move(changed), std::move(removed));
+	queue->Async([=] { checker->Update(std::move(update->first), update->second); });
+	Publish();
+}
+
+void QualityChecker::Publish() {
+	auto checker = this->checker;
+	auto alive = this->alive;
+	auto queue = this->queue.get();
+	queue->Async([=] {
+		// Skip all but the last of a burst of updates
+		if (queue->GetStats().queued > 0) return;
+
+		auto ids = std::make_shared<std::vector<int>>(checker->LinesWithIssues(~0));
+		auto diags = std::make_shared<std::unordered_map<int, agi::qc::Diagnostic>>();
+		diags->reserve(ids->size());
+		for (int id : *ids)
+			(*diags)[id] = checker->Get(id);
+
+		agi::dispatch::Main().Async([=] {
+			issue_lines = std::move(*ids);
+			results = std::move(*diags);
+			AnnounceResultsChanged();
+		}, alive);
+	}, alive);
+}
+
+agi::qc::Diagnostic QualityChecker::Get(const AssDialogue *line) const {
+	auto it = results.find(line->Id);
+	return it == results.end() ? agi::qc::Diagnostic() : it->second;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+/// @file quality_checker.h
+/// @brief Background checking of the open file for common problems
+/// @ingroup main
+
+#include <libaegisub/dispatch.h>
+#include <libaegisub/flyweight.h>
+#include <libaegisub/quality_check.h>
+#include <libaegisub/signal.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace agi { struct Context; }
+class AssDialogue;
+
+/// @class QualityChecker
+/// @brief Keeps agi::qc diagnostics for the open file up to date
+///
+/// Each commit is diffed against what was last sent to the checker so that
+/// only the lines which actually changed are rechecked. The checking is done
+/// on a serial background queue and the results are handed back to the main
+/// thread, so typing in the edit box never waits for it.
+class QualityChecker {
+	/// The parts of a line which were last sent to the checker
+	struct LineState {
+		agi::flyweight<std::string> text;
+		agi::flyweight<std::string> style;
+		int start;
+		int end;
+		bool comment;
+	};
+
+	agi::Context *c;
+	std::vector<agi::signal::Connection> connections;
+
+	/// Queue which all use of checker is serialized on
+	std::unique_ptr<agi::dispatch::Queue> queue;
+	std::shared_ptr<agi::qc::Checker> checker;
+	/// Cancelled on destruction so that results posted to the main thread
+	/// after that are dropped
+	agi::dispatch::CancellationToken alive;
+
+	std::unordered_map<int, LineState> sent;
+	std::unordered_map<int, agi::qc::Diagnostic> results;
+	/// Ids of lines with issues, sorted by start time
+	std::vector<int> issue_lines;
+
+	agi::signal::Signal<> AnnounceResultsChanged;
+
+	void OnCommit(int type, const AssDialogue *single_line);
+	void OnSettingsChanged();
+	void SendStyles();
+	void Send(std::vector<agi::qc::Line> changed, std::vector<int> removed);
+	/// Ask the background queue for fresh results once it's done
+	void Publish();
+
+public:
+	QualityChecker(agi::Context *c);
+	~QualityChecker();
+
+	/// Get the most recent diagnostics for a line
+	agi::qc::Diagnostic Get(const AssDialogue *line) const;
+
+	/// Ids of lines with at least one issue, sorted by start time
+	std::vector<int> const& LinesWithIssues() const { return issue_lines; }
+
+	DEFINE_SIGNAL_ADDERS(AnnounceResultsChanged, AddResultsListener)
+};
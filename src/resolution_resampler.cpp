@@ -21,15 +21,16 @@
 #include "ass_style.h"
 #include "utils.h"
 
+#include <libaegisub/ass/transform.h>
+#include <libaegisub/dispatch.h>
 #include <libaegisub/exception.h>
 #include <libaegisub/of_type_adaptor.h>
-#include <libaegisub/split.h>
-#include <libaegisub/util.h>
 #include <libaegisub/ycbcr_conv.h>
 
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <cmath>
+#include <vector>
 #include <wx/intl.h>
 
 enum {
@@ -64,38 +65,6 @@ std::vector<std::string> MatrixNames() {
 }
 
 namespace {
-	std::string transform_drawing(std::string const& drawing, int shift_x, int shift_y, double scale_x, double scale_y) {
-		bool is_x = true;
-		std::string final;
-		final.reserve(drawing.size());
-
-		for (auto const& cur : agi::Split(drawing, ' ')) {
-			double val;
-			if (agi::util::try_parse(agi::str(cur), &val)) {
-				if (is_x)
-					val = (val + shift_x) * scale_x;
-				else
-					val = (val + shift_y) * scale_y;
-				val = round(val * 8) / 8.0; // round to eighth-pixels
-				final += float_to_string(val);
-				final += ' ';
-				is_x = !is_x;
-			}
-			else if (cur.size() == 1) {
-				char c = tolower(cur[0]);
-				if (c == 'm' || c == 'n' || c == 'l' || c == 'b' || c == 's' || c == 'p' || c == 'c') {
-					is_x = true;
-					final += c;
-					final += ' ';
-				}
-			}
-		}
-
-		if (final.size())
-			final.pop_back();
-		return final;
-	}
-
 	struct resample_state {
 		const int *margin;
 		double rx;
@@ -134,7 +103,7 @@ namespace {
 				break;
 
 			case AssParameterClass::DRAWING: {
-				cur->Set(transform_drawing(
+				cur->Set(agi::ass::TransformDrawing(
 					cur->Get<std::string>(),
 					state->margin[LEFT], state->margin[TOP], state->rx, state->ry));
 				return;
@@ -160,18 +129,23 @@ namespace {
 		if (diag.Comment && (boost::starts_with(diag.Effect.get(), "template") || boost::starts_with(diag.Effect.get(), "code")))
 			return;
 
+		for (size_t i = 0; i < 3; ++i) {
+			if (diag.Margin[i])
+				diag.Margin[i] = int((diag.Margin[i] + state->margin[i]) * (i < 2 ? state->rx : state->ry) + 0.5);
+		}
+
+		// Only build a modifiable copy of the blocks if there's something in
+		// them to resample
+		if (!diag.GetParsedTags()->HasOverrides())
+			return;
+
 		auto blocks = diag.ParseTags();
 
 		for (auto block : blocks | agi::of_type<AssDialogueBlockOverride>())
 			block->ProcessParameters(resample_tags, state);
 
 		for (auto drawing : blocks | agi::of_type<AssDialogueBlockDrawing>())
-			drawing->text = transform_drawing(drawing->text, 0, 0, state->rx / state->ar, state->ry);
-
-		for (size_t i = 0; i < 3; ++i) {
-			if (diag.Margin[i])
-				diag.Margin[i] = int((diag.Margin[i] + state->margin[i]) * (i < 2 ? state->rx : state->ry) + 0.5);
-		}
+			drawing->text = agi::ass::TransformDrawing(drawing->text, 0, 0, state->rx / state->ar, state->ry);
 
 		diag.UpdateText(blocks);
 	}
@@ -278,8 +252,16 @@ void ResampleResolution(AssFile *ass, ResampleSettings settings) {
 
 	for (auto& line : ass->Styles)
 		resample_style(&state, line);
+
+	// Lines are independent of each other, so resample them in parallel
+	// and commit the whole lot at once
+	std::vector<AssDialogue *> lines;
 	for (auto& line : ass->Events)
-		resample_line(&state, line);
+		lines.push_back(&line);
+	agi::dispatch::ParallelFor(lines.size(), 256, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			resample_line(&state, *lines[i]);
+	});
 
 	ass->SetScriptInfo("PlayResX", std::to_string(settings.dest_x));
 	ass->SetScriptInfo("PlayResY", std::to_string(settings.dest_y));
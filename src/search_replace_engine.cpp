@@ -55,7 +55,7 @@ std::string const& get_normalized(const AssDialogue *diag, decltype(&AssDialogue
 typedef std::function<MatchState (const AssDialogue*, size_t)> matcher;
 
 class noop_accessor {
-	boost::flyweight<std::string> AssDialogueBase::*field;
+	agi::flyweight<std::string> AssDialogueBase::*field;
 	size_t start = 0;
 
 public:
@@ -72,7 +72,7 @@ public:
 };
 
 class skip_tags_accessor {
-	boost::flyweight<std::string> AssDialogueBase::*field;
+	agi::flyweight<std::string> AssDialogueBase::*field;
 	agi::util::tagless_find_helper helper;
 
 public:
@@ -62,6 +62,7 @@ void HunspellSpellChecker::AddWord(std::string const& word) {
 
 	// Add it to the in-memory dictionary
 	hunspell->add(conv->Convert(word).c_str());
+	checked_words.clear();
 
 	// Add the word
 	if (customWords.insert(word).second)
@@ -73,6 +74,7 @@ void HunspellSpellChecker::RemoveWord(std::string const& word) {
 
 	// Remove it from the in-memory dictionary
 	hunspell->remove(conv->Convert(word).c_str());
+	checked_words.clear();
 
 	auto word_iter = customWords.find(word);
 	if (word_iter != customWords.end()) {
@@ -118,12 +120,24 @@ void HunspellSpellChecker::WriteUserDictionary() {
 
 bool HunspellSpellChecker::CheckWord(std::string const& word) {
 	if (!hunspell) return true;
+
+	auto it = checked_words.find(word);
+	if (it != checked_words.end())
+		return it->second;
+
+	bool valid;
 	try {
-		return hunspell->spell(conv->Convert(word).c_str()) == 1;
+		valid = hunspell->spell(conv->Convert(word).c_str()) == 1;
 	}
 	catch (agi::charset::ConvError const&) {
-		return false;
+		valid = false;
 	}
+
+	// Don't hang on to every word ever checked
+	if (checked_words.size() > 100000)
+		checked_words.clear();
+	checked_words.emplace(word, valid);
+	return valid;
 }
 
 std::vector<std::string> HunspellSpellChecker::GetSuggestions(std::string const& word) {
@@ -181,6 +195,7 @@ static bool check_path(agi::fs::path const& path, std::string const& language, a
 
 void HunspellSpellChecker::OnLanguageChanged() {
 	hunspell.reset();
+	checked_words.clear();
 
 	auto language = OPT_GET("Tool/Spell Checker/Language")->GetString();
 	if (language.empty()) return;
@@ -28,6 +28,7 @@
 #include <boost/filesystem/path.hpp>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 namespace agi { namespace charset { class IconvWrapper; } }
 class Hunspell;
@@ -50,6 +51,10 @@ class HunspellSpellChecker final : public agi::SpellChecker {
 	/// Words in the custom user dictionary
 	std::set<std::string> customWords;
 
+	/// Results of CheckWord, as the edit box rechecks every word of the
+	/// line on each keystroke and most of them haven't changed
+	std::unordered_map<std::string, bool> checked_words;
+
 	/// Dictionary language change connection
 	agi::signal::Connection lang_listener;
 	/// Dictionary language change handler
@@ -19,6 +19,7 @@
 #include "ass_attachment.h"
 #include "ass_dialogue.h"
 #include "ass_file.h"
+#include "ass_file_snapshot.h"
 #include "ass_info.h"
 #include "ass_style.h"
 #include "compat.h"
@@ -35,7 +36,9 @@
 #include <libaegisub/dispatch.h>
 #include <libaegisub/format_path.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/trace.h>
 #include <libaegisub/util.h>
 
 #include <wx/msgdlg.h>
@@ -147,7 +150,7 @@ SubsController::SubsController(agi::Context *context)
 : context(context)
 , undo_connection(context->ass->AddUndoManager(&SubsController::OnCommit, this))
 , text_selection_connection(context->textSelectionController->AddSelectionListener(&SubsController::OnTextSelectionChanged, this))
-, autosave_queue(agi::dispatch::Create())
+, autosave_queue(agi::dispatch::Create(agi::dispatch::Priority::Low))
 {
 	autosave_timer_changed(&autosave_timer);
 	OPT_SUB("App/Auto/Save", [=] { autosave_timer_changed(&autosave_timer); });
@@ -168,7 +171,10 @@ void SubsController::SetSelectionController(SelectionController *selection_contr
 ProjectProperties SubsController::Load(agi::fs::path const& filename, std::string charset) {
 	AssFile temp;
 
-	SubtitleFormat::GetReader(filename, charset)->ReadFile(&temp, filename, context->project->Timecodes(), charset);
+	{
+		AGI_TRACE_SCOPE("subtitles", "ReadFile");
+		SubtitleFormat::GetReader(filename, charset)->ReadFile(&temp, filename, context->project->Timecodes(), charset);
+	}
 
 	context->ass->swap(temp);
 	auto props = context->ass->Properties;
@@ -266,10 +272,10 @@ void SubsController::AutoSave() {
 
 	autosaved_commit_id = commit_id;
 	auto frame = context->frame;
-	auto subs_copy = new AssFile(*context->ass);
-	autosave_queue->Async([subs_copy, name, directory, frame] {
+	auto snapshot = context->ass->Snapshot();
+	autosave_queue->Async([snapshot, name, directory, frame] {
 		wxString msg;
-		std::unique_ptr<AssFile> subs(subs_copy);
+		auto subs = agi::make_unique<AssFile>(*snapshot);
 
 		try {
 			agi::fs::CreateDirectory(directory);
@@ -389,10 +389,10 @@ void SubsEditBox::UpdateFields(int type, bool repopulate_lists) {
 	}
 }
 
-void SubsEditBox::PopulateList(wxComboBox *combo, boost::flyweight<std::string> AssDialogue::*field) {
+void SubsEditBox::PopulateList(wxComboBox *combo, agi::flyweight<std::string> AssDialogue::*field) {
 	wxEventBlocker blocker(this);
 
-	std::unordered_set<boost::flyweight<std::string>> values;
+	std::unordered_set<agi::flyweight<std::string>> values;
 	for (auto const& line : c->ass->Events) {
 		auto const& value = line.*field;
 		if (!value.get().empty())
@@ -486,13 +486,13 @@ void SubsEditBox::SetSelectedRows(T AssDialogueBase::*field, T value, wxString c
 
 template<class T>
 void SubsEditBox::SetSelectedRows(T AssDialogueBase::*field, wxString const& value, wxString const& desc, int type, bool amend) {
-	boost::flyweight<std::string> conv_value(from_wx(value));
+	agi::flyweight<std::string> conv_value(from_wx(value));
 	SetSelectedRows([&](AssDialogue *d) { d->*field = conv_value; }, desc, type, amend);
 }
 
 void SubsEditBox::CommitText(wxString const& desc) {
 	auto data = edit_ctrl->GetTextRaw();
-	SetSelectedRows(&AssDialogue::Text, boost::flyweight<std::string>(data.data(), data.length()), desc, AssFile::COMMIT_DIAG_TEXT, true);
+	SetSelectedRows(&AssDialogue::Text, agi::flyweight<std::string>(data.data(), data.length()), desc, AssFile::COMMIT_DIAG_TEXT, true);
 }
 
 void SubsEditBox::CommitTimes(TimeField field) {
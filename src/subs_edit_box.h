@@ -29,7 +29,6 @@
 
 #include <array>
 #include <boost/container/map.hpp>
-#include <boost/flyweight/flyweight_fwd.hpp>
 #include <vector>
 
 #include <wx/combobox.h>
@@ -39,6 +38,7 @@
 #include <libaegisub/signal.h>
 
 namespace agi { namespace vfr { class Framerate; } }
+namespace agi { template<typename T> class flyweight; }
 namespace agi { struct Context; }
 namespace agi { class Time; }
 class AssDialogue;
@@ -186,7 +186,7 @@ class SubsEditBox final : public wxPanel {
 	void UpdateFields(int type, bool repopulate_lists);
 
 	/// Regenerate a dropdown list with the unique values of a dialogue field
-	void PopulateList(wxComboBox *combo, boost::flyweight<std::string> AssDialogue::*field);
+	void PopulateList(wxComboBox *combo, agi::flyweight<std::string> AssDialogue::*field);
 
 	/// @brief Enable or disable frame timing mode
 	void UpdateFrameTiming(agi::vfr::Framerate const& fps);
@@ -47,6 +47,7 @@
 #include <libaegisub/make_unique.h>
 #include <libaegisub/spellchecker.h>
 
+#include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <functional>
@@ -71,6 +72,14 @@
 // It should be above 100 (at least 242) and probably not more than 1000
 #define LANGS_MAX 1000
 
+namespace {
+/// Lines at least this long are only styled as far as has been displayed,
+/// as styling every token of a huge drawing is far slower than lexing it
+const size_t lazy_style_threshold = 32 * 1024;
+/// How far past the end of the visible text to style long lines
+const size_t lazy_style_margin = 4096;
+}
+
 /// Event ids
 // Check menu.h for id range allocation before editing this enum
 enum {
@@ -138,14 +147,18 @@ SubsTextEditCtrl::SubsTextEditCtrl(wxWindow* parent, wxSize wsize, long style, a
 	Bind(wxEVT_CONTEXT_MENU, &SubsTextEditCtrl::OnContextMenu, this);
 	Bind(wxEVT_IDLE, std::bind(&SubsTextEditCtrl::UpdateCallTip, this));
 	Bind(wxEVT_STC_DOUBLECLICK, &SubsTextEditCtrl::OnDoubleClick, this);
-	Bind(wxEVT_STC_STYLENEEDED, [=](wxStyledTextEvent&) {
+	Bind(wxEVT_STC_STYLENEEDED, [=](wxStyledTextEvent& evt) {
 		{
 			std::string text = GetTextRaw().data();
-			if (text == line_text) return;
-			line_text = move(text);
+			if (text != line_text) {
+				line_text = move(text);
+				UpdateStyle();
+			}
 		}
 
-		UpdateStyle();
+		// Long lines are styled as they're scrolled into view
+		if (evt.GetPosition() > GetEndStyled())
+			StyleRange(GetEndStyled(), evt.GetPosition() + lazy_style_margin);
 	});
 
 	OPT_SUB("Subtitle/Edit Box/Font Face", &SubsTextEditCtrl::SetStyles, this);
@@ -280,37 +293,83 @@ void SubsTextEditCtrl::UpdateStyle() {
 	AssDialogue *diag = context ? context->selectionController->GetActiveLine() : nullptr;
 	bool template_line = diag && diag->Comment && (boost::istarts_with(diag->Effect.get(), "template") || boost::istarts_with(diag->Effect.get(), "mixin"));
 
-	tokenized_line = agi::ass::TokenizeDialogueBody(line_text, template_line);
+	if (template_line == lexed_as_template)
+		unsplit_tokens = agi::ass::RetokenizeDialogueBody(lexed_text, unsplit_tokens, line_text, template_line);
+	else
+		unsplit_tokens = agi::ass::TokenizeDialogueBody(line_text, template_line);
+	lexed_text = line_text;
+	lexed_as_template = template_line;
+
+	tokenized_line = unsplit_tokens;
 	agi::ass::SplitWords(line_text, tokenized_line);
 
 	cursor_pos = -1;
 	UpdateCallTip();
 
-#if wxVERSION_NUMBER >= 3100
-	StartStyling(0);
-#else
-	StartStyling(0, 255);
-#endif
-
 	if (!OPT_GET("Subtitle/Highlight/Syntax")->GetBool()) {
-		SetStyling(line_text.size(), 0);
+		style_ranges.assign(1, agi::ass::DialogueToken{0, line_text.size()});
+		StyleRange(0, line_text.size());
+		return;
+	}
+
+	if (line_text.empty()) {
+		style_ranges.clear();
 		return;
 	}
 
-	if (line_text.empty()) return;
+	auto new_ranges = agi::ass::SyntaxHighlight(line_text, tokenized_line, spellchecker.get());
+
+	if (line_text.size() < lazy_style_threshold) {
+		style_ranges = std::move(new_ranges);
+		StyleRange(0, line_text.size());
+		return;
+	}
+
+	// Scintilla moves styles along with the text when it's edited, so the
+	// styles before both the edit and the first range which changed are
+	// still correct and only the part from there to the end of what's
+	// visible needs styling
+	size_t first_changed = 0;
+	for (size_t i = 0; i < style_ranges.size() && i < new_ranges.size(); ++i) {
+		if (style_ranges[i].type != new_ranges[i].type || style_ranges[i].length != new_ranges[i].length)
+			break;
+		first_changed += new_ranges[i].length;
+	}
+	style_ranges = std::move(new_ranges);
+
+	auto size = GetClientSize();
+	int visible_end = PositionFromPoint(wxPoint(size.GetWidth(), size.GetHeight()));
+	StyleRange(std::min<size_t>(first_changed, GetEndStyled()), static_cast<size_t>(std::max(0, visible_end)) + lazy_style_margin);
+}
+
+void SubsTextEditCtrl::StyleRange(size_t begin, size_t end) {
+	end = std::min(end, line_text.size());
+	if (begin >= end) return;
+
+#if wxVERSION_NUMBER >= 3100
+	StartStyling(begin);
+#else
+	StartStyling(begin, 255);
+#endif
 
 	SetIndicatorCurrent(0);
 	size_t pos = 0;
-	for (auto const& style_range : agi::ass::SyntaxHighlight(line_text, tokenized_line, spellchecker.get())) {
-		if (style_range.type == agi::ass::SyntaxStyle::SPELLING) {
-			SetStyling(style_range.length, agi::ass::SyntaxStyle::NORMAL);
-			IndicatorFillRange(pos, style_range.length);
-		}
-		else {
-			SetStyling(style_range.length, style_range.type);
-			IndicatorClearRange(pos, style_range.length);
+	for (auto const& style_range : style_ranges) {
+		size_t range_end = pos + style_range.length;
+		if (range_end > begin) {
+			size_t from = std::max(pos, begin);
+			size_t length = std::min(range_end, end) - from;
+			if (style_range.type == agi::ass::SyntaxStyle::SPELLING) {
+				SetStyling(length, agi::ass::SyntaxStyle::NORMAL);
+				IndicatorFillRange(from, length);
+			}
+			else {
+				SetStyling(length, style_range.type);
+				IndicatorClearRange(from, length);
+			}
 		}
-		pos += style_range.length;
+		pos = range_end;
+		if (pos >= end) break;
 	}
 }
 
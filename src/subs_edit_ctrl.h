@@ -80,6 +80,19 @@ class SubsTextEditCtrl final : public wxStyledTextCtrl {
 	/// Tokenized version of line_text
 	std::vector<agi::ass::DialogueToken> tokenized_line;
 
+	/// Text which unsplit_tokens were lexed from
+	std::string lexed_text;
+
+	/// Tokens of lexed_text before splitting words, kept so that only the
+	/// edited part of the line has to be lexed again
+	std::vector<agi::ass::DialogueToken> unsplit_tokens;
+
+	/// Were unsplit_tokens lexed as a karaoke template line?
+	bool lexed_as_template = false;
+
+	/// Syntax highlighting styles for line_text
+	std::vector<agi::ass::DialogueToken> style_ranges;
+
 	void OnContextMenu(wxContextMenuEvent &);
 	void OnDoubleClick(wxStyledTextEvent&);
 	void OnUseSuggestion(wxCommandEvent &event);
@@ -97,6 +110,12 @@ class SubsTextEditCtrl final : public wxStyledTextCtrl {
 
 	void UpdateStyle();
 
+	/// Apply style_ranges to the text between begin and end
+	///
+	/// Very long lines are only styled as far as has been displayed, with
+	/// Scintilla's end styled position tracking how far that is.
+	void StyleRange(size_t begin, size_t end);
+
 	/// Add the thesaurus suggestions to a menu
 	void AddThesaurusEntries(wxMenu &menu);
 
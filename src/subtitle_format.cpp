@@ -48,9 +48,11 @@
 #include "subtitle_format_transtation.h"
 #include "subtitle_format_ttxt.h"
 #include "subtitle_format_txt.h"
+#include "subtitle_format_webvtt.h"
 
 #include <libaegisub/fs.h>
 #include <libaegisub/make_unique.h>
+#include <libaegisub/sniff.h>
 #include <libaegisub/vfr.h>
 
 #include <algorithm>
@@ -73,6 +75,10 @@ bool SubtitleFormat::CanReadFile(agi::fs::path const& filename, std::string cons
 		[&](std::string const& ext) { return agi::fs::HasExtension(filename, ext); });
 }
 
+agi::sniff::Format SubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::Unknown;
+}
+
 bool SubtitleFormat::CanWriteFile(agi::fs::path const& filename) const {
 	auto wildcards = GetWriteWildcards();
 	return any_of(begin(wildcards), end(wildcards),
@@ -83,7 +89,7 @@ bool SubtitleFormat::CanSave(const AssFile *subs) const {
 	if (!subs->Attachments.empty())
 		return false;
 
-	auto def = boost::flyweight<std::string>("Default");
+	auto def = agi::flyweight<std::string>("Default");
 	for (auto const& line : subs->Events) {
 		if (line.Style != def || line.GetStrippedText() != line.Text)
 			return false;
@@ -272,6 +278,7 @@ void SubtitleFormat::LoadFormats() {
 		formats.emplace_back(agi::make_unique<TTXTSubtitleFormat>());
 		formats.emplace_back(agi::make_unique<TXTSubtitleFormat>());
 		formats.emplace_back(agi::make_unique<TranStationSubtitleFormat>());
+		formats.emplace_back(agi::make_unique<WebVttSubtitleFormat>());
 	}
 }
 
@@ -285,6 +292,15 @@ SubtitleFormat *find_or_throw(Cont &container, Pred pred) {
 
 const SubtitleFormat *SubtitleFormat::GetReader(agi::fs::path const& filename, std::string const& encoding) {
 	LoadFormats();
+
+	auto sniffed = agi::sniff::Sniff(filename).format;
+	if (sniffed != agi::sniff::Format::Unknown) {
+		for (auto const& format : formats) {
+			if (format->SniffedFormat() == sniffed)
+				return format.get();
+		}
+	}
+
 	return find_or_throw(formats, [&](std::unique_ptr<SubtitleFormat> const& f) {
 		return f->CanReadFile(filename, encoding);
 	});
@@ -36,7 +36,10 @@
 #include <vector>
 
 class AssFile;
-namespace agi { namespace vfr { class Framerate; } }
+namespace agi {
+	namespace sniff { enum class Format; }
+	namespace vfr { class Framerate; }
+}
 
 class SubtitleFormat {
 	std::string name;
@@ -82,6 +85,13 @@ public:
 	/// format's wildcard list
 	virtual bool CanReadFile(agi::fs::path const& filename, std::string const& encoding) const;
 
+	/// @brief Get the format of files which this can read as identified by agi::sniff
+	///
+	/// Files sniffed as this format are read with this reader regardless of
+	/// their extension. Default implementation returns Format::Unknown,
+	/// which means only CanReadFile is used.
+	virtual agi::sniff::Format SniffedFormat() const;
+
 	/// @brief Check if the given file can be written by this format
 	///
 	/// Default implementation simply checks if the file's extension is in the
@@ -119,7 +129,8 @@ public:
 	/// @param mode 0: load 1: save
 	static std::string GetWildcards(int mode);
 
-	/// Get a subtitle format that can read the given file or nullptr if none can
+	/// Get a subtitle format that can read the given file, preferring the one
+	/// matching the file's contents over ones matching its extension
 	static const SubtitleFormat *GetReader(agi::fs::path const& filename, std::string const& encoding);
 	/// Get a subtitle format that can write the given file or nullptr if none can
 	static const SubtitleFormat *GetWriter(agi::fs::path const& filename);
@@ -30,9 +30,14 @@
 
 #include <libaegisub/ass/uuencode.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/sniff.h>
 
 DEFINE_EXCEPTION(AssParseError, SubtitleFormatParseError);
 
+agi::sniff::Format AssSubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::Ass;
+}
+
 void AssSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& encoding) const {
 	int version = !agi::fs::HasExtension(filename, "ssa");
 
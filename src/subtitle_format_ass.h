@@ -22,6 +22,7 @@ public:
 
 	std::vector<std::string> GetReadWildcards() const override { return {"ass", "ssa"}; }
 	std::vector<std::string> GetWriteWildcards() const override { return {"ass"}; }
+	agi::sniff::Format SniffedFormat() const override;
 
 	// Naturally the ASS subtitle format can save all ASS files
 	bool CanSave(const AssFile*) const override { return true; }
@@ -115,7 +115,7 @@ namespace
 	/// intermediate format
 	class EbuSubtitle
 	{
-		void ProcessOverrides(AssDialogueBlockOverride *ob, bool &underline, bool &italic, int &align, bool style_underline, bool style_italic)
+		void ProcessOverrides(const AssDialogueBlockOverride *ob, bool &underline, bool &italic, int &align, bool style_underline, bool style_italic)
 		{
 			for (auto const& t : ob->Tags)
 			{
@@ -257,7 +257,8 @@ namespace
 
 			bool underline = style_underline, italic = style_italic;
 
-			for (auto& b : line->ParseTags())
+			auto blocks = line->GetParsedTags();
+			for (auto& b : *blocks)
 			{
 				switch (b->GetType())
 				{
@@ -309,8 +310,7 @@ namespace
 					case AssBlockType::OVERRIDE:
 					// find relevant tags and process them
 					{
-						AssDialogueBlockOverride *ob = static_cast<AssDialogueBlockOverride*>(b.get());
-						ob->ParseTags();
+						auto ob = static_cast<const AssDialogueBlockOverride*>(b.get());
 						ProcessOverrides(ob, underline, italic, align, style_underline, style_italic);
 
 						// apply any changes
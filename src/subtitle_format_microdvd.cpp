@@ -43,6 +43,7 @@
 #include <libaegisub/ass/time.h>
 #include <libaegisub/format.h>
 #include <libaegisub/fs.h>
+#include <libaegisub/sniff.h>
 #include <libaegisub/util.h>
 #include <libaegisub/vfr.h>
 
@@ -59,22 +60,23 @@ std::vector<std::string> MicroDVDSubtitleFormat::GetReadWildcards() const {
 	return {"sub"};
 }
 
+agi::sniff::Format MicroDVDSubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::MicroDvd;
+}
+
 std::vector<std::string> MicroDVDSubtitleFormat::GetWriteWildcards() const {
 	return GetReadWildcards();
 }
 
 static const boost::regex line_regex(R"(^[\{\[]([0-9]+)[\}\]][\{\[]([0-9]+)[\}\]](.*)$)");
 
-bool MicroDVDSubtitleFormat::CanReadFile(agi::fs::path const& filename, std::string const& encoding) const {
+bool MicroDVDSubtitleFormat::CanReadFile(agi::fs::path const& filename, std::string const&) const {
 	// Return false immediately if extension is wrong
 	if (!agi::fs::HasExtension(filename, "sub")) return false;
 
-	// Since there is an infinity of .sub formats, load first line and check if it's valid
-	TextFileReader file(filename, encoding);
-	if (file.HasMoreLines())
-		return regex_match(file.ReadLineFromFile(), line_regex);
-
-	return false;
+	// Since there is an infinity of .sub formats, check if the first line
+	// is valid
+	return agi::sniff::Sniff(filename).format == agi::sniff::Format::MicroDvd;
 }
 
 void MicroDVDSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& vfps, std::string const& encoding) const {
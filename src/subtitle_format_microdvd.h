@@ -39,6 +39,7 @@ public:
 	MicroDVDSubtitleFormat();
 
 	std::vector<std::string> GetReadWildcards() const override;
+	agi::sniff::Format SniffedFormat() const override;
 	std::vector<std::string> GetWriteWildcards() const override;
 
 	bool CanReadFile(agi::fs::path const& filename, std::string const& encoding) const override;
@@ -36,6 +36,8 @@
 
 #include "mkv_wrap.h"
 
+#include <libaegisub/sniff.h>
+
 MKVSubtitleFormat::MKVSubtitleFormat()
 : SubtitleFormat("Matroska")
 {
@@ -49,6 +51,10 @@ std::vector<std::string> MKVSubtitleFormat::GetReadWildcards() const {
 	return formats;
 }
 
+agi::sniff::Format MKVSubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::Matroska;
+}
+
 void MKVSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const&) const {
 	MatroskaWrapper::GetSubtitles(filename, target);
 }
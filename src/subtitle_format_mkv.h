@@ -38,6 +38,7 @@ class MKVSubtitleFormat final : public SubtitleFormat {
 public:
 	MKVSubtitleFormat();
 	std::vector<std::string> GetReadWildcards() const override;
+	agi::sniff::Format SniffedFormat() const override;
 
 	void ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& forceEncoding) const override;
 };
@@ -34,17 +34,30 @@
 
 #include "subtitle_format.h"
 
-class AssDialogue;
+#include <libaegisub/ass/srt.h>
+
+class TextFileWriter;
 
 class SRTSubtitleFormat final : public SubtitleFormat {
-	std::string ConvertTags(const AssDialogue *diag) const;
 public:
 	SRTSubtitleFormat();
 	std::vector<std::string> GetReadWildcards() const override;
+	agi::sniff::Format SniffedFormat() const override;
 	std::vector<std::string> GetWriteWildcards() const override;
 
 	bool CanSave(const AssFile *file) const override;
 
 	void ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& forceEncoding) const override;
 	void WriteFile(const AssFile *src, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& encoding) const override;
+
+	// WebVTT is close enough to SRT to share everything other than the
+	// details handled by agi::ass::SrtDialect
+
+	/// Read a SubRip or WebVTT file into target
+	static void ReadCues(AssFile *target, agi::fs::path const& filename, std::string const& encoding, agi::ass::SrtDialect dialect);
+	/// Write the dialogue lines of src as SubRip or WebVTT cues
+	static void WriteCues(const AssFile *src, TextFileWriter& file, agi::ass::SrtDialect dialect);
+	/// Check if src can be saved without losing anything other than the
+	/// given single-letter override tags
+	static bool CanSaveCues(const AssFile *file, const char *supported_tags);
 };
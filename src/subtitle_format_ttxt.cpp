@@ -40,6 +40,7 @@
 #include "options.h"
 
 #include <libaegisub/ass/time.h>
+#include <libaegisub/sniff.h>
 
 #include <wx/xml/xml.h>
 
@@ -54,6 +55,10 @@ std::vector<std::string> TTXTSubtitleFormat::GetReadWildcards() const {
 	return {"ttxt"};
 }
 
+agi::sniff::Format TTXTSubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::Ttxt;
+}
+
 std::vector<std::string> TTXTSubtitleFormat::GetWriteWildcards() const {
 	return GetReadWildcards();
 }
@@ -49,6 +49,7 @@ class TTXTSubtitleFormat final : public SubtitleFormat {
 public:
 	TTXTSubtitleFormat();
 	std::vector<std::string> GetReadWildcards() const override;
+	agi::sniff::Format SniffedFormat() const override;
 	std::vector<std::string> GetWriteWildcards() const override;
 
 	void ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const& fps, std::string const& forceEncoding) const override;
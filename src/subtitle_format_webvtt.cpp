@@ -0,0 +1,43 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include "subtitle_format_webvtt.h"
+
+#include "subtitle_format_srt.h"
+#include "text_file_writer.h"
+
+#include <libaegisub/sniff.h>
+
+agi::sniff::Format WebVttSubtitleFormat::SniffedFormat() const {
+	return agi::sniff::Format::WebVtt;
+}
+
+bool WebVttSubtitleFormat::CanSave(const AssFile *file) const {
+	return SRTSubtitleFormat::CanSaveCues(file, "biu");
+}
+
+void WebVttSubtitleFormat::ReadFile(AssFile *target, agi::fs::path const& filename, agi::vfr::Framerate const&, std::string const& encoding) const {
+	SRTSubtitleFormat::ReadCues(target, filename, encoding, agi::ass::SrtDialect::WebVtt);
+}
+
+void WebVttSubtitleFormat::WriteFile(const AssFile *src, agi::fs::path const& filename, agi::vfr::Framerate const&, std::string const&) const {
+	// WebVTT files are always UTF-8
+	TextFileWriter file(filename, "utf-8");
+	file.WriteLineToFile("WEBVTT");
+	file.WriteLineToFile("");
+	SRTSubtitleFormat::WriteCues(src, file, agi::ass::SrtDialect::WebVtt);
+}
@@ -19,13 +19,19 @@
 #include "ass_dialogue.h"
 #include "ass_attachment.h"
 #include "ass_file.h"
+#include "ass_file_snapshot.h"
 #include "ass_info.h"
 #include "ass_style.h"
 #include "factory_manager.h"
+#include "flyweight_hash.h"
 #include "options.h"
 #include "subtitles_provider_csri.h"
 #include "subtitles_provider_libass.h"
 
+#include <boost/algorithm/string/case_conv.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace {
 	struct factory {
 		std::string name;
@@ -44,6 +50,9 @@ namespace {
 		factories.push_back(factory{"libass", "", libass::Create, false});
 		return factories;
 	}
+
+	AssDialogue const& deref(AssDialogue const& line) { return line; }
+	AssDialogue const& deref(std::shared_ptr<const AssDialogue> const& line) { return *line; }
 }
 
 std::vector<std::string> SubtitlesProviderFactory::GetClasses() {
@@ -68,7 +77,8 @@ std::unique_ptr<SubtitlesProvider> SubtitlesProviderFactory::GetProvider(agi::Ba
 	throw error;
 }
 
-void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
+template<typename File>
+void SubtitlesProvider::LoadFile(File const& subs, int time) {
 	buffer.clear();
 
 	auto push_header = [&](const char *str) {
@@ -80,29 +90,57 @@ void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
 	};
 
 	push_header("\xEF\xBB\xBF[Script Info]\n");
-	for (auto const& line : subs->Info)
+	for (auto const& line : subs.Info)
 		push_line(line.GetEntryData());
 
+	std::unordered_set<std::string> styles;
 	push_header("[V4+ Styles]\n");
-	for (auto const& line : subs->Styles)
+	for (auto const& line : subs.Styles) {
 		push_line(line.GetEntryData());
+		styles.insert(boost::to_lower_copy(line.name));
+	}
 
-	if (!subs->Attachments.empty()) {
-		// TODO: some scripts may have a lot of attachments,
-		// so ideally we'd want to write only those actually used on the requested video frame,
-		// but this would require some pre-parsing of the attached font files with FreeType,
-		// which isn't probably trivial.
+	std::vector<const AssAttachment *> fonts;
+	for (auto const& attachment : subs.Attachments) {
+		if (attachment.Group() == AssEntryGroup::FONT)
+			fonts.push_back(&attachment);
+	}
+	if (!LoadFonts(fonts) && !fonts.empty()) {
 		push_header("[Fonts]\n");
-		for (auto const& attachment : subs->Attachments)
-			if (attachment.Group() == AssEntryGroup::FONT)
-				push_line(attachment.GetEntryData());
+		for (auto font : fonts)
+			push_line(font->GetEntryData());
 	}
 
+	// Style names are flyweights, so only check each distinct name once
+	std::unordered_map<agi::flyweight<std::string>, bool> style_exists;
+
 	push_header("[Events]\n");
-	for (auto const& line : subs->Events) {
-		if (!line.Comment && (time < 0 || !(line.Start > time || line.End <= time)))
+	for (auto const& entry : subs.Events) {
+		auto const& line = deref(entry);
+		if (line.Comment || (time >= 0 && (line.Start > time || line.End <= time)))
+			continue;
+
+		// Lines with a style which doesn't exist are drawn with Default,
+		// as AssFixStylesFilter does when exporting
+		auto it = style_exists.find(line.Style);
+		if (it == style_exists.end())
+			it = style_exists.emplace(line.Style, styles.count(boost::to_lower_copy(line.Style.get())) != 0).first;
+		if (it->second)
 			push_line(line.GetEntryData());
+		else {
+			AssDialogue fixed(line);
+			fixed.Style = "Default";
+			push_line(fixed.GetEntryData());
+		}
 	}
 
 	LoadSubtitles(&buffer[0], buffer.size());
 }
+
+void SubtitlesProvider::LoadSubtitles(AssFile *subs, int time) {
+	LoadFile(*subs, time);
+}
+
+void SubtitlesProvider::LoadSubtitles(AssFileSnapshot const& subs, int time) {
+	LoadFile(subs, time);
+}
@@ -34,6 +34,7 @@
 
 #include "subtitles_provider_libass.h"
 
+#include "ass_attachment.h"
 #include "compat.h"
 #include "include/aegisub/subtitles_provider.h"
 #include "video_frame.h"
@@ -43,12 +44,15 @@
 #include <libaegisub/exception.h>
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
+#include <libaegisub/trace.h>
 #include <libaegisub/util.h>
 
 #include <atomic>
 #include <boost/gil.hpp>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <wx/intl.h>
 #include <wx/thread.h>
@@ -79,9 +83,15 @@ void msg_callback(int level, const char *fmt, va_list args, void *) {
 // Stuff used on the cache thread, owned by a shared_ptr in case the provider
 // gets deleted before the cache finishing updating
 struct cache_thread_shared {
+	/// Each provider gets its own library so that the embedded fonts
+	/// registered with it are those of the provider's script
+	ASS_Library *library = nullptr;
 	ASS_Renderer *renderer = nullptr;
 	std::atomic<bool> ready{false};
-	~cache_thread_shared() { if (renderer) ass_renderer_done(renderer); }
+	~cache_thread_shared() {
+		if (renderer) ass_renderer_done(renderer);
+		if (library) ass_library_done(library);
+	}
 };
 
 class LibassSubtitlesProvider final : public SubtitlesProvider {
@@ -89,6 +99,20 @@ class LibassSubtitlesProvider final : public SubtitlesProvider {
 	std::shared_ptr<cache_thread_shared> shared;
 	ASS_Track* ass_track = nullptr;
 
+	/// Embedded fonts which have been registered with the library, keyed by
+	/// the address of their entry data. Attachments with the same contents
+	/// share their entry data, so this identifies a font without having to
+	/// hash its contents, and the copies stored here keep the data alive so
+	/// the address can't be reused by a different font.
+	std::unordered_map<std::string const*, AssAttachment> registered_fonts;
+	/// Fonts of the current script which haven't been registered yet
+	std::vector<AssAttachment> pending_fonts;
+	/// Has a registered font been removed from the script? libass can't
+	/// remove individual fonts, so they all have to be registered again.
+	bool clear_fonts = false;
+	/// Has anything been rendered with the current renderer?
+	bool rendered = false;
+
 	ASS_Renderer *renderer() {
 		if (shared->ready)
 			return shared->renderer;
@@ -121,10 +145,32 @@ public:
 
 	void LoadSubtitles(const char *data, size_t len) override {
 		if (ass_track) ass_free_track(ass_track);
-		ass_track = ass_read_memory(library, const_cast<char *>(data), len, nullptr);
+		ass_track = ass_read_memory(shared->library, const_cast<char *>(data), len, nullptr);
 		if (!ass_track) throw agi::InternalError("libass failed to load subtitles.");
 	}
 
+	bool LoadFonts(std::vector<const AssAttachment *> const& fonts) override {
+		// Decoding is deferred to the next draw both so that nothing is done
+		// for loads which never get drawn and so that fonts aren't added to
+		// the library while the cache thread is setting up the renderer
+		std::unordered_set<std::string const*> current;
+		for (auto font : fonts)
+			current.insert(&font->GetEntryData());
+		for (auto const& font : registered_fonts) {
+			if (!current.count(font.first))
+				clear_fonts = true;
+		}
+
+		pending_fonts.clear();
+		for (auto font : fonts) {
+			if (clear_fonts || !registered_fonts.count(&font->GetEntryData()))
+				pending_fonts.push_back(*font);
+		}
+		return true;
+	}
+
+	void RegisterPendingFonts();
+
 	void DrawSubtitles(VideoFrame &dst, double time) override;
 
 	void Reinitialize() override {
@@ -133,9 +179,10 @@ public:
 			return;
 
 		ass_renderer_done(shared->renderer);
-		shared->renderer = ass_renderer_init(library);
+		shared->renderer = ass_renderer_init(shared->library);
 		ass_set_font_scale(shared->renderer, 1.);
 		ass_set_fonts(shared->renderer, nullptr, "Sans", 1, nullptr, true);
+		rendered = false;
 	}
 };
 
@@ -143,9 +190,14 @@ LibassSubtitlesProvider::LibassSubtitlesProvider(agi::BackgroundRunner *br)
 : br(br)
 , shared(std::make_shared<cache_thread_shared>())
 {
+	shared->library = ass_library_init();
+	if (!shared->library)
+		throw agi::InternalError("libass failed to initialize.");
+	ass_set_message_cb(shared->library, msg_callback, nullptr);
+
 	auto state = shared;
 	cache_queue->Async([state] {
-		auto ass_renderer = ass_renderer_init(library);
+		auto ass_renderer = ass_renderer_init(state->library);
 		if (ass_renderer) {
 			ass_set_font_scale(ass_renderer, 1.);
 			ass_set_fonts(ass_renderer, nullptr, "Sans", 1, nullptr, true);
@@ -164,7 +216,43 @@ LibassSubtitlesProvider::~LibassSubtitlesProvider() {
 #define _b(c) (((c)>>8)&0xFF)
 #define _a(c) ((c)&0xFF)
 
+void LibassSubtitlesProvider::RegisterPendingFonts() {
+	if (pending_fonts.empty() && !clear_fonts) return;
+	AGI_TRACE_SCOPE("video", "libass::RegisterPendingFonts");
+
+	if (clear_fonts) {
+		ass_clear_fonts(shared->library);
+		registered_fonts.clear();
+	}
+
+	for (auto& font : pending_fonts) {
+		auto key = &font.GetEntryData();
+		if (registered_fonts.count(key)) continue;
+
+		auto data = font.Decode();
+		ass_add_font(shared->library, const_cast<char *>(font.GetFileName().c_str()),
+			data.data(), static_cast<int>(data.size()));
+		registered_fonts.emplace(key, std::move(font));
+	}
+	pending_fonts.clear();
+
+	// The renderer picks up newly added fonts on its own, but any family
+	// which has already been drawn with a fallback font stays cached, and
+	// fonts which have been cleared from the library stay in the renderer's
+	// font selection, so rebuild it if either has happened. fontconfig's
+	// cache was already brought up to date by CacheFonts() at startup, so
+	// don't make it rescan the system fonts on the render thread.
+	if (rendered || clear_fonts)
+		ass_set_fonts(renderer(), nullptr, "Sans", 1, nullptr, false);
+	clear_fonts = false;
+}
+
 void LibassSubtitlesProvider::DrawSubtitles(VideoFrame &frame,double time) {
+	// Make sure the renderer is ready before touching the library's fonts
+	renderer();
+	RegisterPendingFonts();
+	rendered = true;
+
 	ass_set_frame_size(renderer(), frame.width, frame.height);
 	// Note: this relies on Aegisub always rendering at video storage res
 	ass_set_storage_size(renderer(), frame.width, frame.height);
@@ -211,7 +299,7 @@ std::unique_ptr<SubtitlesProvider> Create(std::string const&, agi::BackgroundRun
 
 void CacheFonts() {
 	// Initialize the cache worker thread
-	cache_queue = agi::dispatch::Create();
+	cache_queue = agi::dispatch::Create(agi::dispatch::Priority::Low);
 
 	// Initialize libass
 	library = ass_library_init();
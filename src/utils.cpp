@@ -37,6 +37,7 @@
 #include <libaegisub/dispatch.h>
 #include <libaegisub/fs.h>
 #include <libaegisub/log.h>
+#include <libaegisub/persist.h>
 
 #ifdef __UNIX__
 #include <unistd.h>
@@ -76,15 +77,6 @@ wxString PrettySize(int bytes) {
 	return agi::wxformat(fmt, size) + " " + suffix[i];
 }
 
-std::string float_to_string(double val, int precision) {
-	std::string fmt = "%." + std::to_string(precision) + "f";
-	std::string s = agi::format(fmt, val);
-	size_t pos = s.find_last_not_of("0");
-	if (pos != s.find(".")) ++pos;
-	s.erase(begin(s) + pos, end(s));
-	return s;
-}
-
 int SmallestPowerOf2(int x) {
 	x--;
 	x |= (x >> 1);
@@ -99,6 +91,7 @@ int SmallestPowerOf2(int x) {
 #ifndef __WXMAC__
 void RestartAegisub() {
 	config::opt->Flush();
+	agi::persist::Flush();
 
 #if defined(__WXMSW__)
 	wxExecute("\"" + wxStandardPaths::Get().GetExecutablePath() + "\"");
@@ -159,7 +152,7 @@ void SetClipboard(wxBitmap const& new_data) {
 void CleanCache(agi::fs::path const& directory, std::string const& file_type, uint64_t max_size, uint64_t max_files) {
 	static std::unique_ptr<agi::dispatch::Queue> queue;
 	if (!queue)
-		queue = agi::dispatch::Create();
+		queue = agi::dispatch::Create(agi::dispatch::Priority::Low);
 
 	max_size <<= 20;
 	if (max_files == 0)
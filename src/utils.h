@@ -44,8 +44,6 @@ class wxWindow;
 
 wxString PrettySize(int bytes);
 
-std::string float_to_string(double val, int precision = 3);
-
 /// @brief Get the smallest power of two that is greater or equal to x
 ///
 /// Algorithm from http://bob.allegronetwork.com/prog/tricks.html
@@ -26,7 +26,9 @@
 #include <libaegisub/path.h>
 #include <libaegisub/util.h>
 
+#include <algorithm>
 #include <boost/algorithm/string/replace.hpp>
+#include <vector>
 
 void SetStringVar(const VSAPI *api, VSMap *map, std::string variable, std::string value) {
 	if (api->mapSetData(map, variable.c_str(), value.c_str(), -1, dtUtf8, 1))
@@ -123,4 +125,91 @@ void VSCleanCache() {
 		OPT_GET("Provider/VapourSynth/Cache/Files")->GetInt());
 }
 
+VSFrameRequests::VSFrameRequests(const VSAPI *api, VSNode *node, int window)
+: api(api)
+, node(node)
+, window(std::max(1, window))
+{
+	if (api->getNodeType(node) == mtVideo)
+		frame_count = api->getVideoInfo(node)->numFrames;
+	else
+		frame_count = api->getAudioInfo(node)->numFrames;
+}
+
+VSFrameRequests::~VSFrameRequests() {
+	std::unique_lock<std::mutex> l(lock);
+	cv.wait(l, [&] {
+		for (auto const& request : requests) {
+			if (!request.second.done) return false;
+		}
+		return true;
+	});
+	for (auto const& request : requests) {
+		if (request.second.frame)
+			api->freeFrame(request.second.frame);
+	}
+}
+
+void VS_CC VSFrameRequests::FrameDone(void *userData, const VSFrame *frame, int n, VSNode *, const char *error) {
+	auto self = static_cast<VSFrameRequests *>(userData);
+	std::lock_guard<std::mutex> l(self->lock);
+	auto& request = self->requests[n];
+	request.frame = frame;
+	if (!frame)
+		request.error = error ? error : "Unknown error";
+	request.done = true;
+	self->cv.notify_all();
+}
+
+void VSFrameRequests::RequestRange(std::unique_lock<std::mutex>& l, int first, int last) {
+	std::vector<int> missing;
+	for (int n = std::max(first, 0); n < std::min(last, frame_count); ++n) {
+		if (requests.emplace(n, Request()).second)
+			missing.push_back(n);
+	}
+	if (missing.empty()) return;
+
+	// The callback can be invoked before getFrameAsync returns
+	l.unlock();
+	for (int n : missing)
+		api->getFrameAsync(n, node, FrameDone, this);
+	l.lock();
+}
+
+void VSFrameRequests::Request(int first, int last) {
+	std::unique_lock<std::mutex> l(lock);
+	wanted_end = last;
+	RequestRange(l, first, last);
+}
+
+const VSFrame *VSFrameRequests::Get(int n) {
+	if (n < 0 || n >= frame_count)
+		throw VapourSynthError(agi::format("Error getting frame: frame %d out of range", n));
+
+	std::unique_lock<std::mutex> l(lock);
+	RequestRange(l, n, n + window);
+	cv.wait(l, [&] { return requests[n].done; });
+
+	auto request = std::move(requests[n]);
+	requests.erase(n);
+
+	// Free anything which finished but is no longer wanted, such as the
+	// frames after the previous position when seeking
+	int keep_end = std::max(n + window, wanted_end);
+	for (auto it = begin(requests); it != end(requests); ) {
+		if (it->second.done && (it->first < n || it->first >= keep_end)) {
+			if (it->second.frame)
+				api->freeFrame(it->second.frame);
+			it = requests.erase(it);
+		}
+		else
+			++it;
+	}
+	l.unlock();
+
+	if (!request.frame)
+		throw VapourSynthError(agi::format("Error getting frame: %s", request.error));
+	return request.frame;
+}
+
 #endif // WITH_VAPOURSYNTH
@@ -19,8 +19,64 @@
 
 #include <libaegisub/fs_fwd.h>
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
 int OpenScriptOrVideo(const VSAPI *api, const VSSCRIPTAPI *sapi, VSScript *script, agi::fs::path const& filename, std::string default_script);
 void VSCleanCache();
 void VSLogToProgressSink(int msgType, const char *msg, void *userData);
 
+/// @class VSFrameRequests
+/// @brief Keeps a window of asynchronous frame requests outstanding ahead of
+///        the frames being read from a node
+///
+/// VapourSynth only spreads a filter chain over the core's threads when
+/// several frames have been requested at once, so fetching frames one at a
+/// time with getFrame leaves all but one of them idle.
+class VSFrameRequests {
+	struct Request {
+		const VSFrame *frame = nullptr;
+		std::string error;
+		bool done = false;
+	};
+
+	const VSAPI *api;
+	VSNode *node;
+	int frame_count;
+	int window;
+
+	std::mutex lock;
+	std::condition_variable cv;
+	/// Requests which are outstanding or completed but not yet taken
+	std::map<int, Request> requests;
+	/// End of the most recent range passed to Request()
+	int wanted_end = 0;
+
+	static void VS_CC FrameDone(void *self, const VSFrame *frame, int n, VSNode *, const char *error);
+
+	/// Start requests for any frames in [first, last) which haven't been
+	/// requested yet. lock must be held, and is released while requesting.
+	void RequestRange(std::unique_lock<std::mutex>& l, int first, int last);
+
+public:
+	/// @param api VapourSynth API
+	/// @param node Node to get frames from, which must outlive this object
+	/// @param window Number of frames to request ahead of the frame being read
+	VSFrameRequests(const VSAPI *api, VSNode *node, int window);
+	~VSFrameRequests();
+
+	/// Request a range of frames which will be read soon
+	void Request(int first, int last);
+
+	/// @brief Get a frame, waiting for it to be produced if needed
+	/// @return Frame, which the caller must free
+	///
+	/// Also requests the following frames so that they're ready by the time
+	/// they're wanted when reading sequentially, and discards finished frames
+	/// which are no longer near what's being read.
+	const VSFrame *Get(int n);
+};
+
 #endif // WITH_VAPOURSYNTH
@@ -24,6 +24,7 @@
 #include "utils.h"
 
 #include <libaegisub/format.h>
+#include <libaegisub/util.h>
 
 #include <limits>
 
@@ -88,5 +89,5 @@ std::string Vector2D::DStr(char sep) const {
 }
 
 std::string Vector2D::Str(char sep) const {
-	return float_to_string(x,2) + sep + float_to_string(y,2);
+	return agi::util::float_to_string(x,2) + sep + agi::util::float_to_string(y,2);
 }
@@ -24,6 +24,7 @@
 #include "utils.h"
 
 #include <libaegisub/format.h>
+#include <libaegisub/util.h>
 
 #include <cmath>
 #include <limits>
@@ -95,5 +96,5 @@ std::string Vector3D::DStr(char sep) const {
 }
 
 std::string Vector3D::Str(char sep) const {
-	return float_to_string(x,2) + sep + float_to_string(y,2) + sep + float_to_string(z, 2);
+	return agi::util::float_to_string(x,2) + sep + agi::util::float_to_string(y,2) + sep + agi::util::float_to_string(z, 2);
 }
@@ -80,7 +80,7 @@ void VideoController::OnSubtitlesCommit(int type, const AssDialogue *changed) {
 	if (!changed)
 		provider->LoadSubtitles(context->ass.get());
 	else
-		provider->UpdateSubtitles(context->ass.get(), changed);
+		provider->UpdateSubtitles(context->ass.get());
 }
 
 void VideoController::OnActiveLineChanged(AssDialogue *line) {
@@ -145,8 +145,9 @@ void VideoController::Play() {
 
 	context->audioController->PlayToEnd(start_ms);
 
+	provider->StartPlayback(frame_n, end_frame, context->project->Timecodes());
 	playback_start_time = std::chrono::steady_clock::now();
-	playback.Start(10);
+	playback.Start(5);
 }
 
 void VideoController::PlayLine() {
@@ -164,27 +165,53 @@ void VideoController::PlayLine() {
 
 	JumpToFrame(startFrame);
 
+	provider->StartPlayback(startFrame, end_frame, context->project->Timecodes());
 	playback_start_time = std::chrono::steady_clock::now();
-	playback.Start(10);
+	playback.Start(5);
 }
 
 void VideoController::Stop() {
 	if (IsPlaying()) {
 		playback.Stop();
+		provider->StopPlayback();
 		context->audioController->Stop();
 	}
 }
 
-void VideoController::OnPlayTimer(wxTimerEvent &) {
+int VideoController::GetPlaybackClock() {
 	using namespace std::chrono;
-	int next_frame = FrameAtTime(start_ms + duration_cast<milliseconds>(steady_clock::now() - playback_start_time).count());
-	if (next_frame == frame_n) return;
+	auto now = steady_clock::now();
+
+	// Follow the audio when it's playing so that the video stays in sync
+	// with it even if the audio device's clock drifts from the system
+	// clock, and fall back to the system clock when there's no audio or it
+	// has run out before the video. The system clock is kept in step with
+	// the audio so that there's no jump when switching between them.
+	if (context->audioController->IsPlaying()) {
+		int ms = context->audioController->GetPlaybackPosition();
+		playback_start_time = now - milliseconds(ms - start_ms);
+		return ms;
+	}
+	return start_ms + duration_cast<milliseconds>(now - playback_start_time).count();
+}
 
-	if (next_frame >= end_frame)
+void VideoController::OnPlayTimer(wxTimerEvent &) {
+	int ms = GetPlaybackClock();
+	if (FrameAtTime(ms) >= end_frame) {
 		Stop();
-	else {
-		frame_n = next_frame;
-		RequestFrame();
+		return;
+	}
+
+	AsyncVideoProvider::QueuedFrame frame;
+	if (!provider->PresentFrame(ms, frame)) return;
+
+	FrameReadyEvent evt(std::move(frame.frame), frame.time);
+	evt.SetEventType(EVT_FRAME_READY);
+	ProcessEvent(evt);
+
+	if (frame.frame_n != frame_n) {
+		frame_n = frame.frame_n;
+		context->ass->Properties.video_position = frame_n;
 		Seek(frame_n);
 	}
 }
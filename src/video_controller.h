@@ -70,11 +70,12 @@ class VideoController final : public wxEvtHandler {
 	/// Last seen script color matrix
 	std::string color_matrix;
 
-	/// Playback timer used to periodically check if we should go to the next
-	/// frame while playing video
+	/// Playback timer used to periodically present the next frame from the
+	/// provider's playback queue while playing video
 	wxTimer playback;
 
-	/// Time when playback was last started
+	/// Time when playback was last started, adjusted to match the audio
+	/// clock while audio is playing
 	std::chrono::steady_clock::time_point playback_start_time;
 
 	/// The start time of the first frame of the current playback; undefined if
@@ -102,6 +103,9 @@ class VideoController final : public wxEvtHandler {
 
 	void OnPlayTimer(wxTimerEvent &event);
 
+	/// Get the current playback position in milliseconds
+	int GetPlaybackClock();
+
 	void OnVideoError(VideoProviderErrorEvent const& err);
 	void OnSubtitlesError(SubtitlesProviderErrorEvent const& err);
 
@@ -28,9 +28,15 @@
 #include <libaegisub/log.h>
 #include <libaegisub/make_unique.h>
 #include <libaegisub/path.h>
+#include <libaegisub/trace.h>
 
 #include <mutex>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGI_VS_INTERLEAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "vapoursynth_wrap.h"
 #include "vapoursynth_common.h"
 #include "VSScript4.h"
@@ -47,6 +53,7 @@ class VapourSynthVideoProvider: public VideoProvider {
 	VSScript *script = nullptr;
 	VSNode *node = nullptr;
 	const VSVideoInfo *vi = nullptr;
+	std::unique_ptr<VSFrameRequests> requests;
 
 	double dar = 0;
 	agi::vfr::Framerate fps;
@@ -299,6 +306,11 @@ VapourSynthVideoProvider::VapourSynthVideoProvider(agi::fs::path const& filename
 		const VSFrame *rgbframe = GetVSFrame(0);
 		vs.GetAPI()->freeFrame(rgbframe);
 	}
+
+	// Keep as many frames in flight as the core has threads to filter them
+	VSCoreInfo core_info;
+	vs.GetAPI()->getCoreInfo(vs.GetScriptAPI()->getCore(script), &core_info);
+	requests = agi::make_unique<VSFrameRequests>(vs.GetAPI(), node, core_info.numThreads);
 } catch (VapourSynthError const& err) {     // for try inside of function. We need both here since we need to catch errors from the VapourSynthWrap constructor.
 	if (node != nullptr)
 		vs.GetAPI()->freeNode(node);
@@ -320,13 +332,44 @@ const VSFrame *VapourSynthVideoProvider::GetVSFrame(int n) {
 	return frame;
 }
 
+/// Interleave a row of planar RGB into BGRA
+static void interleave_row(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, int width) {
+	int x = 0;
+#ifdef AGI_VS_INTERLEAVE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 16 <= width; x += 16) {
+		__m128i rv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r + x));
+		__m128i gv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g + x));
+		__m128i bv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+
+		__m128i bg_lo = _mm_unpacklo_epi8(bv, gv);
+		__m128i bg_hi = _mm_unpackhi_epi8(bv, gv);
+		__m128i ra_lo = _mm_unpacklo_epi8(rv, zero);
+		__m128i ra_hi = _mm_unpackhi_epi8(rv, zero);
+
+		auto out = reinterpret_cast<__m128i *>(dst + x * 4);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bg_lo, ra_lo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bg_lo, ra_lo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bg_hi, ra_hi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bg_hi, ra_hi));
+	}
+#endif
+	for (; x < width; ++x) {
+		dst[x * 4 + 0] = b[x];
+		dst[x * 4 + 1] = g[x];
+		dst[x * 4 + 2] = r[x];
+		dst[x * 4 + 3] = 0;
+	}
+}
+
 void VapourSynthVideoProvider::GetFrame(int n, VideoFrame &out) {
-	std::lock_guard<std::mutex> lock(vs.GetMutex());
+	AGI_TRACE_SCOPE("video", "VapourSynth::GetFrame");
 
-	const VSFrame *frame = GetVSFrame(n);
+	const VSFrame *frame = requests->Get(n);
 
 	const VSVideoFormat *format = vs.GetAPI()->getVideoFrameFormat(frame);
 	if (format->colorFamily != cfRGB || format->numPlanes != 3 || format->bitsPerSample != 8 || format->subSamplingH != 0 || format->subSamplingW != 0) {
+		vs.GetAPI()->freeFrame(frame);
 		throw VapourSynthError("Frame not in RGB24 format");
 	}
 
@@ -337,29 +380,24 @@ void VapourSynthVideoProvider::GetFrame(int n, VideoFrame &out) {
 
 	out.data.resize(out.pitch * out.height);
 
-	for (int p = 0; p < format->numPlanes; p++) {
-		ptrdiff_t stride = vs.GetAPI()->getStride(frame, p);
-		const uint8_t *readPtr = vs.GetAPI()->getReadPtr(frame, p);
-		uint8_t *writePtr = &out.data[2 - p];
-		int rows = vs.GetAPI()->getFrameHeight(frame, p);
-		int cols = vs.GetAPI()->getFrameWidth(frame, p);
-
-		for (int row = 0; row < rows; row++) {
-			const uint8_t *rowPtr = readPtr;
-			uint8_t *rowWritePtr = writePtr;
-			for (int col = 0; col < cols; col++) {
-				*rowWritePtr = *rowPtr++;
-				rowWritePtr += 4;
-			}
-			readPtr += stride;
-			writePtr += out.pitch;
-		}
+	const uint8_t *planes[3];
+	ptrdiff_t strides[3];
+	for (int p = 0; p < 3; p++) {
+		planes[p] = vs.GetAPI()->getReadPtr(frame, p);
+		strides[p] = vs.GetAPI()->getStride(frame, p);
+	}
+
+	for (int row = 0; row < out.height; row++) {
+		interleave_row(planes[0] + row * strides[0], planes[1] + row * strides[1], planes[2] + row * strides[2],
+			&out.data[row * out.pitch], out.width);
 	}
 
 	vs.GetAPI()->freeFrame(frame);
 }
 
 VapourSynthVideoProvider::~VapourSynthVideoProvider() {
+	// Wait for any outstanding requests before freeing the node
+	requests.reset();
 	if (node != nullptr) {
 		vs.GetAPI()->freeNode(node);
 	}
@@ -345,7 +345,7 @@ void VisualTool<FeatureType>::RemoveSelection(FeatureType *feat) {
 typedef const std::vector<AssOverrideParameter> * param_vec;
 
 // Find a tag's parameters in a line or return nullptr if it's not found
-static param_vec find_tag(std::vector<std::unique_ptr<AssDialogueBlock>>& blocks, std::string const& tag_name) {
+static param_vec find_tag(AssParsedText const& blocks, std::string const& tag_name) {
 	for (auto ovr : blocks | agi::of_type<AssDialogueBlockOverride>()) {
 		for (auto const& tag : ovr->Tags) {
 			if (tag.Name == tag_name)
@@ -368,10 +368,10 @@ static Vector2D vec_or_bad(param_vec tag, size_t x_idx, size_t y_idx) {
 }
 
 Vector2D VisualToolBase::GetLinePosition(AssDialogue *diag) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (Vector2D ret = vec_or_bad(find_tag(blocks, "\\pos"), 0, 1)) return ret;
-	if (Vector2D ret = vec_or_bad(find_tag(blocks, "\\move"), 0, 1)) return ret;
+	if (Vector2D ret = vec_or_bad(find_tag(*blocks, "\\pos"), 0, 1)) return ret;
+	if (Vector2D ret = vec_or_bad(find_tag(*blocks, "\\move"), 0, 1)) return ret;
 
 	// Get default position
 	auto margin = diag->Margin;
@@ -387,9 +387,9 @@ Vector2D VisualToolBase::GetLinePosition(AssDialogue *diag) {
 
 	param_vec align_tag;
 	int ovr_align = 0;
-	if ((align_tag = find_tag(blocks, "\\an")))
+	if ((align_tag = find_tag(*blocks, "\\an")))
 		ovr_align = (*align_tag)[0].Get<int>(ovr_align);
-	else if ((align_tag = find_tag(blocks, "\\a")))
+	else if ((align_tag = find_tag(*blocks, "\\a")))
 		ovr_align = AssStyle::SsaToAss((*align_tag)[0].Get<int>(2));
 
 	if (ovr_align > 0 && ovr_align <= 9)
@@ -419,14 +419,14 @@ Vector2D VisualToolBase::GetLinePosition(AssDialogue *diag) {
 }
 
 Vector2D VisualToolBase::GetLineOrigin(AssDialogue *diag) {
-	auto blocks = diag->ParseTags();
-	return vec_or_bad(find_tag(blocks, "\\org"), 0, 1);
+	auto blocks = diag->GetParsedTags();
+	return vec_or_bad(find_tag(*blocks, "\\org"), 0, 1);
 }
 
 bool VisualToolBase::GetLineMove(AssDialogue *diag, Vector2D &p1, Vector2D &p2, int &t1, int &t2) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	param_vec tag = find_tag(blocks, "\\move");
+	param_vec tag = find_tag(*blocks, "\\move");
 	if (!tag)
 		return false;
 
@@ -445,26 +445,26 @@ void VisualToolBase::GetLineRotation(AssDialogue *diag, float &rx, float &ry, fl
 	if (AssStyle *style = c->ass->GetStyle(diag->Style))
 		rz = style->angle;
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (param_vec tag = find_tag(blocks, "\\frx"))
+	if (param_vec tag = find_tag(*blocks, "\\frx"))
 		rx = tag->front().Get(rx);
-	if (param_vec tag = find_tag(blocks, "\\fry"))
+	if (param_vec tag = find_tag(*blocks, "\\fry"))
 		ry = tag->front().Get(ry);
-	if (param_vec tag = find_tag(blocks, "\\frz"))
+	if (param_vec tag = find_tag(*blocks, "\\frz"))
 		rz = tag->front().Get(rz);
-	else if ((tag = find_tag(blocks, "\\fr")))
+	else if ((tag = find_tag(*blocks, "\\fr")))
 		rz = tag->front().Get(rz);
 }
 
 void VisualToolBase::GetLineShear(AssDialogue *diag, float& fax, float& fay) {
 	fax = fay = 0.f;
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (param_vec tag = find_tag(blocks, "\\fax"))
+	if (param_vec tag = find_tag(*blocks, "\\fax"))
 		fax = tag->front().Get(fax);
-	if (param_vec tag = find_tag(blocks, "\\fay"))
+	if (param_vec tag = find_tag(*blocks, "\\fay"))
 		fay = tag->front().Get(fay);
 }
 
@@ -476,11 +476,11 @@ void VisualToolBase::GetLineScale(AssDialogue *diag, Vector2D &scale) {
 		y = style->scaley;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (param_vec tag = find_tag(blocks, "\\fscx"))
+	if (param_vec tag = find_tag(*blocks, "\\fscx"))
 		x = tag->front().Get(x);
-	if (param_vec tag = find_tag(blocks, "\\fscy"))
+	if (param_vec tag = find_tag(*blocks, "\\fscy"))
 		y = tag->front().Get(y);
 
 	scale = Vector2D(x, y);
@@ -494,15 +494,15 @@ void VisualToolBase::GetLineOutline(AssDialogue *diag, Vector2D &outline) {
 		y = style->outline_w;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (param_vec tag = find_tag(blocks, "\\bord")) {
+	if (param_vec tag = find_tag(*blocks, "\\bord")) {
 		x = tag->front().Get(x);
 		y = tag->front().Get(y);
 	}
-	if (param_vec tag = find_tag(blocks, "\\xbord"))
+	if (param_vec tag = find_tag(*blocks, "\\xbord"))
 		x = tag->front().Get(x);
-	if (param_vec tag = find_tag(blocks, "\\ybord"))
+	if (param_vec tag = find_tag(*blocks, "\\ybord"))
 		y = tag->front().Get(y);
 
 	outline = Vector2D(x, y);
@@ -516,15 +516,15 @@ void VisualToolBase::GetLineShadow(AssDialogue *diag, Vector2D &shadow) {
 		y = style->shadow_w;
 	}
 
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
-	if (param_vec tag = find_tag(blocks, "\\shad")) {
+	if (param_vec tag = find_tag(*blocks, "\\shad")) {
 		x = tag->front().Get(x);
 		y = tag->front().Get(y);
 	}
-	if (param_vec tag = find_tag(blocks, "\\xshad"))
+	if (param_vec tag = find_tag(*blocks, "\\xshad"))
 		x = tag->front().Get(x);
-	if (param_vec tag = find_tag(blocks, "\\yshad"))
+	if (param_vec tag = find_tag(*blocks, "\\yshad"))
 		y = tag->front().Get(y);
 
 	shadow = Vector2D(x, y);
@@ -535,8 +535,8 @@ int VisualToolBase::GetLineAlignment(AssDialogue *diag) {
 
 	if (AssStyle *style = c->ass->GetStyle(diag->Style))
 		an = style->alignment;
-	auto blocks = diag->ParseTags();
-	if (param_vec tag = find_tag(blocks, "\\an"))
+	auto blocks = diag->GetParsedTags();
+	if (param_vec tag = find_tag(*blocks, "\\an"))
 		an = tag->front().Get(an);
 
 	return an;
@@ -553,13 +553,13 @@ std::pair<Vector2D, Vector2D> VisualToolBase::GetLineBaseExtents(AssDialogue *di
 		style.scaley = 100.;
 	}
 
-	auto blocks = diag->ParseTags();
-	param_vec ptag = find_tag(blocks, "\\p");
+	auto blocks = diag->GetParsedTags();
+	param_vec ptag = find_tag(*blocks, "\\p");
 
 	if (ptag && ptag->front().Get(0)) {		// A drawing
 		Spline spline;
 		spline.SetScale(ptag->front().Get(1));
-		std::string drawing_text = join(blocks | agi::of_type<AssDialogueBlockDrawing>() | boost::adaptors::transformed([&](AssDialogueBlock *d) { return d->GetText(); }), "");
+		std::string drawing_text = join(*blocks | agi::of_type<AssDialogueBlockDrawing>() | boost::adaptors::transformed([&](const AssDialogueBlock *d) { return d->GetText(); }), "");
 		spline.DecodeFromAss(drawing_text);
 
 		if (!spline.size())
@@ -581,9 +581,9 @@ std::pair<Vector2D, Vector2D> VisualToolBase::GetLineBaseExtents(AssDialogue *di
 
 		return std::make_pair(Vector2D(left, top), Vector2D(right, bot));
 	} else {
-		if (param_vec tag = find_tag(blocks, "\\fs"))
+		if (param_vec tag = find_tag(*blocks, "\\fs"))
 			style.fontsize = tag->front().Get(style.fontsize);
-		if (param_vec tag = find_tag(blocks, "\\fn"))
+		if (param_vec tag = find_tag(*blocks, "\\fn"))
 			style.font = tag->front().Get(style.font);
 
 		std::string text = diag->GetStrippedText();
@@ -611,12 +611,12 @@ std::pair<Vector2D, Vector2D> VisualToolBase::GetLineBaseExtents(AssDialogue *di
 void VisualToolBase::GetLineClip(AssDialogue *diag, Vector2D &p1, Vector2D &p2, bool &inverse) {
 	inverse = false;
 
-	auto blocks = diag->ParseTags();
-	param_vec tag = find_tag(blocks, "\\iclip");
+	auto blocks = diag->GetParsedTags();
+	param_vec tag = find_tag(*blocks, "\\iclip");
 	if (tag)
 		inverse = true;
 	else
-		tag = find_tag(blocks, "\\clip");
+		tag = find_tag(*blocks, "\\clip");
 
 	if (tag && tag->size() == 4) {
 		p1 = vec_or_bad(tag, 0, 1);
@@ -629,16 +629,16 @@ void VisualToolBase::GetLineClip(AssDialogue *diag, Vector2D &p1, Vector2D &p2,
 }
 
 std::string VisualToolBase::GetLineVectorClip(AssDialogue *diag, int &scale, bool &inverse) {
-	auto blocks = diag->ParseTags();
+	auto blocks = diag->GetParsedTags();
 
 	scale = 1;
 	inverse = false;
 
-	param_vec tag = find_tag(blocks, "\\iclip");
+	param_vec tag = find_tag(*blocks, "\\iclip");
 	if (tag)
 		inverse = true;
 	else
-		tag = find_tag(blocks, "\\clip");
+		tag = find_tag(*blocks, "\\clip");
 
 	if (tag && tag->size() == 4) {
 		return agi::format("m %.2f %.2f l %.2f %.2f %.2f %.2f %.2f %.2f"
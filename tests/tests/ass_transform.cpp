@@ -0,0 +1,117 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/transform.h>
+#include <libaegisub/dispatch.h>
+
+#include <random>
+
+using agi::ass::FramerateTransform;
+using agi::ass::TransformDrawing;
+
+TEST(lagi_ass_transform, drawing) {
+	EXPECT_EQ("m 20 10 l 220 35", TransformDrawing("m 0 0 l 100 50", 10, 20, 2, 0.5));
+	EXPECT_EQ("m 0.125 0.5", TransformDrawing("m 0.1 0.49", 0, 0, 1, 1));
+	EXPECT_EQ("m 1 2 b 3 4 5 6 7 8", TransformDrawing("M 1 2 B 3 4 5 6 7 8", 0, 0, 1, 1));
+	EXPECT_EQ("m 1 2", TransformDrawing("m 1 2 q", 0, 0, 1, 1));
+	EXPECT_EQ("", TransformDrawing("", 0, 0, 1, 1));
+}
+
+TEST(lagi_ass_transform, framerate_tags) {
+	FramerateTransform transform(agi::vfr::Framerate(25, 1), agi::vfr::Framerate(50, 1));
+	FramerateTransform::Line line(transform, 1000, 2000);
+	EXPECT_EQ(500, line.Start());
+	EXPECT_EQ(1000, line.End());
+
+	EXPECT_EQ(250, line.RelativeToStart(500));
+	EXPECT_EQ(250, line.RelativeToEnd(500));
+	// Zero means the end of the line, so anything else must not become it
+	EXPECT_EQ(0, line.RelativeToStart(0));
+	EXPECT_EQ(1, line.RelativeToStart(1));
+
+	EXPECT_EQ(25, line.Karaoke(50));
+	EXPECT_EQ(25, line.Karaoke(50));
+}
+
+namespace {
+struct TransformedLine {
+	int start, end;
+	std::vector<int> tags;
+	std::string drawing;
+
+	bool operator==(TransformedLine const& o) const {
+		return start == o.start && end == o.end && tags == o.tags && drawing == o.drawing;
+	}
+};
+
+struct SourceLine {
+	int start, end;
+	/// Tag kind (0: relative to start, 1: relative to end, 2: karaoke) and value
+	std::vector<std::pair<int, int>> tags;
+	std::string drawing;
+};
+
+TransformedLine transform_line(FramerateTransform const& transform, SourceLine const& src) {
+	FramerateTransform::Line line(transform, src.start, src.end);
+	TransformedLine ret{line.Start(), line.End(), {}, TransformDrawing(src.drawing, 12, -7, 1.5, 0.75)};
+	for (auto const& tag : src.tags) {
+		switch (tag.first) {
+			case 0: ret.tags.push_back(line.RelativeToStart(tag.second)); break;
+			case 1: ret.tags.push_back(line.RelativeToEnd(tag.second)); break;
+			default: ret.tags.push_back(line.Karaoke(tag.second)); break;
+		}
+	}
+	return ret;
+}
+}
+
+TEST(lagi_ass_transform, parallel_matches_serial) {
+	std::mt19937 rng(39);
+
+	// Variable frame rate output so that the conversion isn't a plain ratio
+	std::vector<int> timecodes{0};
+	std::uniform_int_distribution<int> frame_length(30, 50);
+	for (int i = 0; i < 100000; ++i)
+		timecodes.push_back(timecodes.back() + frame_length(rng));
+	FramerateTransform transform(agi::vfr::Framerate(24000, 1001), agi::vfr::Framerate(timecodes));
+
+	std::uniform_int_distribution<int> time(0, 3000000), length(0, 10000), kind(0, 2), value(0, 2000), coord(-5000, 5000);
+	std::vector<SourceLine> lines(20000);
+	for (auto& line : lines) {
+		line.start = time(rng);
+		line.end = line.start + length(rng);
+		for (int i = kind(rng) * 3; i > 0; --i)
+			line.tags.emplace_back(kind(rng), value(rng));
+		line.drawing = "m";
+		for (int i = kind(rng) * 4; i > 0; --i)
+			line.drawing += " " + std::to_string(coord(rng) / 8.0);
+	}
+
+	std::vector<TransformedLine> serial;
+	for (auto const& line : lines)
+		serial.push_back(transform_line(transform, line));
+
+	std::vector<TransformedLine> parallel(lines.size());
+	agi::dispatch::ParallelFor(lines.size(), 256, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			parallel[i] = transform_line(transform, lines[i]);
+	});
+
+	for (size_t i = 0; i < lines.size(); ++i)
+		ASSERT_TRUE(serial[i] == parallel[i]) << "line " << i;
+}
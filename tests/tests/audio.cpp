@@ -228,6 +228,86 @@ TEST(lagi_audio, hd_cache) {
 		ASSERT_EQ(static_cast<uint16_t>((1 << 22) - 256 + i), buff[i]);
 }
 
+TEST(lagi_audio, block_cache) {
+	auto provider = agi::CreateBlockCacheAudioProvider(agi::make_unique<TestAudioProvider<>>(), 1 << 20);
+	EXPECT_EQ(provider->GetNumSamples(), provider->GetDecodedSamples());
+
+	uint16_t buff[512];
+	provider->GetAudio(buff, (1 << 16) - 256, 512); // Stride two cache blocks
+	for (size_t i = 0; i < 512; ++i)
+		ASSERT_EQ(static_cast<uint16_t>((1 << 16) - 256 + i), buff[i]);
+
+	auto stats = provider->GetCacheStats();
+	EXPECT_EQ(0u, stats.hits);
+	EXPECT_EQ(2u, stats.misses);
+
+	provider->GetAudio(buff, 100, 512);
+	EXPECT_EQ(1u, provider->GetCacheStats().hits);
+}
+
+TEST(lagi_audio, block_cache_stays_within_limit) {
+	// Each block is 128 KB, so this fits four
+	auto provider = agi::CreateBlockCacheAudioProvider(agi::make_unique<TestAudioProvider<>>(), 512 * 1024);
+
+	uint16_t buff[16];
+	for (int64_t block = 0; block < 20; ++block) {
+		provider->GetAudio(buff, block << 16, 16);
+		ASSERT_EQ(static_cast<uint16_t>(block << 16), buff[0]);
+	}
+
+	auto stats = provider->GetCacheStats();
+	EXPECT_EQ(20u, stats.misses);
+	EXPECT_EQ(16u, stats.evictions);
+	EXPECT_EQ(512u * 1024u, stats.bytes);
+
+	// The most recently used blocks are still cached but the first aren't
+	provider->GetAudio(buff, 19 << 16, 16);
+	EXPECT_EQ(1u, provider->GetCacheStats().hits);
+	provider->GetAudio(buff, 0, 16);
+	EXPECT_EQ(21u, provider->GetCacheStats().misses);
+}
+
+TEST(lagi_audio, block_cache_prefetch) {
+	auto provider = agi::CreateBlockCacheAudioProvider(agi::make_unique<TestAudioProvider<>>(), 4 << 20);
+	provider->Prefetch(10 << 16, 3 << 16);
+	while (provider->GetCacheStats().prefetched < 3) agi::util::sleep_for(1);
+
+	uint16_t buff[512];
+	provider->GetAudio(buff, (11 << 16) - 256, 512);
+	for (size_t i = 0; i < 512; ++i)
+		ASSERT_EQ(static_cast<uint16_t>((11 << 16) - 256 + i), buff[i]);
+
+	auto stats = provider->GetCacheStats();
+	EXPECT_EQ(2u, stats.hits);
+	EXPECT_EQ(0u, stats.misses);
+}
+
+TEST(lagi_audio, block_cache_uncached_scan) {
+	// Each block is 128 KB, so this fits four
+	auto provider = agi::CreateBlockCacheAudioProvider(agi::make_unique<TestAudioProvider<>>(), 512 * 1024);
+
+	int16_t buff[16];
+	provider->GetInt16MonoAudio(buff, 3 << 16, 16);
+
+	// Scan twenty blocks' worth without caching any of them
+	std::vector<int16_t> scan(1 << 16);
+	for (int64_t block = 0; block < 20; ++block) {
+		provider->GetInt16MonoAudioUncached(scan.data(), block << 16, 1 << 16);
+		ASSERT_EQ(static_cast<int16_t>(block << 16), scan[0]);
+		ASSERT_EQ(static_cast<int16_t>((block << 16) + 12345), scan[12345]);
+	}
+
+	auto stats = provider->GetCacheStats();
+	EXPECT_EQ(1u, stats.misses);
+	EXPECT_EQ(1u, stats.hits);
+	EXPECT_EQ(19u, stats.uncached);
+	EXPECT_EQ(0u, stats.evictions);
+
+	// The block read normally is still cached
+	provider->GetInt16MonoAudio(buff, 3 << 16, 16);
+	EXPECT_EQ(2u, provider->GetCacheStats().hits);
+}
+
 TEST(lagi_audio, convert_8bit) {
 	auto provider = agi::CreateConvertAudioProvider(agi::make_unique<TestAudioProvider<uint8_t>>());
 
@@ -19,6 +19,10 @@
 
 #include <libaegisub/character_count.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 TEST(lagi_character_count, basic) {
 	EXPECT_EQ(5, agi::CharacterCount("hello", agi::IGNORE_NONE));
 }
@@ -27,6 +31,39 @@ TEST(lagi_character_count, japanese) {
 	EXPECT_EQ(4, agi::CharacterCount("ドングズ", agi::IGNORE_NONE));
 }
 
+TEST(lagi_character_count, latin) {
+	EXPECT_EQ(5, agi::CharacterCount("h\xc3\xa9llo", agi::IGNORE_NONE));
+	EXPECT_EQ(4, agi::CharacterCount("\xc2\xa1hola!", agi::IGNORE_PUNCTUATION));
+	EXPECT_EQ(2, agi::CharacterCount("a\xc2\xa0" "b", agi::IGNORE_WHITESPACE));
+}
+
+TEST(lagi_character_count, latin_with_combining_mark) {
+	// e followed by a combining acute accent is one character
+	EXPECT_EQ(5, agi::CharacterCount("he\xcc\x81llo", agi::IGNORE_NONE));
+}
+
+TEST(lagi_character_count, crlf_is_one_character) {
+	EXPECT_EQ(3, agi::CharacterCount("a\r\nb", agi::IGNORE_NONE));
+	EXPECT_EQ(4, agi::CharacterCount("a\n\rb", agi::IGNORE_NONE));
+}
+
+TEST(lagi_character_count, invalid_utf8) {
+	// Overlong encodings and truncated sequences aren't taken by the fast
+	// path, but still shouldn't crash
+	agi::CharacterCount("\xc0\x80", agi::IGNORE_NONE);
+	agi::CharacterCount("abc\xc3", agi::IGNORE_NONE);
+}
+
+TEST(lagi_character_count, long_ascii) {
+	std::string str(1000, 'a');
+	str[500] = ' ';
+	EXPECT_EQ(1000, agi::CharacterCount(str, agi::IGNORE_NONE));
+	EXPECT_EQ(999, agi::CharacterCount(str, agi::IGNORE_WHITESPACE));
+	str[700] = '\xc3';
+	str[701] = '\xa9';
+	EXPECT_EQ(999, agi::CharacterCount(str, agi::IGNORE_NONE));
+}
+
 TEST(lagi_character_count, zalgo) {
 	EXPECT_EQ(5, agi::CharacterCount("\xe1\xb8\xa9\x65\xcc\x94\xcc\x8b\xcd\xad\xcc\x80\xcd\x86\xcd\x97\xcc\x84\x6c\xcc\xb6\xcc\x88\xcc\x81\x6c\xcc\xab\xcc\x9c\xcd\x94\xcc\xac\xcc\x96\xcc\x9f\xcc\xb2\xcd\xa8\xcd\xae\xcc\x8b\xcc\x93\x6f\xcc\xad\xcd\x88\xcc\x9f\xcc\x9c\xcd\x94\xcc\xab\xcc\xb0\xcd\x8a\xcd\x97", agi::IGNORE_NONE));
 }
@@ -80,9 +117,30 @@ TEST(lagi_character_count, character_index) {
 	EXPECT_EQ(3, agi::IndexOfCharacter("abc", 3));
 	EXPECT_EQ(3, agi::IndexOfCharacter("abc", 4));
 
+	EXPECT_EQ(3, agi::IndexOfCharacter("h\xc3\xa9llo", 2));
+	EXPECT_EQ(3, agi::IndexOfCharacter("a\r\nb", 2));
+	EXPECT_EQ(4, agi::IndexOfCharacter("he\xcc\x81llo", 2));
+
 	EXPECT_EQ(3, agi::IndexOfCharacter("ドングズ", 1));
 	EXPECT_EQ(6, agi::IndexOfCharacter("ドングズ", 2));
 	EXPECT_EQ(9, agi::IndexOfCharacter("ドングズ", 3));
 }
 
 
+
+TEST(lagi_character_count, thread_safe) {
+	std::atomic<int> failures{0};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&] {
+			for (int j = 0; j < 500; ++j) {
+				if (agi::CharacterCount("ドングズ", agi::IGNORE_NONE) != 4) ++failures;
+				if (agi::CharacterCount("he\xcc\x81llo", agi::IGNORE_NONE) != 5) ++failures;
+				if (agi::IndexOfCharacter("ドングズ", 2) != 6) ++failures;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_EQ(0, failures);
+}
@@ -17,6 +17,8 @@
 #include <main.h>
 #include <util.h>
 
+#include <random>
+
 class lagi_dialogue_lexer : public libagi {
 };
 
@@ -359,3 +361,49 @@ TEST(lagi_dialogue_lexer, templater_expression) {
 		expect_tok(ARG, 1u);
 	);
 }
+
+TEST(lagi_dialogue_lexer, retokenize_matches_full) {
+	const char *fragments[] = {
+		"{", "}", "\\", "(", ")", ",", " ", "a", "bc", "\\N", "\\pos(1,2)",
+		"\\p1", "m 0 0 l 10 10", "\\clip(", "\\b1", "!", "$x", "\\fn Arial"
+	};
+
+	std::mt19937 rng(1234);
+	auto random_string = [&](size_t count) {
+		std::string str;
+		for (size_t i = 0; i < count; ++i)
+			str += fragments[rng() % (sizeof(fragments) / sizeof(fragments[0]))];
+		return str;
+	};
+
+	for (int i = 0; i < 5000; ++i) {
+		std::string old_str = random_string(rng() % 30);
+		std::string str = old_str;
+		size_t pos = old_str.empty() ? 0 : rng() % old_str.size();
+		size_t erase = std::min<size_t>(rng() % 4, str.size() - pos);
+		str.replace(pos, erase, random_string(rng() % 3));
+
+		for (bool kt : {false, true}) {
+			auto old_tokens = TokenizeDialogueBody(old_str, kt);
+			auto expected = TokenizeDialogueBody(str, kt);
+			auto actual = RetokenizeDialogueBody(old_str, old_tokens, str, kt);
+			ASSERT_EQ(expected.size(), actual.size()) << old_str << " -> " << str;
+			for (size_t j = 0; j < expected.size(); ++j) {
+				ASSERT_EQ(expected[j].type, actual[j].type) << old_str << " -> " << str;
+				ASSERT_EQ(expected[j].length, actual[j].length) << old_str << " -> " << str;
+			}
+		}
+	}
+}
+
+TEST(lagi_dialogue_lexer, retokenize_edit_between_blocks) {
+	std::string old_str = "{\\b1}hello{\\i1}world{\\pos(1,2)}!";
+	std::string str = "{\\b1}hello there{\\i1}world{\\pos(1,2)}!";
+	auto tokens = RetokenizeDialogueBody(old_str, TokenizeDialogueBody(old_str), str);
+	auto expected = TokenizeDialogueBody(str);
+	ASSERT_EQ(expected.size(), tokens.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_EQ(expected[i].type, tokens[i].type);
+		EXPECT_EQ(expected[i].length, tokens[i].length);
+	}
+}
@@ -0,0 +1,202 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <libaegisub/dispatch.h>
+
+#include <main.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace agi::dispatch;
+
+TEST(lagi_dispatch, background_sync) {
+	int x = 0;
+	Background().Sync([&] { x = 1; });
+	EXPECT_EQ(1, x);
+}
+
+TEST(lagi_dispatch, sync_rethrows) {
+	EXPECT_THROW(Background().Sync([] { throw std::runtime_error("error"); }), std::runtime_error);
+}
+
+TEST(lagi_dispatch, all_priorities_run) {
+	std::atomic<int> count{0};
+	TaskGroup group;
+	for (auto priority : { Priority::High, Priority::Normal, Priority::Low }) {
+		for (int i = 0; i < 100; ++i)
+			group.Async(Background(priority), [&] { ++count; });
+	}
+	group.Wait();
+	EXPECT_EQ(300, count);
+}
+
+TEST(lagi_dispatch, serial_queue_is_ordered) {
+	auto queue = Create(Priority::Low);
+	std::vector<int> order;
+	for (int i = 0; i < 1000; ++i)
+		queue->Async([&, i] { order.push_back(i); });
+	queue->Sync([] { });
+
+	ASSERT_EQ(1000u, order.size());
+	for (int i = 0; i < 1000; ++i)
+		EXPECT_EQ(i, order[i]);
+}
+
+TEST(lagi_dispatch, cancelled_thunks_do_not_run) {
+	auto queue = Create();
+	CancellationToken token;
+	bool ran = false;
+
+	// Block the queue so that the thunk can't start before it's cancelled
+	TaskGroup blocker;
+	std::atomic<bool> release{false};
+	blocker.Async(*queue, [&] { while (!release) std::this_thread::yield(); });
+	queue->Async([&] { ran = true; }, token);
+	token.Cancel();
+	release = true;
+	queue->Sync([] { });
+
+	EXPECT_FALSE(ran);
+	EXPECT_EQ(1u, queue->GetStats().cancelled);
+}
+
+TEST(lagi_dispatch, task_group_then) {
+	auto queue = Create();
+	std::atomic<int> count{0};
+	std::atomic<int> seen{-1};
+
+	TaskGroup group;
+	for (int i = 0; i < 50; ++i)
+		group.Async(Background(), [&] { ++count; });
+	group.Then(*queue, [&] { seen = count.load(); });
+	group.Wait();
+	queue->Sync([] { });
+
+	EXPECT_EQ(50, seen);
+}
+
+TEST(lagi_dispatch, task_group_wait_rethrows) {
+	TaskGroup group;
+	group.Async(Background(), [] { throw std::runtime_error("error"); });
+	group.Async(Background(), [] { });
+	EXPECT_THROW(group.Wait(), std::runtime_error);
+}
+
+TEST(lagi_dispatch, task_group_nested) {
+	// Thunks posted from a worker go on that worker's own deque and have to
+	// be stolen by the others, as the worker which posted them is blocked.
+	// There are always at least four workers.
+	std::atomic<int> count{0};
+	TaskGroup outer;
+	for (int i = 0; i < 2; ++i) {
+		outer.Async(Background(), [&] {
+			TaskGroup inner;
+			for (int j = 0; j < 8; ++j)
+				inner.Async(Background(Priority::High), [&] { ++count; });
+			inner.Wait();
+		});
+	}
+	outer.Wait();
+	EXPECT_EQ(16, count);
+}
+
+TEST(lagi_dispatch, stats) {
+	auto queue = Create();
+	for (int i = 0; i < 10; ++i)
+		queue->Async([] { });
+	queue->Sync([] { });
+
+	auto stats = queue->GetStats();
+	EXPECT_EQ(0u, stats.queued);
+	// The Sync thunk itself may not have been counted yet
+	EXPECT_LE(10u, stats.completed);
+	EXPECT_EQ(0u, stats.cancelled);
+	EXPECT_LE(stats.max_latency, stats.total_latency);
+}
+
+TEST(lagi_dispatch, parallel_for_matches_serial) {
+	auto transform = [](size_t i) {
+		std::string str = std::to_string(i * 2654435761u);
+		std::reverse(begin(str), end(str));
+		return str;
+	};
+
+	std::vector<std::string> serial(10007), parallel(serial.size());
+	for (size_t i = 0; i < serial.size(); ++i)
+		serial[i] = transform(i);
+
+	std::atomic<size_t> calls{0};
+	ParallelFor(parallel.size(), 64, [&](size_t begin, size_t end) {
+		++calls;
+		for (size_t i = begin; i < end; ++i) {
+			EXPECT_TRUE(parallel[i].empty());
+			parallel[i] = transform(i);
+		}
+	});
+
+	EXPECT_EQ(serial, parallel);
+	EXPECT_EQ((serial.size() + 63) / 64, calls);
+}
+
+TEST(lagi_dispatch, parallel_for_small_range_runs_inline) {
+	auto caller = std::this_thread::get_id();
+	std::thread::id ran_on;
+	ParallelFor(10, 64, [&](size_t begin, size_t end) {
+		EXPECT_EQ(0u, begin);
+		EXPECT_EQ(10u, end);
+		ran_on = std::this_thread::get_id();
+	});
+	EXPECT_EQ(caller, ran_on);
+
+	ParallelFor(0, 64, [](size_t, size_t) { FAIL(); });
+}
+
+TEST(lagi_dispatch, parallel_for_rethrows) {
+	EXPECT_THROW(ParallelFor(1000, 10, [](size_t begin, size_t) {
+		if (begin == 500) throw std::runtime_error("error");
+	}), std::runtime_error);
+}
+
+TEST(lagi_dispatch, parallel_for_from_every_worker) {
+	// Occupy more pool threads than there are, each waiting on a ParallelFor
+	// of its own, which can only finish if callers run their own chunks
+	const size_t callers = 4 * std::max(4u, std::thread::hardware_concurrency());
+	std::atomic<size_t> total{0};
+	TaskGroup group;
+	for (size_t i = 0; i < callers; ++i) {
+		group.Async(Background(), [&] {
+			ParallelFor(1000, 10, [&](size_t begin, size_t end) {
+				total += end - begin;
+			});
+		});
+	}
+	group.Wait();
+	EXPECT_EQ(callers * 1000, total);
+}
+
+TEST(lagi_dispatch, parallel_for_from_serial_queue) {
+	auto queue = Create();
+	std::atomic<size_t> total{0};
+	queue->Sync([&] {
+		ParallelFor(1000, 10, [&](size_t begin, size_t end) {
+			total += end - begin;
+		});
+	});
+	EXPECT_EQ(1000u, total);
+}
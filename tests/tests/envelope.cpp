@@ -0,0 +1,112 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/audio/envelope.h>
+#include <libaegisub/audio/provider.h>
+#include <libaegisub/exception.h>
+
+#include <cmath>
+
+namespace {
+/// Quiet noise with loud tones in the given millisecond ranges
+struct SpeechProvider : agi::AudioProvider {
+	std::vector<std::pair<int, int>> speech;
+
+	SpeechProvider(int duration_ms, std::vector<std::pair<int, int>> speech)
+	: speech(std::move(speech))
+	{
+		channels = 1;
+		sample_rate = 22050;
+		num_samples = int64_t(duration_ms) * sample_rate / 1000;
+		decoded_samples = num_samples;
+		bytes_per_sample = 2;
+		float_samples = false;
+	}
+
+	void FillBuffer(void *buf, int64_t start, int64_t count) const override {
+		auto out = static_cast<int16_t *>(buf);
+		for (int64_t i = start; i < start + count; ++i) {
+			int ms = int(i * 1000 / sample_rate);
+			bool loud = false;
+			for (auto const& range : speech)
+				loud = loud || (ms >= range.first && ms < range.second);
+			double amplitude = loud ? 8000 : 30;
+			*out++ = int16_t(amplitude * std::sin(i * 0.05));
+		}
+	}
+};
+}
+
+TEST(lagi_envelope, finds_speech_segments) {
+	SpeechProvider provider(10000, {{1000, 2500}, {4000, 4600}, {7000, 9000}});
+	auto env = agi::EnergyEnvelope::Compute(provider, [] { return false; });
+
+	EXPECT_EQ(1000u, env->Levels().size());
+	ASSERT_EQ(3u, env->Onsets().size());
+	ASSERT_EQ(3u, env->Offsets().size());
+
+	int expected[][2] = {{1000, 2500}, {4000, 4600}, {7000, 9000}};
+	for (size_t i = 0; i < 3; ++i) {
+		EXPECT_NEAR(expected[i][0], env->Onsets()[i], 10);
+		EXPECT_NEAR(expected[i][1], env->Offsets()[i], 10);
+	}
+}
+
+TEST(lagi_envelope, short_gaps_do_not_split_segments) {
+	SpeechProvider provider(5000, {{1000, 2000}, {2080, 3000}});
+	auto env = agi::EnergyEnvelope::Compute(provider, [] { return false; });
+
+	ASSERT_EQ(1u, env->Onsets().size());
+	EXPECT_NEAR(1000, env->Onsets()[0], 10);
+	EXPECT_NEAR(3000, env->Offsets()[0], 10);
+}
+
+TEST(lagi_envelope, clicks_are_ignored) {
+	SpeechProvider provider(5000, {{1000, 1020}, {3000, 4000}});
+	auto env = agi::EnergyEnvelope::Compute(provider, [] { return false; });
+
+	ASSERT_EQ(1u, env->Onsets().size());
+	EXPECT_NEAR(3000, env->Onsets()[0], 10);
+}
+
+TEST(lagi_envelope, nearest) {
+	std::vector<uint8_t> levels(1000, 10);
+	std::fill(levels.begin() + 100, levels.begin() + 200, 100);
+	std::fill(levels.begin() + 500, levels.begin() + 700, 100);
+	agi::EnergyEnvelope env(std::move(levels));
+
+	ASSERT_EQ(2u, env.Onsets().size());
+	EXPECT_EQ(1000, env.NearestOnset(1100, 200));
+	EXPECT_EQ(5000, env.NearestOnset(4000, 1000));
+	EXPECT_EQ(1000, env.NearestOnset(2900, 2000));
+	EXPECT_EQ(-1, env.NearestOnset(3000, 100));
+	EXPECT_EQ(2000, env.NearestOffset(2050, 100));
+	EXPECT_EQ(7000, env.NearestOffset(9000, 2000));
+	EXPECT_EQ(-1, env.NearestOffset(0, 100));
+}
+
+TEST(lagi_envelope, empty) {
+	agi::EnergyEnvelope env{std::vector<uint8_t>()};
+	EXPECT_TRUE(env.Onsets().empty());
+	EXPECT_EQ(-1, env.NearestOnset(0, 1000));
+}
+
+TEST(lagi_envelope, cancel) {
+	SpeechProvider provider(5000, {});
+	EXPECT_THROW(agi::EnergyEnvelope::Compute(provider, [] { return true; }), agi::UserCancelException);
+}
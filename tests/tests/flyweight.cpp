@@ -0,0 +1,153 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include <libaegisub/flyweight.h>
+
+#include <main.h>
+
+#include <boost/flyweight.hpp>
+#include <chrono>
+#include <set>
+#include <thread>
+
+using agi::flyweight;
+
+TEST(lagi_flyweight, equal_values_share_storage) {
+	flyweight<std::string> a(std::string("value"));
+	flyweight<std::string> b("value");
+	flyweight<std::string> c("value!", 5);
+	flyweight<std::string> d("other");
+
+	EXPECT_EQ(&a.get(), &b.get());
+	EXPECT_EQ(&a.get(), &c.get());
+	EXPECT_TRUE(a == b);
+	EXPECT_TRUE(a != d);
+	EXPECT_EQ("value", a.get());
+}
+
+TEST(lagi_flyweight, default_is_empty) {
+	flyweight<std::string> a;
+	flyweight<std::string> b("");
+	EXPECT_TRUE(a.get().empty());
+	EXPECT_TRUE(a == b);
+}
+
+TEST(lagi_flyweight, assignment) {
+	flyweight<std::string> a("first");
+	flyweight<std::string> b = a;
+	a = "second";
+	EXPECT_EQ("first", b.get());
+	EXPECT_EQ("second", a.get());
+
+	a = std::string("third");
+	b = a;
+	EXPECT_TRUE(a == b);
+	b = b;
+	EXPECT_EQ("third", b.get());
+}
+
+TEST(lagi_flyweight, compare_with_values) {
+	flyweight<std::string> a("b");
+	flyweight<std::string> b("c");
+	EXPECT_TRUE(a < b);
+	EXPECT_FALSE(b < a);
+	EXPECT_FALSE(a < a);
+	EXPECT_TRUE(a == "b");
+	EXPECT_TRUE("b" == a);
+	EXPECT_TRUE(a != std::string("c"));
+	EXPECT_TRUE(a < "c");
+
+	std::set<flyweight<std::string>> set{b, a, flyweight<std::string>("b")};
+	ASSERT_EQ(2u, set.size());
+	EXPECT_EQ("b", set.begin()->get());
+}
+
+TEST(lagi_flyweight, released_values_can_be_interned_again) {
+	{
+		flyweight<std::string> a("released value");
+		flyweight<std::string> b = a;
+	}
+	flyweight<std::string> c("released value");
+	flyweight<std::string> d("released value");
+	EXPECT_EQ("released value", c.get());
+	EXPECT_TRUE(c == d);
+}
+
+TEST(lagi_flyweight, vectors) {
+	flyweight<std::vector<uint32_t>> a(std::vector<uint32_t>{1, 2, 3});
+	flyweight<std::vector<uint32_t>> b(std::vector<uint32_t>{1, 2, 3});
+	flyweight<std::vector<uint32_t>> c(std::vector<uint32_t>{1, 2});
+	flyweight<std::vector<uint32_t>> empty;
+	EXPECT_TRUE(a == b);
+	EXPECT_TRUE(a != c);
+	EXPECT_TRUE(empty.get().empty());
+	EXPECT_TRUE(c < a);
+}
+
+TEST(lagi_flyweight, concurrent_interning) {
+	const int thread_count = 8;
+	const int iterations = 20000;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; ++t) {
+		threads.emplace_back([&] {
+			for (int i = 0; i < iterations; ++i) {
+				// Repeatedly create and drop the last reference to values
+				// other threads are interning at the same time
+				flyweight<std::string> value(std::to_string(i % 100));
+				flyweight<std::string> copy = value;
+				EXPECT_TRUE(copy == flyweight<std::string>(std::to_string(i % 100)));
+				ASSERT_EQ(std::to_string(i % 100), copy.get());
+			}
+		});
+	}
+	for (auto& thread : threads) thread.join();
+}
+
+namespace {
+/// Time several threads at once copying a file's worth of fields and then
+/// setting each of them to a value no other thread uses, which is the
+/// flyweight work autosave and the video provider do when copying lines
+template<template<typename> class Flyweight>
+int parallel_copy_ms() {
+	std::vector<Flyweight<std::string>> file;
+	file.reserve(20000);
+	for (int i = 0; i < 20000; ++i)
+		file.emplace_back("Line number " + std::to_string(i));
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 10; ++i) {
+				std::vector<Flyweight<std::string>> copy = file;
+				for (auto& field : copy)
+					field = field.get() + std::to_string(t);
+			}
+		});
+	}
+	for (auto& thread : threads) thread.join();
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+template<typename T> using boost_flyweight = boost::flyweight<T>;
+}
+
+TEST(lagi_flyweight, parallel_copy_benchmark) {
+	RecordProperty("flyweight_ms", parallel_copy_ms<flyweight>());
+	RecordProperty("boost_flyweight_ms", parallel_copy_ms<boost_flyweight>());
+}
@@ -0,0 +1,316 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <libaegisub/matroska.h>
+
+#include <libaegisub/file_mapping.h>
+#include <libaegisub/fs.h>
+
+#include <main.h>
+
+#include <algorithm>
+#include <fstream>
+
+using namespace agi::matroska;
+
+namespace {
+const char *mkv_file = "data/matroska_tmp.mkv";
+
+std::string id_bytes(uint32_t id) {
+	std::string ret;
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		if (ret.empty() && !(id >> shift)) continue;
+		ret += static_cast<char>((id >> shift) & 0xFF);
+	}
+	return ret;
+}
+
+std::string element(uint32_t id, std::string const& data) {
+	// Always use eight-byte sizes to keep things simple
+	std::string ret = id_bytes(id);
+	ret += '\x01';
+	for (int shift = 48; shift >= 0; shift -= 8)
+		ret += static_cast<char>((data.size() >> shift) & 0xFF);
+	return ret + data;
+}
+
+std::string uint_element(uint32_t id, uint64_t value) {
+	std::string data;
+	for (int shift = 56; shift >= 0; shift -= 8)
+		data += static_cast<char>((value >> shift) & 0xFF);
+	return element(id, data);
+}
+
+std::string block_header(unsigned track, int16_t timecode) {
+	std::string ret;
+	ret += static_cast<char>(0x80 | track);
+	ret += static_cast<char>((timecode >> 8) & 0xFF);
+	ret += static_cast<char>(timecode & 0xFF);
+	ret += '\0';
+	return ret;
+}
+
+std::string simple_block(unsigned track, int16_t timecode, std::string const& data) {
+	return element(0xA3, block_header(track, timecode) + data);
+}
+
+/// Build a simple block with the given lacing flags, where laces is
+/// everything between the header and the frames
+std::string laced_block(unsigned track, int16_t timecode, char lacing, std::string const& laces, std::vector<std::string> const& frames) {
+	std::string header = block_header(track, timecode);
+	header.back() = lacing;
+	std::string data;
+	for (auto const& frame : frames)
+		data += frame;
+	return element(0xA3, header + static_cast<char>(frames.size() - 1) + laces + data);
+}
+
+std::string block_group(unsigned track, int16_t timecode, uint64_t duration, std::string const& data) {
+	return element(0xA0, element(0xA1, block_header(track, timecode) + data) + uint_element(0x9B, duration));
+}
+
+struct Cluster {
+	uint64_t timecode;
+	std::vector<std::string> blocks;
+};
+
+/// Get the track number of a block built by simple_block or block_group
+unsigned block_track(std::string const& block) {
+	// Skip the element headers, which are one byte of ID and eight of size
+	return static_cast<uint8_t>(block[block[0] == '\xA3' ? 9 : 18]) & 0x7F;
+}
+
+/// Build a file with the given clusters, optionally with cues listing the
+/// clusters that contain blocks of cue_track. The cues are either before
+/// the clusters or after them with a seek head pointing at them. If
+/// video_cues is set, every cluster also gets a cue for track 1, as muxers
+/// do for the video keyframe starting each cluster. If sparse_cues is set,
+/// only the first cluster containing cue_track gets a cue for it.
+void write_file(std::vector<Cluster> const& clusters, int cue_track = -1, bool cues_first = false, bool sparse_cues = false, bool video_cues = true) {
+	std::string cluster_data;
+	std::vector<uint64_t> cluster_positions;
+	for (auto const& cluster : clusters) {
+		cluster_positions.push_back(cluster_data.size());
+		std::string data = uint_element(0xE7, cluster.timecode);
+		for (auto const& block : cluster.blocks)
+			data += block;
+		cluster_data += element(0x1F43B675, data);
+	}
+
+	// All sizes and integers are fixed-width, so these can be built once to
+	// find their size and again once the positions are known
+	auto build_cues = [&](uint64_t clusters_offset) {
+		std::string points;
+		auto add_point = [&](size_t i, unsigned track) {
+			points += element(0xBB, uint_element(0xB3, clusters[i].timecode) +
+				element(0xB7, uint_element(0xF7, track) + uint_element(0xF1, clusters_offset + cluster_positions[i])));
+		};
+		bool cued_track = false;
+		for (size_t i = 0; i < clusters.size(); ++i) {
+			if (video_cues && cue_track != 1)
+				add_point(i, 1);
+			auto const& blocks = clusters[i].blocks;
+			if (sparse_cues && cued_track) continue;
+			if (std::any_of(begin(blocks), end(blocks), [&](std::string const& b) { return (int)block_track(b) == cue_track; })) {
+				add_point(i, cue_track);
+				cued_track = true;
+			}
+		}
+		return element(0x1C53BB6B, points);
+	};
+	auto build_seek_head = [&](uint64_t cues_position) {
+		return element(0x114D9B74, element(0x4DBB,
+			element(0x53AB, id_bytes(0x1C53BB6B)) + uint_element(0x53AC, cues_position)));
+	};
+
+	std::string info = element(0x1549A966, uint_element(0x2AD7B1, 1000000));
+	std::string segment;
+	if (cue_track < 0)
+		segment = info + cluster_data;
+	else if (cues_first) {
+		auto cues = build_cues(info.size() + build_cues(0).size());
+		segment = info + cues + cluster_data;
+	}
+	else {
+		auto seek_head_size = build_seek_head(0).size();
+		auto cues = build_cues(seek_head_size + info.size());
+		segment = build_seek_head(seek_head_size + info.size() + cluster_data.size()) + info + cluster_data + cues;
+	}
+
+	std::ofstream out(mkv_file, std::ios::binary);
+	out << element(0x1A45DFA3, element(0x4282, "matroska"));
+	out << element(0x18538067, segment);
+}
+
+std::vector<Block> read(uint64_t track, ReadStats *stats = nullptr) {
+	agi::read_file_mapping file(mkv_file);
+	return ReadTrack(file, track, [](size_t, size_t) { return true; }, stats);
+}
+
+struct lagi_matroska : public ::testing::Test {
+	void TearDown() override { agi::fs::Remove(mkv_file); }
+};
+}
+
+TEST_F(lagi_matroska, reads_only_requested_track) {
+	write_file({
+		{0, {simple_block(1, 0, "video 1"), block_group(2, 10, 500, "sub 1"), simple_block(1, 40, "video 2")}},
+		{1000, {simple_block(1, 0, "video 3"), block_group(2, 200, 300, "sub 2")}},
+	});
+
+	ReadStats stats;
+	auto blocks = read(2, &stats);
+	ASSERT_EQ(2u, blocks.size());
+	EXPECT_EQ("sub 1", blocks[0].data);
+	EXPECT_EQ(10 * 1000000, blocks[0].start);
+	EXPECT_EQ(510 * 1000000, blocks[0].end);
+	EXPECT_EQ("sub 2", blocks[1].data);
+	EXPECT_EQ(1200 * 1000000LL, blocks[1].start);
+	EXPECT_EQ(1500 * 1000000LL, blocks[1].end);
+
+	EXPECT_EQ(2u, stats.clusters_read);
+	EXPECT_EQ(2u, stats.blocks);
+}
+
+TEST_F(lagi_matroska, times_are_relative_to_first_block) {
+	write_file({
+		{5000, {simple_block(1, 20, "video"), block_group(2, 100, 50, "sub")}},
+	});
+
+	auto blocks = read(2);
+	ASSERT_EQ(1u, blocks.size());
+	EXPECT_EQ(80 * 1000000, blocks[0].start);
+	EXPECT_EQ(130 * 1000000, blocks[0].end);
+}
+
+TEST_F(lagi_matroska, simple_blocks_have_no_duration) {
+	write_file({{0, {simple_block(3, 25, "text")}}});
+	auto blocks = read(3);
+	ASSERT_EQ(1u, blocks.size());
+	EXPECT_EQ(blocks[0].start, blocks[0].end);
+}
+
+TEST_F(lagi_matroska, cues_do_not_change_what_is_read) {
+	std::vector<Cluster> clusters;
+	for (int i = 0; i < 20; ++i) {
+		Cluster c{static_cast<uint64_t>(i * 1000), {simple_block(1, 0, std::string(1000, 'v'))}};
+		if (i % 5 == 0)
+			c.blocks.push_back(block_group(2, 10, 100, "sub " + std::to_string(i)));
+		clusters.push_back(c);
+	}
+
+	for (bool cues_first : {false, true}) {
+		write_file(clusters, 2, cues_first);
+
+		ReadStats stats;
+		auto blocks = read(2, &stats);
+		EXPECT_EQ(20u, stats.clusters_read);
+		ASSERT_EQ(4u, blocks.size());
+		EXPECT_EQ("sub 0", blocks[0].data);
+		EXPECT_EQ("sub 15", blocks[3].data);
+		EXPECT_EQ((15000 + 10) * 1000000LL, blocks[3].start);
+	}
+}
+
+TEST_F(lagi_matroska, cues_for_other_tracks_are_ignored) {
+	std::vector<Cluster> clusters;
+	for (int i = 0; i < 4; ++i)
+		clusters.push_back(Cluster{static_cast<uint64_t>(i * 1000), {simple_block(1, 0, "v"), block_group(2, 0, 10, "s")}});
+	write_file(clusters, 1);
+
+	ReadStats stats;
+	auto blocks = read(2, &stats);
+	EXPECT_EQ(4u, stats.clusters_read);
+	EXPECT_EQ(4u, blocks.size());
+}
+
+TEST_F(lagi_matroska, cues_which_skip_clusters_are_not_trusted) {
+	// Only the first subtitle block has a cue. With video cues every cluster
+	// is indexed, but the subtitle track's cues still miss a block.
+	std::vector<Cluster> clusters;
+	for (int i = 0; i < 6; ++i)
+		clusters.push_back(Cluster{static_cast<uint64_t>(i * 1000), {simple_block(1, 0, "v")}});
+	clusters[0].blocks.push_back(block_group(2, 0, 10, "sub 0"));
+	clusters[4].blocks.push_back(block_group(2, 0, 10, "sub 4"));
+
+	for (bool video_cues : {false, true}) {
+		write_file(clusters, 2, false, true, video_cues);
+
+		ReadStats stats;
+		auto blocks = read(2, &stats);
+		EXPECT_EQ(6u, stats.clusters_read);
+		ASSERT_EQ(2u, blocks.size());
+		EXPECT_EQ("sub 0", blocks[0].data);
+		EXPECT_EQ("sub 4", blocks[1].data);
+	}
+}
+
+TEST_F(lagi_matroska, laced_blocks_are_split) {
+	write_file({{0, {
+		laced_block(2, 0, 0x02, "\x02\x03", {"ab", "cde", "f"}),    // Xiph
+		laced_block(2, 10, 0x04, "", {"gh", "ij", "kl"}),           // Fixed
+		laced_block(2, 20, 0x06, "\x82\xC0", {"mn", "opq", "rstu"}), // EBML
+	}}});
+
+	auto blocks = read(2);
+	std::vector<std::string> expected{"ab", "cde", "f", "gh", "ij", "kl", "mn", "opq", "rstu"};
+	ASSERT_EQ(expected.size(), blocks.size());
+	for (size_t i = 0; i < expected.size(); ++i)
+		EXPECT_EQ(expected[i], blocks[i].data);
+	EXPECT_EQ(10 * 1000000, blocks[3].start);
+	EXPECT_EQ(20 * 1000000, blocks[8].start);
+}
+
+TEST_F(lagi_matroska, truncated_laced_block) {
+	write_file({{0, {laced_block(2, 0, 0x02, "\x10", {"ab", "c"})}}});
+	EXPECT_THROW(read(2), MatroskaError);
+}
+
+TEST_F(lagi_matroska, cancel_keeps_blocks_read_so_far) {
+	write_file({{0, {block_group(2, 0, 10, "s 1")}}, {1000, {block_group(2, 0, 10, "s 2")}}});
+	agi::read_file_mapping file(mkv_file);
+	ReadStats stats;
+	auto blocks = ReadTrack(file, 2, [](size_t done, size_t) { return done == 0; }, &stats);
+	EXPECT_TRUE(stats.cancelled);
+	ASSERT_EQ(1u, blocks.size());
+	EXPECT_EQ("s 1", blocks[0].data);
+}
+
+TEST_F(lagi_matroska, not_matroska) {
+	{
+		std::ofstream out(mkv_file, std::ios::binary);
+		out << "this is not a matroska file";
+	}
+	EXPECT_THROW(read(1), MatroskaError);
+}
+
+TEST_F(lagi_matroska, large_file_reads_only_subtitle_blocks) {
+	// 64 MB of "video" with a subtitle every tenth cluster; only the headers
+	// of the video blocks are read
+	std::vector<Cluster> clusters;
+	const std::string video(256 * 1024, 'v');
+	for (int i = 0; i < 256; ++i) {
+		Cluster c{static_cast<uint64_t>(i * 1000), {simple_block(1, 0, video)}};
+		if (i % 10 == 0)
+			c.blocks.push_back(block_group(2, 500, 1000, "line " + std::to_string(i)));
+		clusters.push_back(std::move(c));
+	}
+	write_file(clusters, 2);
+
+	ReadStats stats;
+	auto blocks = read(2, &stats);
+	EXPECT_EQ(256u, stats.clusters_read);
+	ASSERT_EQ(26u, blocks.size());
+	EXPECT_EQ("line 250", blocks.back().data);
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <libaegisub/persist.h>
+
+#include <libaegisub/fs.h>
+#include <libaegisub/io.h>
+#include <libaegisub/json.h>
+#include <libaegisub/mru.h>
+
+#include <main.h>
+
+#include <thread>
+
+using namespace agi;
+
+namespace {
+const char *persist_file = "data/persist_tmp.json";
+
+int64_t read_value() {
+	auto root = json_util::parse(*io::Open(persist_file));
+	return static_cast<json::Object&>(root)["a"];
+}
+
+struct lagi_persist : public ::testing::Test {
+	void SetUp() override {
+		persist::SetDelay(std::chrono::milliseconds(50));
+		fs::Remove(persist_file);
+	}
+	void TearDown() override {
+		persist::Flush();
+		persist::SetDelay(std::chrono::milliseconds(1000));
+		fs::Remove(persist_file);
+	}
+};
+}
+
+TEST_F(lagi_persist, write_is_deferred_until_flush) {
+	persist::SetDelay(std::chrono::hours(1));
+	json::Object obj;
+	obj["a"] = 1;
+	persist::Write(persist_file, std::move(obj));
+	EXPECT_FALSE(fs::FileExists(persist_file));
+
+	persist::Flush();
+	ASSERT_TRUE(fs::FileExists(persist_file));
+	EXPECT_EQ(1, read_value());
+}
+
+TEST_F(lagi_persist, newest_write_wins) {
+	for (int64_t i = 0; i < 100; ++i) {
+		json::Object obj;
+		obj["a"] = i;
+		persist::Write(persist_file, std::move(obj));
+	}
+
+	persist::Flush();
+	EXPECT_EQ(99, read_value());
+}
+
+TEST_F(lagi_persist, write_happens_after_delay) {
+	json::Object obj;
+	obj["a"] = 1;
+	persist::Write(persist_file, std::move(obj));
+
+	for (int i = 0; i < 200 && !fs::FileExists(persist_file); ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	EXPECT_TRUE(fs::FileExists(persist_file));
+}
+
+TEST_F(lagi_persist, write_now_discards_older_queued_write) {
+	persist::SetDelay(std::chrono::hours(1));
+	json::Object old_obj;
+	old_obj["a"] = 1;
+	persist::Write(persist_file, std::move(old_obj));
+
+	json::Object new_obj;
+	new_obj["a"] = 2;
+	persist::WriteNow(persist_file, std::move(new_obj));
+	EXPECT_EQ(2, read_value());
+
+	persist::Flush();
+	EXPECT_EQ(2, read_value());
+}
+
+TEST_F(lagi_persist, mru_writes_on_destruction) {
+	persist::SetDelay(std::chrono::hours(1));
+	{
+		MRUManager mru(persist_file, "{}");
+		mru.Add("Video", "/path/to/file");
+	}
+
+	MRUManager mru(persist_file, "{}");
+	ASSERT_EQ(1u, mru.Get("Video")->size());
+	EXPECT_STREQ("/path/to/file", mru.Get("Video")->front().string().c_str());
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include <libaegisub/quality_check.h>
+#include <libaegisub/character_count.h>
+
+#include <main.h>
+
+#include <chrono>
+
+using namespace agi::qc;
+
+namespace {
+Line make_line(int id, int start, int end, std::string text = "text", std::string style = "Default") {
+	Line line;
+	line.id = id;
+	line.start = start;
+	line.end = end;
+	line.text = std::move(text);
+	line.style = std::move(style);
+	return line;
+}
+
+std::vector<Line> lines(std::initializer_list<Line> list) {
+	return std::vector<Line>(list);
+}
+}
+
+TEST(lagi_qc, cps) {
+	Checker checker;
+	Settings settings;
+	settings.max_cps = 10;
+	checker.SetSettings(settings);
+	checker.SetStyles({"Default"});
+
+	checker.Update(lines({
+		make_line(1, 0, 1000, "short"),
+		make_line(2, 2000, 3000, "this is far too much text"),
+		make_line(3, 4000, 4050, "too short to judge")
+	}), {});
+
+	EXPECT_EQ(5, checker.Get(1).cps);
+	EXPECT_EQ(0, checker.Get(1).issues);
+	EXPECT_EQ(25, checker.Get(2).cps);
+	EXPECT_EQ(ISSUE_CPS, checker.Get(2).issues);
+	EXPECT_EQ(-1, checker.Get(3).cps);
+	EXPECT_EQ(0, checker.Get(3).issues);
+}
+
+TEST(lagi_qc, cps_ignores_override_blocks) {
+	Checker checker;
+	checker.SetStyles({"Default"});
+	checker.Update(lines({make_line(1, 0, 1000, "{\\an8\\pos(100,100)}hello")}), {});
+	EXPECT_EQ(5, checker.Get(1).cps);
+}
+
+TEST(lagi_qc, line_length) {
+	Checker checker;
+	Settings settings;
+	settings.max_line_length = 5;
+	checker.SetSettings(settings);
+	checker.SetStyles({"Default"});
+
+	checker.Update(lines({
+		make_line(1, 0, 10000, "hello\\Nworld"),
+		make_line(2, 20000, 30000, "hello world")
+	}), {});
+
+	EXPECT_EQ(5u, checker.Get(1).line_length);
+	EXPECT_EQ(0, checker.Get(1).issues);
+	EXPECT_EQ(11u, checker.Get(2).line_length);
+	EXPECT_EQ(ISSUE_LINE_LENGTH, checker.Get(2).issues);
+}
+
+TEST(lagi_qc, missing_style) {
+	Checker checker;
+	checker.SetStyles({"Default", "Sign"});
+	checker.Update(lines({
+		make_line(1, 0, 10000, "a", "default"),
+		make_line(2, 20000, 30000, "a", "Signs")
+	}), {});
+
+	EXPECT_EQ(0, checker.Get(1).issues);
+	EXPECT_EQ(ISSUE_MISSING_STYLE, checker.Get(2).issues);
+
+	checker.SetStyles({"Signs"});
+	EXPECT_EQ(ISSUE_MISSING_STYLE, checker.Get(1).issues);
+	EXPECT_EQ(0, checker.Get(2).issues);
+}
+
+TEST(lagi_qc, overlaps) {
+	Checker checker;
+	checker.SetStyles({"Default"});
+
+	auto comment = make_line(6, 0, 100000);
+	comment.comment = true;
+
+	checker.Update(lines({
+		make_line(1, 0, 10000),
+		make_line(2, 1000, 2000),
+		make_line(3, 10000, 11000), // Starts exactly when 1 ends
+		make_line(4, 20000, 30000),
+		make_line(5, 29999, 40000),
+		comment
+	}), {});
+
+	EXPECT_EQ(ISSUE_OVERLAP, checker.Get(1).issues);
+	EXPECT_EQ(ISSUE_OVERLAP, checker.Get(2).issues);
+	EXPECT_EQ(0, checker.Get(3).issues);
+	EXPECT_EQ(ISSUE_OVERLAP, checker.Get(4).issues);
+	EXPECT_EQ(ISSUE_OVERLAP, checker.Get(5).issues);
+	EXPECT_EQ(0, checker.Get(6).issues);
+
+	// Moving a line away clears the flag on both it and what it overlapped
+	checker.Update(lines({make_line(2, 50000, 51000)}), {});
+	EXPECT_EQ(0, checker.Get(1).issues);
+	EXPECT_EQ(0, checker.Get(2).issues);
+
+	checker.Update({}, {5});
+	EXPECT_EQ(0, checker.Get(4).issues);
+	EXPECT_EQ(0, checker.Get(5).issues);
+	EXPECT_EQ(5u, checker.size());
+}
+
+TEST(lagi_qc, lines_with_issues_sorted_by_time) {
+	Checker checker;
+	checker.SetStyles({"Default"});
+	checker.Update(lines({
+		make_line(1, 5000, 6000, "a", "Missing"),
+		make_line(2, 1000, 2000, "a", "Missing"),
+		make_line(3, 3000, 4000, "a")
+	}), {});
+
+	EXPECT_EQ(std::vector<int>({2, 1}), checker.LinesWithIssues(ISSUE_MISSING_STYLE));
+	EXPECT_TRUE(checker.LinesWithIssues(ISSUE_OVERLAP).empty());
+}
+
+TEST(lagi_qc, large_file) {
+	Checker checker;
+	Settings settings;
+	settings.max_cps = 15;
+	settings.max_line_length = 40;
+	settings.ignore = agi::IGNORE_WHITESPACE;
+	checker.SetSettings(settings);
+	checker.SetStyles({"Default"});
+
+	// 100k lines of two seconds each, with every hundredth overlapping the
+	// next one and every thousandth too long
+	std::vector<Line> file;
+	file.reserve(100000);
+	for (int i = 0; i < 100000; ++i) {
+		int end = i * 2000 + (i % 100 == 0 ? 2500 : 1900);
+		std::string text = i % 1000 == 0
+			? "{\\i1}A line which is far too long to fit on the screen in one go at all{\\i0}"
+			: "{\\i1}Dialogue\\Nline{\\i0}";
+		file.push_back(make_line(i, i * 2000, end, std::move(text)));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	checker.Update(std::move(file), {});
+	auto full = std::chrono::steady_clock::now() - start;
+
+	EXPECT_EQ(100000u, checker.size());
+	EXPECT_EQ(2000u, checker.LinesWithIssues(ISSUE_OVERLAP).size());
+	EXPECT_EQ(100u, checker.LinesWithIssues(ISSUE_LINE_LENGTH).size());
+	EXPECT_EQ(100u, checker.LinesWithIssues(ISSUE_CPS).size());
+	EXPECT_EQ(ISSUE_OVERLAP | ISSUE_LINE_LENGTH | ISSUE_CPS, checker.Get(0).issues);
+	EXPECT_EQ(ISSUE_OVERLAP, checker.Get(1).issues);
+
+	// Updating a single line only rechecks that line
+	start = std::chrono::steady_clock::now();
+	checker.Update(lines({make_line(500, 1000000, 1001900, "Short")}), {});
+	auto single = std::chrono::steady_clock::now() - start;
+
+	EXPECT_EQ(0, checker.Get(500).issues);
+
+	using std::chrono::microseconds;
+	RecordProperty("full_check_us", static_cast<int>(std::chrono::duration_cast<microseconds>(full).count()));
+	RecordProperty("single_line_update_us", static_cast<int>(std::chrono::duration_cast<microseconds>(single).count()));
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <libaegisub/scene_change.h>
+
+#include <main.h>
+
+using namespace agi::scene_change;
+
+namespace {
+std::vector<uint8_t> solid_image(size_t width, size_t height, uint8_t b, uint8_t g, uint8_t r) {
+	std::vector<uint8_t> image(width * height * 4);
+	for (size_t i = 0; i < image.size(); i += 4) {
+		image[i] = b;
+		image[i + 1] = g;
+		image[i + 2] = r;
+		image[i + 3] = 0;
+	}
+	return image;
+}
+
+std::vector<uint32_t> steady_differences(size_t frames, uint32_t per_pixel) {
+	return std::vector<uint32_t>(frames, per_pixel * thumb_size);
+}
+}
+
+TEST(lagi_scene_change, thumbnail_of_solid_image_is_solid) {
+	auto image = solid_image(640, 360, 255, 255, 255);
+	std::vector<uint8_t> thumb(thumb_size);
+	Thumbnail(image.data(), 640, 360, 640 * 4, false, thumb.data());
+	for (auto px : thumb)
+		EXPECT_EQ(255, px);
+
+	image = solid_image(640, 360, 0, 0, 0);
+	Thumbnail(image.data(), 640, 360, 640 * 4, false, thumb.data());
+	for (auto px : thumb)
+		EXPECT_EQ(0, px);
+}
+
+TEST(lagi_scene_change, thumbnail_weights_green_most) {
+	std::vector<uint8_t> blue(thumb_size), green(thumb_size), red(thumb_size);
+	auto image = solid_image(128, 72, 255, 0, 0);
+	Thumbnail(image.data(), 128, 72, 128 * 4, false, blue.data());
+	image = solid_image(128, 72, 0, 255, 0);
+	Thumbnail(image.data(), 128, 72, 128 * 4, false, green.data());
+	image = solid_image(128, 72, 0, 0, 255);
+	Thumbnail(image.data(), 128, 72, 128 * 4, false, red.data());
+
+	EXPECT_LT(blue[0], red[0]);
+	EXPECT_LT(red[0], green[0]);
+}
+
+TEST(lagi_scene_change, thumbnail_handles_flipped_and_tiny_images) {
+	// 2x2 image with a white top row and black bottom row
+	std::vector<uint8_t> image(2 * 2 * 4, 0);
+	std::fill(image.begin(), image.begin() + 8, 255);
+
+	std::vector<uint8_t> thumb(thumb_size);
+	Thumbnail(image.data(), 2, 2, 8, false, thumb.data());
+	EXPECT_EQ(255, thumb.front());
+	EXPECT_EQ(0, thumb.back());
+
+	Thumbnail(image.data(), 2, 2, 8, true, thumb.data());
+	EXPECT_EQ(0, thumb.front());
+	EXPECT_EQ(255, thumb.back());
+}
+
+TEST(lagi_scene_change, difference) {
+	std::vector<uint8_t> a(thumb_size, 10), b(thumb_size, 10);
+	EXPECT_EQ(0u, Difference(a.data(), b.data()));
+
+	b[0] = 20;
+	b[thumb_size - 1] = 0;
+	EXPECT_EQ(20u, Difference(a.data(), b.data()));
+	EXPECT_EQ(20u, Difference(b.data(), a.data()));
+
+	std::fill(a.begin(), a.end(), 0);
+	std::fill(b.begin(), b.end(), 255);
+	EXPECT_EQ(255u * thumb_size, Difference(a.data(), b.data()));
+}
+
+TEST(lagi_scene_change, detect_empty) {
+	EXPECT_TRUE(Detect({}).empty());
+	EXPECT_EQ(std::vector<int>{0}, Detect({0}));
+}
+
+TEST(lagi_scene_change, detect_finds_cuts) {
+	auto diffs = steady_differences(100, 1);
+	diffs[30] = 100 * thumb_size;
+	diffs[70] = 100 * thumb_size;
+	EXPECT_EQ((std::vector<int>{0, 30, 70}), Detect(diffs));
+}
+
+TEST(lagi_scene_change, detect_ignores_small_changes) {
+	auto diffs = steady_differences(100, 0);
+	diffs[50] = 5 * thumb_size;
+	EXPECT_EQ(std::vector<int>{0}, Detect(diffs));
+}
+
+TEST(lagi_scene_change, detect_ignores_steady_high_motion) {
+	auto diffs = steady_differences(100, 40);
+	EXPECT_EQ(std::vector<int>{0}, Detect(diffs));
+
+	diffs[50] = 200 * thumb_size;
+	EXPECT_EQ((std::vector<int>{0, 50}), Detect(diffs));
+}
+
+TEST(lagi_scene_change, detect_merges_nearby_cuts) {
+	auto diffs = steady_differences(100, 1);
+	diffs[30] = 100 * thumb_size;
+	diffs[32] = 100 * thumb_size;
+	EXPECT_EQ((std::vector<int>{0, 30}), Detect(diffs));
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include <libaegisub/fs.h>
+#include <libaegisub/sniff.h>
+
+#include <main.h>
+
+#include <fstream>
+
+using namespace agi::sniff;
+
+namespace {
+void write(std::string const& filename, std::string const& contents) {
+	std::ofstream out(filename, std::ios::binary);
+	out << contents;
+}
+}
+
+TEST(lagi_sniff, identify) {
+	EXPECT_EQ(Format::Ass, Identify("[Script Info]\r\n; comment\r\nScriptType: v4.00+\r\n"));
+	EXPECT_EQ(Format::Ass, Identify("\xef\xbb\xbf\n\n[script info]\n"));
+	EXPECT_EQ(Format::WebVtt, Identify("WEBVTT\n\n00:01.000 --> 00:02.000\nhi\n"));
+	EXPECT_EQ(Format::WebVtt, Identify("WEBVTT - title\n"));
+	EXPECT_EQ(Format::Unknown, Identify("WEBVTTX\n"));
+	EXPECT_EQ(Format::Srt, Identify("1\r\n0:00:01,000 --> 0:00:02,000\r\nhi\r\n"));
+	EXPECT_EQ(Format::Srt, Identify("\n\n12\n00:00:01.000  -->  00:00:02.000\n"));
+	EXPECT_EQ(Format::Unknown, Identify("1\nnot a time\n"));
+	EXPECT_EQ(Format::MicroDvd, Identify("{0}{25}hello|world\n"));
+	EXPECT_EQ(Format::MicroDvd, Identify("[10][20]hello\n"));
+	EXPECT_EQ(Format::Unknown, Identify("{0}hello\n"));
+	EXPECT_EQ(Format::Ttxt, Identify("<?xml version=\"1.0\"?>\n<TextStream version=\"1.1\">\n"));
+	EXPECT_EQ(Format::Unknown, Identify("<?xml version=\"1.0\"?>\n<html>\n"));
+	EXPECT_EQ(Format::Timecodes, Identify("# timecode format v2\n0\n42\n"));
+	EXPECT_EQ(Format::Timecodes, Identify("Assume 23.976\n"));
+	EXPECT_EQ(Format::Keyframes, Identify("# keyframe format v1\nfps 0\n"));
+	EXPECT_EQ(Format::Keyframes, Identify("#options: 1280x720 fps=24000/1001\n"));
+	EXPECT_EQ(Format::Unknown, Identify("Just some text\n"));
+	EXPECT_EQ(Format::Unknown, Identify(""));
+}
+
+TEST(lagi_sniff, identify_truncated) {
+	// Only the first few KB are looked at, so the text can end anywhere
+	EXPECT_EQ(Format::Srt, Identify("1\n00:00:01,000 -->"));
+	EXPECT_EQ(Format::Unknown, Identify("1\n00:00:01,0"));
+	EXPECT_EQ(Format::Ass, Identify("[Script Info]"));
+}
+
+TEST(lagi_sniff, files) {
+	ClearCache();
+
+	write("data/sniff_ass.txt", "[Script Info]\nTitle: caf\xc3\xa9\n");
+	Result r;
+	ASSERT_NO_THROW(r = Sniff("data/sniff_ass.txt"));
+	EXPECT_EQ("utf-8", r.encoding);
+	EXPECT_EQ(Format::Ass, r.format);
+
+	write("data/sniff_mkv.txt", std::string("\x1a\x45\xdf\xa3\x01\x00\x00\x00", 8));
+	ASSERT_NO_THROW(r = Sniff("data/sniff_mkv.txt"));
+	EXPECT_EQ("binary", r.encoding);
+	EXPECT_EQ(Format::Matroska, r.format);
+
+	write("data/sniff_binary.txt", std::string(100, '\0'));
+	ASSERT_NO_THROW(r = Sniff("data/sniff_binary.txt"));
+	EXPECT_EQ(Format::Binary, r.format);
+
+	write("data/sniff_empty.txt", "");
+	ASSERT_NO_THROW(r = Sniff("data/sniff_empty.txt"));
+	EXPECT_EQ(Format::Unknown, r.format);
+
+	EXPECT_THROW(Sniff("data/sniff_nonexistent.txt"), agi::fs::FileNotFound);
+}
+
+TEST(lagi_sniff, utf16) {
+	ClearCache();
+
+	// "1\n0:00:01,000 --> 0:00:02,000\n" in UTF-16 with BOMs
+	std::string text = "1\n0:00:01,000 --> 0:00:02,000\n";
+	std::string le = "\xff\xfe", be = "\xfe\xff";
+	for (char c : text) {
+		le += c; le += '\0';
+		be += '\0'; be += c;
+	}
+
+	write("data/sniff_utf16le.txt", le);
+	Result r;
+	ASSERT_NO_THROW(r = Sniff("data/sniff_utf16le.txt"));
+	EXPECT_EQ("utf-16le", r.encoding);
+	EXPECT_EQ(Format::Srt, r.format);
+
+	write("data/sniff_utf16be.txt", be);
+	ASSERT_NO_THROW(r = Sniff("data/sniff_utf16be.txt"));
+	EXPECT_EQ("utf-16be", r.encoding);
+	EXPECT_EQ(Format::Srt, r.format);
+}
+
+TEST(lagi_sniff, cached_until_modified) {
+	ClearCache();
+
+	write("data/sniff_cache.txt", "[Script Info]\n");
+	auto modified = agi::fs::ModifiedTime("data/sniff_cache.txt");
+	EXPECT_EQ(Format::Ass, Sniff("data/sniff_cache.txt").format);
+
+	// Same size and modification time, so the cached result is used
+	write("data/sniff_cache.txt", "WEBVTT\n\n\n\n\n\n\n\n");
+	boost::filesystem::last_write_time("data/sniff_cache.txt", modified);
+	EXPECT_EQ(Format::Ass, Sniff("data/sniff_cache.txt").format);
+
+	boost::filesystem::last_write_time("data/sniff_cache.txt", modified + 10);
+	EXPECT_EQ(Format::WebVtt, Sniff("data/sniff_cache.txt").format);
+
+	// Different size
+	write("data/sniff_cache.txt", "1\n0:00:01,000 --> 0:00:02,000\n");
+	boost::filesystem::last_write_time("data/sniff_cache.txt", modified + 10);
+	EXPECT_EQ(Format::Srt, Sniff("data/sniff_cache.txt").format);
+}
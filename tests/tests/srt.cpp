@@ -0,0 +1,193 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+
+#include <libaegisub/ass/srt.h>
+
+#include <main.h>
+
+#include <chrono>
+
+using namespace agi::ass;
+
+namespace {
+std::vector<SrtCue> parse(std::string const& text, SrtDialect dialect = SrtDialect::SubRip) {
+	return ParseSrt(text.data(), text.data() + text.size(), dialect);
+}
+
+std::string to_ass(std::string const& text, SrtDialect dialect = SrtDialect::SubRip) {
+	return SrtToAss(text, dialect);
+}
+}
+
+TEST(lagi_srt, basic) {
+	auto cues = parse(
+		"\xef\xbb\xbf" "1\r\n"
+		"00:00:01,000 --> 00:00:02,500\r\n"
+		"Hello\r\n"
+		"world\r\n"
+		"\r\n"
+		"2\r\n"
+		"0:1:2,3 --> 0:1:3,45\r\n"
+		"  Second  \r\n");
+	ASSERT_EQ(2u, cues.size());
+	EXPECT_EQ(1000, cues[0].start);
+	EXPECT_EQ(2500, cues[0].end);
+	EXPECT_EQ("Hello\\Nworld", cues[0].text);
+	EXPECT_EQ(62300, cues[1].start);
+	EXPECT_EQ(63450, cues[1].end);
+	EXPECT_EQ("Second", cues[1].text);
+}
+
+TEST(lagi_srt, blank_lines_in_text) {
+	auto cues = parse(
+		"1\n00:00:01,000 --> 00:00:02,000\nfirst\n\n\nsecond\n\n"
+		"2\n00:00:03,000 --> 00:00:04,000\n\nafter blank\n");
+	ASSERT_EQ(2u, cues.size());
+	EXPECT_EQ("first\\N\\N\\Nsecond", cues[0].text);
+	// The blank line after the timestamps still counts as a line break
+	EXPECT_EQ("\\Nafter blank", cues[1].text);
+}
+
+TEST(lagi_srt, missing_indices) {
+	auto cues = parse(
+		"00:00:01,000 --> 00:00:02,000 X1:10 Y1:20\nfirst\n\n"
+		"00:00:03,000 --> 00:00:04,000\nsecond\n");
+	ASSERT_EQ(2u, cues.size());
+	EXPECT_EQ("first", cues[0].text);
+	EXPECT_EQ(3000, cues[1].start);
+}
+
+TEST(lagi_srt, malformed) {
+	EXPECT_THROW(parse("text\n"), SrtParseError);
+	EXPECT_THROW(parse("1\nnot a timestamp\n"), SrtParseError);
+	EXPECT_THROW(parse("1\n00:00:01.000 --> 00:00:02.000\n"), SrtParseError);
+	EXPECT_THROW(parse("1\n100:00:01,000 --> 00:00:02,000\n"), SrtParseError);
+	EXPECT_THROW(parse("1\n00:00:01,000 --> 00:00:02,000"), SrtParseError);
+	EXPECT_THROW(parse("1"), SrtParseError);
+	EXPECT_NO_THROW(parse("1\n00:00:01,000 --> 00:00:02,000\n"));
+	EXPECT_TRUE(parse("").empty());
+	EXPECT_TRUE(parse("\n\n").empty());
+}
+
+TEST(lagi_srt, tags) {
+	EXPECT_EQ("plain", to_ass("plain"));
+	EXPECT_EQ("{\\b1}bold{\\b}", to_ass("<b>bold</b>"));
+	EXPECT_EQ("{\\i1\\u1}a{\\u\\i}", to_ass("<I><u>a</U></i>"));
+	EXPECT_EQ("{\\s1}a{\\s}", to_ass("<s>a</s>"));
+	EXPECT_EQ("{\\b1}a{\\b}", to_ass("<b><b>a</b></b>"));
+	EXPECT_EQ("a", to_ass("a</b>"));
+	EXPECT_EQ("{\\fnArial\\fs20}a{\\fn\\fs}", to_ass("<font face=\"Arial\" size=20>a</font>"));
+	EXPECT_EQ("{\\fnA}a{\\fnB}b{\\fnA}c{\\fn}", to_ass("<font face='A'>a<font face=B>b</font>c</font>"));
+	EXPECT_EQ("{\\c&H0000FF&}red{\\c}", to_ass("<font color=\"#FF0000\">red</font>"));
+	EXPECT_EQ("a", to_ass("</font>a"));
+	EXPECT_EQ("{\\fnA}a", to_ass("<font face=A bogus=1 size=3>a"));
+	EXPECT_EQ("<br>x<span>y</span>", to_ass("<br>x<span>y</span>"));
+	EXPECT_EQ("1 < 2 {\\b1}x", to_ass("1 < 2 <b>x"));
+	EXPECT_EQ("a <b", to_ass("a <b"));
+	EXPECT_EQ("{\\b1}a\\Nb{\\b}", to_ass("<b>a\\Nb</b>"));
+}
+
+TEST(lagi_srt, many_tags) {
+	std::string srt, ass;
+	for (int i = 0; i < 20000; ++i) {
+		srt += "<i>x</i> ";
+		ass += "{\\i1}x{\\i} ";
+	}
+	EXPECT_EQ(ass, to_ass(srt));
+}
+
+TEST(lagi_srt, webvtt) {
+	auto cues = parse(
+		"WEBVTT - some title\n"
+		"Kind: captions\n"
+		"\n"
+		"NOTE this is a comment\n"
+		"00:00:00.000 --> 00:00:01.000\n"
+		"\n"
+		"STYLE\n"
+		"::cue { color: red }\n"
+		"\n"
+		"intro\n"
+		"00:01.000 --> 00:02.500 align:start position:10%\n"
+		"Hello\n"
+		"world\n"
+		"\n"
+		"01:00:00.250 --> 01:00:01.000\n"
+		"Second\n"
+		"\n"
+		"broken --> timing\n"
+		"skipped\n",
+		SrtDialect::WebVtt);
+	ASSERT_EQ(2u, cues.size());
+	EXPECT_EQ(1000, cues[0].start);
+	EXPECT_EQ(2500, cues[0].end);
+	EXPECT_EQ("Hello\\Nworld", cues[0].text);
+	EXPECT_EQ(3600250, cues[1].start);
+	EXPECT_EQ("Second", cues[1].text);
+
+	EXPECT_THROW(parse("1\n00:00:01,000 --> 00:00:02,000\n", SrtDialect::WebVtt), SrtParseError);
+	EXPECT_THROW(parse("WEBVTTX\n", SrtDialect::WebVtt), SrtParseError);
+	EXPECT_TRUE(parse("WEBVTT", SrtDialect::WebVtt).empty());
+}
+
+TEST(lagi_srt, webvtt_tags) {
+	auto vtt = SrtDialect::WebVtt;
+	EXPECT_EQ("{\\b1}a{\\b}", to_ass("<b>a</b>", vtt));
+	EXPECT_EQ("{\\i1}a{\\i}", to_ass("<i.loud>a</i>", vtt));
+	EXPECT_EQ("Bob: hi", to_ass("<v Bob>Bob: hi</v>", vtt));
+	EXPECT_EQ("a b", to_ass("<c.yellow>a</c> <00:00:01.000>b", vtt));
+	EXPECT_EQ("<s> & x\\hy", to_ass("&lt;s&gt; &amp; x&nbsp;y", vtt));
+	EXPECT_EQ("&unknown; &", to_ass("&unknown; &", vtt));
+	EXPECT_EQ("a", to_ass("a<b", vtt));
+}
+
+TEST(lagi_srt, write) {
+	EXPECT_EQ("00:00:00,000", SrtTime(0, SrtDialect::SubRip));
+	EXPECT_EQ("01:02:03,045", SrtTime(3723045, SrtDialect::SubRip));
+	EXPECT_EQ("01:02:03.045", SrtTime(3723045, SrtDialect::WebVtt));
+	EXPECT_EQ("00:00:00.000", SrtTime(-5, SrtDialect::WebVtt));
+	EXPECT_EQ("a &lt;b&gt; &amp; c", EscapeWebVtt("a <b> & c"));
+}
+
+TEST(lagi_srt, large_file) {
+	const int count = 200000;
+	std::string file;
+	file.reserve(count * 64);
+	for (int i = 0; i < count; ++i) {
+		auto start = SrtTime(i * 1000, SrtDialect::SubRip);
+		auto end = SrtTime(i * 1000 + 800, SrtDialect::SubRip);
+		file += std::to_string(i + 1) + "\r\n" + start + " --> " + end + "\r\n";
+		file += "Line <i>number</i> " + std::to_string(i) + "\r\n<font color=\"#00FF00\">second</font> line\r\n\r\n";
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	auto cues = parse(file);
+	auto parsed = std::chrono::steady_clock::now();
+	std::vector<std::string> text;
+	text.reserve(cues.size());
+	for (auto const& cue : cues)
+		text.push_back(SrtToAss(cue.text, SrtDialect::SubRip));
+	auto converted = std::chrono::steady_clock::now();
+
+	using ms = std::chrono::milliseconds;
+	RecordProperty("parse_ms", static_cast<int>(std::chrono::duration_cast<ms>(parsed - begin).count()));
+	RecordProperty("convert_ms", static_cast<int>(std::chrono::duration_cast<ms>(converted - parsed).count()));
+
+	ASSERT_EQ(static_cast<size_t>(count), cues.size());
+	EXPECT_EQ(199999000, cues.back().start);
+	EXPECT_EQ("Line {\\i1}number{\\i} 199999\\N{\\c&H00FF00&}second{\\c} line", text.back());
+}
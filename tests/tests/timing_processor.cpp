@@ -0,0 +1,305 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+//
+// Aegisub Project http://www.aegisub.org/
+
+#include <main.h>
+
+#include <libaegisub/ass/time.h>
+#include <libaegisub/audio/envelope.h>
+#include <libaegisub/timing_processor.h>
+#include <libaegisub/vfr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using agi::timing::Line;
+using agi::timing::Settings;
+
+namespace {
+/// The timing processor as it was before it was moved out of the dialog,
+/// operating on agi::Time like AssDialogue does, to compare against
+struct RefLine {
+	agi::Time start, end;
+
+	bool CollidesWith(RefLine const& o) const {
+		return (start < o.start) ? (o.start < end) : (start < o.end);
+	}
+};
+
+int ref_closest_kf(std::vector<int> const& kf, int frame) {
+	auto pos = std::upper_bound(begin(kf), end(kf), frame);
+	if (pos == end(kf)) return kf.back();
+	return (pos == begin(kf) || *pos - frame < frame - *(pos - 1)) ? *pos : *(pos - 1);
+}
+
+std::vector<Line> reference(std::vector<Line> const& input, Settings const& s, std::vector<int> const& kf, agi::vfr::Framerate const& fps, agi::EnergyEnvelope const* envelope) {
+	std::vector<RefLine> lines;
+	for (auto const& line : input)
+		lines.push_back(RefLine{line.start, line.end});
+
+	std::vector<RefLine *> sorted;
+	for (auto& line : lines) sorted.push_back(&line);
+	auto sort = [&] {
+		std::stable_sort(begin(sorted), end(sorted), [](RefLine const *a, RefLine const *b) {
+			return a->start < b->start;
+		});
+	};
+	sort();
+
+	if (s.speech && envelope) {
+		for (auto cur : sorted) {
+			int start = envelope->NearestOnset(cur->start, s.speech_distance);
+			int end = envelope->NearestOffset(cur->end, s.speech_distance);
+			if (start < 0) start = cur->start;
+			if (end < 0) end = cur->end;
+			if (start < end) {
+				cur->start = start;
+				cur->end = end;
+			}
+		}
+		sort();
+	}
+
+	if (s.lead_in) {
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			int start = sorted[i]->start - s.lead_in;
+			for (size_t j = 0; j < i; ++j) {
+				if (!sorted[i]->CollidesWith(*sorted[j]))
+					start = std::max<int>(start, sorted[j]->end);
+			}
+			sorted[i]->start = start;
+		}
+	}
+
+	if (s.lead_out) {
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			int end = sorted[i]->end + s.lead_out;
+			for (size_t j = i + 1; j < sorted.size(); ++j) {
+				if (!sorted[i]->CollidesWith(*sorted[j]))
+					end = std::min<int>(end, sorted[j]->start);
+			}
+			sorted[i]->end = end;
+		}
+	}
+
+	if (s.adjacent) {
+		for (size_t i = 1; i < sorted.size(); ++i) {
+			RefLine *prev = sorted[i - 1];
+			RefLine *cur = sorted[i];
+			int dist = cur->start - prev->end;
+			if ((dist < 0 && -dist <= s.adjacent_overlap) || (dist > 0 && dist <= s.adjacent_gap)) {
+				int pos = prev->end + int(dist * s.adjacent_bias);
+				cur->start = pos;
+				prev->end = pos;
+			}
+		}
+	}
+
+	if (s.keyframes && !kf.empty()) {
+		for (auto cur : sorted) {
+			int start_frame = fps.FrameAtTime(cur->start, agi::vfr::START);
+			int end_frame = fps.FrameAtTime(cur->end, agi::vfr::END);
+
+			int closest = ref_closest_kf(kf, start_frame);
+			int time = fps.TimeAtFrame(closest, agi::vfr::START);
+			if ((closest > start_frame && time - cur->start <= s.keyframe_before_start) || (closest < start_frame && cur->start - time <= s.keyframe_after_start))
+				cur->start = time;
+
+			closest = ref_closest_kf(kf, end_frame) - 1;
+			time = fps.TimeAtFrame(closest, agi::vfr::END);
+			if ((closest > end_frame && time - cur->end <= s.keyframe_before_end) || (closest < end_frame && cur->end - time <= s.keyframe_after_end))
+				cur->end = time;
+		}
+	}
+
+	std::vector<Line> ret;
+	for (auto const& line : lines)
+		ret.push_back(Line{line.start, line.end});
+	return ret;
+}
+
+std::vector<Line> random_lines(std::mt19937& rng, size_t count, int duration) {
+	std::uniform_int_distribution<int> start(0, duration);
+	std::uniform_int_distribution<int> length(0, 6000);
+	std::vector<Line> lines;
+	for (size_t i = 0; i < count; ++i) {
+		int s = start(rng);
+		lines.push_back(Line{s, s + length(rng)});
+	}
+	return lines;
+}
+
+std::vector<int> random_keyframes(std::mt19937& rng, int frames) {
+	std::uniform_int_distribution<int> gap(1, 300);
+	std::vector<int> kf;
+	for (int frame = 0; frame < frames; frame += gap(rng))
+		kf.push_back(frame);
+	kf.push_back(frames - 1);
+	return kf;
+}
+
+/// Quiet audio with speech in random stretches
+agi::EnergyEnvelope random_envelope(std::mt19937& rng, int duration) {
+	std::uniform_int_distribution<int> gap(20, 300);
+	std::uniform_int_distribution<int> length(5, 400);
+	std::vector<uint8_t> levels(duration / agi::EnergyEnvelope::window_ms, 20);
+	for (size_t i = gap(rng); i < levels.size(); i += gap(rng)) {
+		size_t end = std::min(levels.size(), i + length(rng));
+		std::fill(begin(levels) + i, begin(levels) + end, 120);
+		i = end;
+	}
+	return agi::EnergyEnvelope(std::move(levels));
+}
+
+Settings all_settings() {
+	Settings s;
+	s.lead_in = 200;
+	s.lead_out = 300;
+	s.adjacent = true;
+	s.adjacent_gap = 500;
+	s.adjacent_overlap = 250;
+	s.adjacent_bias = 0.6;
+	s.keyframes = true;
+	s.keyframe_before_start = 250;
+	s.keyframe_after_start = 150;
+	s.keyframe_before_end = 500;
+	s.keyframe_after_end = 300;
+	s.speech = true;
+	s.speech_distance = 200;
+	return s;
+}
+
+void expect_same(std::vector<Line> const& expected, std::vector<Line> const& actual) {
+	ASSERT_EQ(expected.size(), actual.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_EQ(expected[i].start, actual[i].start) << "line " << i;
+		EXPECT_EQ(expected[i].end, actual[i].end) << "line " << i;
+	}
+}
+}
+
+TEST(lagi_timing_processor, empty) {
+	std::vector<Line> lines;
+	agi::timing::Process(lines, all_settings(), {}, agi::vfr::Framerate(24000, 1001), nullptr);
+	EXPECT_TRUE(lines.empty());
+}
+
+TEST(lagi_timing_processor, lead_in_stops_at_previous_line) {
+	std::vector<Line> lines{{1500, 3000}, {0, 1000}, {500, 2000}};
+	Settings s;
+	s.lead_in = 400;
+	agi::timing::Process(lines, s, {}, agi::vfr::Framerate(24000, 1001), nullptr);
+
+	// The overlapping line doesn't limit the lead-in, but the one which ends
+	// before the line starts does
+	EXPECT_EQ(1100, lines[0].start);
+	EXPECT_EQ(0, lines[1].start);
+	EXPECT_EQ(100, lines[2].start);
+}
+
+TEST(lagi_timing_processor, lead_out_stops_at_next_line) {
+	std::vector<Line> lines{{0, 1000}, {1200, 2000}, {1500, 2500}};
+	Settings s;
+	s.lead_out = 400;
+	agi::timing::Process(lines, s, {}, agi::vfr::Framerate(24000, 1001), nullptr);
+
+	EXPECT_EQ(1200, lines[0].end);
+	EXPECT_EQ(2400, lines[1].end);
+	EXPECT_EQ(2900, lines[2].end);
+}
+
+TEST(lagi_timing_processor, times_are_rounded_to_centiseconds) {
+	std::vector<Line> lines{{1004, 2006}};
+	Settings s;
+	s.lead_in = 33;
+	agi::timing::Process(lines, s, {}, agi::vfr::Framerate(24000, 1001), nullptr);
+
+	EXPECT_EQ(970, lines[0].start);
+	EXPECT_EQ(2010, lines[0].end);
+}
+
+TEST(lagi_timing_processor, adjacent_meets_at_bias) {
+	std::vector<Line> lines{{0, 1000}, {1400, 2000}, {1900, 3000}};
+	Settings s;
+	s.adjacent = true;
+	s.adjacent_gap = 500;
+	s.adjacent_overlap = 200;
+	s.adjacent_bias = 0.5;
+	agi::timing::Process(lines, s, {}, agi::vfr::Framerate(24000, 1001), nullptr);
+
+	EXPECT_EQ(1200, lines[0].end);
+	EXPECT_EQ(1200, lines[1].start);
+	EXPECT_EQ(1950, lines[1].end);
+	EXPECT_EQ(1950, lines[2].start);
+}
+
+TEST(lagi_timing_processor, snaps_to_keyframes) {
+	agi::vfr::Framerate fps(25, 1);
+	std::vector<int> kf{0, 50, 100};
+	// Starts 0.2s before the keyframe at 2s, and ends 0.1s after the frame
+	// before the keyframe at 4s
+	std::vector<Line> lines{{1800, 4060}};
+	Settings s;
+	s.keyframes = true;
+	s.keyframe_before_start = 250;
+	s.keyframe_after_end = 150;
+	agi::timing::Process(lines, s, kf, fps, nullptr);
+
+	EXPECT_EQ(fps.TimeAtFrame(50, agi::vfr::START), lines[0].start);
+	EXPECT_EQ(fps.TimeAtFrame(99, agi::vfr::END), lines[0].end);
+}
+
+TEST(lagi_timing_processor, matches_serial_implementation) {
+	std::mt19937 rng(1234);
+	agi::vfr::Framerate fps(24000, 1001);
+	const int duration = 20 * 60 * 1000;
+	auto kf = random_keyframes(rng, fps.FrameAtTime(duration));
+	auto envelope = random_envelope(rng, duration);
+
+	for (int round = 0; round < 20; ++round) {
+		Settings s = all_settings();
+		// Cover each step on its own as well as all of them together
+		if (round % 5 == 1) s = Settings{}, s.lead_in = 300;
+		if (round % 5 == 2) s = Settings{}, s.lead_out = 400;
+		if (round % 5 == 3) s.speech = false;
+		if (round % 5 == 4) s.keyframes = false, s.adjacent_bias = 0.25;
+
+		auto lines = random_lines(rng, 3000, duration);
+		auto expected = reference(lines, s, kf, fps, &envelope);
+		agi::timing::Process(lines, s, kf, fps, &envelope);
+		expect_same(expected, lines);
+		if (HasFailure()) break;
+	}
+}
+
+TEST(lagi_timing_processor, large_batch_benchmark) {
+	std::mt19937 rng(5678);
+	agi::vfr::Framerate fps(24000, 1001);
+	const int duration = 10 * 60 * 60 * 1000;
+	auto kf = random_keyframes(rng, fps.FrameAtTime(duration));
+	auto envelope = random_envelope(rng, duration);
+	auto lines = random_lines(rng, 200000, duration);
+
+	auto begin = std::chrono::steady_clock::now();
+	agi::timing::Process(lines, all_settings(), kf, fps, &envelope);
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+	RecordProperty("process_ms", static_cast<int>(ms));
+
+	for (auto const& line : lines) {
+		ASSERT_EQ(line.start, (int)agi::Time(line.start));
+		ASSERT_EQ(line.end, (int)agi::Time(line.end));
+	}
+}
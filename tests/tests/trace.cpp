@@ -0,0 +1,104 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <libaegisub/trace.h>
+
+#include <libaegisub/cajun/reader.h>
+#include <libaegisub/signal.h>
+
+#include <main.h>
+
+#include <sstream>
+
+using namespace agi::trace;
+
+namespace {
+struct TraceTest : public ::testing::Test {
+	void SetUp() override { Clear(); }
+	void TearDown() override {
+		SetEnabled(false);
+		Clear();
+	}
+};
+
+struct Listener {
+	int calls = 0;
+	void OnSignal() { ++calls; }
+};
+}
+
+TEST_F(TraceTest, disabled_records_nothing) {
+	{ AGI_TRACE_SCOPE("test", "scope"); }
+	EXPECT_TRUE(Events().empty());
+}
+
+TEST_F(TraceTest, scope_is_recorded) {
+	SetEnabled(true);
+	{ AGI_TRACE_SCOPE("test", "scope"); }
+	SetEnabled(false);
+	{ AGI_TRACE_SCOPE("test", "after"); }
+
+	auto events = Events();
+	ASSERT_EQ(1u, events.size());
+	EXPECT_STREQ("test", events[0].category);
+	EXPECT_EQ("scope", EventName(events[0]));
+}
+
+TEST_F(TraceTest, signal_slots_are_named_by_type) {
+	agi::signal::Signal<> sig;
+	Listener listener;
+	agi::signal::Connection c = sig.Connect(&Listener::OnSignal, &listener);
+
+	SetEnabled(true);
+	sig();
+	sig();
+
+	auto summary = Summarize();
+	ASSERT_EQ(1u, summary.size());
+	EXPECT_EQ("signal", summary[0].category);
+	EXPECT_NE(std::string::npos, summary[0].name.find("Listener"));
+	EXPECT_EQ(2u, summary[0].count);
+	EXPECT_EQ(2, listener.calls);
+}
+
+TEST_F(TraceTest, summary_is_sorted_by_total) {
+	SetEnabled(true);
+	{ AGI_TRACE_SCOPE("test", "fast"); }
+	{
+		AGI_TRACE_SCOPE("test", "slow");
+		auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(2)) ;
+	}
+
+	auto summary = Summarize();
+	ASSERT_EQ(2u, summary.size());
+	EXPECT_EQ("slow", summary[0].name);
+	EXPECT_LE(2000u, summary[0].max);
+}
+
+TEST_F(TraceTest, chrome_trace_is_valid_json) {
+	SetEnabled(true);
+	{ AGI_TRACE_SCOPE("test", "a \"quoted\" name"); }
+
+	std::stringstream out;
+	WriteChromeTrace(out);
+
+	json::UnknownElement root;
+	ASSERT_NO_THROW(json::Reader::Read(root, out));
+	json::Array const& events = static_cast<json::Object const&>(root).at("traceEvents");
+	ASSERT_EQ(1u, events.size());
+	json::Object const& event = events[0];
+	EXPECT_EQ("a \"quoted\" name", static_cast<std::string const&>(event.at("name")));
+	EXPECT_EQ("X", static_cast<std::string const&>(event.at("ph")));
+}
@@ -42,4 +42,14 @@ TEST(lagi_util, try_parse_int) {
 	EXPECT_EQ(1.0, i);
 }
 
+TEST(lagi_util, float_to_string) {
+	EXPECT_EQ("1", util::float_to_string(1.0));
+	EXPECT_EQ("1.5", util::float_to_string(1.5));
+	EXPECT_EQ("1.125", util::float_to_string(1.125));
+	EXPECT_EQ("1.13", util::float_to_string(1.126, 2));
+	EXPECT_EQ("100", util::float_to_string(100.0));
+	EXPECT_EQ("-0.25", util::float_to_string(-0.25));
+	EXPECT_EQ("0", util::float_to_string(0.0001));
+}
+
 }
@@ -462,6 +462,69 @@ TEST(lagi_vfr, duplicate_timestamps) {
 	EXPECT_EQ(3, fps.FrameAtTime(200, EXACT));
 }
 
+TEST(lagi_vfr, mixed_runs) {
+	// 23.976 fps, then some irregular frames, then 119.88 fps, then a
+	// duplicate timestamp and more 23.976
+	std::vector<int> timecodes;
+	for (int i = 0; i < 1000; ++i)
+		timecodes.push_back(i * 1001 / 24);
+	for (int delta : { 5, 17, 3, 40, 40, 1, 90 })
+		timecodes.push_back(timecodes.back() + delta);
+	int base = timecodes.back() + 10;
+	for (int i = 0; i < 5000; ++i)
+		timecodes.push_back(base + i * 1001 / 120);
+	timecodes.push_back(timecodes.back());
+	base = timecodes.back();
+	for (int i = 1; i < 500; ++i)
+		timecodes.push_back(base + (i * 1001 + 12) / 24);
+
+	Framerate fps;
+	ASSERT_NO_THROW(fps = Framerate(timecodes));
+
+	for (size_t i = 0; i < timecodes.size(); ++i)
+		ASSERT_EQ(timecodes[i], fps.TimeAtFrame((int)i, EXACT));
+
+	// Last frame with a start time <= ms
+	int frame = 0;
+	for (int ms = 0; ms <= timecodes.back(); ++ms) {
+		while (frame + 1 < (int)timecodes.size() && timecodes[frame + 1] <= ms)
+			++frame;
+		ASSERT_EQ(frame, fps.FrameAtTime(ms, EXACT));
+	}
+}
+
+TEST(lagi_vfr, batched_matches_single) {
+	std::vector<int> timecodes;
+	for (int i = 0; i < 2000; ++i)
+		timecodes.push_back(i * 1001 / 30 + (i > 1500 ? i - 1500 : 0));
+
+	std::vector<int> times, frames;
+	for (int ms = -100; ms < timecodes.back() + 1000; ms += 7)
+		times.push_back(ms);
+	for (int i = -5; i < 2100; ++i)
+		frames.push_back(i);
+	std::vector<int> shuffled_times(times.rbegin(), times.rend());
+	std::vector<int> shuffled_frames(frames.rbegin(), frames.rend());
+
+	for (auto fps : { Framerate(timecodes), Framerate(24000, 1001), Framerate("data/vfr/in/v1_mode5.txt") }) {
+		for (auto type : { EXACT, START, END }) {
+			for (auto const& input : { times, shuffled_times }) {
+				auto result = fps.FramesAtTimes(input, type);
+				ASSERT_EQ(input.size(), result.size());
+				for (size_t i = 0; i < input.size(); ++i)
+					ASSERT_EQ(fps.FrameAtTime(input[i], type), result[i]);
+			}
+
+			for (auto const& input : { frames, shuffled_frames }) {
+				auto result = fps.TimesAtFrames(input, type);
+				ASSERT_EQ(input.size(), result.size());
+				for (size_t i = 0; i < input.size(); ++i)
+					ASSERT_EQ(fps.TimeAtFrame(input[i], type), result[i]);
+			}
+		}
+	}
+}
+
 #define EXPECT_SMPTE(eh, em, es, ef) \
 	EXPECT_EQ(eh, h); \
 	EXPECT_EQ(em, m); \
@@ -160,3 +160,23 @@ TEST(lagi_word_split, several_words) {
 	EXPECT_EQ(1, tokens[8].length);
 }
 
+
+TEST(lagi_word_split, large_drawing) {
+	std::string text = "{\\p1}m 0 0";
+	for (int i = 0; i < 20000; ++i)
+		text += " l " + std::to_string(i) + " " + std::to_string(i * 2);
+	text += "{\\p0}";
+
+	auto tokens = TokenizeDialogueBody(text);
+	SplitWords(text, tokens);
+
+	// OVR_BEGIN, TAG_START, TAG_NAME, ARG, OVR_END, then the drawing with
+	// whitespace between each word, then the closing block
+	size_t words = 3 + 20000 * 3;
+	ASSERT_EQ(5 + words * 2 - 1 + 5, tokens.size());
+	EXPECT_EQ(dt::DRAWING_CMD, tokens[5].type);
+	EXPECT_EQ(dt::DRAWING_X, tokens[7].type);
+	EXPECT_EQ(dt::DRAWING_Y, tokens[9].type);
+	EXPECT_EQ(dt::DRAWING_CMD, tokens[11].type);
+	EXPECT_EQ(dt::DRAWING_Y, tokens[tokens.size() - 6].type);
+}
@@ -0,0 +1,201 @@
+// Copyright (c) 2026, Aegisub contributors
+//
+// Permission to use, copy, modify, and distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+// Runs the timing post-processor on the dialogue lines of an ASS file
+// without the GUI, for batch processing many files at once. Speech snapping
+// isn't available as it needs the audio.
+
+#include <libaegisub/ass/time.h>
+#include <libaegisub/dispatch.h>
+#include <libaegisub/exception.h>
+#include <libaegisub/io.h>
+#include <libaegisub/keyframe.h>
+#include <libaegisub/log.h>
+#include <libaegisub/timing_processor.h>
+#include <libaegisub/vfr.h>
+
+#include <boost/locale/generator.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+void usage() {
+	printf(
+		"usage: timing-processor [options] <input.ass> <output.ass>\n"
+		"  --lead-in <ms>                  move starts earlier by ms\n"
+		"  --lead-out <ms>                 move ends later by ms\n"
+		"  --adjacent <gap> <overlap>      join lines with a gap or overlap of at most\n"
+		"                                  this many ms\n"
+		"  --adjacent-bias <0-1>           where between the lines to join them\n"
+		"  --keyframes <file>              snap to the keyframes in file, which needs\n"
+		"                                  --timecodes or --fps\n"
+		"  --keyframe-thresholds <a> <b> <c> <d>\n"
+		"                                  ms to move starts later, starts earlier,\n"
+		"                                  ends later and ends earlier to a keyframe\n"
+		"  --timecodes <file>              timecodes for the video\n"
+		"  --fps <fps>                     constant frame rate of the video\n");
+}
+
+struct Dialogue {
+	/// Index of the line in the file
+	size_t line;
+	/// Positions of the start and end time fields in the line
+	size_t start_pos, start_len, end_pos, end_len;
+};
+
+/// Find the start and end time fields of a Dialogue line
+bool parse_dialogue(std::string const& text, size_t line, Dialogue& out) {
+	if (text.compare(0, 9, "Dialogue:") != 0) return false;
+	size_t layer_end = text.find(',', 9);
+	if (layer_end == std::string::npos) return false;
+	size_t start_end = text.find(',', layer_end + 1);
+	if (start_end == std::string::npos) return false;
+	size_t end_end = text.find(',', start_end + 1);
+	if (end_end == std::string::npos) return false;
+
+	out.line = line;
+	out.start_pos = layer_end + 1;
+	out.start_len = start_end - out.start_pos;
+	out.end_pos = start_end + 1;
+	out.end_len = end_end - out.end_pos;
+	return true;
+}
+
+int run(int argc, char *argv[]) {
+	agi::timing::Settings settings;
+	std::string keyframes_file, timecodes_file;
+	double fps = 0;
+	std::vector<const char *> files;
+
+	for (int i = 1; i < argc; ++i) {
+		auto arg = [&](int n) -> const char * {
+			if (i + n >= argc) {
+				fprintf(stderr, "%s needs %d arguments\n", argv[i], n);
+				exit(1);
+			}
+			return argv[i + n];
+		};
+
+		if (!strcmp(argv[i], "--lead-in"))
+			settings.lead_in = atoi(arg(1)), i += 1;
+		else if (!strcmp(argv[i], "--lead-out"))
+			settings.lead_out = atoi(arg(1)), i += 1;
+		else if (!strcmp(argv[i], "--adjacent")) {
+			settings.adjacent = true;
+			settings.adjacent_gap = atoi(arg(1));
+			settings.adjacent_overlap = atoi(arg(2));
+			i += 2;
+		}
+		else if (!strcmp(argv[i], "--adjacent-bias"))
+			settings.adjacent_bias = atof(arg(1)), i += 1;
+		else if (!strcmp(argv[i], "--keyframes")) {
+			settings.keyframes = true;
+			keyframes_file = arg(1);
+			i += 1;
+		}
+		else if (!strcmp(argv[i], "--keyframe-thresholds")) {
+			settings.keyframe_before_start = atoi(arg(1));
+			settings.keyframe_after_start = atoi(arg(2));
+			settings.keyframe_before_end = atoi(arg(3));
+			settings.keyframe_after_end = atoi(arg(4));
+			i += 4;
+		}
+		else if (!strcmp(argv[i], "--timecodes"))
+			timecodes_file = arg(1), i += 1;
+		else if (!strcmp(argv[i], "--fps"))
+			fps = atof(arg(1)), i += 1;
+		else if (argv[i][0] == '-' && argv[i][1] == '-') {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+		else
+			files.push_back(argv[i]);
+	}
+
+	if (files.size() != 2) {
+		usage();
+		return 1;
+	}
+
+	agi::vfr::Framerate timecodes;
+	if (!timecodes_file.empty())
+		timecodes = agi::vfr::Framerate(timecodes_file);
+	else if (fps > 0)
+		timecodes = agi::vfr::Framerate(fps);
+
+	std::vector<int> keyframes;
+	if (settings.keyframes) {
+		if (!timecodes.IsLoaded()) {
+			fprintf(stderr, "--keyframes needs --timecodes or --fps\n");
+			return 1;
+		}
+		keyframes = agi::keyframe::Load(keyframes_file);
+	}
+
+	std::vector<std::string> text;
+	{
+		auto in = agi::io::Open(files[0]);
+		std::string line;
+		while (getline(*in, line))
+			text.push_back(std::move(line));
+	}
+
+	std::vector<Dialogue> dialogue;
+	std::vector<agi::timing::Line> lines;
+	for (size_t i = 0; i < text.size(); ++i) {
+		Dialogue d;
+		if (!parse_dialogue(text[i], i, d)) continue;
+		dialogue.push_back(d);
+		lines.push_back({
+			agi::Time(text[i].substr(d.start_pos, d.start_len)),
+			agi::Time(text[i].substr(d.end_pos, d.end_len))
+		});
+	}
+
+	agi::timing::Process(lines, settings, keyframes, timecodes, nullptr);
+
+	// Replace the end time before the start time so that start_pos stays valid
+	for (size_t i = 0; i < dialogue.size(); ++i) {
+		auto& d = dialogue[i];
+		auto& line = text[d.line];
+		line.replace(d.end_pos, d.end_len, agi::Time(lines[i].end).GetAssFormatted());
+		line.replace(d.start_pos, d.start_len, agi::Time(lines[i].start).GetAssFormatted());
+	}
+
+	agi::io::Save out(files[1]);
+	for (auto const& line : text)
+		out.Get() << line << '\n';
+
+	printf("Processed %d lines\n", (int)lines.size());
+	return 0;
+}
+}
+
+int main(int argc, char *argv[]) {
+	// Process() spreads its passes over the background queue
+	agi::dispatch::Init([](agi::dispatch::Thunk f) { });
+	std::locale::global(boost::locale::generator().generate(""));
+	agi::log::log = new agi::log::LogSink;
+
+	try {
+		return run(argc, argv);
+	}
+	catch (agi::Exception const& e) {
+		fprintf(stderr, "%s\n", e.GetMessage().c_str());
+		return 1;
+	}
+}
@@ -0,0 +1,164 @@
+# Copyright (c) 2026, Aegisub contributors
+#
+# Permission to use, copy, modify, and distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+# ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+# WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+# ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+# OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Aegisub Project http://www.aegisub.org/
+
+# Measures how much throughput the VapourSynth providers gain from keeping
+# several frame requests in flight rather than fetching one frame at a time.
+#
+# The clips are built only from core filters applied to blank clips, so every
+# run filters exactly the same data and no source plugins are needed.
+#
+# Run directly with Python to compare the two ways of reading frames:
+#   python3 vs-throughput.py [--frames N] [--depth N] [--threads N]
+# This reads the video clip sequentially, as the providers did before (one
+# synchronous get_frame at a time), and as they do now (a window of
+# get_frame_async requests as wide as the core's thread pool), then does the
+# same for the audio clip one FillBuffer-sized block at a time.
+#
+# The file can also be opened in Aegisub as a video or audio file to measure
+# the providers themselves. Set AEGISUB_VS_THROUGHPUT=audio in the environment
+# to get the audio clip rather than the video clip, enable "Record performance
+# trace" in the log window, play or scroll through the file, and compare the
+# totals for VapourSynth::GetFrame and VapourSynth::FillBuffer between builds.
+
+import argparse
+import collections
+import os
+import time
+
+import vapoursynth as vs
+
+core = vs.core
+
+WIDTH = 1920
+HEIGHT = 1080
+FPS = (24000, 1001)
+SAMPLE_RATE = 48000
+# Samples read by each FillBuffer call when measuring audio; the audio cache
+# in front of the provider reads blocks of this size
+AUDIO_BLOCK = 1 << 16
+
+
+def make_video(frames, depth):
+    """A deterministic clip which costs a fair amount of CPU per frame"""
+    clip = core.std.BlankClip(width=WIDTH, height=HEIGHT, format=vs.YUV420P8,
+                              length=frames, fpsnum=FPS[0], fpsden=FPS[1])
+    # Give every frame different content so that nothing can be shared
+    # between frames
+    clip = core.std.Expr(clip, ['X Y + N 7 * + 255 %', '128', '128'])
+    for i in range(depth):
+        clip = core.std.Convolution(clip, matrix=[1, 2, 1, 2, 4, 2, 1, 2, 1])
+        clip = core.std.Expr(clip, ['x {} + 255 %'.format(i * 3 + 1), '', ''])
+    # The video provider converts anything which isn't RGB24 itself, so do the
+    # same here to include that cost in the measurement
+    return core.resize.Bicubic(clip, format=vs.RGB24, matrix_in_s='709')
+
+
+def make_audio(frames, depth):
+    """A deterministic audio clip as long as the video clip"""
+    length = frames * SAMPLE_RATE * FPS[1] // FPS[0]
+    audio = core.std.BlankAudio(channels=vs.STEREO, bits=32,
+                                sampletype=vs.FLOAT, samplerate=SAMPLE_RATE,
+                                length=length)
+    # Core audio filters are all cheap, so stack enough of them for filtering
+    # to dominate
+    for i in range(depth * 8):
+        audio = core.std.AudioGain(audio, gain=[1.0 + (i % 3) * 0.01, 0.99])
+        audio = core.std.AudioMix(audio, matrix=[0.9, 0.1, 0.1, 0.9],
+                                  channels_out=[vs.FRONT_LEFT, vs.FRONT_RIGHT])
+    return audio
+
+
+def read_sync(node, count):
+    for n in range(count):
+        node.get_frame(n)
+
+
+def read_windowed(node, count, window):
+    """Read frames in order the way VSFrameRequests does"""
+    pending = collections.deque()
+    requested = 0
+    for n in range(count):
+        while requested < count and requested < n + window:
+            pending.append(node.get_frame_async(requested))
+            requested += 1
+        pending.popleft().result()
+
+
+def audio_blocks(audio):
+    per_frame = 3072
+    for start in range(0, audio.num_samples, AUDIO_BLOCK):
+        end = min(start + AUDIO_BLOCK, audio.num_samples)
+        yield start // per_frame, (end - 1) // per_frame + 1
+
+
+def read_audio_sync(audio):
+    for first, last in audio_blocks(audio):
+        for n in range(first, last):
+            audio.get_frame(n)
+
+
+def read_audio_parallel(audio):
+    """Request every frame of a block up front, as FillBuffer does now"""
+    for first, last in audio_blocks(audio):
+        for f in [audio.get_frame_async(n) for n in range(first, last)]:
+            f.result()
+
+
+def measure(name, units, fn, *args):
+    start = time.perf_counter()
+    fn(*args)
+    elapsed = time.perf_counter() - start
+    print('{:<28} {:8.2f} s {:10.1f} frames/s'.format(name, elapsed, units / elapsed))
+    return elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure VapourSynth frame request throughput")
+    parser.add_argument('--frames', type=int, default=480, help='number of video frames to read')
+    parser.add_argument('--depth', type=int, default=8, help='number of filter passes per clip')
+    parser.add_argument('--threads', type=int, default=0, help='core threads (default: all)')
+    args = parser.parse_args()
+
+    if args.threads:
+        core.num_threads = args.threads
+    window = core.num_threads
+    print('VapourSynth {}, {} threads, {} frames, depth {}'.format(
+        core.version_number(), window, args.frames, args.depth))
+
+    # Warm up the thread pool so that the first measurement doesn't pay for it
+    read_windowed(make_video(window, args.depth), window, window)
+
+    # Each measurement gets a clip of its own so that neither can be served
+    # from frames the other left in the core's cache
+    video = make_video(args.frames, args.depth)
+    before = measure('video, one at a time', args.frames, read_sync, video, args.frames)
+    video = make_video(args.frames, args.depth)
+    after = measure('video, {} in flight'.format(window), args.frames, read_windowed, video, args.frames, window)
+    print('video speedup: {:.2f}x'.format(before / after))
+
+    audio = make_audio(args.frames, args.depth)
+    before = measure('audio, one at a time', audio.num_frames, read_audio_sync, audio)
+    audio = make_audio(args.frames, args.depth)
+    after = measure('audio, whole block at once', audio.num_frames, read_audio_parallel, audio)
+    print('audio speedup: {:.2f}x'.format(before / after))
+
+
+if __name__ == '__main__':
+    main()
+elif os.environ.get('AEGISUB_VS_THROUGHPUT') == 'audio':
+    make_audio(480, 8).set_output()
+else:
+    make_video(480, 8).set_output()